@@ -0,0 +1,131 @@
+// Standalone benchmark of the compressed heightfield (ratio, encode and decode throughput, cached queries), not part of HeightMap.vcxproj (it has its own main)
+// Build from the HeightMap folder, for example:
+//   cl /O2 /EHsc /std:c++17 /I"..\Third Party\glm" /I. Benchmarks\HeightCompressionBenchmark.cpp CompressedHeightField.cpp HeightMapGenerator.cpp HeightField.cpp ValueNoiseKernel.cpp FractalNoise.cpp ThreadPool.cpp
+//   g++ -O2 -std=c++17 -pthread -I"../Third Party/glm" -I. Benchmarks/HeightCompressionBenchmark.cpp CompressedHeightField.cpp HeightMapGenerator.cpp HeightField.cpp ValueNoiseKernel.cpp FractalNoise.cpp ThreadPool.cpp
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include "CompressedHeightField.h"
+#include "HeightMapGenerator.h"
+
+#define BENCHMARK_RES 1024 // the resolution can be given on the command line
+#define BENCHMARK_TILE_SIZE 64
+#define BENCHMARK_RUNS 5
+#define BENCHMARK_CACHED_BLOCKS 64
+#define BENCHMARK_QUERIES 4000000
+#define BENCHMARK_WALKS 64 // the queries are split between this many random walks
+
+template <typename F>
+static double measureBestSeconds(F run)
+{
+	double bestSeconds = 1e30;
+	for (int runIndex = 0; runIndex < BENCHMARK_RUNS; ++runIndex)
+	{
+		auto startTime = std::chrono::steady_clock::now();
+		run();
+		bestSeconds = std::min(bestSeconds, std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count());
+	}
+	return bestSeconds;
+}
+
+static void benchmark(const std::string& name, const HeightField& heightField, float maxError, ThreadPool& threadPool)
+{
+	const uint32_t resolution = heightField.getResolution();
+	const double sampleCount = static_cast<double>(resolution) * resolution;
+	CompressedHeightField compressedHeightField(resolution, BENCHMARK_TILE_SIZE, maxError, BENCHMARK_CACHED_BLOCKS);
+	HeightField decodedHeightField(resolution, BENCHMARK_TILE_SIZE);
+
+	const double encodeSeconds = measureBestSeconds([&]() { compressedHeightField.compress(heightField, nullptr); });
+	const double decodeSeconds = measureBestSeconds([&]() { compressedHeightField.decompress(decodedHeightField, nullptr); });
+	const double threadedDecodeSeconds = measureBestSeconds([&]() { compressedHeightField.decompress(decodedHeightField, &threadPool); });
+
+	float measuredMaxError = 0.0f;
+	for (uint32_t i = 0; i < resolution; ++i)
+		for (uint32_t j = 0; j < resolution; ++j)
+			measuredMaxError = std::max(measuredMaxError, std::abs(decodedHeightField.get(i, j) - heightField.get(i, j)));
+	// Quantized heights are rounded to floats once more when decoded
+	const bool withinBound = maxError == 0.0f ? measuredMaxError == 0.0f : measuredMaxError <= maxError * 1.001f;
+
+	std::cout << name << " : " << 8.0 * compressedHeightField.getCompressedSize() / sampleCount << " bits/sample (ratio " <<
+		sampleCount * sizeof(float) / compressedHeightField.getCompressedSize() << "), max error " << measuredMaxError << (withinBound ? "" : " (ABOVE THE BOUND)") << std::endl;
+	std::cout << "  encode " << sampleCount / encodeSeconds / 1'000'000.0 << " Msamples/s, decode " << sampleCount / decodeSeconds / 1'000'000.0 <<
+		" Msamples/s, decode " << threadPool.getThreadCount() << " threads " << sampleCount / threadedDecodeSeconds / 1'000'000.0 << " Msamples/s" << std::endl;
+
+	// Random walks of queries, as cameras or brushes moving over the terrain: most queries hit the cached blocks. Through get() each query locks
+	// a cache shard, a Reader only goes through the cache when the walk enters another block
+	auto walk = [&](uint32_t walkIndex, bool withReader)
+	{
+		CompressedHeightField::Reader reader(compressedHeightField);
+		uint32_t walkI = resolution / 2, walkJ = resolution / 2;
+		uint32_t randomState = walkIndex + 1;
+		float checksum = 0.0f;
+		for (uint32_t query = 0; query < BENCHMARK_QUERIES / BENCHMARK_WALKS; ++query)
+		{
+			randomState = randomState * 1664525u + 1013904223u;
+			walkI = std::min(std::max(static_cast<int>(walkI) + static_cast<int>(randomState >> 28) - 8, 0), static_cast<int>(resolution) - 1);
+			walkJ = std::min(std::max(static_cast<int>(walkJ) + static_cast<int>((randomState >> 24) & 15) - 8, 0), static_cast<int>(resolution) - 1);
+			checksum += withReader ? reader.get(walkI, walkJ) : compressedHeightField.get(walkI, walkJ);
+		}
+		return checksum;
+	};
+	for (bool withReader : { false, true })
+	{
+		std::vector<float> checksums(BENCHMARK_WALKS);
+		const uint64_t hitCount = compressedHeightField.getCacheHitCount();
+		const uint64_t missCount = compressedHeightField.getCacheMissCount();
+		const double querySeconds = measureBestSeconds([&]() { for (uint32_t walkIndex = 0; walkIndex < BENCHMARK_WALKS; ++walkIndex) checksums[walkIndex] = walk(walkIndex, withReader); });
+		const double threadedQuerySeconds = measureBestSeconds([&]() { threadPool.parallelFor(BENCHMARK_WALKS, [&](uint32_t walkIndex) { checksums[walkIndex] = walk(walkIndex, withReader); }); });
+		const uint64_t cacheQueryCount = compressedHeightField.getCacheHitCount() - hitCount + compressedHeightField.getCacheMissCount() - missCount;
+		std::cout << "  " << (withReader ? "Reader" : "get()") << " queries " << BENCHMARK_QUERIES / querySeconds / 1'000'000.0 << " M/s, " << threadPool.getThreadCount() <<
+			" threads " << BENCHMARK_QUERIES / threadedQuerySeconds / 1'000'000.0 << " M/s, " << 100.0 * cacheQueryCount / (2.0 * BENCHMARK_RUNS * BENCHMARK_QUERIES) <<
+			" % through the cache, hit rate " << 100.0 * (compressedHeightField.getCacheHitCount() - hitCount) / cacheQueryCount << " % (checksum " <<
+			std::accumulate(checksums.begin(), checksums.end(), 0.0f) << ")" << std::endl;
+	}
+
+	// copyRow as HeightField::copyRow, over block boundaries
+	std::vector<float> row(resolution), decodedRow(resolution);
+	bool rowsEqual = true;
+	for (uint32_t i = 0; i < resolution; i += 7)
+	{
+		const uint32_t firstColumn = (i * 13) % resolution;
+		compressedHeightField.copyRow(i, firstColumn, resolution - firstColumn, row.data());
+		decodedHeightField.copyRow(i, firstColumn, resolution - firstColumn, decodedRow.data());
+		rowsEqual = rowsEqual && std::equal(row.begin(), row.begin() + (resolution - firstColumn), decodedRow.begin());
+	}
+	std::cout << "  copyRow " << (rowsEqual ? "equal to the decoded heightfield" : "DIFFERENT FROM THE DECODED HEIGHTFIELD") << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+	const uint32_t resolution = argc > 1 ? static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 10)) : BENCHMARK_RES;
+	ThreadPool threadPool;
+	HeightField heightField(resolution, BENCHMARK_TILE_SIZE);
+
+	std::cout << "Heightfield " << resolution << "x" << resolution << ", " << static_cast<double>(resolution) * resolution * sizeof(float) / (1024.0 * 1024.0) << " MiB of floats" << std::endl;
+	HeightMapGenerator valueNoiseGenerator(resolution);
+	valueNoiseGenerator.generate(heightField, &threadPool);
+	benchmark("Value noise, lossless", heightField, 0.0f, threadPool);
+	benchmark("Value noise, 16 bit error", heightField, 0.5f / 65535.0f, threadPool);
+	benchmark("Value noise, 1e-3 error", heightField, 1e-3f, threadPool);
+
+	FractalNoise::Parameters noiseParameters;
+	noiseParameters.type = FractalNoise::Type::SIMPLEX;
+	HeightMapGenerator fractalGenerator(resolution, noiseParameters);
+	fractalGenerator.generate(heightField, &threadPool);
+	benchmark("Simplex fractal, lossless", heightField, 0.0f, threadPool);
+	benchmark("Simplex fractal, 16 bit error", heightField, 0.5f / 65535.0f, threadPool);
+
+	// Generated straight into the compressed blocks
+	CompressedHeightField compressedHeightField(resolution, BENCHMARK_TILE_SIZE, 0.5f / 65535.0f, BENCHMARK_CACHED_BLOCKS);
+	const double generateSeconds = measureBestSeconds([&]() { compressedHeightField.generate(valueNoiseGenerator, &threadPool); });
+	std::cout << "Value noise generated compressed : " << generateSeconds * 1000.0 << " ms, " << compressedHeightField.getCompressedSize() / (1024.0 * 1024.0) << " MiB" << std::endl;
+
+	return 0;
+}
@@ -0,0 +1,114 @@
+// Standalone benchmark of the height pyramid ray casts (time of the rays cast one by one and of the batch raycast on the calling thread and on the
+// thread pool, agreement of their hits), not part of HeightMap.vcxproj (it has its own main)
+// Build from the HeightMap folder, for example:
+//   cl /O2 /EHsc /std:c++17 /I"..\Third Party\glm" /I. Benchmarks\RaycastBenchmark.cpp TerrainHeightPyramid.cpp HeightMapGenerator.cpp HeightField.cpp ValueNoiseKernel.cpp FractalNoise.cpp ThreadPool.cpp
+//   g++ -O2 -std=c++17 -pthread -I"../Third Party/glm" -I. Benchmarks/RaycastBenchmark.cpp TerrainHeightPyramid.cpp HeightMapGenerator.cpp HeightField.cpp ValueNoiseKernel.cpp FractalNoise.cpp ThreadPool.cpp
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "HeightMapGenerator.h"
+#include "TerrainHeightPyramid.h"
+
+#define BENCHMARK_RES 1024 // the resolution can be given on the command line
+#define BENCHMARK_TILE_SIZE 64
+#define BENCHMARK_WORLD_SIZE 512.0f // as the scene
+#define BENCHMARK_MAX_HEIGHT 50.0f
+#define BENCHMARK_REPEAT_COUNT 5
+#define BENCHMARK_RAY_COUNT (1 << 18)
+
+// Rays of a kind: origins over the terrain, directions from the generator
+template <typename DirectionGenerator>
+static std::vector<TerrainHeightPyramid::Ray> generateRays(float minHeight, float maxHeight, float maxDistance, DirectionGenerator directionGenerator)
+{
+	std::mt19937 random(1234);
+	std::uniform_real_distribution<float> positionDistribution(0.0f, BENCHMARK_WORLD_SIZE);
+	std::uniform_real_distribution<float> heightDistribution(minHeight, maxHeight);
+	std::vector<TerrainHeightPyramid::Ray> rays(BENCHMARK_RAY_COUNT);
+	for (TerrainHeightPyramid::Ray& ray : rays)
+	{
+		ray.origin = glm::vec3(positionDistribution(random), heightDistribution(random), positionDistribution(random));
+		ray.direction = directionGenerator(random);
+		ray.maxDistance = maxDistance;
+	}
+	return rays;
+}
+
+// Returns the best time of the casts in seconds, without batch the rays are cast one by one
+static double castRays(const TerrainHeightPyramid& pyramid, const std::vector<TerrainHeightPyramid::Ray>& rays, bool batch, ThreadPool* threadPool,
+	std::vector<TerrainHeightPyramid::RaycastHit>& outHits)
+{
+	outHits.assign(rays.size(), TerrainHeightPyramid::RaycastHit());
+	double bestSeconds = 1e30;
+	for (uint32_t repeat = 0; repeat < BENCHMARK_REPEAT_COUNT; ++repeat)
+	{
+		auto startTime = std::chrono::steady_clock::now();
+		if (batch)
+			pyramid.raycast(rays.data(), static_cast<uint32_t>(rays.size()), outHits.data(), threadPool);
+		else
+			for (size_t rayIndex = 0; rayIndex < rays.size(); ++rayIndex)
+				outHits[rayIndex] = pyramid.raycast(rays[rayIndex]);
+		bestSeconds = std::min(bestSeconds, std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count());
+	}
+	return bestSeconds;
+}
+
+static void runRays(const std::string& name, const TerrainHeightPyramid& pyramid, const std::vector<TerrainHeightPyramid::Ray>& rays, ThreadPool& threadPool)
+{
+	std::vector<TerrainHeightPyramid::RaycastHit> singleHits, batchHits, threadedHits;
+	const double singleSeconds = castRays(pyramid, rays, false, nullptr, singleHits);
+	const double batchSeconds = castRays(pyramid, rays, true, nullptr, batchHits);
+	const double threadedSeconds = castRays(pyramid, rays, true, &threadPool, threadedHits);
+
+	auto sameHits = [](const TerrainHeightPyramid::RaycastHit& a, const TerrainHeightPyramid::RaycastHit& b) { return a.hit == b.hit && a.distance == b.distance; };
+	const bool batchIdentical = std::equal(singleHits.begin(), singleHits.end(), batchHits.begin(), sameHits);
+	const bool threadedIdentical = std::equal(singleHits.begin(), singleHits.end(), threadedHits.begin(), sameHits);
+	const uint32_t hitCount = static_cast<uint32_t>(std::count_if(singleHits.begin(), singleHits.end(), [](const TerrainHeightPyramid::RaycastHit& hit) { return hit.hit; }));
+
+	const double rayCount = static_cast<double>(rays.size());
+	std::cout << name << ": " << 100.0 * hitCount / rayCount << " % hit, one by one " << rayCount / singleSeconds / 1e6 << " Mrays/s, batch " <<
+		rayCount / batchSeconds / 1e6 << " Mrays/s on 1 thread, " << rayCount / threadedSeconds / 1e6 << " Mrays/s on " << threadPool.getThreadCount() <<
+		" threads (x" << singleSeconds / threadedSeconds << ")" << std::endl;
+	std::cout << "  batch " << (batchIdentical ? "identical" : "DIFFERENT") << ", threaded batch " << (threadedIdentical ? "identical" : "DIFFERENT") << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+	const uint32_t resolution = argc > 1 ? static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 10)) : BENCHMARK_RES;
+	ThreadPool threadPool;
+	HeightField heightField(resolution, BENCHMARK_TILE_SIZE);
+	HeightMapGenerator heightMapGenerator(resolution);
+	heightMapGenerator.generate(heightField, &threadPool);
+
+	TerrainMeshBuilder::GridInfo gridInfo;
+	gridInfo.tileSize = glm::vec3(BENCHMARK_WORLD_SIZE / resolution, 0.0f, BENCHMARK_WORLD_SIZE / resolution);
+	gridInfo.maxHeight = BENCHMARK_MAX_HEIGHT;
+	TerrainHeightPyramid pyramid(heightField, gridInfo, &threadPool);
+	std::cout << "Height pyramid ray casts " << resolution << "x" << resolution << ", " << BENCHMARK_RAY_COUNT << " rays, best of " << BENCHMARK_REPEAT_COUNT << std::endl;
+
+	std::uniform_real_distribution<float> unitDistribution(-1.0f, 1.0f);
+	// Picking: from above the terrain, looking down
+	runRays("Picking", pyramid, generateRays(BENCHMARK_MAX_HEIGHT, 2.0f * BENCHMARK_MAX_HEIGHT, 1000.0f, [&](std::mt19937& random)
+	{
+		return glm::vec3(unitDistribution(random), -0.2f - std::abs(unitDistribution(random)), unitDistribution(random));
+	}), threadPool);
+	// Lines of sight: close to the surface, nearly horizontal, long
+	runRays("Grazing", pyramid, generateRays(0.0f, BENCHMARK_MAX_HEIGHT, 1000.0f, [&](std::mt19937& random)
+	{
+		return glm::vec3(unitDistribution(random), 0.05f * unitDistribution(random), unitDistribution(random));
+	}), threadPool);
+	// Along the axes and vertical: zero direction components
+	runRays("Axis aligned", pyramid, generateRays(0.0f, 2.0f * BENCHMARK_MAX_HEIGHT, 1000.0f, [&](std::mt19937& random)
+	{
+		static const glm::vec3 directions[] = { { 1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, -1.0f }, { 0.0f, -1.0f, 0.0f }, { -1.0f, -0.1f, 0.0f }, { 0.0f, -0.1f, 1.0f } };
+		return directions[random() % 5];
+	}), threadPool);
+
+	return 0;
+}
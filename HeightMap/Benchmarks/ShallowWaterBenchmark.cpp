@@ -0,0 +1,95 @@
+// Standalone benchmark of the shallow water simulation (time per step against the 60 Hz budget, determinism across thread counts, conservation of
+// the water volume), not part of HeightMap.vcxproj (it has its own main)
+// Build from the HeightMap folder, for example:
+//   cl /O2 /EHsc /std:c++17 /I"..\Third Party\glm" /I. Benchmarks\ShallowWaterBenchmark.cpp ShallowWater.cpp HeightMapGenerator.cpp HeightField.cpp ValueNoiseKernel.cpp FractalNoise.cpp ThreadPool.cpp
+//   g++ -O2 -std=c++17 -pthread -I"../Third Party/glm" -I. Benchmarks/ShallowWaterBenchmark.cpp ShallowWater.cpp HeightMapGenerator.cpp HeightField.cpp ValueNoiseKernel.cpp FractalNoise.cpp ThreadPool.cpp
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "HeightMapGenerator.h"
+#include "ShallowWater.h"
+
+#define BENCHMARK_RES 1024 // the resolution can be given on the command line
+#define BENCHMARK_TILE_SIZE 64
+#define BENCHMARK_WORLD_SIZE 512.0f // as the scene
+#define BENCHMARK_MAX_HEIGHT 50.0f
+#define BENCHMARK_STEPS 300 // 5 simulated seconds
+
+// Runs the steps and returns the best time of a step in seconds
+static double simulate(ShallowWater& shallowWater)
+{
+	double bestSeconds = 1e30;
+	for (uint32_t step = 0; step < BENCHMARK_STEPS; ++step)
+	{
+		// A spring on the terrain keeps water flowing during the whole run
+		if (step % 10 == 0)
+		{
+			const float center = static_cast<float>(shallowWater.getResolution()) * 0.5f;
+			shallowWater.addWater(center, center, static_cast<float>(shallowWater.getResolution()) / 16.0f, 0.5f);
+		}
+
+		auto startTime = std::chrono::steady_clock::now();
+		shallowWater.step();
+		bestSeconds = std::min(bestSeconds, std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count());
+	}
+	return bestSeconds;
+}
+
+static void printResult(const std::string& name, double stepSeconds)
+{
+	std::cout << name << " : " << stepSeconds * 1000.0 << " ms per step, " << 1.0 / stepSeconds << " steps/s, " << stepSeconds * 60.0 * 100.0 <<
+		" % of the 60 Hz frame budget" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+	const uint32_t resolution = argc > 1 ? static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 10)) : BENCHMARK_RES;
+	ThreadPool threadPool;
+	HeightField heightField(resolution, BENCHMARK_TILE_SIZE);
+	HeightMapGenerator heightMapGenerator(resolution);
+	heightMapGenerator.generate(heightField, &threadPool);
+
+	TerrainMeshBuilder::GridInfo gridInfo;
+	gridInfo.tileSize = glm::vec3(BENCHMARK_WORLD_SIZE / resolution, 0.0f, BENCHMARK_WORLD_SIZE / resolution);
+	gridInfo.maxHeight = BENCHMARK_MAX_HEIGHT;
+	std::cout << "Shallow water " << resolution << "x" << resolution << ", " << BENCHMARK_STEPS << " steps of " << SHALLOW_WATER_TIMESTEP * 1000.0f << " ms" << std::endl;
+
+	ShallowWater::Parameters parameters;
+	ShallowWater serialWater(heightField, gridInfo, parameters, nullptr);
+	printResult("1 thread", simulate(serialWater));
+	ShallowWater threadedWater(heightField, gridInfo, parameters, &threadPool);
+	printResult(std::to_string(threadPool.getThreadCount()) + " threads", simulate(threadedWater));
+
+	uint32_t differentCount = 0;
+	uint32_t wetCount = 0;
+	for (uint32_t i = 0; i < resolution; ++i)
+	{
+		for (uint32_t j = 0; j < resolution; ++j)
+		{
+			if (serialWater.getDepth(i, j) != threadedWater.getDepth(i, j))
+				++differentCount;
+			if (serialWater.getDepth(i, j) > 0.0f)
+				++wetCount;
+		}
+	}
+	std::cout << wetCount << " wet cells, " << differentCount << " depths differ between 1 and " << threadPool.getThreadCount() << " threads" << std::endl;
+
+	// Without evaporation the water only leaves through the removal of the shallowest depths
+	parameters.evaporationRate = 0.0f;
+	ShallowWater closedWater(heightField, gridInfo, parameters, &threadPool);
+	const float center = static_cast<float>(resolution) * 0.5f;
+	closedWater.addWater(center, center, static_cast<float>(resolution) / 8.0f, 4.0f);
+	const double initialVolume = closedWater.computeVolume();
+	for (uint32_t step = 0; step < BENCHMARK_STEPS; ++step)
+		closedWater.step();
+	std::cout << "Volume without evaporation: " << initialVolume << " -> " << closedWater.computeVolume() << " (" <<
+		100.0 * (closedWater.computeVolume() - initialVolume) / initialVolume << " %)" << std::endl;
+
+	return 0;
+}
@@ -0,0 +1,138 @@
+// Standalone micro-benchmark of the heightmap value noise, not part of HeightMap.vcxproj (it has its own main)
+// Build from the HeightMap folder, for example:
+//   cl /O2 /EHsc /std:c++17 /I"..\Third Party\glm" /I. Benchmarks\ValueNoiseBenchmark.cpp HeightMapGenerator.cpp HeightField.cpp ValueNoiseKernel.cpp FractalNoise.cpp ThreadPool.cpp
+//   g++ -O2 -std=c++17 -pthread -I"../Third Party/glm" -I. Benchmarks/ValueNoiseBenchmark.cpp HeightMapGenerator.cpp HeightField.cpp ValueNoiseKernel.cpp FractalNoise.cpp ThreadPool.cpp
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/glm.hpp>
+
+#include "HeightMapGenerator.h"
+
+#define BENCHMARK_RES 1024
+#define BENCHMARK_TILE_SIZE 64
+#define BENCHMARK_RUNS 10
+
+// The octave loop as it was in ::Scene::Scene before the kernel, kept as the reference
+static void generateReference(std::vector<float>& heightMap)
+{
+	auto rand = [](glm::vec2 co) { return glm::fract(glm::sin(glm::dot(co, glm::vec2(12.9898f, 78.233f))) * 43758.5453f); };
+
+	std::fill(heightMap.begin(), heightMap.end(), 0.0f);
+
+	float totalWeight = 0;
+	float weight = 1.0f;
+	for (int div = 2; div < BENCHMARK_RES; div *= 2)
+	{
+		for (int xFragment = 0; xFragment < div; ++xFragment)
+		{
+			for (int yFragment = 0; yFragment < div; ++yFragment)
+			{
+				float randNumber = rand(glm::vec2(xFragment, yFragment));
+				float randNumberNextX = rand(glm::vec2(xFragment + 1, yFragment));
+				float randNumberNextY = rand(glm::vec2(xFragment, yFragment + 1));
+				float randNumberNextXY = rand(glm::vec2(xFragment + 1, yFragment + 1));
+
+				for (int i = xFragment * (BENCHMARK_RES / div); i < (xFragment + 1) * (BENCHMARK_RES / div); ++i)
+				{
+					for (int j = yFragment * (BENCHMARK_RES / div); j < (yFragment + 1) * (BENCHMARK_RES / div); ++j)
+					{
+						float valueX1 = glm::mix(randNumber, randNumberNextX, ((float)i - ((float)xFragment * ((float)BENCHMARK_RES / (float)div))) / ((float)BENCHMARK_RES / (float)div));
+						float valueX2 = glm::mix(randNumberNextY, randNumberNextXY, ((float)i - ((float)xFragment * ((float)BENCHMARK_RES / (float)div))) / ((float)BENCHMARK_RES / (float)div));
+						float bilinearValue = glm::mix(valueX1, valueX2, ((float)j - (float)yFragment * (BENCHMARK_RES / div)) / ((float)BENCHMARK_RES / (float)div));
+						heightMap[i * BENCHMARK_RES + j] += bilinearValue * weight;
+					}
+				}
+			}
+		}
+		totalWeight += weight;
+		weight -= 0.1f;
+		weight = std::max(weight, 0.1f);
+	}
+
+	for (float& height : heightMap)
+		height /= totalWeight;
+}
+
+template <typename F>
+static void benchmark(const std::string& name, F generate, const HeightField* heightField, const std::vector<float>& reference)
+{
+	double bestSeconds = 1e30;
+	for (int run = 0; run < BENCHMARK_RUNS; ++run)
+	{
+		auto startTime = std::chrono::steady_clock::now();
+		generate();
+		bestSeconds = std::min(bestSeconds, std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count());
+	}
+
+	const double texelsPerSecond = static_cast<double>(BENCHMARK_RES) * BENCHMARK_RES / bestSeconds;
+	std::vector<float> heightMap(reference);
+	if (heightField)
+		heightField->copyToRowMajor(heightMap.data());
+	const bool identical = std::memcmp(heightMap.data(), reference.data(), heightMap.size() * sizeof(float)) == 0;
+	std::cout << name << " : " << bestSeconds * 1000.0 << " ms, " << texelsPerSecond / 1'000'000.0 << " Mtexels/s" << (identical ? "" : " (OUTPUT DIFFERS FROM REFERENCE)") << std::endl;
+}
+
+int main()
+{
+	std::vector<float> reference(BENCHMARK_RES * BENCHMARK_RES);
+	HeightField heightField(BENCHMARK_RES, BENCHMARK_TILE_SIZE);
+
+	benchmark("Reference (previous loop)", [&]() { generateReference(reference); }, nullptr, reference);
+
+	const ValueNoiseKernel::InstructionSet bestInstructionSet = ValueNoiseKernel::getBestInstructionSet();
+	for (ValueNoiseKernel::InstructionSet instructionSet : { ValueNoiseKernel::InstructionSet::SCALAR, ValueNoiseKernel::InstructionSet::SSE, ValueNoiseKernel::InstructionSet::AVX })
+	{
+		if (static_cast<int>(instructionSet) > static_cast<int>(bestInstructionSet))
+			break;
+
+		benchmark(std::string("Kernel ") + ValueNoiseKernel::getInstructionSetName(instructionSet) + ", 1 thread", [&]()
+		{
+			HeightMapGenerator heightMapGenerator(BENCHMARK_RES);
+			heightMapGenerator.generate(heightField, nullptr, instructionSet);
+		}, &heightField, reference);
+	}
+
+	ThreadPool threadPool;
+	benchmark(std::string("Kernel ") + ValueNoiseKernel::getInstructionSetName(bestInstructionSet) + ", " + std::to_string(threadPool.getThreadCount()) + " threads", [&]()
+	{
+		HeightMapGenerator heightMapGenerator(BENCHMARK_RES);
+		heightMapGenerator.generate(heightField, &threadPool);
+	}, &heightField, reference);
+
+	// Seeded fractal noise: the scalar generation is the reference of the vectorized one
+	const std::pair<FractalNoise::Type, const char*> noiseTypes[] = { { FractalNoise::Type::VALUE, "value" }, { FractalNoise::Type::GRADIENT, "gradient" },
+		{ FractalNoise::Type::SIMPLEX, "simplex" } };
+	for (const std::pair<FractalNoise::Type, const char*>& noiseType : noiseTypes)
+	{
+		FractalNoise::Parameters noiseParameters;
+		noiseParameters.type = noiseType.first;
+		HeightMapGenerator heightMapGenerator(BENCHMARK_RES, noiseParameters);
+
+		benchmark(std::string("Fractal ") + noiseType.second + " scalar, 1 thread", [&]()
+		{
+			heightMapGenerator.generate(heightField, nullptr, ValueNoiseKernel::InstructionSet::SCALAR);
+		}, nullptr, reference);
+		heightField.copyToRowMajor(reference.data());
+
+		benchmark(std::string("Fractal ") + noiseType.second + " " + ValueNoiseKernel::getInstructionSetName(bestInstructionSet) + ", 1 thread", [&]()
+		{
+			heightMapGenerator.generate(heightField, nullptr, bestInstructionSet);
+		}, &heightField, reference);
+		benchmark(std::string("Fractal ") + noiseType.second + " " + ValueNoiseKernel::getInstructionSetName(bestInstructionSet) + ", " +
+			std::to_string(threadPool.getThreadCount()) + " threads", [&]()
+		{
+			heightMapGenerator.generate(heightField, &threadPool, bestInstructionSet);
+		}, &heightField, reference);
+	}
+
+	return 0;
+}
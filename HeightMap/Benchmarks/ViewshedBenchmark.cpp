@@ -0,0 +1,119 @@
+// Standalone benchmark of the viewshed (time of a mask from the center and from a corner, determinism across thread counts, agreement with a line
+// of sight cast to each sample), not part of HeightMap.vcxproj (it has its own main)
+// Build from the HeightMap folder, for example:
+//   cl /O2 /EHsc /std:c++17 /I"..\Third Party\glm" /I. Benchmarks\ViewshedBenchmark.cpp TerrainViewshed.cpp HeightMapGenerator.cpp HeightField.cpp ValueNoiseKernel.cpp FractalNoise.cpp ThreadPool.cpp
+//   g++ -O2 -std=c++17 -pthread -I"../Third Party/glm" -I. Benchmarks/ViewshedBenchmark.cpp TerrainViewshed.cpp HeightMapGenerator.cpp HeightField.cpp ValueNoiseKernel.cpp FractalNoise.cpp ThreadPool.cpp
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "HeightMapGenerator.h"
+#include "TerrainViewshed.h"
+
+#define BENCHMARK_RES 1024 // the resolution can be given on the command line
+#define BENCHMARK_TILE_SIZE 64
+#define BENCHMARK_WORLD_SIZE 512.0f // as the scene
+#define BENCHMARK_MAX_HEIGHT 50.0f
+#define BENCHMARK_REPEAT_COUNT 5
+#define BENCHMARK_REFERENCE_SAMPLE_COUNT 20000
+
+// Returns the best time of a viewshed in seconds
+static double computeViewshed(const TerrainViewshed& viewshed, const TerrainViewshed::Observer& observer, ThreadPool* threadPool, std::vector<uint8_t>& outMask,
+	uint32_t& outVisibleCount)
+{
+	double bestSeconds = 1e30;
+	for (uint32_t repeat = 0; repeat < BENCHMARK_REPEAT_COUNT; ++repeat)
+	{
+		auto startTime = std::chrono::steady_clock::now();
+		outVisibleCount = viewshed.compute(observer, outMask, threadPool);
+		bestSeconds = std::min(bestSeconds, std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count());
+	}
+	return bestSeconds;
+}
+
+// Line of sight to the sample (i, j) alone (R3): the terrain interpolated where the line crosses each row or column of samples stays below it
+static bool isVisible(const HeightField& heightField, const TerrainMeshBuilder::GridInfo& gridInfo, int64_t observerI, int64_t observerJ, int64_t i, int64_t j,
+	const TerrainViewshed::Observer& observer)
+{
+	const int64_t resolution = heightField.getResolution();
+	auto getHeight = [&](int64_t sampleI, int64_t sampleJ) { return static_cast<double>(heightField.get(static_cast<uint32_t>(sampleI), static_cast<uint32_t>(sampleJ))) * gridInfo.maxHeight; };
+	const double eyeHeight = getHeight(observerI, observerJ) + observer.observerHeight;
+	const double targetHeight = getHeight(i, j) + observer.targetHeight;
+	const int64_t di = i - observerI;
+	const int64_t dj = j - observerJ;
+	const bool majorI = std::abs(di) >= std::abs(dj);
+	const int64_t steps = majorI ? std::abs(di) : std::abs(dj);
+	for (int64_t s = 1; s < steps; ++s)
+	{
+		const double t = static_cast<double>(s) / static_cast<double>(steps);
+		const double minor = (majorI ? static_cast<double>(dj) : static_cast<double>(di)) * t;
+		const int64_t minorFloor = static_cast<int64_t>(std::floor(minor));
+		const double weight = minor - static_cast<double>(minorFloor);
+		const int64_t majorSample = (majorI ? observerI + (di > 0 ? s : -s) : observerJ + (dj > 0 ? s : -s));
+		const int64_t minorSample = (majorI ? observerJ : observerI) + minorFloor;
+		auto getLineHeight = [&](int64_t sampleMinor) { return majorI ? getHeight(majorSample, sampleMinor) : getHeight(sampleMinor, majorSample); };
+		double height = getLineHeight(std::max(minorSample, static_cast<int64_t>(0)));
+		if (weight > 0.0 && minorSample + 1 < resolution)
+			height += (getLineHeight(minorSample + 1) - height) * weight;
+		if (height > eyeHeight + (targetHeight - eyeHeight) * t)
+			return false;
+	}
+	return true;
+}
+
+static void runObserver(const std::string& name, const HeightField& heightField, const TerrainMeshBuilder::GridInfo& gridInfo, ThreadPool& threadPool,
+	int64_t observerI, int64_t observerJ)
+{
+	const uint32_t resolution = heightField.getResolution();
+	TerrainViewshed viewshed(heightField, gridInfo);
+	TerrainViewshed::Observer observer;
+	observer.x = gridInfo.topLeftPos.x + static_cast<float>(observerI) * gridInfo.tileSize.x;
+	observer.z = gridInfo.topLeftPos.z + static_cast<float>(observerJ) * gridInfo.tileSize.z;
+
+	std::vector<uint8_t> serialMask, threadedMask;
+	uint32_t serialVisibleCount, threadedVisibleCount;
+	const double serialSeconds = computeViewshed(viewshed, observer, nullptr, serialMask, serialVisibleCount);
+	const double threadedSeconds = computeViewshed(viewshed, observer, &threadPool, threadedMask, threadedVisibleCount);
+	std::cout << name << ": " << serialSeconds * 1000.0 << " ms on 1 thread, " << threadedSeconds * 1000.0 << " ms on " << threadPool.getThreadCount() <<
+		" threads, " << 100.0 * serialVisibleCount / (static_cast<double>(resolution) * resolution) << " % visible, masks " <<
+		(serialMask == threadedMask && serialVisibleCount == threadedVisibleCount ? "identical" : "DIFFERENT") << std::endl;
+
+	std::mt19937 random(1234);
+	std::uniform_int_distribution<int64_t> sampleDistribution(0, resolution - 1);
+	uint32_t agreeCount = 0;
+	for (uint32_t sample = 0; sample < BENCHMARK_REFERENCE_SAMPLE_COUNT; ++sample)
+	{
+		const int64_t i = sampleDistribution(random);
+		const int64_t j = sampleDistribution(random);
+		if ((serialMask[i * resolution + j] != 0) == isVisible(heightField, gridInfo, observerI, observerJ, i, j, observer))
+			++agreeCount;
+	}
+	std::cout << "  agreement with the line of sight to each sample: " << 100.0 * agreeCount / BENCHMARK_REFERENCE_SAMPLE_COUNT << " % of " <<
+		BENCHMARK_REFERENCE_SAMPLE_COUNT << " random samples" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+	const uint32_t resolution = argc > 1 ? static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 10)) : BENCHMARK_RES;
+	ThreadPool threadPool;
+	HeightField heightField(resolution, BENCHMARK_TILE_SIZE);
+	HeightMapGenerator heightMapGenerator(resolution);
+	heightMapGenerator.generate(heightField, &threadPool);
+
+	TerrainMeshBuilder::GridInfo gridInfo;
+	gridInfo.tileSize = glm::vec3(BENCHMARK_WORLD_SIZE / resolution, 0.0f, BENCHMARK_WORLD_SIZE / resolution);
+	gridInfo.maxHeight = BENCHMARK_MAX_HEIGHT;
+	std::cout << "Viewshed " << resolution << "x" << resolution << ", best of " << BENCHMARK_REPEAT_COUNT << std::endl;
+
+	runObserver("Center", heightField, gridInfo, threadPool, resolution / 2, resolution / 2);
+	runObserver("Corner", heightField, gridInfo, threadPool, 0, 0);
+	runObserver("Off center", heightField, gridInfo, threadPool, resolution / 3, 2 * resolution / 3);
+
+	return 0;
+}
@@ -83,6 +83,8 @@ glm::mat4 Camera::getProjection()
 
 void Camera::setPosition(glm::vec3 position)
 {
+	m_position = position;
+	m_target = m_position + m_orientation;
 }
 
 void Camera::setTarget(glm::vec3 target)
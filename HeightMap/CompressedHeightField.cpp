@@ -0,0 +1,438 @@
+#include "CompressedHeightField.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Bits are appended from the least significant one, 32 at a time
+struct BitWriter
+{
+	std::vector<uint8_t>& data;
+	uint64_t bits = 0;
+	uint32_t bitCount = 0;
+
+	explicit BitWriter(std::vector<uint8_t>& outData) : data(outData) {}
+
+	// value must fit in count bits, count is at most 32
+	void write(uint32_t value, uint32_t count)
+	{
+		bits |= static_cast<uint64_t>(value) << bitCount;
+		bitCount += count;
+		if (bitCount >= 32)
+		{
+			for (uint32_t byte = 0; byte < 4; ++byte)
+				data.push_back(static_cast<uint8_t>(bits >> (8 * byte)));
+			bits >>= 32;
+			bitCount -= 32;
+		}
+	}
+
+	void flush()
+	{
+		while (bitCount > 0)
+		{
+			data.push_back(static_cast<uint8_t>(bits));
+			bits >>= 8;
+			bitCount = bitCount > 8 ? bitCount - 8 : 0;
+		}
+	}
+};
+
+// Past the end of the data the reader sees zeros. A valid stream never reads them
+struct BitReader
+{
+	const uint8_t* data;
+	size_t size;
+	size_t position = 0;
+	uint64_t bits = 0;
+	uint32_t bitCount = 0;
+
+	BitReader(const uint8_t* inData, size_t inSize) : data(inData), size(inSize) {}
+
+	// At least 56 bits are buffered after a refill
+	void refill()
+	{
+		if (position + 8 <= size)
+		{
+			// Little-endian load: the bytes above bitCount are loaded again by the next refill, at the same place
+			uint64_t word;
+			std::memcpy(&word, data + position, sizeof(word));
+			bits |= word << bitCount;
+			const uint32_t byteCount = (63 - bitCount) >> 3;
+			position += byteCount;
+			bitCount += byteCount * 8;
+			return;
+		}
+		for (; bitCount < 56; bitCount += 8, ++position)
+			bits |= static_cast<uint64_t>(position < size ? data[position] : 0) << bitCount;
+	}
+
+	void skip(uint32_t count)
+	{
+		bits >>= count;
+		bitCount -= count;
+	}
+
+	// count is at most 32
+	uint32_t read(uint32_t count)
+	{
+		refill();
+		const uint32_t value = static_cast<uint32_t>(bits & ((1ull << count) - 1));
+		skip(count);
+		return value;
+	}
+};
+
+static uint32_t countTrailingZeros(uint64_t value)
+{
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanForward64(&index, value);
+	return static_cast<uint32_t>(index);
+#else
+	return static_cast<uint32_t>(__builtin_ctzll(value));
+#endif
+}
+
+CompressedHeightField::CompressedHeightField(uint32_t resolution, uint32_t blockSize, float maxError, uint32_t cachedBlockCount) : m_resolution(resolution),
+	m_blockSize(blockSize), m_blockCountPerSide(resolution / blockSize), m_maxError(maxError), m_quantizationStep(2.0f * maxError),
+	m_cacheShardCount(std::max(std::min(cachedBlockCount, static_cast<uint32_t>(COMPRESSED_HEIGHT_FIELD_MAX_CACHE_SHARD_COUNT)), 1u))
+{
+	m_cacheShards.reset(new CacheShard[m_cacheShardCount]);
+	for (uint32_t shardIndex = 0; shardIndex < m_cacheShardCount; ++shardIndex)
+		m_cacheShards[shardIndex].cachedBlockCount = cachedBlockCount / m_cacheShardCount + (shardIndex < cachedBlockCount % m_cacheShardCount ? 1 : 0);
+	m_blocks.resize(static_cast<size_t>(m_blockCountPerSide) * m_blockCountPerSide);
+
+	// Blocks never set decode to zeros, as a new HeightField
+	const std::vector<float> zeros(static_cast<size_t>(m_blockSize) * m_blockSize, 0.0f);
+	setBlock(0, 0, zeros.data());
+	for (std::vector<uint8_t>& block : m_blocks)
+		block = m_blocks[0];
+}
+
+size_t CompressedHeightField::getCompressedSize() const
+{
+	size_t size = 0;
+	for (const std::vector<uint8_t>& block : m_blocks)
+		size += block.size();
+	return size;
+}
+
+void CompressedHeightField::setBlock(uint32_t blockI, uint32_t blockJ, const float* block)
+{
+	const uint32_t blockIndex = blockI * m_blockCountPerSide + blockJ;
+	std::vector<int32_t> codes(static_cast<size_t>(m_blockSize) * m_blockSize);
+	for (size_t k = 0; k < codes.size(); ++k)
+		codes[k] = toCode(block[k]);
+
+	std::vector<uint8_t> data;
+	data.reserve(codes.size());
+	BitWriter writer(data);
+	std::vector<uint32_t> residuals(m_blockSize);
+	for (uint32_t i = 0; i < m_blockSize; ++i)
+	{
+		// Residuals modulo 2^32, zigzag mapped so that small negative residuals are small too
+		uint64_t residualSum = 0;
+		for (uint32_t j = 0; j < m_blockSize; ++j)
+		{
+			const uint32_t residual = static_cast<uint32_t>(codes[i * m_blockSize + j]) - static_cast<uint32_t>(predict(codes.data(), m_blockSize, i, j));
+			residuals[j] = (residual << 1) ^ static_cast<uint32_t>(static_cast<int32_t>(residual) >> 31);
+			residualSum += residuals[j];
+		}
+
+		// Smallest Rice parameter with 2^k * sampleCount >= sum, as in LOCO-I
+		uint32_t riceParameter = 0;
+		while (riceParameter < 31 && (static_cast<uint64_t>(m_blockSize) << riceParameter) < residualSum)
+			++riceParameter;
+		writer.write(riceParameter, 5);
+
+		// Quotient in unary (zeros ended by a one), then the low bits
+		for (uint32_t j = 0; j < m_blockSize; ++j)
+		{
+			const uint32_t quotient = residuals[j] >> riceParameter;
+			if (quotient < COMPRESSED_HEIGHT_FIELD_ESCAPE_LENGTH)
+			{
+				writer.write(1u << quotient, quotient + 1);
+				writer.write(residuals[j] & ((1u << riceParameter) - 1), riceParameter);
+			}
+			else
+			{
+				writer.write(0, COMPRESSED_HEIGHT_FIELD_ESCAPE_LENGTH);
+				writer.write(residuals[j], 32);
+			}
+		}
+	}
+	writer.flush();
+	data.shrink_to_fit();
+	m_blocks[blockIndex] = std::move(data);
+
+	CacheShard& shard = getCacheShard(blockIndex);
+	std::lock_guard<std::mutex> lock(shard.mutex);
+	const auto cachedBlock = shard.cachedBlocks.find(blockIndex);
+	if (cachedBlock != shard.cachedBlocks.end())
+	{
+		const uint32_t entryIndex = cachedBlock->second;
+		shard.cachedBlocks.erase(cachedBlock);
+		if (entryIndex != shard.entries.size() - 1)
+		{
+			shard.entries[entryIndex] = std::move(shard.entries.back());
+			shard.cachedBlocks[shard.entries[entryIndex].blockIndex] = entryIndex;
+		}
+		shard.entries.pop_back();
+	}
+}
+
+void CompressedHeightField::decodeBlock(uint32_t blockI, uint32_t blockJ, float* outBlock) const
+{
+	const std::vector<uint8_t>& data = m_blocks[blockI * m_blockCountPerSide + blockJ];
+	BitReader reader(data.data(), data.size());
+	std::vector<int32_t> codes(static_cast<size_t>(m_blockSize) * m_blockSize);
+	const uint64_t escapeMask = (1ull << COMPRESSED_HEIGHT_FIELD_ESCAPE_LENGTH) - 1;
+	auto readResidual = [&](uint32_t riceParameter)
+	{
+		reader.refill();
+		uint32_t residual;
+		if ((reader.bits & escapeMask) == 0)
+		{
+			reader.skip(COMPRESSED_HEIGHT_FIELD_ESCAPE_LENGTH);
+			residual = reader.read(32);
+		}
+		else
+		{
+			// The quotient and the low bits are within the 56 buffered bits
+			const uint32_t quotient = countTrailingZeros(reader.bits);
+			reader.skip(quotient + 1);
+			residual = (quotient << riceParameter) | static_cast<uint32_t>(reader.bits & ((1ull << riceParameter) - 1));
+			reader.skip(riceParameter);
+		}
+		return (residual >> 1) ^ (0u - (residual & 1));
+	};
+
+	// predict() with the first row and column taken out of the loop
+	for (uint32_t i = 0; i < m_blockSize; ++i)
+	{
+		const uint32_t riceParameter = reader.read(5);
+		int32_t* row = &codes[i * m_blockSize];
+		const int32_t* previousRow = row - m_blockSize;
+		row[0] = static_cast<int32_t>((i == 0 ? 0u : static_cast<uint32_t>(previousRow[0])) + readResidual(riceParameter));
+		for (uint32_t j = 1; j < m_blockSize; ++j)
+		{
+			const uint32_t prediction = static_cast<uint32_t>(i == 0 ? row[j - 1] : predictMedian(row[j - 1], previousRow[j], previousRow[j - 1]));
+			row[j] = static_cast<int32_t>(prediction + readResidual(riceParameter));
+		}
+	}
+
+	if (m_quantizationStep > 0.0f)
+		for (size_t k = 0; k < codes.size(); ++k)
+			outBlock[k] = static_cast<float>(codes[k]) * m_quantizationStep;
+	else
+		for (size_t k = 0; k < codes.size(); ++k)
+			outBlock[k] = fromCode(codes[k]);
+}
+
+std::shared_ptr<const std::vector<float>> CompressedHeightField::getBlock(uint32_t blockI, uint32_t blockJ) const
+{
+	const uint32_t blockIndex = blockI * m_blockCountPerSide + blockJ;
+	CacheShard& shard = getCacheShard(blockIndex);
+	{
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		++shard.useCount;
+		const auto cachedBlock = shard.cachedBlocks.find(blockIndex);
+		if (cachedBlock != shard.cachedBlocks.end())
+		{
+			++shard.hitCount;
+			shard.entries[cachedBlock->second].lastUse = shard.useCount;
+			return shard.entries[cachedBlock->second].heights;
+		}
+		++shard.missCount;
+	}
+
+	// Decoded outside of the lock, other threads keep using the shard meanwhile
+	std::shared_ptr<std::vector<float>> heights = std::make_shared<std::vector<float>>(static_cast<size_t>(m_blockSize) * m_blockSize);
+	decodeBlock(blockI, blockJ, heights->data());
+	if (shard.cachedBlockCount == 0)
+		return heights;
+
+	std::lock_guard<std::mutex> lock(shard.mutex);
+	const auto cachedBlock = shard.cachedBlocks.find(blockIndex);
+	if (cachedBlock != shard.cachedBlocks.end())
+		return shard.entries[cachedBlock->second].heights;
+
+	uint32_t entryIndex = static_cast<uint32_t>(shard.entries.size());
+	if (shard.entries.size() < shard.cachedBlockCount)
+		shard.entries.push_back(CacheEntry());
+	else
+	{
+		// The shards are small: a linear search of the least recently used block is cheaper than keeping a list
+		entryIndex = 0;
+		for (uint32_t otherEntryIndex = 1; otherEntryIndex < shard.entries.size(); ++otherEntryIndex)
+			if (shard.entries[otherEntryIndex].lastUse < shard.entries[entryIndex].lastUse)
+				entryIndex = otherEntryIndex;
+		shard.cachedBlocks.erase(shard.entries[entryIndex].blockIndex);
+	}
+	shard.entries[entryIndex] = { blockIndex, shard.useCount, heights };
+	shard.cachedBlocks[blockIndex] = entryIndex;
+
+	return heights;
+}
+
+float CompressedHeightField::get(uint32_t i, uint32_t j) const
+{
+	const uint32_t blockMask = m_blockSize - 1;
+	return (*getBlock(i / m_blockSize, j / m_blockSize))[(i & blockMask) * m_blockSize + (j & blockMask)];
+}
+
+void CompressedHeightField::copyRow(uint32_t i, uint32_t firstColumn, uint32_t count, float* heights) const
+{
+	const uint32_t blockMask = m_blockSize - 1;
+	const uint32_t endColumn = firstColumn + count;
+	for (uint32_t j = firstColumn; j < endColumn;)
+	{
+		const uint32_t spanEnd = std::min((j & ~blockMask) + m_blockSize, endColumn);
+		const std::shared_ptr<const std::vector<float>> block = getBlock(i / m_blockSize, j / m_blockSize);
+		const float* blockRow = block->data() + (i & blockMask) * m_blockSize;
+		std::copy(blockRow + (j & blockMask), blockRow + (j & blockMask) + (spanEnd - j), heights + (j - firstColumn));
+		j = spanEnd;
+	}
+}
+
+uint64_t CompressedHeightField::getCacheHitCount() const
+{
+	uint64_t hitCount = 0;
+	for (uint32_t shardIndex = 0; shardIndex < m_cacheShardCount; ++shardIndex)
+	{
+		std::lock_guard<std::mutex> lock(m_cacheShards[shardIndex].mutex);
+		hitCount += m_cacheShards[shardIndex].hitCount;
+	}
+	return hitCount;
+}
+
+uint64_t CompressedHeightField::getCacheMissCount() const
+{
+	uint64_t missCount = 0;
+	for (uint32_t shardIndex = 0; shardIndex < m_cacheShardCount; ++shardIndex)
+	{
+		std::lock_guard<std::mutex> lock(m_cacheShards[shardIndex].mutex);
+		missCount += m_cacheShards[shardIndex].missCount;
+	}
+	return missCount;
+}
+
+float CompressedHeightField::Reader::get(uint32_t i, uint32_t j)
+{
+	const uint32_t blockSize = m_heightField.m_blockSize;
+	const uint32_t blockMask = blockSize - 1;
+	const uint32_t blockIndex = (i / blockSize) * m_heightField.m_blockCountPerSide + j / blockSize;
+	if (blockIndex != m_blockIndex)
+	{
+		m_block = m_heightField.getBlock(i / blockSize, j / blockSize);
+		m_blockIndex = blockIndex;
+	}
+	return (*m_block)[(i & blockMask) * blockSize + (j & blockMask)];
+}
+
+void CompressedHeightField::compress(const HeightField& heightField, ThreadPool* threadPool)
+{
+	auto compressBlock = [&](uint32_t blockIndex)
+	{
+		const uint32_t blockI = blockIndex / m_blockCountPerSide;
+		const uint32_t blockJ = blockIndex % m_blockCountPerSide;
+		setBlock(blockI, blockJ, heightField.getBlock(blockI, blockJ));
+	};
+
+	if (threadPool)
+		threadPool->parallelFor(static_cast<uint32_t>(m_blocks.size()), compressBlock);
+	else
+		for (uint32_t blockIndex = 0; blockIndex < m_blocks.size(); ++blockIndex)
+			compressBlock(blockIndex);
+}
+
+void CompressedHeightField::generate(HeightMapGenerator& generator, ThreadPool* threadPool)
+{
+	generator.prepareOctaves(threadPool);
+
+	const ValueNoiseKernel::InstructionSet instructionSet = ValueNoiseKernel::getBestInstructionSet();
+	auto generateBlock = [&](uint32_t blockIndex)
+	{
+		const uint32_t blockI = blockIndex / m_blockCountPerSide;
+		const uint32_t blockJ = blockIndex % m_blockCountPerSide;
+		std::vector<float> block(static_cast<size_t>(m_blockSize) * m_blockSize);
+		generator.generateTile(block.data(), m_blockSize, blockI, blockJ, instructionSet);
+		setBlock(blockI, blockJ, block.data());
+	};
+
+	if (threadPool)
+		threadPool->parallelFor(static_cast<uint32_t>(m_blocks.size()), generateBlock);
+	else
+		for (uint32_t blockIndex = 0; blockIndex < m_blocks.size(); ++blockIndex)
+			generateBlock(blockIndex);
+}
+
+void CompressedHeightField::decompress(HeightField& heightField, ThreadPool* threadPool) const
+{
+	auto decompressBlock = [&](uint32_t blockIndex)
+	{
+		const uint32_t blockI = blockIndex / m_blockCountPerSide;
+		const uint32_t blockJ = blockIndex % m_blockCountPerSide;
+		decodeBlock(blockI, blockJ, heightField.getBlock(blockI, blockJ));
+	};
+
+	if (threadPool)
+		threadPool->parallelFor(static_cast<uint32_t>(m_blocks.size()), decompressBlock);
+	else
+		for (uint32_t blockIndex = 0; blockIndex < m_blocks.size(); ++blockIndex)
+			decompressBlock(blockIndex);
+}
+
+int32_t CompressedHeightField::toCode(float height) const
+{
+	if (m_quantizationStep > 0.0f)
+	{
+		const double quantized = std::round(static_cast<double>(height) / m_quantizationStep);
+		return static_cast<int32_t>(std::min(std::max(quantized, static_cast<double>(std::numeric_limits<int32_t>::min())),
+			static_cast<double>(std::numeric_limits<int32_t>::max())));
+	}
+
+	// The float bits, ordered as the floats: close heights have close codes
+	int32_t code;
+	std::memcpy(&code, &height, sizeof(code));
+	return code < 0 ? code ^ 0x7FFFFFFF : code;
+}
+
+float CompressedHeightField::fromCode(int32_t code) const
+{
+	if (m_quantizationStep > 0.0f)
+		return static_cast<float>(code) * m_quantizationStep;
+
+	code = code < 0 ? code ^ 0x7FFFFFFF : code;
+	float height;
+	std::memcpy(&height, &code, sizeof(height));
+	return height;
+}
+
+int32_t CompressedHeightField::predict(const int32_t* codes, uint32_t blockSize, uint32_t i, uint32_t j)
+{
+	if (i == 0)
+		return j == 0 ? 0 : codes[j - 1];
+	if (j == 0)
+		return codes[(i - 1) * blockSize];
+
+	return predictMedian(codes[i * blockSize + j - 1], codes[(i - 1) * blockSize + j], codes[(i - 1) * blockSize + j - 1]);
+}
+
+int32_t CompressedHeightField::predictMedian(int32_t left, int32_t top, int32_t topLeft)
+{
+	// Median edge detector: the smaller neighbour above an edge, the larger below, the plane through the three otherwise
+	const int32_t minimum = std::min(left, top);
+	const int32_t maximum = std::max(left, top);
+	if (topLeft >= maximum)
+		return minimum;
+	if (topLeft <= minimum)
+		return maximum;
+	return static_cast<int32_t>(static_cast<int64_t>(left) + top - topLeft);
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "HeightField.h"
+#include "HeightMapGenerator.h"
+#include "ThreadPool.h"
+
+#define COMPRESSED_HEIGHT_FIELD_ESCAPE_LENGTH 24 // unary quotients reaching this length are written as a raw 32 bit residual instead
+#define COMPRESSED_HEIGHT_FIELD_MAX_CACHE_SHARD_COUNT 16 // the cached blocks are split between up to this many LRU caches with a lock each
+
+// HeightField with the blocks kept compressed in memory, for resolutions whose floats don't fit in RAM.
+// Each block is coded on its own: a sample is predicted from its left, top and top-left neighbours (median edge detector of LOCO-I), and the
+// residuals are Rice coded with one parameter per row of the block. Lossless when maxError is 0 (the float bits are coded), otherwise the heights
+// are quantized to steps of 2 * maxError first.
+// The last decoded blocks are kept in small LRU caches shared by all threads, a block always goes to the same cache (shard) picked by a hash of its
+// index so that neighbouring blocks are spread over the shards.
+// The read methods are the ones of HeightField (get, getBlock, copyRow), sample queries of a thread go through a Reader
+class CompressedHeightField
+{
+public:
+	// Handle for the sample queries of one thread: keeps the block of its last query, only a query in another block goes through the cache.
+	// The block kept is the one at the time of the query, as for getBlock
+	class Reader
+	{
+	public:
+		explicit Reader(const CompressedHeightField& heightField) : m_heightField(heightField) {}
+
+		float get(uint32_t i, uint32_t j);
+
+	private:
+		const CompressedHeightField& m_heightField;
+		uint32_t m_blockIndex = UINT32_MAX;
+		std::shared_ptr<const std::vector<float>> m_block;
+	};
+
+	// blockSize must be a power of 2 and resolution a multiple of it
+	CompressedHeightField(uint32_t resolution, uint32_t blockSize, float maxError, uint32_t cachedBlockCount);
+
+	uint32_t getResolution() const { return m_resolution; }
+	uint32_t getBlockSize() const { return m_blockSize; }
+	uint32_t getBlockCountPerSide() const { return m_blockCountPerSide; }
+	float getMaxError() const { return m_maxError; }
+	// Bytes of all the compressed blocks
+	size_t getCompressedSize() const;
+
+	// Different blocks can be set concurrently, the cached copy of the block is dropped
+	void setBlock(uint32_t blockI, uint32_t blockJ, const float* block);
+	// Decodes without going through the cache, block as in HeightField::getBlock
+	void decodeBlock(uint32_t blockI, uint32_t blockJ, float* outBlock) const;
+
+	// Decoded block from the cache, which keeps it alive even once evicted
+	std::shared_ptr<const std::vector<float>> getBlock(uint32_t blockI, uint32_t blockJ) const;
+	// Goes through the cache for each sample: for scattered queries, a thread with many queries should use a Reader and sweeps getBlock or copyRow
+	float get(uint32_t i, uint32_t j) const;
+	// Samples (i, firstColumn) ... (i, firstColumn + count - 1), one cache query per block
+	void copyRow(uint32_t i, uint32_t firstColumn, uint32_t count, float* heights) const;
+	uint64_t getCacheHitCount() const;
+	uint64_t getCacheMissCount() const;
+
+	void compress(const HeightField& heightField, ThreadPool* threadPool);
+	// Heights of the generator (same resolution), each block compressed as soon as it is generated: the floats of the whole heightfield are never allocated
+	void generate(HeightMapGenerator& generator, ThreadPool* threadPool);
+	void decompress(HeightField& heightField, ThreadPool* threadPool) const;
+
+private:
+	int32_t toCode(float height) const;
+	float fromCode(int32_t code) const;
+	static int32_t predict(const int32_t* codes, uint32_t blockSize, uint32_t i, uint32_t j);
+	static int32_t predictMedian(int32_t left, int32_t top, int32_t topLeft);
+
+private:
+	uint32_t m_resolution;
+	uint32_t m_blockSize;
+	uint32_t m_blockCountPerSide;
+	float m_maxError;
+	float m_quantizationStep;
+
+	std::vector<std::vector<uint8_t>> m_blocks;
+
+	struct CacheEntry
+	{
+		uint32_t blockIndex;
+		uint64_t lastUse;
+		std::shared_ptr<const std::vector<float>> heights;
+	};
+	struct CacheShard
+	{
+		std::mutex mutex;
+		std::vector<CacheEntry> entries;
+		std::unordered_map<uint32_t, uint32_t> cachedBlocks; // block index to cache entry
+		uint32_t cachedBlockCount = 0;
+		uint64_t useCount = 0;
+		uint64_t hitCount = 0;
+		uint64_t missCount = 0;
+	};
+	CacheShard& getCacheShard(uint32_t blockIndex) const { return m_cacheShards[((blockIndex * 2654435761u) >> 16) % m_cacheShardCount]; }
+
+	uint32_t m_cacheShardCount;
+	mutable std::unique_ptr<CacheShard[]> m_cacheShards;
+};
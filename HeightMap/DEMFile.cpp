@@ -0,0 +1,149 @@
+#include "DEMFile.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <vector>
+
+bool DEMFile::open(const std::string& filename, uint32_t rawWidth)
+{
+	m_samples = nullptr;
+	m_width = 0;
+	m_height = 0;
+	if (!m_file.open(filename))
+		return false;
+
+	const uint8_t* data = m_file.getData();
+	const size_t size = m_file.getSize();
+	if (size >= 2 && data[0] == 'P' && data[1] == '5')
+	{
+		if (!parsePGMHeader())
+		{
+			m_file.close();
+			m_width = 0;
+			m_height = 0;
+			return false;
+		}
+		return true;
+	}
+
+	// RAW
+	const size_t sampleCount = size / sizeof(uint16_t);
+	m_width = rawWidth ? rawWidth : static_cast<uint32_t>(std::llround(std::sqrt(static_cast<double>(sampleCount))));
+	m_height = m_width ? static_cast<uint32_t>(sampleCount / m_width) : 0;
+	if (m_width == 0 || m_height == 0 || (rawWidth == 0 && static_cast<size_t>(m_width) * m_width != sampleCount))
+	{
+		m_file.close();
+		m_width = 0;
+		m_height = 0;
+		return false;
+	}
+	m_samples = data;
+	m_bigEndian = false;
+	m_maxValue = 65535.0f;
+
+	return true;
+}
+
+void DEMFile::readRegion(uint32_t firstRow, uint32_t firstColumn, uint32_t rowCount, uint32_t columnCount, uint32_t resolution, float* outHeights, size_t outRowPitch) const
+{
+	std::vector<uint32_t> fileColumns(columnCount), nextFileColumns(columnCount);
+	std::vector<float> columnWeights(columnCount);
+	for (uint32_t column = 0; column < columnCount; ++column)
+		mapSample(firstColumn + column, resolution, m_width, fileColumns[column], nextFileColumns[column], columnWeights[column]);
+
+	// Only the two file rows around each grid row are touched
+	for (uint32_t row = 0; row < rowCount; ++row)
+	{
+		uint32_t fileRow, nextFileRow;
+		float rowWeight;
+		mapSample(firstRow + row, resolution, m_height, fileRow, nextFileRow, rowWeight);
+		float* heights = outHeights + row * outRowPitch;
+		for (uint32_t column = 0; column < columnCount; ++column)
+		{
+			const float top = getHeight(fileRow, fileColumns[column]);
+			const float topRight = getHeight(fileRow, nextFileColumns[column]);
+			const float bottom = getHeight(nextFileRow, fileColumns[column]);
+			const float bottomRight = getHeight(nextFileRow, nextFileColumns[column]);
+			const float topHeight = top + columnWeights[column] * (topRight - top);
+			heights[column] = topHeight + rowWeight * (bottom + columnWeights[column] * (bottomRight - bottom) - topHeight);
+		}
+	}
+}
+
+void DEMFile::loadHeightField(HeightField& heightField, ThreadPool* threadPool) const
+{
+	const uint32_t resolution = heightField.getResolution();
+	const uint32_t blockSize = heightField.getBlockSize();
+	const uint32_t blockCountPerSide = heightField.getBlockCountPerSide();
+	auto loadBlock = [&](uint32_t blockIndex)
+	{
+		const uint32_t blockI = blockIndex / blockCountPerSide;
+		const uint32_t blockJ = blockIndex % blockCountPerSide;
+		readRegion(blockI * blockSize, blockJ * blockSize, blockSize, blockSize, resolution, heightField.getBlock(blockI, blockJ), blockSize);
+	};
+
+	if (threadPool)
+		threadPool->parallelFor(blockCountPerSide * blockCountPerSide, loadBlock);
+	else
+		for (uint32_t blockIndex = 0; blockIndex < blockCountPerSide * blockCountPerSide; ++blockIndex)
+			loadBlock(blockIndex);
+}
+
+void DEMFile::mapSample(uint32_t sample, uint32_t resolution, uint32_t fileSize, uint32_t& outIndex, uint32_t& outNextIndex, float& outWeight)
+{
+	// sample * (fileSize - 1) / (resolution - 1) in integers, exact at both ends
+	const uint64_t lastSample = std::max(resolution, 2u) - 1;
+	const uint64_t position = static_cast<uint64_t>(sample) * (fileSize - 1);
+	outIndex = static_cast<uint32_t>(position / lastSample);
+	outNextIndex = std::min(outIndex + 1, fileSize - 1);
+	outWeight = static_cast<float>(position % lastSample) / static_cast<float>(lastSample);
+}
+
+bool DEMFile::parsePGMHeader()
+{
+	// "P5" width height maxValue, separated by whitespaces and # comments, then a single whitespace before the samples
+	const uint8_t* data = m_file.getData();
+	const size_t size = m_file.getSize();
+	size_t position = 2;
+	uint32_t values[3];
+	for (uint32_t& value : values)
+	{
+		while (position < size && (std::isspace(data[position]) || data[position] == '#'))
+		{
+			if (data[position] == '#')
+				while (position < size && data[position] != '\n')
+					++position;
+			else
+				++position;
+		}
+		if (position >= size || !std::isdigit(data[position]))
+			return false;
+
+		value = 0;
+		while (position < size && std::isdigit(data[position]))
+			value = value * 10 + (data[position++] - '0');
+	}
+	++position;
+
+	m_width = values[0];
+	m_height = values[1];
+	const uint32_t maxValue = values[2];
+	// 8-bit PGMs (maxValue <= 255) are not elevation data
+	if (m_width == 0 || m_height == 0 || maxValue <= 255 || maxValue > 65535 || position + static_cast<size_t>(m_width) * m_height * sizeof(uint16_t) > size)
+		return false;
+
+	m_samples = data + position;
+	m_bigEndian = true;
+	m_maxValue = static_cast<float>(maxValue);
+
+	return true;
+}
+
+float DEMFile::getHeight(uint32_t row, uint32_t column) const
+{
+	const uint8_t* sample = m_samples + (static_cast<size_t>(row) * m_width + column) * sizeof(uint16_t);
+	const uint16_t value = m_bigEndian ? static_cast<uint16_t>((sample[0] << 8) | sample[1]) : static_cast<uint16_t>(sample[0] | (sample[1] << 8));
+
+	return std::min(static_cast<float>(value) / m_maxValue, 1.0f);
+}
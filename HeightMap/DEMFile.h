@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "HeightField.h"
+#include "MappedFile.h"
+#include "ThreadPool.h"
+
+// 16-bit elevation grid (binary PGM "P5", or headerless little-endian RAW) mapped in memory: the file is never read as a whole,
+// only the pages of the samples that are converted are loaded by the system, so it can be larger than the RAM
+class DEMFile
+{
+public:
+	// A RAW file has no header, its width is given or the file is assumed square. Returns false if the file can't be mapped or parsed
+	bool open(const std::string& filename, uint32_t rawWidth = 0);
+
+	uint32_t getWidth() const { return m_width; }
+	uint32_t getHeight() const { return m_height; }
+
+	// Heights in [0, 1] of the samples [firstRow, firstRow + rowCount[ x [firstColumn, firstColumn + columnCount[ of a resolution x resolution grid
+	// stretched over the whole file: its last sample is the last one of the file on each axis, the others are bilinear between the file samples
+	void readRegion(uint32_t firstRow, uint32_t firstColumn, uint32_t rowCount, uint32_t columnCount, uint32_t resolution, float* outHeights, size_t outRowPitch) const;
+
+	// The heightfield covers the whole file (readRegion at its resolution), block by block on the thread pool
+	void loadHeightField(HeightField& heightField, ThreadPool* threadPool) const;
+
+private:
+	bool parsePGMHeader();
+	// File samples on both sides of a grid sample along an axis of fileSize samples, weight of the second one
+	static void mapSample(uint32_t sample, uint32_t resolution, uint32_t fileSize, uint32_t& outIndex, uint32_t& outNextIndex, float& outWeight);
+	float getHeight(uint32_t row, uint32_t column) const;
+
+private:
+	MappedFile m_file;
+
+	const uint8_t* m_samples = nullptr;
+	uint32_t m_width = 0;
+	uint32_t m_height = 0;
+	bool m_bigEndian = false; // PGM samples are big-endian, RAW ones little-endian
+	float m_maxValue = 65535.0f;
+};
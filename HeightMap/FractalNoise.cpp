@@ -0,0 +1,384 @@
+#include "FractalNoise.h"
+
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define FRACTAL_NOISE_X86
+#include <emmintrin.h>
+#endif
+
+// Skew factors of the 2D simplex grid: (sqrt(3) - 1) / 2 and (3 - sqrt(3)) / 6
+#define FRACTAL_NOISE_F2 0.36602540378f
+#define FRACTAL_NOISE_G2 0.21132486540f
+// Bring the octaves to about [-1, 1]
+#define FRACTAL_NOISE_GRADIENT_SCALE 0.507f
+#define FRACTAL_NOISE_SIMPLEX_SCALE 40.0f
+
+namespace
+{
+	uint32_t hash(int32_t x, int32_t y, uint32_t seed)
+	{
+		uint32_t h = (static_cast<uint32_t>(x) * 0x8da6b343u) ^ (static_cast<uint32_t>(y) * 0xd8163841u) ^ (seed * 0xcb1ab31fu);
+		h ^= h >> 15;
+		h *= 0x2c1b3c6du;
+		h ^= h >> 12;
+		h *= 0x297a2d39u;
+		h ^= h >> 15;
+		return h;
+	}
+
+	float toUnit(uint32_t h)
+	{
+		return static_cast<float>(static_cast<int32_t>(h >> 8)) * (1.0f / 16777216.0f);
+	}
+
+	// 6t^5 - 15t^4 + 10t^3
+	float fade(float t)
+	{
+		const float t3 = (t * t) * t;
+		return t3 * (t * (t * 6.0f - 15.0f) + 10.0f);
+	}
+
+	// One of 8 gradients of length 1 to sqrt(5) dotted with (x, y)
+	float grad(uint32_t h, float x, float y)
+	{
+		const float u = (h & 4) ? y : x;
+		const float v = (h & 4) ? x : y;
+		return ((h & 1) ? -u : u) + ((h & 2) ? -(v + v) : (v + v));
+	}
+
+	float simplexCorner(float x, float y, uint32_t h)
+	{
+		const float t = (0.5f - x * x) - y * y;
+		if (t < 0.0f)
+			return 0.0f;
+		const float t2 = t * t;
+		return (t2 * t2) * grad(h, x, y);
+	}
+}
+
+FractalNoise::FractalNoise(const Parameters& parameters) : m_parameters(parameters)
+{
+	float totalAmplitude = 0.0f;
+	float amplitude = 1.0f;
+	for (uint32_t octave = 0; octave < m_parameters.octaveCount; ++octave)
+	{
+		totalAmplitude += amplitude;
+		amplitude *= m_parameters.gain;
+	}
+	if (totalAmplitude == 0.0f)
+		totalAmplitude = 1.0f;
+
+	// Value noise is in [0, 1], the others in [-1, 1]
+	m_scale = m_parameters.type == Type::VALUE ? 1.0f / totalAmplitude : 0.5f / totalAmplitude;
+	m_offset = m_parameters.type == Type::VALUE ? 0.0f : 0.5f;
+}
+
+float FractalNoise::evaluate(float x, float y) const
+{
+	float height;
+	evaluateRowScalar(x, y, 0.0f, 0, 1, &height);
+	return height;
+}
+
+void FractalNoise::evaluateRow(float x, float y, float step, uint32_t count, float* outHeights, ValueNoiseKernel::InstructionSet instructionSet) const
+{
+	if (instructionSet == ValueNoiseKernel::InstructionSet::SCALAR)
+		evaluateRowScalar(x, y, step, 0, count, outHeights);
+	else
+		evaluateRowSSE(x, y, step, count, outHeights);
+}
+
+void FractalNoise::evaluateTile(float x, float y, float step, uint32_t width, uint32_t height, float* outHeights, size_t rowPitch,
+	ValueNoiseKernel::InstructionSet instructionSet) const
+{
+	for (uint32_t row = 0; row < height; ++row)
+		evaluateRow(x, y + static_cast<float>(row) * step, step, width, outHeights + row * rowPitch, instructionSet);
+}
+
+float FractalNoise::valueNoise(float x, float y, uint32_t seed)
+{
+	const float xFloor = std::floor(x);
+	const float yFloor = std::floor(y);
+	const int32_t ix = static_cast<int32_t>(xFloor);
+	const int32_t iy = static_cast<int32_t>(yFloor);
+	const float u = fade(x - xFloor);
+	const float v = fade(y - yFloor);
+
+	const float v00 = toUnit(hash(ix, iy, seed));
+	const float v10 = toUnit(hash(ix + 1, iy, seed));
+	const float v01 = toUnit(hash(ix, iy + 1, seed));
+	const float v11 = toUnit(hash(ix + 1, iy + 1, seed));
+
+	const float v0 = v00 + u * (v10 - v00);
+	const float v1 = v01 + u * (v11 - v01);
+	return v0 + v * (v1 - v0);
+}
+
+float FractalNoise::gradientNoise(float x, float y, uint32_t seed)
+{
+	const float xFloor = std::floor(x);
+	const float yFloor = std::floor(y);
+	const int32_t ix = static_cast<int32_t>(xFloor);
+	const int32_t iy = static_cast<int32_t>(yFloor);
+	const float fx = x - xFloor;
+	const float fy = y - yFloor;
+	const float fx1 = fx - 1.0f;
+	const float fy1 = fy - 1.0f;
+	const float u = fade(fx);
+	const float v = fade(fy);
+
+	const float n00 = grad(hash(ix, iy, seed), fx, fy);
+	const float n10 = grad(hash(ix + 1, iy, seed), fx1, fy);
+	const float n01 = grad(hash(ix, iy + 1, seed), fx, fy1);
+	const float n11 = grad(hash(ix + 1, iy + 1, seed), fx1, fy1);
+
+	const float n0 = n00 + u * (n10 - n00);
+	const float n1 = n01 + u * (n11 - n01);
+	return FRACTAL_NOISE_GRADIENT_SCALE * (n0 + v * (n1 - n0));
+}
+
+float FractalNoise::simplexNoise(float x, float y, uint32_t seed)
+{
+	// Cell of the skewed grid, then the triangle of the cell containing the point
+	const float s = (x + y) * FRACTAL_NOISE_F2;
+	const float iFloor = std::floor(x + s);
+	const float jFloor = std::floor(y + s);
+	const int32_t i = static_cast<int32_t>(iFloor);
+	const int32_t j = static_cast<int32_t>(jFloor);
+	const float t = (iFloor + jFloor) * FRACTAL_NOISE_G2;
+	const float x0 = x - (iFloor - t);
+	const float y0 = y - (jFloor - t);
+
+	const int32_t i1 = x0 > y0 ? 1 : 0;
+	const int32_t j1 = 1 - i1;
+	const float x1 = (x0 - static_cast<float>(i1)) + FRACTAL_NOISE_G2;
+	const float y1 = (y0 - static_cast<float>(j1)) + FRACTAL_NOISE_G2;
+	const float x2 = (x0 - 1.0f) + 2.0f * FRACTAL_NOISE_G2;
+	const float y2 = (y0 - 1.0f) + 2.0f * FRACTAL_NOISE_G2;
+
+	const float n0 = simplexCorner(x0, y0, hash(i, j, seed));
+	const float n1 = simplexCorner(x1, y1, hash(i + i1, j + j1, seed));
+	const float n2 = simplexCorner(x2, y2, hash(i + 1, j + 1, seed));
+	return FRACTAL_NOISE_SIMPLEX_SCALE * ((n0 + n1) + n2);
+}
+
+void FractalNoise::evaluateRowScalar(float x, float y, float step, uint32_t first, uint32_t count, float* outHeights) const
+{
+	for (uint32_t k = first; k < count; ++k)
+	{
+		const float sampleX = x + static_cast<float>(k) * step;
+
+		float sum = 0.0f;
+		float frequency = m_parameters.frequency;
+		float amplitude = 1.0f;
+		for (uint32_t octave = 0; octave < m_parameters.octaveCount; ++octave)
+		{
+			const uint32_t seed = m_parameters.seed + octave;
+			float noise;
+			switch (m_parameters.type)
+			{
+			case Type::VALUE:
+				noise = valueNoise(sampleX * frequency, y * frequency, seed);
+				break;
+			case Type::GRADIENT:
+				noise = gradientNoise(sampleX * frequency, y * frequency, seed);
+				break;
+			default:
+				noise = simplexNoise(sampleX * frequency, y * frequency, seed);
+				break;
+			}
+			sum += noise * amplitude;
+
+			frequency *= m_parameters.lacunarity;
+			amplitude *= m_parameters.gain;
+		}
+
+		outHeights[k] = sum * m_scale + m_offset;
+	}
+}
+
+#if defined(FRACTAL_NOISE_X86)
+namespace
+{
+	// Low 32 bits of the 32-bit products without _mm_mullo_epi32 (SSE4.1): 64-bit products of lanes 0 and 2, then of lanes 1 and 3, low halves interleaved back
+	__m128i mulLo(__m128i a, __m128i b)
+	{
+		const __m128i evenProducts = _mm_mul_epu32(a, b);
+		const __m128i oddProducts = _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+		return _mm_unpacklo_epi32(_mm_shuffle_epi32(evenProducts, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(oddProducts, _MM_SHUFFLE(0, 0, 2, 0)));
+	}
+
+	__m128i hashSSE(__m128i x, __m128i y, __m128i seedProduct)
+	{
+		__m128i h = _mm_xor_si128(_mm_xor_si128(mulLo(x, _mm_set1_epi32(static_cast<int32_t>(0x8da6b343u))), mulLo(y, _mm_set1_epi32(static_cast<int32_t>(0xd8163841u)))),
+			seedProduct);
+		h = _mm_xor_si128(h, _mm_srli_epi32(h, 15));
+		h = mulLo(h, _mm_set1_epi32(0x2c1b3c6d));
+		h = _mm_xor_si128(h, _mm_srli_epi32(h, 12));
+		h = mulLo(h, _mm_set1_epi32(0x297a2d39));
+		h = _mm_xor_si128(h, _mm_srli_epi32(h, 15));
+		return h;
+	}
+
+	// _mm_floor_ps is SSE4.1: truncate, then remove 1 where truncation rounded up
+	__m128 floorSSE(__m128 x)
+	{
+		const __m128 truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(x));
+		return _mm_sub_ps(truncated, _mm_and_ps(_mm_cmpgt_ps(truncated, x), _mm_set1_ps(1.0f)));
+	}
+
+	__m128 toUnitSSE(__m128i h)
+	{
+		return _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(h, 8)), _mm_set1_ps(1.0f / 16777216.0f));
+	}
+
+	__m128 fadeSSE(__m128 t)
+	{
+		const __m128 t3 = _mm_mul_ps(_mm_mul_ps(t, t), t);
+		const __m128 inner = _mm_add_ps(_mm_mul_ps(t, _mm_sub_ps(_mm_mul_ps(t, _mm_set1_ps(6.0f)), _mm_set1_ps(15.0f))), _mm_set1_ps(10.0f));
+		return _mm_mul_ps(t3, inner);
+	}
+
+	__m128 lerpSSE(__m128 a, __m128 b, __m128 t)
+	{
+		return _mm_add_ps(a, _mm_mul_ps(t, _mm_sub_ps(b, a)));
+	}
+
+	__m128 selectSSE(__m128 mask, __m128 a, __m128 b)
+	{
+		return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+	}
+
+	__m128 gradSSE(__m128i h, __m128 x, __m128 y)
+	{
+		const __m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(h, _mm_set1_epi32(4)), _mm_set1_epi32(4)));
+		const __m128 u = selectSSE(swap, y, x);
+		const __m128 v = selectSSE(swap, x, y);
+		// Sign flips of u and v from bits 0 and 1
+		const __m128 uSign = _mm_castsi128_ps(_mm_slli_epi32(h, 31));
+		const __m128 vSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_srli_epi32(h, 1), 31));
+		return _mm_add_ps(_mm_xor_ps(u, uSign), _mm_xor_ps(_mm_add_ps(v, v), vSign));
+	}
+
+	__m128 simplexCornerSSE(__m128 x, __m128 y, __m128i h)
+	{
+		const __m128 t = _mm_sub_ps(_mm_sub_ps(_mm_set1_ps(0.5f), _mm_mul_ps(x, x)), _mm_mul_ps(y, y));
+		const __m128 t2 = _mm_mul_ps(t, t);
+		const __m128 corner = _mm_mul_ps(_mm_mul_ps(t2, t2), gradSSE(h, x, y));
+		return _mm_and_ps(_mm_cmpge_ps(t, _mm_setzero_ps()), corner);
+	}
+
+	__m128 valueNoiseSSE(__m128 x, __m128 y, __m128i seedProduct)
+	{
+		const __m128 xFloor = floorSSE(x);
+		const __m128 yFloor = floorSSE(y);
+		const __m128i ix = _mm_cvttps_epi32(xFloor);
+		const __m128i iy = _mm_cvttps_epi32(yFloor);
+		const __m128i ix1 = _mm_add_epi32(ix, _mm_set1_epi32(1));
+		const __m128i iy1 = _mm_add_epi32(iy, _mm_set1_epi32(1));
+		const __m128 u = fadeSSE(_mm_sub_ps(x, xFloor));
+		const __m128 v = fadeSSE(_mm_sub_ps(y, yFloor));
+
+		const __m128 v00 = toUnitSSE(hashSSE(ix, iy, seedProduct));
+		const __m128 v10 = toUnitSSE(hashSSE(ix1, iy, seedProduct));
+		const __m128 v01 = toUnitSSE(hashSSE(ix, iy1, seedProduct));
+		const __m128 v11 = toUnitSSE(hashSSE(ix1, iy1, seedProduct));
+
+		return lerpSSE(lerpSSE(v00, v10, u), lerpSSE(v01, v11, u), v);
+	}
+
+	__m128 gradientNoiseSSE(__m128 x, __m128 y, __m128i seedProduct)
+	{
+		const __m128 xFloor = floorSSE(x);
+		const __m128 yFloor = floorSSE(y);
+		const __m128i ix = _mm_cvttps_epi32(xFloor);
+		const __m128i iy = _mm_cvttps_epi32(yFloor);
+		const __m128i ix1 = _mm_add_epi32(ix, _mm_set1_epi32(1));
+		const __m128i iy1 = _mm_add_epi32(iy, _mm_set1_epi32(1));
+		const __m128 fx = _mm_sub_ps(x, xFloor);
+		const __m128 fy = _mm_sub_ps(y, yFloor);
+		const __m128 fx1 = _mm_sub_ps(fx, _mm_set1_ps(1.0f));
+		const __m128 fy1 = _mm_sub_ps(fy, _mm_set1_ps(1.0f));
+		const __m128 u = fadeSSE(fx);
+		const __m128 v = fadeSSE(fy);
+
+		const __m128 n00 = gradSSE(hashSSE(ix, iy, seedProduct), fx, fy);
+		const __m128 n10 = gradSSE(hashSSE(ix1, iy, seedProduct), fx1, fy);
+		const __m128 n01 = gradSSE(hashSSE(ix, iy1, seedProduct), fx, fy1);
+		const __m128 n11 = gradSSE(hashSSE(ix1, iy1, seedProduct), fx1, fy1);
+
+		return _mm_mul_ps(_mm_set1_ps(FRACTAL_NOISE_GRADIENT_SCALE), lerpSSE(lerpSSE(n00, n10, u), lerpSSE(n01, n11, u), v));
+	}
+
+	__m128 simplexNoiseSSE(__m128 x, __m128 y, __m128i seedProduct)
+	{
+		const __m128 s = _mm_mul_ps(_mm_add_ps(x, y), _mm_set1_ps(FRACTAL_NOISE_F2));
+		const __m128 iFloor = floorSSE(_mm_add_ps(x, s));
+		const __m128 jFloor = floorSSE(_mm_add_ps(y, s));
+		const __m128i i = _mm_cvttps_epi32(iFloor);
+		const __m128i j = _mm_cvttps_epi32(jFloor);
+		const __m128 t = _mm_mul_ps(_mm_add_ps(iFloor, jFloor), _mm_set1_ps(FRACTAL_NOISE_G2));
+		const __m128 x0 = _mm_sub_ps(x, _mm_sub_ps(iFloor, t));
+		const __m128 y0 = _mm_sub_ps(y, _mm_sub_ps(jFloor, t));
+
+		const __m128 lowerTriangle = _mm_cmpgt_ps(x0, y0);
+		const __m128i i1 = _mm_and_si128(_mm_castps_si128(lowerTriangle), _mm_set1_epi32(1));
+		const __m128i j1 = _mm_sub_epi32(_mm_set1_epi32(1), i1);
+		const __m128 x1 = _mm_add_ps(_mm_sub_ps(x0, _mm_cvtepi32_ps(i1)), _mm_set1_ps(FRACTAL_NOISE_G2));
+		const __m128 y1 = _mm_add_ps(_mm_sub_ps(y0, _mm_cvtepi32_ps(j1)), _mm_set1_ps(FRACTAL_NOISE_G2));
+		const __m128 x2 = _mm_add_ps(_mm_sub_ps(x0, _mm_set1_ps(1.0f)), _mm_set1_ps(2.0f * FRACTAL_NOISE_G2));
+		const __m128 y2 = _mm_add_ps(_mm_sub_ps(y0, _mm_set1_ps(1.0f)), _mm_set1_ps(2.0f * FRACTAL_NOISE_G2));
+
+		const __m128 n0 = simplexCornerSSE(x0, y0, hashSSE(i, j, seedProduct));
+		const __m128 n1 = simplexCornerSSE(x1, y1, hashSSE(_mm_add_epi32(i, i1), _mm_add_epi32(j, j1), seedProduct));
+		const __m128 n2 = simplexCornerSSE(x2, y2, hashSSE(_mm_add_epi32(i, _mm_set1_epi32(1)), _mm_add_epi32(j, _mm_set1_epi32(1)), seedProduct));
+		return _mm_mul_ps(_mm_set1_ps(FRACTAL_NOISE_SIMPLEX_SCALE), _mm_add_ps(_mm_add_ps(n0, n1), n2));
+	}
+}
+#endif
+
+void FractalNoise::evaluateRowSSE(float x, float y, float step, uint32_t count, float* outHeights) const
+{
+#if defined(FRACTAL_NOISE_X86)
+	uint32_t k = 0;
+	for (; k + 4 <= count; k += 4)
+	{
+		const __m128 sampleX = _mm_add_ps(_mm_set1_ps(x), _mm_mul_ps(_mm_cvtepi32_ps(_mm_setr_epi32(static_cast<int32_t>(k), static_cast<int32_t>(k + 1), static_cast<int32_t>(k + 2), static_cast<int32_t>(k + 3))), _mm_set1_ps(step)));
+		const __m128 sampleY = _mm_set1_ps(y);
+
+		__m128 sum = _mm_setzero_ps();
+		float frequency = m_parameters.frequency;
+		float amplitude = 1.0f;
+		for (uint32_t octave = 0; octave < m_parameters.octaveCount; ++octave)
+		{
+			const __m128i seedProduct = _mm_set1_epi32(static_cast<int32_t>((m_parameters.seed + octave) * 0xcb1ab31fu));
+			const __m128 octaveX = _mm_mul_ps(sampleX, _mm_set1_ps(frequency));
+			const __m128 octaveY = _mm_mul_ps(sampleY, _mm_set1_ps(frequency));
+			__m128 noise;
+			switch (m_parameters.type)
+			{
+			case Type::VALUE:
+				noise = valueNoiseSSE(octaveX, octaveY, seedProduct);
+				break;
+			case Type::GRADIENT:
+				noise = gradientNoiseSSE(octaveX, octaveY, seedProduct);
+				break;
+			default:
+				noise = simplexNoiseSSE(octaveX, octaveY, seedProduct);
+				break;
+			}
+			sum = _mm_add_ps(sum, _mm_mul_ps(noise, _mm_set1_ps(amplitude)));
+
+			frequency *= m_parameters.lacunarity;
+			amplitude *= m_parameters.gain;
+		}
+
+		_mm_storeu_ps(outHeights + k, _mm_add_ps(_mm_mul_ps(sum, _mm_set1_ps(m_scale)), _mm_set1_ps(m_offset)));
+	}
+
+	evaluateRowScalar(x, y, step, k, count, outHeights);
+#else
+	evaluateRowScalar(x, y, step, 0, count, outHeights);
+#endif
+}
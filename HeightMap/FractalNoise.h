@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "ValueNoiseKernel.h"
+
+// Seeded fractal noise (fBm) of value, gradient (Perlin) or simplex noise, in [0, 1] (gradient and simplex slightly overshoot).
+// Lattices are hashed with integer operations only and the batch paths do the scalar operations in the same order without fusing them,
+// so a seed gives the same heights on every machine and with every instruction set
+class FractalNoise
+{
+public:
+	enum class Type { VALUE, GRADIENT, SIMPLEX };
+	struct Parameters
+	{
+		Type type = Type::GRADIENT;
+		uint32_t seed = 0;
+		uint32_t octaveCount = 8;
+		float frequency = 4.0f; // of the first octave, in cycles per unit of the input coordinates
+		float lacunarity = 2.0f; // frequency ratio between an octave and the previous one
+		float gain = 0.5f; // amplitude ratio between an octave and the previous one
+	};
+
+	FractalNoise(const Parameters& parameters);
+
+	const Parameters& getParameters() const { return m_parameters; }
+
+	// Reference single sample
+	float evaluate(float x, float y) const;
+	// outHeights[k] = evaluate(x + k * step, y) for k < count
+	void evaluateRow(float x, float y, float step, uint32_t count, float* outHeights,
+		ValueNoiseKernel::InstructionSet instructionSet = ValueNoiseKernel::getBestInstructionSet()) const;
+	// outHeights[row * rowPitch + column] = evaluate(x + column * step, y + row * step)
+	void evaluateTile(float x, float y, float step, uint32_t width, uint32_t height, float* outHeights, size_t rowPitch,
+		ValueNoiseKernel::InstructionSet instructionSet = ValueNoiseKernel::getBestInstructionSet()) const;
+
+private:
+	static float valueNoise(float x, float y, uint32_t seed);
+	static float gradientNoise(float x, float y, uint32_t seed);
+	static float simplexNoise(float x, float y, uint32_t seed);
+
+	void evaluateRowScalar(float x, float y, float step, uint32_t first, uint32_t count, float* outHeights) const;
+	// 4 samples at a time with SSE2 only. The integer hash needs the low 32 bits of 32-bit products, which SSE2 has no instruction for
+	// (_mm_mullo_epi32 is SSE4.1): they are rebuilt from two _mm_mul_epu32 (32 x 32 -> 64-bit products of the even lanes, then of the odd ones).
+	// AVX has no 256-bit integer instructions (they come with AVX2), so the AVX instruction set uses this path too
+	void evaluateRowSSE(float x, float y, float step, uint32_t count, float* outHeights) const;
+
+private:
+	Parameters m_parameters;
+	float m_scale; // applied to the weighted sum of the octaves
+	float m_offset;
+};
@@ -0,0 +1,53 @@
+#include "HeightField.h"
+
+#include <algorithm>
+
+HeightField::HeightField(uint32_t resolution, uint32_t blockSize) : m_resolution(resolution)
+{
+	while ((1u << m_blockSizeLog2) < blockSize)
+		++m_blockSizeLog2;
+	m_blockCountPerSide = m_resolution >> m_blockSizeLog2;
+
+	m_heights.resize(static_cast<size_t>(m_resolution) * m_resolution, 0.0f);
+}
+
+void HeightField::copyToRowMajor(float* heights) const
+{
+	const uint32_t blockSize = getBlockSize();
+	for (uint32_t blockI = 0; blockI < m_blockCountPerSide; ++blockI)
+	{
+		for (uint32_t blockJ = 0; blockJ < m_blockCountPerSide; ++blockJ)
+		{
+			const float* block = getBlock(blockI, blockJ);
+			for (uint32_t i = 0; i < blockSize; ++i)
+				std::copy_n(block + i * blockSize, blockSize, heights + static_cast<size_t>(blockI * blockSize + i) * m_resolution + blockJ * blockSize);
+		}
+	}
+}
+
+void HeightField::copyFromRowMajor(const float* heights)
+{
+	const uint32_t blockSize = getBlockSize();
+	for (uint32_t blockI = 0; blockI < m_blockCountPerSide; ++blockI)
+	{
+		for (uint32_t blockJ = 0; blockJ < m_blockCountPerSide; ++blockJ)
+		{
+			float* block = getBlock(blockI, blockJ);
+			for (uint32_t i = 0; i < blockSize; ++i)
+				std::copy_n(heights + static_cast<size_t>(blockI * blockSize + i) * m_resolution + blockJ * blockSize, blockSize, block + i * blockSize);
+		}
+	}
+}
+
+void HeightField::copyRow(uint32_t i, uint32_t firstColumn, uint32_t count, float* heights) const
+{
+	const uint32_t blockMask = getBlockSize() - 1;
+	uint32_t j = firstColumn;
+	while (j < firstColumn + count)
+	{
+		// Up to the end of the block
+		const uint32_t runLength = std::min(getBlockSize() - (j & blockMask), firstColumn + count - j);
+		std::copy_n(&m_heights[getIndex(i, j)], runLength, heights + (j - firstColumn));
+		j += runLength;
+	}
+}
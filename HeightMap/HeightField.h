@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Square grid of heights allocated at runtime and stored by blocks of blockSize * blockSize texels: blocks are row-major, and so are the texels
+// inside a block. A texel and its neighbours (including the ones of the next rows) are then a few cache lines apart whatever the resolution.
+// blockSize must be a power of 2 and resolution a multiple of it
+class HeightField
+{
+public:
+	HeightField(uint32_t resolution, uint32_t blockSize);
+
+	uint32_t getResolution() const { return m_resolution; }
+	uint32_t getBlockSize() const { return 1u << m_blockSizeLog2; }
+	uint32_t getBlockCountPerSide() const { return m_blockCountPerSide; }
+
+	// Texel (i, j) is row i, column j as in a row-major heights[i * resolution + j]
+	float get(uint32_t i, uint32_t j) const { return m_heights[getIndex(i, j)]; }
+	void set(uint32_t i, uint32_t j, float height) { m_heights[getIndex(i, j)] = height; }
+
+	// The block of texels (blockI * blockSize, blockJ * blockSize), its texel (i, j) is block[i * blockSize + j]
+	float* getBlock(uint32_t blockI, uint32_t blockJ) { return &m_heights[getBlockOffset(blockI, blockJ)]; }
+	const float* getBlock(uint32_t blockI, uint32_t blockJ) const { return &m_heights[getBlockOffset(blockI, blockJ)]; }
+
+	void copyToRowMajor(float* heights) const;
+	void copyFromRowMajor(const float* heights);
+	// Samples (i, firstColumn) ... (i, firstColumn + count - 1)
+	void copyRow(uint32_t i, uint32_t firstColumn, uint32_t count, float* heights) const;
+
+private:
+	size_t getBlockOffset(uint32_t blockI, uint32_t blockJ) const
+	{
+		return (static_cast<size_t>(blockI) * m_blockCountPerSide + blockJ) << (2 * m_blockSizeLog2);
+	}
+	size_t getIndex(uint32_t i, uint32_t j) const
+	{
+		const uint32_t blockMask = (1u << m_blockSizeLog2) - 1;
+		return getBlockOffset(i >> m_blockSizeLog2, j >> m_blockSizeLog2) + ((i & blockMask) << m_blockSizeLog2) + (j & blockMask);
+	}
+
+private:
+	uint32_t m_resolution;
+	uint32_t m_blockSizeLog2 = 0;
+	uint32_t m_blockCountPerSide;
+
+	std::vector<float> m_heights;
+};
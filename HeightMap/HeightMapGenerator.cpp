@@ -0,0 +1,216 @@
+#include "HeightMapGenerator.h"
+
+#include <algorithm>
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/glm.hpp>
+
+// Lattice hash fract(sin(dot(p, direction)) * scale)
+static const glm::vec2 HASH_DIRECTION(12.9898f, 78.233f);
+static const float HASH_SCALE = 43758.5453f;
+
+HeightMapGenerator::HeightMapGenerator(uint32_t resolution) : m_resolution(resolution)
+{
+	float weight = 1.0f;
+	for (uint32_t div = 2; div < m_resolution; div *= 2)
+	{
+		Octave octave;
+		octave.div = div;
+		octave.fragmentSize = m_resolution / div;
+		while ((1u << octave.fragmentSizeLog2) < octave.fragmentSize)
+			++octave.fragmentSizeLog2;
+		octave.weight = weight;
+		m_octaves.push_back(octave);
+
+		m_totalWeight += weight;
+		weight -= 0.1f;
+		weight = std::max(weight, 0.1f);
+	}
+}
+
+HeightMapGenerator::HeightMapGenerator(uint32_t resolution, const FractalNoise::Parameters& noiseParameters) : m_resolution(resolution),
+	m_fractalNoise(std::make_unique<FractalNoise>(noiseParameters))
+{
+}
+
+void HeightMapGenerator::generate(HeightField& heightField, ThreadPool* threadPool, ValueNoiseKernel::InstructionSet instructionSet)
+{
+	prepareOctaves(threadPool);
+
+	// Each texel goes through the same operations in the same order as a serial sweep, so the result does not depend on the thread count
+	const uint32_t tileCountPerSide = heightField.getBlockCountPerSide();
+	auto generateTileByIndex = [&](uint32_t tileIndex)
+	{
+		const uint32_t tileX = tileIndex / tileCountPerSide;
+		const uint32_t tileY = tileIndex % tileCountPerSide;
+		generateTile(heightField.getBlock(tileX, tileY), heightField.getBlockSize(), tileX, tileY, instructionSet);
+	};
+
+	if (threadPool)
+		threadPool->parallelFor(tileCountPerSide * tileCountPerSide, generateTileByIndex);
+	else
+		for (uint32_t tileIndex = 0; tileIndex < tileCountPerSide * tileCountPerSide; ++tileIndex)
+			generateTileByIndex(tileIndex);
+}
+
+void HeightMapGenerator::generateOctaves(HeightField& octaveSums, HeightField& heightField, uint32_t firstOctave, uint32_t endOctave, ThreadPool* threadPool,
+	ValueNoiseKernel::InstructionSet instructionSet)
+{
+	prepareOctaves(threadPool);
+
+	// Summed in the order of m_totalWeight, so that the last call divides by the same weight as generate()
+	float weight = 0.0f;
+	for (uint32_t octaveIndex = 0; octaveIndex < endOctave; ++octaveIndex)
+		weight += m_octaves[octaveIndex].weight;
+
+	const uint32_t tileCountPerSide = heightField.getBlockCountPerSide();
+	const uint32_t tileSize = heightField.getBlockSize();
+	auto generateTileByIndex = [&](uint32_t tileIndex)
+	{
+		const uint32_t tileX = tileIndex / tileCountPerSide;
+		const uint32_t tileY = tileIndex % tileCountPerSide;
+		float* sums = octaveSums.getBlock(tileX, tileY);
+		if (firstOctave == 0)
+			std::fill_n(sums, tileSize * tileSize, 0.0f);
+		accumulateOctaves(sums, tileSize, tileX, tileY, firstOctave, endOctave, instructionSet);
+
+		float* tile = heightField.getBlock(tileX, tileY);
+		for (uint32_t k = 0; k < tileSize * tileSize; ++k)
+			tile[k] = sums[k] / weight;
+	};
+
+	if (threadPool)
+		threadPool->parallelFor(tileCountPerSide * tileCountPerSide, generateTileByIndex);
+	else
+		for (uint32_t tileIndex = 0; tileIndex < tileCountPerSide * tileCountPerSide; ++tileIndex)
+			generateTileByIndex(tileIndex);
+}
+
+void HeightMapGenerator::prepareOctaves(ThreadPool* threadPool)
+{
+	// The sin based hash is the expensive part of the noise: evaluate it once per fragment corner instead of once per fragment and per tile
+	auto prepareOctave = [this](uint32_t octaveIndex)
+	{
+		Octave& octave = m_octaves[octaveIndex];
+		if (!octave.latticeValues.empty())
+			return;
+
+		const uint32_t latticeSize = octave.div + 1;
+		octave.latticeValues.resize(latticeSize * latticeSize);
+		for (uint32_t xFragment = 0; xFragment < latticeSize; ++xFragment)
+			for (uint32_t yFragment = 0; yFragment < latticeSize; ++yFragment)
+				octave.latticeValues[xFragment * latticeSize + yFragment] = rand(static_cast<float>(xFragment), static_cast<float>(yFragment));
+
+		const float fragmentSize = (float)m_resolution / (float)octave.div;
+		octave.interpolationWeights.resize(m_resolution);
+		for (uint32_t p = 0; p < m_resolution; ++p)
+			octave.interpolationWeights[p] = ((float)p - ((float)(p / octave.fragmentSize) * fragmentSize)) / fragmentSize;
+	};
+
+	if (threadPool)
+		threadPool->parallelFor(static_cast<uint32_t>(m_octaves.size()), prepareOctave);
+	else
+		for (uint32_t octaveIndex = 0; octaveIndex < m_octaves.size(); ++octaveIndex)
+			prepareOctave(octaveIndex);
+}
+
+void HeightMapGenerator::generateTile(float* tile, uint32_t tileSize, uint32_t tileX, uint32_t tileY, ValueNoiseKernel::InstructionSet instructionSet) const
+{
+	const uint32_t iStart = tileX * tileSize;
+	const uint32_t jStart = tileY * tileSize;
+
+	// Sample (i, j) is the noise at (j, i) / resolution
+	if (m_fractalNoise)
+	{
+		const float step = 1.0f / static_cast<float>(m_resolution);
+		m_fractalNoise->evaluateTile(static_cast<float>(jStart) * step, static_cast<float>(iStart) * step, step, tileSize, tileSize, tile, tileSize, instructionSet);
+		return;
+	}
+
+	std::fill_n(tile, tileSize * tileSize, 0.0f);
+	accumulateOctaves(tile, tileSize, tileX, tileY, 0, static_cast<uint32_t>(m_octaves.size()), instructionSet);
+
+	for (uint32_t k = 0; k < tileSize * tileSize; ++k)
+		tile[k] /= m_totalWeight;
+}
+
+void HeightMapGenerator::accumulateOctaves(float* tile, uint32_t tileSize, uint32_t tileX, uint32_t tileY, uint32_t firstOctave, uint32_t endOctave,
+	ValueNoiseKernel::InstructionSet instructionSet) const
+{
+	const uint32_t iStart = tileX * tileSize;
+	const uint32_t iEnd = iStart + tileSize;
+	const uint32_t jStart = tileY * tileSize;
+
+	std::vector<float> rowValues;
+
+	for (uint32_t octaveIndex = firstOctave; octaveIndex < endOctave; ++octaveIndex)
+	{
+		const Octave& octave = m_octaves[octaveIndex];
+		const uint32_t latticeSize = octave.div + 1;
+		const uint32_t firstYFragment = jStart / octave.fragmentSize;
+		const uint32_t lastYFragment = (jStart + tileSize - 1) / octave.fragmentSize + 1;
+		rowValues.resize(lastYFragment - firstYFragment + 4); // padding for the vector loads of the kernel
+
+		for (uint32_t i = iStart; i < iEnd; ++i)
+		{
+			const uint32_t xFragment = i / octave.fragmentSize;
+			const float* latticeRow = &octave.latticeValues[xFragment * latticeSize];
+			const float* nextLatticeRow = &octave.latticeValues[(xFragment + 1) * latticeSize];
+			const float xWeight = octave.interpolationWeights[i];
+
+			// Interpolation along x at each fragment corner of the row: the end value of a fragment is the start value of the next one
+			for (uint32_t yFragment = firstYFragment; yFragment <= lastYFragment; ++yFragment)
+				rowValues[yFragment - firstYFragment] = glm::mix(latticeRow[yFragment], nextLatticeRow[yFragment], xWeight);
+
+			// Tiles are aligned on fragments (or inside a single one), so the fragment of texel k is k / fragmentSize relative to the first one
+			ValueNoiseKernel::accumulateRow(tile + (i - iStart) * tileSize, rowValues.data(), octave.fragmentSizeLog2, &octave.interpolationWeights[jStart], tileSize,
+				octave.weight, instructionSet);
+		}
+	}
+}
+
+uint64_t HeightMapGenerator::getParametersKey() const
+{
+	// FNV-1a
+	uint64_t key = 14695981039346656037ull;
+	auto addBytes = [&key](const void* data, size_t size)
+	{
+		for (size_t i = 0; i < size; ++i)
+		{
+			key ^= static_cast<const uint8_t*>(data)[i];
+			key *= 1099511628211ull;
+		}
+	};
+
+	addBytes(&m_resolution, sizeof(m_resolution));
+	for (const Octave& octave : m_octaves)
+	{
+		addBytes(&octave.div, sizeof(octave.div));
+		addBytes(&octave.weight, sizeof(octave.weight));
+	}
+	if (m_fractalNoise)
+	{
+		// Field by field, the padding of the structure is undefined
+		const FractalNoise::Parameters& noiseParameters = m_fractalNoise->getParameters();
+		addBytes(&noiseParameters.type, sizeof(noiseParameters.type));
+		addBytes(&noiseParameters.seed, sizeof(noiseParameters.seed));
+		addBytes(&noiseParameters.octaveCount, sizeof(noiseParameters.octaveCount));
+		addBytes(&noiseParameters.frequency, sizeof(noiseParameters.frequency));
+		addBytes(&noiseParameters.lacunarity, sizeof(noiseParameters.lacunarity));
+		addBytes(&noiseParameters.gain, sizeof(noiseParameters.gain));
+	}
+	else
+	{
+		addBytes(&HASH_DIRECTION, sizeof(HASH_DIRECTION));
+		addBytes(&HASH_SCALE, sizeof(HASH_SCALE));
+	}
+
+	return key;
+}
+
+float HeightMapGenerator::rand(float x, float y)
+{
+	return glm::fract(glm::sin(glm::dot(glm::vec2(x, y), HASH_DIRECTION)) * HASH_SCALE);
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "FractalNoise.h"
+#include "HeightField.h"
+#include "ThreadPool.h"
+#include "ValueNoiseKernel.h"
+
+// Value noise heightmap (sum of bilinear octaves), generated tile by tile: a tile is a block of the heightfield.
+// The seeded fractal noise can be used instead, sampled over [0, 1]^2 whatever the resolution
+class HeightMapGenerator
+{
+public:
+	HeightMapGenerator(uint32_t resolution);
+	HeightMapGenerator(uint32_t resolution, const FractalNoise::Parameters& noiseParameters);
+
+	// The heightfield must have the resolution of the generator, a null thread pool generates on the calling thread
+	void generate(HeightField& heightField, ThreadPool* threadPool, ValueNoiseKernel::InstructionSet instructionSet = ValueNoiseKernel::getBestInstructionSet());
+	// Coarse to fine generation of the value noise: adds the octaves [firstOctave, endOctave[ to the weighted sums of octaveSums (a heightfield of the
+	// same resolution, reset when firstOctave is 0), then writes the sums divided by the weight of the octaves [0, endOctave[ into heightField.
+	// Once every octave is added, the heights are exactly the ones of generate()
+	void generateOctaves(HeightField& octaveSums, HeightField& heightField, uint32_t firstOctave, uint32_t endOctave, ThreadPool* threadPool,
+		ValueNoiseKernel::InstructionSet instructionSet = ValueNoiseKernel::getBestInstructionSet());
+
+	struct Octave
+	{
+		uint32_t div;
+		uint32_t fragmentSize;
+		uint32_t fragmentSizeLog2 = 0;
+		float weight;
+
+		std::vector<float> latticeValues; // (div + 1)^2 random values, one per fragment corner, latticeValues[xFragment * (div + 1) + yFragment]
+		std::vector<float> interpolationWeights; // per texel position inside its fragment, shared by rows and columns
+	};
+	// Other implementations of the noise (GPU) use the same lattices, so the heights only depend on the resolution. There are none with the fractal noise
+	void prepareOctaves(ThreadPool* threadPool);
+	const std::vector<Octave>& getOctaves() const { return m_octaves; }
+	// Octaves of the value noise from the coarsest, 0 with the fractal noise
+	uint32_t getOctaveCount() const { return static_cast<uint32_t>(m_octaves.size()); }
+	float getTotalWeight() const { return m_totalWeight; }
+	// Heights of the tile (tileX, tileY) of a heightfield of tileSize blocks, as generate() writes them into the block (tileX, tileY). prepareOctaves must
+	// have been called
+	void generateTile(float* tile, uint32_t tileSize, uint32_t tileX, uint32_t tileY, ValueNoiseKernel::InstructionSet instructionSet) const;
+
+	// Hash of everything the heights depend on (resolution, octaves, hash constants as the seed, or the fractal noise parameters): equal keys give equal heightfields
+	uint64_t getParametersKey() const;
+
+private:
+	// Adds the weighted value noise octaves [firstOctave, endOctave[ to the tile
+	void accumulateOctaves(float* tile, uint32_t tileSize, uint32_t tileX, uint32_t tileY, uint32_t firstOctave, uint32_t endOctave,
+		ValueNoiseKernel::InstructionSet instructionSet) const;
+
+	static float rand(float x, float y);
+
+private:
+	uint32_t m_resolution;
+
+	std::vector<Octave> m_octaves;
+	float m_totalWeight = 0.0f;
+
+	std::unique_ptr<FractalNoise> m_fractalNoise;
+};
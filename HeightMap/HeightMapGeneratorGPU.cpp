@@ -0,0 +1,94 @@
+#include "HeightMapGeneratorGPU.h"
+
+using namespace Wolf;
+
+HeightMapGeneratorGPU::HeightMapGeneratorGPU(Wolf::WolfInstance* wolfInstance, uint32_t resolution) : m_wolfInstance(wolfInstance), m_resolution(resolution),
+	m_octaveSource(resolution)
+{
+	m_image = m_wolfInstance->createImage({ m_resolution, m_resolution, 1 }, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT |
+		VK_IMAGE_USAGE_TRANSFER_DST_BIT, VK_FORMAT_R32_SFLOAT, VK_SAMPLE_COUNT_1_BIT, VK_IMAGE_ASPECT_COLOR_BIT);
+}
+
+void HeightMapGeneratorGPU::generate(ThreadPool* threadPool)
+{
+	m_octaveSource.prepareOctaves(threadPool);
+	const std::vector<HeightMapGenerator::Octave>& octaves = m_octaveSource.getOctaves();
+
+	// All octaves in 2 flat arrays: lattices one after the other, interpolation weights at octaveIndex * resolution
+	std::vector<GPUOctave> gpuOctaves(octaves.size());
+	std::vector<float> latticeValues;
+	std::vector<float> interpolationWeights;
+	interpolationWeights.reserve(octaves.size() * m_resolution);
+	for (size_t octaveIndex = 0; octaveIndex < octaves.size(); ++octaveIndex)
+	{
+		const HeightMapGenerator::Octave& octave = octaves[octaveIndex];
+		gpuOctaves[octaveIndex] = { static_cast<uint32_t>(latticeValues.size()), octave.div + 1, octave.fragmentSizeLog2, octave.weight };
+		latticeValues.insert(latticeValues.end(), octave.latticeValues.begin(), octave.latticeValues.end());
+		interpolationWeights.insert(interpolationWeights.end(), octave.interpolationWeights.begin(), octave.interpolationWeights.end());
+	}
+
+	GenerationParameters parameters = { m_resolution, static_cast<uint32_t>(octaves.size()), m_octaveSource.getTotalWeight(), 0.0f };
+	UniformBuffer* parametersBuffer = m_wolfInstance->createUniformBufferObject(&parameters, sizeof(parameters));
+	UniformBuffer* octavesBuffer = m_wolfInstance->createUniformBufferObject(gpuOctaves.data(), gpuOctaves.size() * sizeof(GPUOctave), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+	UniformBuffer* latticeBuffer = m_wolfInstance->createUniformBufferObject(latticeValues.data(), latticeValues.size() * sizeof(float), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+	UniformBuffer* weightsBuffer = m_wolfInstance->createUniformBufferObject(interpolationWeights.data(), interpolationWeights.size() * sizeof(float),
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+
+	// The descriptor is written with the current layout of the image
+	m_image->setImageLayout(VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+
+	// A scene of its own, submitted once before the terrain scene is built
+	Wolf::Scene::SceneCreateInfo sceneCreateInfo;
+	sceneCreateInfo.swapChainCommandType = Wolf::Scene::CommandType::GRAPHICS;
+	Wolf::Scene* scene = m_wolfInstance->createScene(sceneCreateInfo);
+
+	// On the graphics queue like the image transitions and the vertex shader reads, so the image never changes of queue family
+	Wolf::Scene::CommandBufferCreateInfo commandBufferCreateInfo;
+	commandBufferCreateInfo.commandType = Wolf::Scene::CommandType::GRAPHICS;
+	commandBufferCreateInfo.finalPipelineStage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+	const int commandBufferID = scene->addCommandBuffer(commandBufferCreateInfo);
+
+	DescriptorSetGenerator descriptorSetGenerator;
+	descriptorSetGenerator.addUniformBuffer(parametersBuffer, VK_SHADER_STAGE_COMPUTE_BIT, 0);
+	descriptorSetGenerator.addBuffer(octavesBuffer->getUniformBuffer(), gpuOctaves.size() * sizeof(GPUOctave), VK_SHADER_STAGE_COMPUTE_BIT, 1);
+	descriptorSetGenerator.addBuffer(latticeBuffer->getUniformBuffer(), latticeValues.size() * sizeof(float), VK_SHADER_STAGE_COMPUTE_BIT, 2);
+	descriptorSetGenerator.addBuffer(weightsBuffer->getUniformBuffer(), interpolationWeights.size() * sizeof(float), VK_SHADER_STAGE_COMPUTE_BIT, 3);
+	descriptorSetGenerator.addImages({ m_image }, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT, 4);
+
+	Wolf::Scene::ComputePassCreateInfo computePassCreateInfo;
+	computePassCreateInfo.commandBufferID = commandBufferID;
+	computePassCreateInfo.name = "Heightmap generation";
+	computePassCreateInfo.computeShaderPath = "Shaders/heightmap/generateComp.spv";
+	computePassCreateInfo.extent = { m_resolution, m_resolution };
+	computePassCreateInfo.dispatchGroups = { 16, 16, 1 };
+	computePassCreateInfo.descriptorSetCreateInfo = descriptorSetGenerator.getDescritorSetCreateInfo();
+	scene->addComputePass(computePassCreateInfo);
+
+	scene->record();
+	m_wolfInstance->submitAndWait(scene, { commandBufferID });
+
+	// Only the image is kept, the queues are idle
+	m_wolfInstance->destroyScene(scene);
+	for (UniformBuffer* buffer : { parametersBuffer, octavesBuffer, latticeBuffer, weightsBuffer })
+		m_wolfInstance->destroyUniformBufferObject(buffer);
+
+	m_image->setImageLayout(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_VERTEX_SHADER_BIT);
+}
+
+void HeightMapGeneratorGPU::readBack(HeightField& heightField, ThreadPool* threadPool) const
+{
+	std::vector<float> heights(static_cast<size_t>(m_resolution) * m_resolution);
+	m_image->copyToPixels(heights.data(), sizeof(float), { 0, 0 }, { m_resolution, m_resolution }, VK_PIPELINE_STAGE_VERTEX_SHADER_BIT);
+
+	auto copyRow = [&](uint32_t i)
+	{
+		for (uint32_t j = 0; j < m_resolution; ++j)
+			heightField.set(i, j, heights[static_cast<size_t>(i) * m_resolution + j]);
+	};
+
+	if (threadPool)
+		threadPool->parallelFor(m_resolution, copyRow);
+	else
+		for (uint32_t i = 0; i < m_resolution; ++i)
+			copyRow(i);
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <WolfEngine.h>
+
+#include "HeightField.h"
+#include "HeightMapGenerator.h"
+#include "ThreadPool.h"
+
+// The value noise of HeightMapGenerator evaluated by a compute pass into a R32_SFLOAT storage image, texel (x = j, y = i) is the sample (i, j).
+// The lattices are hashed on the CPU (a GPU sin would not match), the interpolation is done in the same order so the heights are the CPU ones
+class HeightMapGeneratorGPU
+{
+public:
+	HeightMapGeneratorGPU(Wolf::WolfInstance* wolfInstance, uint32_t resolution);
+
+	// Runs the compute pass and waits for it, the image is then in shader read only layout for the vertex shader
+	void generate(ThreadPool* threadPool);
+	// Copy of the generated heights for the CPU side (LOD bounds, comparison with the CPU reference)
+	void readBack(HeightField& heightField, ThreadPool* threadPool) const;
+
+	Wolf::Image* getImage() const { return m_image; }
+
+private:
+	Wolf::WolfInstance* m_wolfInstance;
+	uint32_t m_resolution;
+
+	HeightMapGenerator m_octaveSource;
+	Wolf::Image* m_image;
+
+	struct GenerationParameters
+	{
+		uint32_t resolution;
+		uint32_t octaveCount;
+		float totalWeight;
+		float padding;
+	};
+	struct GPUOctave
+	{
+		uint32_t latticeOffset;
+		uint32_t latticeSize;
+		uint32_t fragmentSizeLog2;
+		float weight;
+	};
+};
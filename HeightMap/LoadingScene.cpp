@@ -134,5 +134,6 @@ void LoadingScene::update() const
 	float timeDiff = std::chrono::duration_cast<std::chrono::milliseconds>(currentTimer - startTimer).count() / 1'000.0f;
 	
 	glm::mat4 transform = glm::scale(glm::rotate(glm::translate(glm::mat4(1.0f), glm::vec3(0.8f, 0.75f, 0.0f)), timeDiff * 2.0f, glm::vec3(0.0f, 0.0f, 1.0f)), glm::vec3(0.15f, 0.15f, 1.0f));
+	m_scene->waitForLastFrame();
 	m_iconUniformBuffer->updateData(&transform);
 }
@@ -1,8 +1,13 @@
 #include "Scene.h"
 
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
 using namespace Wolf;
 
-::Scene::Scene(Wolf::WolfInstance* wolfInstance)
+::Scene::Scene(Wolf::WolfInstance* wolfInstance, ThreadPool* threadPool, const SceneCreateInfo& createInfo) : m_threadPool(threadPool),
+	m_terrainRenderMode(createInfo.terrainRenderMode), m_heightField(createInfo.heightMapResolution, HEIGHMAP_TILE_SIZE), m_editor(m_heightField)
 {
 	m_window = wolfInstance->getWindowPtr();
 	
@@ -18,85 +23,188 @@ using namespace Wolf;
 	renderPassCreateInfo.outputIsSwapChain = true;
 	m_renderPassID = m_scene->addRenderPass(renderPassCreateInfo);
 
-	// Heightmap creation (perlin noise)
-	float totalWeight = 0;
-	float weight = 1.0f;
-	for (int div = 2; div < HEIGHMAP_RES; div *= 2)
+	// Heightmap creation: elevation file or perlin noise
+	const bool demLoaded = !createInfo.demFilename.empty() && loadDEM(createInfo.demFilename);
+	std::unique_ptr<TerrainQuadTree::HeightSummary> cachedHeightSummary;
+	if (!demLoaded && createInfo.heightMapGeneration == HeightMapGeneration::CPU)
 	{
-		for (int xFragment = 0; xFragment < div; ++xFragment)
+		// A cache baked with the same parameters replaces the generation
+		HeightMapGenerator heightMapGenerator = createInfo.useFractalNoise ? HeightMapGenerator(createInfo.heightMapResolution, createInfo.noiseParameters) :
+			HeightMapGenerator(createInfo.heightMapResolution);
+		TerrainTileCache tileCache;
+		const bool progressive = createInfo.progressiveGeneration && !createInfo.useFractalNoise && !createInfo.useErosion && !createInfo.scatterProps &&
+			m_terrainRenderMode != TerrainRenderMode::ADAPTIVE && heightMapGenerator.getOctaveCount() > HEIGHMAP_PROGRESSIVE_FIRST_OCTAVE_COUNT;
+		if (tileCache.open(TerrainTileCache::getFilename(heightMapGenerator.getParametersKey(), createInfo.heightMapResolution), heightMapGenerator.getParametersKey(),
+			createInfo.heightMapResolution, HEIGHMAP_TILE_SIZE, HEIGHMAP_CHUNK_SIZE))
 		{
-			for (int yFragment = 0; yFragment < div; ++yFragment)
-			{
-				float randNumber = rand(glm::vec2(xFragment, yFragment));
-				float randNumberNextX = rand(glm::vec2(xFragment + 1, yFragment));
-				float randNumberNextY = rand(glm::vec2(xFragment, yFragment + 1));
-				float randNumberNextXY = rand(glm::vec2(xFragment + 1, yFragment + 1));
-
-				for (int i = xFragment * (HEIGHMAP_RES / div); i < (xFragment + 1) * (HEIGHMAP_RES / div); ++i)
-				{
-					for (int j = yFragment * (HEIGHMAP_RES / div); j < (yFragment + 1) * (HEIGHMAP_RES / div); ++j)
-					{
-						float valueX1 = glm::mix(randNumber, randNumberNextX, ((float)i - ((float)xFragment * ((float)HEIGHMAP_RES / (float)div))) / ((float)HEIGHMAP_RES / (float)div));
-						float valueX2 = glm::mix(randNumberNextY, randNumberNextXY, ((float)i - ((float)xFragment * ((float)HEIGHMAP_RES / (float)div))) / ((float)HEIGHMAP_RES / (float)div));
-						float bilinearValue = glm::mix(valueX1, valueX2, ((float)j - (float)yFragment * (HEIGHMAP_RES / div)) / ((float)HEIGHMAP_RES / (float)div));
-						m_heightMap[i][j] += bilinearValue * weight;
-					}
-				}
-			}
+			tileCache.loadHeightField(m_heightField, m_threadPool);
+			cachedHeightSummary = std::make_unique<TerrainQuadTree::HeightSummary>(tileCache.getHeightSummary());
+		}
+		else if (progressive)
+		{
+			// The refinement thread is started once the scene is recorded
+			m_progressiveGenerator = std::make_unique<HeightMapGenerator>(std::move(heightMapGenerator));
+			m_octaveSums = std::make_unique<HeightField>(createInfo.heightMapResolution, HEIGHMAP_TILE_SIZE);
+			m_refinedHeightField = std::make_unique<HeightField>(createInfo.heightMapResolution, HEIGHMAP_TILE_SIZE);
+			m_generatedOctaveCount = HEIGHMAP_PROGRESSIVE_FIRST_OCTAVE_COUNT;
+			m_progressiveGenerator->generateOctaves(*m_octaveSums, m_heightField, 0, m_generatedOctaveCount, m_threadPool);
+			Debug::sendInfo("Progressive generation: " + std::to_string(m_generatedOctaveCount) + " of " + std::to_string(m_progressiveGenerator->getOctaveCount()) + " octaves");
 		}
-		totalWeight += weight;
-		weight -= 0.1f;
-		weight = std::max(weight, 0.1f);
+		else
+			heightMapGenerator.generate(m_heightField, m_threadPool);
 	}
+	else if (!demLoaded)
+		generateHeightMapOnGPU(wolfInstance, createInfo.heightMapGeneration);
 
-	for (int i = 0; i < HEIGHMAP_RES; ++i)
+	m_gridInfo.topLeftPos = glm::vec3(-100.0f, 0.0f, -100.0f);
+	m_gridInfo.tileSize = glm::vec3(HEIGHMAP_WORLD_SIZE / createInfo.heightMapResolution, 0.0f, HEIGHMAP_WORLD_SIZE / createInfo.heightMapResolution);
+	m_gridInfo.maxHeight = 50.0f;
+
+	if (!demLoaded && createInfo.useErosion)
 	{
-		for (int j = 0; j < HEIGHMAP_RES; ++j)
-		{
-			m_heightMap[i][j] /= totalWeight;
-		}
+		const auto startTime = std::chrono::steady_clock::now();
+		TerrainErosion erosion(createInfo.erosionParameters);
+		erosion.erode(m_heightField, m_gridInfo, m_threadPool);
+		// The generated image and the cached summary have the heights before erosion
+		m_generatedHeightImage = nullptr;
+		cachedHeightSummary = nullptr;
+		Debug::sendInfo("Erosion: " + std::to_string(createInfo.erosionParameters.dropletCount) + " droplets, " +
+			std::to_string(createInfo.erosionParameters.thermalIterationCount) + " thermal iterations in " +
+			std::to_string(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count()) + " ms");
 	}
 
-	std::vector<glm::vec3> vertices;
-	std::vector<uint32_t> indices;
+	// Terrain chunks: in mesh mode the heights of all LOD patches are in one vertex buffer and they share the indices of a single patch,
+	// in displacement mode there is only this single patch and the heights come from a texture, in tessellation mode the patch is reduced to its corners
+	m_terrain = std::make_unique<TerrainQuadTree>(m_heightField, HEIGHMAP_CHUNK_SIZE, m_gridInfo, m_threadPool, hasMeshVertices(),
+		cachedHeightSummary.get());
+	m_normalMap = std::make_unique<TerrainNormalMap>(wolfInstance, m_heightField, m_gridInfo, m_threadPool);
+	m_horizonMap = std::make_unique<TerrainHorizonMap>(wolfInstance, m_heightField, m_gridInfo, m_threadPool);
+	m_heightPyramid = std::make_unique<TerrainHeightPyramid>(m_heightField, m_gridInfo, m_threadPool);
 
-	glm::vec3 topLeftPos(-100.0f, 0.0f, -100.0f);
-	glm::vec3 tileSize(0.5f, 0.0f, 0.5f);
-	float maxHeight = 50.0f;
+	// The vertices keep their order: the shaders and the edits find a vertex from its index. The ranges drawn separately are reordered separately
+	auto optimizeIndices = [&](std::vector<uint32_t> indices, uint32_t vertexCount, const std::vector<size_t>& rangeEnds, const std::string& name)
+	{
+		if (createInfo.optimizeIndices)
+			Debug::sendInfo(name + " indices: " + MeshOptimizer::toString(MeshOptimizer::optimizeIndices(indices, vertexCount, rangeEnds)));
+		return indices;
+	};
 
-	for (int i = 0; i < HEIGHMAP_RES - 1; ++i)
+	Model::ModelCreateInfo modelCreateInfo{};
+	modelCreateInfo.inputVertexTemplate = InputVertexTemplate::NO;
+	std::unique_ptr<TerrainRTIN> adaptiveMesh;
+	if (m_terrainRenderMode == TerrainRenderMode::MESH)
 	{
-		for (int j = 0; j < HEIGHMAP_RES - 1; ++j)
-		{
-			int firstIndice = vertices.size();
+		m_model = wolfInstance->createModel<MeshVertex>(modelCreateInfo);
+		m_meshID = m_model->addMeshFromVertices((void*)m_terrain->getVertices().data(), m_terrain->getVertices().size(), sizeof(MeshVertex),
+			optimizeIndices(m_terrain->getPatchIndices(), m_terrain->getVertexCountPerNode(), {}, "Patch")); // data are pushed to GPU here
+	}
+	else if (m_terrainRenderMode == TerrainRenderMode::ADAPTIVE)
+	{
+		adaptiveMesh = std::make_unique<TerrainRTIN>(m_heightField, HEIGHMAP_CHUNK_SIZE, m_gridInfo.maxHeight, m_threadPool);
+		adaptiveMesh->buildIndices(HEIGHMAP_ADAPTIVE_MAX_ERROR, m_threadPool);
+		Debug::sendInfo("Adaptive terrain: " + std::to_string(adaptiveMesh->getIndices().size() / 3) + " triangles instead of " +
+			std::to_string(2ull * createInfo.heightMapResolution * createInfo.heightMapResolution));
+
+		std::vector<size_t> chunkEnds;
+		for (uint32_t chunkI = 0; chunkI < adaptiveMesh->getChunkCountPerSide(); ++chunkI)
+			for (uint32_t chunkJ = 0; chunkJ < adaptiveMesh->getChunkCountPerSide(); ++chunkJ)
+				chunkEnds.push_back(adaptiveMesh->getChunkRange(chunkI, chunkJ).firstIndex + adaptiveMesh->getChunkRange(chunkI, chunkJ).indexCount);
+		std::sort(chunkEnds.begin(), chunkEnds.end());
 
-			vertices.push_back(glm::vec3(topLeftPos.x + i * tileSize.x, m_heightMap[i][j] * maxHeight, topLeftPos.z + j * tileSize.z));
-			vertices.push_back(glm::vec3(topLeftPos.x + (i + 1) * tileSize.x, m_heightMap[i + 1][j] * maxHeight, topLeftPos.z + j * tileSize.z));
-			vertices.push_back(glm::vec3(topLeftPos.x + i * tileSize.x, m_heightMap[i][j + 1] * maxHeight, topLeftPos.z + (j + 1) * tileSize.z));
-			vertices.push_back(glm::vec3(topLeftPos.x + (i + 1) * tileSize.x, m_heightMap[i + 1][j + 1] * maxHeight, topLeftPos.z + (j + 1) * tileSize.z));
+		m_model = wolfInstance->createModel<MeshVertex>(modelCreateInfo);
+		m_meshID = m_model->addMeshFromVertices((void*)m_terrain->getVertices().data(), m_terrain->getVertices().size(), sizeof(MeshVertex),
+			optimizeIndices(adaptiveMesh->getIndices(), m_terrain->getVertexCountPerNode(), chunkEnds, "Adaptive"));
+	}
+	else if (m_terrainRenderMode == TerrainRenderMode::CLIPMAP)
+	{
+		m_clipmap = std::make_unique<TerrainClipmap>(wolfInstance, m_heightField, m_threadPool);
 
-			indices.push_back(firstIndice);
-			indices.push_back(firstIndice + 1);
-			indices.push_back(firstIndice + 2);
+		std::vector<glm::vec2> gridVertices;
+		std::vector<uint32_t> gridIndices;
+		TerrainClipmap::buildGeometry(gridVertices, gridIndices);
+		std::vector<PatchVertex> patchVertices;
+		for (const glm::vec2& gridVertex : gridVertices)
+			patchVertices.push_back({ gridVertex });
+		m_model = wolfInstance->createModel<PatchVertex>(modelCreateInfo);
+		std::vector<size_t> variantEnds;
+		for (uint32_t variant = 0; variant < 5; ++variant)
+			variantEnds.push_back(TerrainClipmap::getIndexRange(variant).firstIndex + TerrainClipmap::getIndexRange(variant).indexCount);
+		m_model->addMeshFromVertices(patchVertices.data(), patchVertices.size(), sizeof(PatchVertex),
+			optimizeIndices(std::move(gridIndices), static_cast<uint32_t>(patchVertices.size()), variantEnds, "Clipmap"));
+	}
+	else
+	{
+		if (m_generatedHeightImage)
+			m_heightTexture = std::make_unique<TerrainHeightTexture>(m_generatedHeightImage, m_heightField, m_threadPool);
+		else
+			m_heightTexture = std::make_unique<TerrainHeightTexture>(wolfInstance, m_heightField, m_threadPool);
 
-			indices.push_back(firstIndice + 1);
-			indices.push_back(firstIndice + 3);
-			indices.push_back(firstIndice + 2);
+		std::vector<PatchVertex> patchVertices;
+		m_model = wolfInstance->createModel<PatchVertex>(modelCreateInfo);
+		if (m_terrainRenderMode == TerrainRenderMode::TESSELLATION)
+		{
+			// Control points in the order of Shaders/scene/tessellation.tesc
+			const float chunkSize = static_cast<float>(m_terrain->getChunkSize());
+			patchVertices = { { glm::vec2(0.0f, 0.0f) }, { glm::vec2(chunkSize, 0.0f) }, { glm::vec2(0.0f, chunkSize) }, { glm::vec2(chunkSize, chunkSize) } };
+			m_model->addMeshFromVertices(patchVertices.data(), patchVertices.size(), sizeof(PatchVertex), { 0, 1, 2, 3 });
+		}
+		else
+		{
+			for (uint32_t a = 0; a <= m_terrain->getChunkSize(); ++a)
+				for (uint32_t b = 0; b <= m_terrain->getChunkSize(); ++b)
+					patchVertices.push_back({ glm::vec2(static_cast<float>(a), static_cast<float>(b)) });
+			m_model->addMeshFromVertices(patchVertices.data(), patchVertices.size(), sizeof(PatchVertex),
+				optimizeIndices(m_terrain->getPatchIndices(), static_cast<uint32_t>(patchVertices.size()), {}, "Patch"));
 		}
 	}
 
-	Model::ModelCreateInfo modelCreateInfo{};
-	modelCreateInfo.inputVertexTemplate = InputVertexTemplate::NO;
-	Model* model = wolfInstance->createModel<Vertex3D>(modelCreateInfo);
-	model->addMeshFromVertices(vertices.data(), vertices.size(), sizeof(Vertex3D), indices); // data are pushed to GPU here
+	// Kept for the height ranges updated by the edits. The clipmap levels are written by updateClipmap()
+	if (m_clipmap)
+		m_chunkInstances.resize(m_clipmap->getLevelCount(), ChunkInstance{});
+	else
+	{
+		m_chunkInstances.resize(m_terrain->getNodeCount());
+		for (uint32_t nodeIndex = 0; nodeIndex < m_terrain->getNodeCount(); ++nodeIndex)
+		{
+			const TerrainQuadTree::NodeGrid nodeGrid = m_terrain->getNodeGrid(nodeIndex);
+			m_chunkInstances[nodeIndex].grid = glm::vec4(nodeGrid.i, nodeGrid.j, nodeGrid.stride, nodeGrid.level);
+			m_chunkInstances[nodeIndex].heightRange = m_terrain->getNodeHeightRange(nodeIndex);
+		}
+	}
+	m_chunkInstance = wolfInstance->createInstanceBuffer<ChunkInstance>();
+	m_chunkInstance->loadFromVector(m_chunkInstances);
+	InstanceBuffer chunkInstanceBuffer = m_chunkInstance->getInstanceBuffer();
 
 	RendererCreateInfo rendererCreateInfo;
 
 	ShaderCreateInfo vertexShaderCreateInfo{};
-	vertexShaderCreateInfo.filename = "Shaders/scene/vert.spv";
+	if (hasMeshVertices())
+		vertexShaderCreateInfo.filename = "Shaders/scene/vert.spv";
+	else if (m_terrainRenderMode == TerrainRenderMode::DISPLACEMENT)
+		vertexShaderCreateInfo.filename = "Shaders/scene/displacementVert.spv";
+	else if (m_terrainRenderMode == TerrainRenderMode::CLIPMAP)
+		vertexShaderCreateInfo.filename = "Shaders/scene/clipmapVert.spv";
+	else
+		vertexShaderCreateInfo.filename = "Shaders/scene/tessellationVert.spv";
 	vertexShaderCreateInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
 	rendererCreateInfo.pipelineCreateInfo.shaderCreateInfos.push_back(vertexShaderCreateInfo);
 
+	if (m_terrainRenderMode == TerrainRenderMode::TESSELLATION)
+	{
+		ShaderCreateInfo tessellationControlShaderCreateInfo{};
+		tessellationControlShaderCreateInfo.filename = "Shaders/scene/tessellationTesc.spv";
+		tessellationControlShaderCreateInfo.stage = VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+		rendererCreateInfo.pipelineCreateInfo.shaderCreateInfos.push_back(tessellationControlShaderCreateInfo);
+
+		ShaderCreateInfo tessellationEvaluationShaderCreateInfo{};
+		tessellationEvaluationShaderCreateInfo.filename = "Shaders/scene/tessellationTese.spv";
+		tessellationEvaluationShaderCreateInfo.stage = VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+		rendererCreateInfo.pipelineCreateInfo.shaderCreateInfos.push_back(tessellationEvaluationShaderCreateInfo);
+
+		rendererCreateInfo.pipelineCreateInfo.topology = VK_PRIMITIVE_TOPOLOGY_PATCH_LIST;
+		rendererCreateInfo.pipelineCreateInfo.patchControlPoint = 4;
+	}
+
 	ShaderCreateInfo fragmentShaderCreateInfo{};
 	fragmentShaderCreateInfo.filename = "Shaders/scene/frag.spv";
 	fragmentShaderCreateInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
@@ -104,8 +212,18 @@ using namespace Wolf;
 
 	rendererCreateInfo.inputVerticesTemplate = InputVertexTemplate::NO;
 	rendererCreateInfo.instanceTemplate = InstanceTemplate::NO;
-	rendererCreateInfo.pipelineCreateInfo.vertexInputBindingDescriptions = { Vertex3D::getBindingDescription(0) };
-	rendererCreateInfo.pipelineCreateInfo.vertexInputAttributeDescriptions = { Vertex3D::getAttributeDescriptions(0) };
+	if (hasMeshVertices())
+	{
+		rendererCreateInfo.pipelineCreateInfo.vertexInputBindingDescriptions = { MeshVertex::getBindingDescription(0), ChunkInstance::getBindingDescription(1) };
+		rendererCreateInfo.pipelineCreateInfo.vertexInputAttributeDescriptions = MeshVertex::getAttributeDescriptions(0);
+	}
+	else
+	{
+		rendererCreateInfo.pipelineCreateInfo.vertexInputBindingDescriptions = { PatchVertex::getBindingDescription(0), ChunkInstance::getBindingDescription(1) };
+		rendererCreateInfo.pipelineCreateInfo.vertexInputAttributeDescriptions = PatchVertex::getAttributeDescriptions(0);
+	}
+	for (const VkVertexInputAttributeDescription& attributeDescription : ChunkInstance::getAttributeDescriptions(1, 1))
+		rendererCreateInfo.pipelineCreateInfo.vertexInputAttributeDescriptions.push_back(attributeDescription);
 	rendererCreateInfo.renderPassID = m_renderPassID;
 
 	rendererCreateInfo.pipelineCreateInfo.polygonMode = VK_POLYGON_MODE_LINE;
@@ -118,8 +236,41 @@ using namespace Wolf;
 	m_ubData.projection[1][1] *= -1;
 	m_ubData.view = glm::lookAt(glm::vec3(-2.0f, 2.0f, 2.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
 	m_ubData.model = glm::scale(glm::mat4(1.0f), glm::vec3(1.0f));
+	m_ubData.cameraPosition = glm::vec4(0.0f);
+	m_lodDistanceScale = static_cast<float>(wolfInstance->getWindowSize().height) / (2.0f * glm::tan(glm::radians(45.0f) * 0.5f));
+	m_terrain->updateRanges(m_lodDistanceScale, HEIGHMAP_MAX_PIXEL_ERROR);
+	updateMorphRanges();
+	m_ubData.terrainGrid = glm::vec4(m_gridInfo.topLeftPos.x, m_gridInfo.topLeftPos.z, m_gridInfo.tileSize.x, m_gridInfo.tileSize.z);
+	m_ubData.terrainHeight = glm::vec4(m_gridInfo.maxHeight, static_cast<float>(createInfo.heightMapResolution), static_cast<float>(m_terrain->getChunkSize()), 0.0f);
+	m_ubData.tessellation = glm::vec4(m_lodDistanceScale, HEIGHMAP_TESSELLATION_EDGE_PIXELS, 0.0f, 0.0f);
 	m_ub = wolfInstance->createUniformBufferObject(&m_ubData, sizeof(m_ubData));
-	descriptorSetGenerator.addUniformBuffer(m_ub, VK_SHADER_STAGE_VERTEX_BIT, 0);
+	const VkShaderStageFlags geometryStages = m_terrainRenderMode == TerrainRenderMode::TESSELLATION ?
+		VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT | VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT : VK_SHADER_STAGE_VERTEX_BIT;
+	descriptorSetGenerator.addUniformBuffer(m_ub, geometryStages, 0);
+
+	if (m_heightTexture || m_clipmap)
+	{
+		Sampler* heightSampler = wolfInstance->createSampler(VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE, 1.0f, VK_FILTER_NEAREST, 1.0f);
+		descriptorSetGenerator.addCombinedImageSampler(m_heightTexture ? m_heightTexture->getImage() : m_clipmap->getImage(), heightSampler, geometryStages, 1);
+	}
+
+	Sampler* normalSampler = wolfInstance->createSampler(VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE, 1.0f, VK_FILTER_LINEAR, 1.0f);
+	descriptorSetGenerator.addCombinedImageSampler(m_normalMap->getImage(), normalSampler, VK_SHADER_STAGE_FRAGMENT_BIT, 2);
+	for (uint32_t imageIndex = 0; imageIndex < TERRAIN_HORIZON_MAP_IMAGE_COUNT; ++imageIndex)
+		descriptorSetGenerator.addCombinedImageSampler(m_horizonMap->getImage(imageIndex), normalSampler, VK_SHADER_STAGE_FRAGMENT_BIT, 3 + imageIndex);
+
+	// The shading always samples a water depth
+	if (createInfo.simulateWater)
+		m_water = std::make_unique<TerrainWater>(wolfInstance, m_heightField, m_gridInfo, createInfo.waterParameters, m_threadPool);
+	else
+	{
+		const float noWaterDepth = 0.0f;
+		m_noWaterImage = wolfInstance->createImage({ 1, 1, 1 }, VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT, VK_FORMAT_R32_SFLOAT, VK_SAMPLE_COUNT_1_BIT,
+			VK_IMAGE_ASPECT_COLOR_BIT);
+		m_noWaterImage->copyFromPixels(&noWaterDepth, sizeof(float), { 0, 0 }, { 1, 1 }, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+	}
+	descriptorSetGenerator.addCombinedImageSampler(m_water ? m_water->getImage() : m_noWaterImage, normalSampler, VK_SHADER_STAGE_FRAGMENT_BIT,
+		3 + TERRAIN_HORIZON_MAP_IMAGE_COUNT);
 
 	rendererCreateInfo.descriptorLayouts = descriptorSetGenerator.getDescriptorLayouts();
 
@@ -127,25 +278,418 @@ using namespace Wolf;
 
 	// Link the model to the renderer
 	Renderer::AddMeshInfo addMeshInfo{};
-	addMeshInfo.vertexBuffer = model->getVertexBuffers()[0];
+	addMeshInfo.vertexBuffer = m_model->getVertexBuffers()[0];
+	addMeshInfo.instanceBuffer = chunkInstanceBuffer;
 	addMeshInfo.renderPassID = m_renderPassID;
 	addMeshInfo.rendererID = m_rendererID;
 
+	// Written each frame by update(), the command buffers never change. The adaptive triangulation draws every leaf chunk with its own indices,
+	// the tessellation draws every leaf patch and leaves the LOD and the culling to the tessellation control shader
+	m_drawCommands.resize(m_clipmap ? m_clipmap->getLevelCount() : m_terrain->getMaxSelectedNodeCount(), VkDrawIndexedIndirectCommand{});
+	if (m_terrainRenderMode == TerrainRenderMode::TESSELLATION)
+	{
+		uint32_t leafIndex = 0;
+		for (uint32_t nodeIndex = 0; nodeIndex < m_terrain->getNodeCount(); ++nodeIndex)
+		{
+			if (m_terrain->getNodeGrid(nodeIndex).level != 0)
+				continue;
+
+			VkDrawIndexedIndirectCommand& drawCommand = m_drawCommands[leafIndex++];
+			drawCommand.indexCount = 4;
+			drawCommand.instanceCount = 1;
+			drawCommand.firstInstance = nodeIndex;
+		}
+	}
+	else if (adaptiveMesh)
+	{
+		uint32_t leafIndex = 0;
+		for (uint32_t nodeIndex = 0; nodeIndex < m_terrain->getNodeCount(); ++nodeIndex)
+		{
+			const TerrainQuadTree::NodeGrid nodeGrid = m_terrain->getNodeGrid(nodeIndex);
+			if (nodeGrid.level != 0)
+				continue;
+
+			const TerrainRTIN::ChunkRange& chunkRange = adaptiveMesh->getChunkRange(nodeGrid.i / m_terrain->getChunkSize(), nodeGrid.j / m_terrain->getChunkSize());
+			VkDrawIndexedIndirectCommand& drawCommand = m_drawCommands[leafIndex++];
+			drawCommand.indexCount = chunkRange.indexCount;
+			drawCommand.instanceCount = 1;
+			drawCommand.firstIndex = chunkRange.firstIndex;
+			drawCommand.vertexOffset = static_cast<int32_t>(nodeIndex * m_terrain->getVertexCountPerNode());
+			drawCommand.firstInstance = nodeIndex;
+		}
+	}
+	m_drawCommandsBuffer = wolfInstance->createUniformBufferObject(m_drawCommands.data(), m_drawCommands.size() * sizeof(VkDrawIndexedIndirectCommand),
+		VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT);
+	addMeshInfo.indirectBuffer.indirectBuffer = m_drawCommandsBuffer->getUniformBuffer();
+	addMeshInfo.indirectBuffer.drawCount = static_cast<uint32_t>(m_drawCommands.size());
+
 	addMeshInfo.descriptorSetCreateInfo = descriptorSetGenerator.getDescritorSetCreateInfo();
 
 	m_scene->addMesh(addMeshInfo);
 
+	// Drawn after the terrain in the same render pass, the culling command buffer is submitted before it
+	if (createInfo.scatterProps)
+	{
+		m_vegetation = std::make_unique<TerrainVegetation>(wolfInstance, m_scene, m_renderPassID, m_heightField, m_gridInfo, m_threadPool);
+		if (m_vegetation->getInstanceCount() == 0)
+			m_vegetation.reset();
+	}
+
 	m_camera.initialize(glm::vec3(0.0f, 50.0f, 0.0f), glm::vec3(2.0f, 0.9f, -0.3f), glm::vec3(0.0f, 1.0f, 0.0f), 0.01f, 5.0f,
 		16.0f / 9.0f);
 
 	// Record
 	m_scene->record();
+	m_lastUpdateTime = std::chrono::steady_clock::now();
+
+	if (m_progressiveGenerator)
+		m_refinementThread = std::thread(&::Scene::refineHeightField, this);
+}
+
+::Scene::~Scene()
+{
+	if (m_refinementThread.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_refinementMutex);
+			m_stopRefinement = true;
+		}
+		m_refinementCondition.notify_all();
+		m_refinementThread.join();
+	}
+}
+
+bool ::Scene::isHeightMapResolutionValid(uint32_t heightMapResolution)
+{
+	const uint32_t blockSize = std::max(HEIGHMAP_TILE_SIZE, HEIGHMAP_CHUNK_SIZE);
+	if (heightMapResolution < blockSize || heightMapResolution % blockSize != 0)
+		return false;
+
+	const uint32_t chunkCountPerSide = heightMapResolution / HEIGHMAP_CHUNK_SIZE;
+	return (chunkCountPerSide & (chunkCountPerSide - 1)) == 0;
+}
+
+void ::Scene::generateHeightMapOnGPU(Wolf::WolfInstance* wolfInstance, HeightMapGeneration heightMapGeneration)
+{
+	HeightMapGeneratorGPU heightMapGenerator(wolfInstance, m_heightField.getResolution());
+	heightMapGenerator.generate(m_threadPool);
+	// The LOD bounds and errors are computed on the CPU
+	heightMapGenerator.readBack(m_heightField, m_threadPool);
+	m_generatedHeightImage = heightMapGenerator.getImage();
+
+	if (heightMapGeneration == HeightMapGeneration::GPU_VERIFY)
+	{
+		HeightField reference(m_heightField.getResolution(), HEIGHMAP_TILE_SIZE);
+		HeightMapGenerator referenceGenerator(m_heightField.getResolution());
+		referenceGenerator.generate(reference, m_threadPool);
+
+		float maxDifference = 0.0f;
+		uint32_t differentCount = 0;
+		for (uint32_t i = 0; i < m_heightField.getResolution(); ++i)
+		{
+			for (uint32_t j = 0; j < m_heightField.getResolution(); ++j)
+			{
+				const float difference = std::abs(m_heightField.get(i, j) - reference.get(i, j));
+				maxDifference = std::max(maxDifference, difference);
+				if (difference != 0.0f)
+					++differentCount;
+			}
+		}
+		Debug::sendInfo("GPU heightmap: " + std::to_string(differentCount) + " heights differ from the CPU reference, max difference " + std::to_string(maxDifference));
+	}
+}
+
+bool ::Scene::loadDEM(const std::string& filename)
+{
+	DEMFile demFile;
+	if (!demFile.open(filename))
+	{
+		Debug::sendError("Can't open elevation file " + filename + ", the heightmap is generated");
+		return false;
+	}
+
+	demFile.loadHeightField(m_heightField, m_threadPool);
+	Debug::sendInfo("Elevation file " + filename + " (" + std::to_string(demFile.getWidth()) + "x" + std::to_string(demFile.getHeight()) + ") resampled to " +
+		std::to_string(m_heightField.getResolution()) + "x" + std::to_string(m_heightField.getResolution()));
+
+	return true;
+}
+
+void ::Scene::updateMorphRanges()
+{
+	for (uint32_t level = 0; level < TERRAIN_MAX_LOD_COUNT; ++level)
+		m_ubData.morphRanges[level] = level < m_terrain->getLevelCount() ? glm::vec4(m_terrain->getMorphRange(level), 0.0f, 0.0f) : glm::vec4(0.0f);
+	// The adaptive triangulation only uses the leaves, which never morph
+	if (m_terrainRenderMode == TerrainRenderMode::ADAPTIVE)
+		m_ubData.morphRanges[0] = glm::vec4(std::numeric_limits<float>::max(), 1.0f, 0.0f, 0.0f);
+}
+
+void ::Scene::refineHeightField()
+{
+	for (uint32_t octave = HEIGHMAP_PROGRESSIVE_FIRST_OCTAVE_COUNT; octave < m_progressiveGenerator->getOctaveCount(); ++octave)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_refinementMutex);
+			m_refinementCondition.wait(lock, [this] { return !m_refinementReady || m_stopRefinement; });
+			if (m_stopRefinement)
+				return;
+		}
+
+		// The sums are only touched here, the refined heights and their data are not read by the main thread before they are ready
+		m_progressiveGenerator->generateOctaves(*m_octaveSums, *m_refinedHeightField, octave, octave + 1, m_threadPool);
+		buildRefinedData(octave + 1 == m_progressiveGenerator->getOctaveCount());
+
+		{
+			std::lock_guard<std::mutex> lock(m_refinementMutex);
+			m_refinementReady = true;
+		}
+	}
+}
+
+void ::Scene::buildRefinedData(bool lastOctave)
+{
+	const uint32_t resolution = m_refinedHeightField->getResolution();
+	m_refinedTerrain.reset();
+	m_refinedTerrain = std::make_unique<TerrainQuadTree>(*m_refinedHeightField, HEIGHMAP_CHUNK_SIZE, m_gridInfo, m_threadPool, hasMeshVertices());
+	m_refinedHeightPyramid.reset();
+	m_refinedHeightPyramid = std::make_unique<TerrainHeightPyramid>(*m_refinedHeightField, m_gridInfo, m_threadPool);
+	m_refinedNormalTexels.resize(static_cast<size_t>(resolution) * resolution);
+	TerrainNormalMap::computeRegion(*m_refinedHeightField, m_gridInfo, 0, 0, resolution, resolution, m_refinedNormalTexels.data(), resolution, m_threadPool);
+	if (m_heightTexture)
+		TerrainHeightTexture::computeRegion(*m_refinedHeightField, 0, 0, resolution, resolution, m_refinedHeightTexels, m_threadPool);
+	if (m_water)
+		ShallowWater::computeTerrainHeights(*m_refinedHeightField, m_gridInfo, m_refinedWaterTerrain);
+
+	// The horizons are only swept for the final heights
+	if (!lastOctave)
+		return;
+	for (uint32_t imageIndex = 0; imageIndex < TERRAIN_HORIZON_MAP_IMAGE_COUNT; ++imageIndex)
+	{
+		m_refinedHorizonTexels[imageIndex].resize(static_cast<size_t>(resolution) * resolution);
+		TerrainHorizonMap::computeTexels(*m_refinedHeightField, m_gridInfo, 4 * imageIndex, m_refinedHorizonTexels[imageIndex].data(), m_threadPool);
+	}
+}
+
+void ::Scene::updateRefinement()
+{
+	if (!m_progressiveGenerator)
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(m_refinementMutex);
+		if (!m_refinementReady)
+			return;
+	}
+
+	// Every user of the heights keeps a reference to m_heightField, only the samples and the data built from them are exchanged. The refinement thread
+	// doesn't touch them before m_refinementReady is cleared
+	std::swap(m_heightField, *m_refinedHeightField);
+	m_terrain->swapHeightData(*m_refinedTerrain);
+	m_heightPyramid->swapHeightData(*m_refinedHeightPyramid);
+	if (m_water)
+		m_water->getSimulation().swapTerrainHeights(m_refinedWaterTerrain);
+	m_terrain->updateRanges(m_lodDistanceScale, HEIGHMAP_MAX_PIXEL_ERROR);
+	updateMorphRanges();
+	++m_generatedOctaveCount;
+	const bool lastOctave = m_generatedOctaveCount == m_progressiveGenerator->getOctaveCount();
+
+	// Only the uploads are left to the main thread
+	const uint32_t resolution = m_heightField.getResolution();
+	m_normalMap->uploadRegion(0, 0, resolution, resolution, m_refinedNormalTexels.data());
+	if (m_heightTexture)
+		m_heightTexture->uploadRegion(0, 0, resolution, resolution, m_refinedHeightTexels);
+	if (m_clipmap)
+		m_clipmap->updateRegion(0, 0, resolution, resolution);
+	if (lastOctave)
+		m_horizonMap->swapTexels(m_refinedHorizonTexels);
+	m_updatedNodes.resize(m_terrain->getNodeCount());
+	for (uint32_t nodeIndex = 0; nodeIndex < m_terrain->getNodeCount(); ++nodeIndex)
+		m_updatedNodes[nodeIndex] = nodeIndex;
+	uploadNodes(m_updatedNodes);
+	Debug::sendInfo("Progressive generation: " + std::to_string(m_generatedOctaveCount) + " of " + std::to_string(m_progressiveGenerator->getOctaveCount()) + " octaves");
+
+	{
+		std::lock_guard<std::mutex> lock(m_refinementMutex);
+		m_refinementReady = false;
+	}
+	m_refinementCondition.notify_all();
+	if (!lastOctave)
+		return;
+
+	m_refinementThread.join();
+	m_progressiveGenerator.reset();
+	m_octaveSums.reset();
+	m_refinedHeightField.reset();
+	m_refinedTerrain.reset();
+	m_refinedHeightPyramid.reset();
+	m_refinedNormalTexels = std::vector<uint32_t>();
+	m_refinedHeightTexels = std::vector<uint16_t>();
+	m_refinedWaterTerrain = std::vector<float>();
+	m_refinedHorizonTexels = std::array<std::vector<uint32_t>, TERRAIN_HORIZON_MAP_IMAGE_COUNT>();
+}
+
+void ::Scene::updateEditing()
+{
+	const int modeKeys[] = { GLFW_KEY_1, GLFW_KEY_2, GLFW_KEY_3, GLFW_KEY_4 };
+	const TerrainEditor::BrushMode modes[] = { TerrainEditor::BrushMode::RAISE, TerrainEditor::BrushMode::LOWER, TerrainEditor::BrushMode::SMOOTH,
+		TerrainEditor::BrushMode::FLATTEN };
+	for (size_t i = 0; i < 4; ++i)
+		if (glfwGetKey(m_window, modeKeys[i]) == GLFW_PRESS)
+			m_brush.mode = modes[i];
+
+	// The edits would be lost at the next swap of the progressive generation. The adaptive triangulation is built once for the initial heights,
+	// edited heights would no longer be within HEIGHMAP_ADAPTIVE_MAX_ERROR of it
+	const bool wasEditing = m_editing;
+	m_editing = !m_progressiveGenerator && m_terrainRenderMode != TerrainRenderMode::ADAPTIVE && glfwGetMouseButton(m_window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS;
+	const TerrainHeightPyramid::RaycastHit hit = m_editing ?
+		m_heightPyramid->raycast({ m_camera.getPosition(), m_camera.getOrientation(), HEIGHMAP_PICKING_DISTANCE }) : TerrainHeightPyramid::RaycastHit();
+	if (hit.hit)
+	{
+		const glm::vec2 sample((hit.position.x - m_gridInfo.topLeftPos.x) / m_gridInfo.tileSize.x, (hit.position.z - m_gridInfo.topLeftPos.z) / m_gridInfo.tileSize.z);
+		// Flatten to the height under the center of the screen when the button is pressed
+		if (m_brush.mode == TerrainEditor::BrushMode::FLATTEN && !wasEditing)
+			m_brush.flattenHeight = m_heightField.get(static_cast<uint32_t>(std::lround(sample.x)), static_cast<uint32_t>(std::lround(sample.y)));
+		m_editor.apply(m_brush, sample.x, sample.y);
+	}
+
+	// Everything derived from the heights is updated over the edited regions only
+	m_editor.takeDirtyRegions(m_dirtyRegions);
+	for (const TerrainEditor::Region& region : m_dirtyRegions)
+	{
+		m_normalMap->updateRegion(region.i, region.j, region.height, region.width);
+		m_heightPyramid->updateRegion(region.i, region.j, region.height, region.width);
+		if (m_heightTexture)
+			m_heightTexture->updateRegion(region.i, region.j, region.height, region.width);
+		if (m_clipmap)
+			m_clipmap->updateRegion(region.i, region.j, region.height, region.width);
+		if (m_water)
+			m_water->getSimulation().updateRegion(region.i, region.j, region.height, region.width);
+
+		// The node bounds are also needed by the culling of the displacement mode and, through the chunk instances, of the tessellation mode
+		m_terrain->updateRegion(region.i, region.j, region.height, region.width, m_updatedNodes);
+		uploadNodes(m_updatedNodes);
+	}
+	// The horizons are swept again along the lines crossing all the edited samples at once. While the heights are refined they wait for the final ones
+	if (m_dirtyRegions.empty() || m_progressiveGenerator)
+		return;
+	uint32_t iStart = m_heightField.getResolution();
+	uint32_t jStart = m_heightField.getResolution();
+	uint32_t iEnd = 0;
+	uint32_t jEnd = 0;
+	for (const TerrainEditor::Region& region : m_dirtyRegions)
+	{
+		iStart = std::min(iStart, region.i);
+		jStart = std::min(jStart, region.j);
+		iEnd = std::max(iEnd, region.i + region.height);
+		jEnd = std::max(jEnd, region.j + region.width);
+	}
+	m_horizonMap->updateRegion(iStart, jStart, iEnd - iStart, jEnd - jStart);
+}
+
+void ::Scene::uploadNodes(const std::vector<uint32_t>& nodes)
+{
+	if (m_terrainRenderMode == TerrainRenderMode::DISPLACEMENT || m_terrainRenderMode == TerrainRenderMode::CLIPMAP)
+		return;
+
+	// Consecutive nodes are copied as one range
+	std::vector<std::pair<uint32_t, uint32_t>> nodeRanges;
+	for (uint32_t nodeIndex : nodes)
+	{
+		m_chunkInstances[nodeIndex].heightRange = m_terrain->getNodeHeightRange(nodeIndex);
+		if (!nodeRanges.empty() && nodeRanges.back().first + nodeRanges.back().second == nodeIndex)
+			++nodeRanges.back().second;
+		else
+			nodeRanges.emplace_back(nodeIndex, 1);
+	}
+	m_chunkInstance->updateInstances(nodeRanges, m_chunkInstances.data());
+	if (!hasMeshVertices())
+		return;
+
+	std::vector<std::pair<uint32_t, uint32_t>> vertexRanges;
+	for (const std::pair<uint32_t, uint32_t>& nodeRange : nodeRanges)
+		vertexRanges.emplace_back(nodeRange.first * m_terrain->getVertexCountPerNode(), nodeRange.second * m_terrain->getVertexCountPerNode());
+	m_model->updateMeshVertices(m_meshID, vertexRanges, m_terrain->getVertices().data());
 }
 
 void ::Scene::update()
 {
 	m_camera.update(m_window);
+	const glm::vec3 cameraPosition = m_camera.getPosition();
+	const float groundHeight = m_heightPyramid->getHeight(cameraPosition.x, cameraPosition.z) + HEIGHMAP_CAMERA_GROUND_CLEARANCE;
+	if (cameraPosition.y < groundHeight)
+		m_camera.setPosition(glm::vec3(cameraPosition.x, groundHeight, cameraPosition.z));
 	m_ubData.view = m_camera.getViewMatrix();
+	m_ubData.cameraPosition = glm::vec4(m_camera.getPosition(), 1.0f);
 
+	// The buffers written below (uniforms, indirect draws, instances) are read by the last submitted frame
+	m_scene->waitForLastFrame();
+	updateRefinement();
 	m_ub->updateData(&m_ubData);
-}
\ No newline at end of file
+	if (m_vegetation)
+		m_vegetation->update(m_ubData.projection * m_ubData.view * m_ubData.model, m_camera.getPosition());
+
+	updateEditing();
+
+	const std::chrono::steady_clock::time_point updateTime = std::chrono::steady_clock::now();
+	if (m_water)
+		updateWater(std::chrono::duration<float>(updateTime - m_lastUpdateTime).count());
+	m_lastUpdateTime = updateTime;
+
+	if (m_terrainRenderMode == TerrainRenderMode::CLIPMAP)
+		updateClipmap();
+	if (m_terrainRenderMode != TerrainRenderMode::MESH && m_terrainRenderMode != TerrainRenderMode::DISPLACEMENT)
+		return;
+
+	// LOD selection: the instance index of a draw selects the chunk instance data, in mesh mode a draw also starts at the vertices of its chunk
+	// while in displacement mode all draws use the same vertices
+	m_terrain->select(m_camera.getPosition(), m_ubData.projection * m_ubData.view * m_ubData.model, m_selectedNodes);
+	for (size_t i = 0; i < m_drawCommands.size(); ++i)
+	{
+		VkDrawIndexedIndirectCommand& drawCommand = m_drawCommands[i];
+		drawCommand = VkDrawIndexedIndirectCommand{};
+		if (i >= m_selectedNodes.size())
+			continue;
+
+		drawCommand.indexCount = static_cast<uint32_t>(m_terrain->getPatchIndices().size());
+		drawCommand.instanceCount = 1;
+		if (m_terrainRenderMode == TerrainRenderMode::MESH)
+			drawCommand.vertexOffset = static_cast<int32_t>(m_selectedNodes[i].nodeIndex * m_terrain->getVertexCountPerNode());
+		drawCommand.firstInstance = m_selectedNodes[i].nodeIndex;
+	}
+	m_drawCommandsBuffer->updateData(m_drawCommands.data());
+}
+
+void ::Scene::updateWater(float elapsedSeconds)
+{
+	// Poured at the center of the screen, as the brush
+	if (glfwGetMouseButton(m_window, GLFW_MOUSE_BUTTON_RIGHT) == GLFW_PRESS)
+	{
+		const TerrainHeightPyramid::RaycastHit hit = m_heightPyramid->raycast({ m_camera.getPosition(), m_camera.getOrientation(), HEIGHMAP_PICKING_DISTANCE });
+		if (hit.hit)
+			m_water->getSimulation().addWater((hit.position.x - m_gridInfo.topLeftPos.x) / m_gridInfo.tileSize.x, (hit.position.z - m_gridInfo.topLeftPos.z) / m_gridInfo.tileSize.z,
+				HEIGHMAP_WATER_POUR_RADIUS, HEIGHMAP_WATER_POUR_RATE * elapsedSeconds);
+	}
+
+	m_water->update(elapsedSeconds);
+}
+
+void ::Scene::updateClipmap()
+{
+	// One draw per level: the full grid for the finest one, the ring around the next finer level for the others
+	const glm::vec3 cameraPosition = m_camera.getPosition();
+	m_clipmap->update((cameraPosition.x - m_gridInfo.topLeftPos.x) / m_gridInfo.tileSize.x, (cameraPosition.z - m_gridInfo.topLeftPos.z) / m_gridInfo.tileSize.z);
+	for (uint32_t levelIndex = 0; levelIndex < m_clipmap->getLevelCount(); ++levelIndex)
+	{
+		const TerrainClipmap::Level& level = m_clipmap->getLevel(levelIndex);
+		m_chunkInstances[levelIndex].grid = glm::vec4(level.originI, level.originJ, 1u << levelIndex, levelIndex);
+
+		const TerrainClipmap::IndexRange indexRange = TerrainClipmap::getIndexRange(level.holeVariant);
+		VkDrawIndexedIndirectCommand& drawCommand = m_drawCommands[levelIndex];
+		drawCommand.indexCount = indexRange.indexCount;
+		drawCommand.instanceCount = 1;
+		drawCommand.firstIndex = indexRange.firstIndex;
+		drawCommand.firstInstance = levelIndex;
+	}
+	m_chunkInstance->updateInstances({ { 0, m_clipmap->getLevelCount() } }, m_chunkInstances.data());
+	m_drawCommandsBuffer->updateData(m_drawCommands.data());
+}
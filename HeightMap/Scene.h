@@ -1,44 +1,208 @@
 #pragma once
 
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
 #include <WolfEngine.h>
 #include <Template3D.h>
 
 #include "Camera.h"
+#include "DEMFile.h"
+#include "HeightMapGenerator.h"
+#include "HeightMapGeneratorGPU.h"
+#include "TerrainClipmap.h"
+#include "TerrainEditor.h"
+#include "TerrainErosion.h"
+#include "TerrainMeshBuilder.h"
+#include "TerrainHeightPyramid.h"
+#include "TerrainHeightTexture.h"
+#include "TerrainHorizonMap.h"
+#include "TerrainNormalMap.h"
+#include "TerrainQuadTree.h"
+#include "TerrainRTIN.h"
+#include "TerrainTileCache.h"
+#include "TerrainVegetation.h"
+#include "TerrainWater.h"
+#include "ThreadPool.h"
+
+#define HEIGHMAP_DEFAULT_RES 1024 // the resolution can be given on the command line
+#define HEIGHMAP_TILE_SIZE 64 // heightfield blocks, also the generation tiles
+#define HEIGHMAP_CHUNK_SIZE 64 // cells per side of a terrain LOD patch
+#define HEIGHMAP_WORLD_SIZE 512.0f // the terrain keeps its size whatever the resolution
+#define HEIGHMAP_MAX_PIXEL_ERROR 8.0f // tolerated projected height error of a terrain LOD, in pixels
+#define HEIGHMAP_ADAPTIVE_MAX_ERROR 0.1f // tolerated height error of the adaptive triangulation, in world units
+#define HEIGHMAP_TESSELLATION_EDGE_PIXELS 8.0f // target screen-space length of a tessellated edge, in pixels
+#define HEIGHMAP_CAMERA_GROUND_CLEARANCE 1.0f // minimum height of the camera above the terrain, in world units
+#define HEIGHMAP_PICKING_DISTANCE 1000.0f // brush picking range, in world units
+#define HEIGHMAP_WATER_POUR_RADIUS 8.0f // in samples, water poured with the right mouse button
+#define HEIGHMAP_WATER_POUR_RATE 2.0f // world units of depth per second at the center of the pour
+#define HEIGHMAP_PROGRESSIVE_FIRST_OCTAVE_COUNT 3 // value noise octaves generated before the first frame, the others are added in the background
+
+enum class TerrainRenderMode
+{
+	MESH, // LOD patches baked in one vertex buffer
+	DISPLACEMENT, // one grid patch displaced in the vertex shader by the heightmap texture
+	ADAPTIVE, // full resolution chunks of the mesh mode vertex buffer triangulated by TerrainRTIN, without LOD nor editing
+	TESSELLATION, // one 4 control point patch per leaf chunk, subdivided by the tessellation shaders and displaced by the heightmap texture
+	CLIPMAP // nested grids around the camera displaced by toroidal height textures, see TerrainClipmap
+};
 
-#define HEIGHMAP_RES 1024
+enum class HeightMapGeneration
+{
+	CPU,
+	GPU, // compute pass, the heights are read back for the CPU side
+	GPU_VERIFY // GPU, then compared with the CPU reference
+};
 
 class Scene
 {
 public:
-	Scene(Wolf::WolfInstance* wolfInstance);
+	struct SceneCreateInfo
+	{
+		uint32_t heightMapResolution = HEIGHMAP_DEFAULT_RES;
+		TerrainRenderMode terrainRenderMode = TerrainRenderMode::MESH;
+		HeightMapGeneration heightMapGeneration = HeightMapGeneration::CPU;
+		bool useFractalNoise = false; // CPU generation with the seeded fractal noise of noiseParameters instead of the value noise
+		FractalNoise::Parameters noiseParameters;
+		std::string demFilename; // 16-bit PGM or square RAW elevation file used instead of the generation when not empty
+		bool useErosion = false; // erodes the generated heights with erosionParameters
+		TerrainErosion::Parameters erosionParameters;
+		bool optimizeIndices = true; // vertex cache order of the terrain indices, see Wolf::MeshOptimizer
+		bool scatterProps = false; // grass, trees and rocks culled on the GPU, see TerrainVegetation
+		bool simulateWater = false; // shallow water poured with the right mouse button, see TerrainWater
+		ShallowWater::Parameters waterParameters;
+		// CPU value noise only: the coarse octaves are shown first and the finer ones replace the heights as they are generated.
+		// Ignored with a tile cache, erosion, props or the adaptive mode, which need the final heights
+		bool progressiveGeneration = false;
+	};
+	Scene(Wolf::WolfInstance* wolfInstance, ThreadPool* threadPool, const SceneCreateInfo& createInfo);
+	~Scene();
 
+	// A power of 2 multiple of both the tile and the chunk size
+	static bool isHeightMapResolutionValid(uint32_t heightMapResolution);
 	void update();
 
 	Wolf::Scene* getScene() const { return m_scene; }
-	std::vector<int> getCommandBufferToSubmit() { return {}; }
-	std::vector<std::pair<int, int>> getCommandBufferSynchronisation() { return {}; }
-
-private:
-	float rand(glm::vec2 co)
+	// The vegetation culling, waited for by the swap chain command buffer
+	std::vector<int> getCommandBufferToSubmit() { return m_vegetation ? std::vector<int>{ m_vegetation->getCommandBufferID() } : std::vector<int>(); }
+	std::vector<std::pair<int, int>> getCommandBufferSynchronisation()
 	{
-		return glm::fract(glm::sin(glm::dot(co, glm::vec2(12.9898f, 78.233f))) * 43758.5453f);
+		return m_vegetation ? std::vector<std::pair<int, int>>{ { m_vegetation->getCommandBufferID(), -1 } } : std::vector<std::pair<int, int>>();
 	}
 
+private:
+	void generateHeightMapOnGPU(Wolf::WolfInstance* wolfInstance, HeightMapGeneration heightMapGeneration);
+	bool loadDEM(const std::string& filename);
+	void updateEditing();
+	void updateClipmap();
+	void updateWater(float elapsedSeconds);
+	void updateMorphRanges();
+	// Background thread of the progressive generation: one octave at a time into m_refinedHeightField, which waits to be swapped by updateRefinement()
+	void refineHeightField();
+	// Refinement thread: everything the scene derives from the heights on the CPU, for m_refinedHeightField
+	void buildRefinedData(bool lastOctave);
+	// Main thread: takes the refined heights and their data when they are ready, and uploads them
+	void updateRefinement();
+	// Chunk instances and, in the mesh and adaptive modes, vertices of the nodes, in increasing order
+	void uploadNodes(const std::vector<uint32_t>& nodes);
+	// The mesh and adaptive modes draw the heights of the TerrainQuadTree vertices, the other modes read them from textures
+	bool hasMeshVertices() const { return m_terrainRenderMode == TerrainRenderMode::MESH || m_terrainRenderMode == TerrainRenderMode::ADAPTIVE; }
+
 private:
 	Camera m_camera;
 	GLFWwindow* m_window;
+	ThreadPool* m_threadPool;
 	
-	std::array<std::array<float, HEIGHMAP_RES>, HEIGHMAP_RES> m_heightMap;
+	TerrainRenderMode m_terrainRenderMode;
+	HeightField m_heightField;
+
+	std::unique_ptr<TerrainQuadTree> m_terrain;
+	std::unique_ptr<TerrainHeightTexture> m_heightTexture;
+	std::unique_ptr<TerrainClipmap> m_clipmap;
+	std::unique_ptr<TerrainNormalMap> m_normalMap;
+	std::unique_ptr<TerrainHorizonMap> m_horizonMap;
+	std::unique_ptr<TerrainHeightPyramid> m_heightPyramid; // picking and camera ground clamping
+	std::unique_ptr<TerrainVegetation> m_vegetation; // scattered on the initial heights, the edits don't move the props
+	std::unique_ptr<TerrainWater> m_water;
+	Wolf::Image* m_noWaterImage = nullptr; // 1 x 1 dry texel sampled when the water isn't simulated
+	std::chrono::steady_clock::time_point m_lastUpdateTime;
+	Wolf::Image* m_generatedHeightImage = nullptr;
+
+	// Progressive generation, released once every octave is added
+	std::unique_ptr<HeightMapGenerator> m_progressiveGenerator;
+	std::unique_ptr<HeightField> m_octaveSums;
+	std::unique_ptr<HeightField> m_refinedHeightField;
+	// Built from m_refinedHeightField by the refinement thread, exchanged with the ones of m_heightField along the samples
+	std::unique_ptr<TerrainQuadTree> m_refinedTerrain;
+	std::unique_ptr<TerrainHeightPyramid> m_refinedHeightPyramid;
+	std::vector<uint32_t> m_refinedNormalTexels;
+	std::vector<uint16_t> m_refinedHeightTexels; // with a height texture
+	std::vector<float> m_refinedWaterTerrain; // with water
+	std::array<std::vector<uint32_t>, TERRAIN_HORIZON_MAP_IMAGE_COUNT> m_refinedHorizonTexels; // last octave only
+	uint32_t m_generatedOctaveCount = 0;
+	std::thread m_refinementThread;
+	std::mutex m_refinementMutex;
+	std::condition_variable m_refinementCondition;
+	bool m_refinementReady = false; // m_refinedHeightField and its data belong to the main thread until they are swapped
+	bool m_stopRefinement = false;
+	std::vector<TerrainQuadTree::SelectedNode> m_selectedNodes;
+	float m_lodDistanceScale;
+	TerrainMeshBuilder::GridInfo m_gridInfo;
+
+	// Keys 1 to 4 select the brush mode, the left mouse button edits the terrain at the center of the screen
+	TerrainEditor m_editor;
+	TerrainEditor::Brush m_brush;
+	bool m_editing = false;
+	std::vector<TerrainEditor::Region> m_dirtyRegions;
+	std::vector<uint32_t> m_updatedNodes;
+
+	// Mesh mode: both heights of TerrainQuadTree::Vertex, the position and the chunk come from the vertex index and the chunk instance
+	struct MeshVertex
+	{
+		uint16_t height;
+		uint16_t morphHeight;
+
+		static VkVertexInputBindingDescription getBindingDescription(uint32_t binding)
+		{
+			VkVertexInputBindingDescription bindingDescription = {};
+			bindingDescription.binding = binding;
+			bindingDescription.stride = sizeof(MeshVertex);
+			bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+			return bindingDescription;
+		}
+
+		static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions(uint32_t binding)
+		{
+			std::vector<VkVertexInputAttributeDescription> attributeDescriptions(1);
 
-	struct Vertex3D
+			attributeDescriptions[0].binding = binding;
+			attributeDescriptions[0].location = 0;
+			attributeDescriptions[0].format = VK_FORMAT_R16G16_UNORM;
+			attributeDescriptions[0].offset = offsetof(MeshVertex, height);
+
+			return attributeDescriptions;
+		}
+
+		bool operator==(const MeshVertex& other) const
+		{
+			return height == other.height && morphHeight == other.morphHeight;
+		}
+	};
+	static_assert(sizeof(MeshVertex) == sizeof(TerrainQuadTree::Vertex), "The terrain vertices are uploaded as MeshVertex");
+
+	// Displacement, tessellation and clipmap modes: vertex or control point of the shared patch or grid. Per chunk (clipmap level) instance in all modes, the chunk of a draw is selected with its first instance
+	struct PatchVertex
 	{
-		glm::vec3 pos;
+		glm::vec2 patchPosition;
 
 		static VkVertexInputBindingDescription getBindingDescription(uint32_t binding)
 		{
 			VkVertexInputBindingDescription bindingDescription = {};
 			bindingDescription.binding = binding;
-			bindingDescription.stride = sizeof(Vertex3D);
+			bindingDescription.stride = sizeof(PatchVertex);
 			bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
 
 			return bindingDescription;
@@ -50,17 +214,55 @@ private:
 
 			attributeDescriptions[0].binding = binding;
 			attributeDescriptions[0].location = 0;
-			attributeDescriptions[0].format = VK_FORMAT_R32G32B32_SFLOAT;
-			attributeDescriptions[0].offset = offsetof(Vertex3D, pos);
+			attributeDescriptions[0].format = VK_FORMAT_R32G32_SFLOAT;
+			attributeDescriptions[0].offset = offsetof(PatchVertex, patchPosition);
 
 			return attributeDescriptions;
 		}
 
-		bool operator==(const Vertex3D& other) const
+		bool operator==(const PatchVertex& other) const
 		{
-			return pos == other.pos;
+			return patchPosition == other.patchPosition;
 		}
 	};
+
+	struct ChunkInstance
+	{
+		glm::vec4 grid; // first sample i, j, stride, LOD level
+		glm::vec2 heightRange; // mesh mode, to dequantize the heights: see TerrainQuadTree::getNodeHeightRange
+
+		static VkVertexInputBindingDescription getBindingDescription(uint32_t binding)
+		{
+			VkVertexInputBindingDescription bindingDescription = {};
+			bindingDescription.binding = binding;
+			bindingDescription.stride = sizeof(ChunkInstance);
+			bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+
+			return bindingDescription;
+		}
+
+		static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions(uint32_t binding, uint32_t startLocation)
+		{
+			std::vector<VkVertexInputAttributeDescription> attributeDescriptions(2);
+
+			attributeDescriptions[0].binding = binding;
+			attributeDescriptions[0].location = startLocation;
+			attributeDescriptions[0].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+			attributeDescriptions[0].offset = offsetof(ChunkInstance, grid);
+
+			attributeDescriptions[1].binding = binding;
+			attributeDescriptions[1].location = startLocation + 1;
+			attributeDescriptions[1].format = VK_FORMAT_R32G32_SFLOAT;
+			attributeDescriptions[1].offset = offsetof(ChunkInstance, heightRange);
+
+			return attributeDescriptions;
+		}
+	};
+	
+	Wolf::Model* m_model = nullptr;
+	int m_meshID = -1;
+	std::vector<ChunkInstance> m_chunkInstances;
+	Wolf::Instance<ChunkInstance>* m_chunkInstance = nullptr;
 	
 	Wolf::Scene* m_scene = nullptr;
 	int m_renderPassID = -1;
@@ -71,8 +273,17 @@ private:
 		glm::mat4 projection;
 		glm::mat4 model;
 		glm::mat4 view;
+		glm::vec4 cameraPosition;
+		glm::vec4 morphRanges[TERRAIN_MAX_LOD_COUNT]; // per LOD level, see TerrainQuadTree::getMorphRange
+		glm::vec4 terrainGrid; // topLeftPos.x, topLeftPos.z, tileSize.x, tileSize.z
+		glm::vec4 terrainHeight; // maxHeight, resolution, chunk size
+		glm::vec4 tessellation; // m_lodDistanceScale, HEIGHMAP_TESSELLATION_EDGE_PIXELS
 	};
 	UniformBufferData m_ubData;
 	Wolf::UniformBuffer* m_ub;
+
+	// One indirect draw per selected chunk, the unused ones have no index
+	std::vector<VkDrawIndexedIndirectCommand> m_drawCommands;
+	Wolf::UniformBuffer* m_drawCommandsBuffer;
 };
 
@@ -0,0 +1,2 @@
+C:\VulkanSDK\1.2.148.1\Bin\glslangValidator.exe -V generate.comp -o generateComp.spv || exit /b 1
+if not "%1"=="nopause" pause
\ No newline at end of file
@@ -0,0 +1,73 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(binding = 0) uniform UniformBufferObjectMVP
+{
+    mat4 projection;
+    mat4 model;
+	mat4 view;
+	vec4 cameraPosition;
+	vec4 morphRanges[16]; // per LOD level: x = morph start distance, y = 1 / morph length
+	vec4 terrainGrid; // topLeftPos.x, topLeftPos.z, tileSize.x, tileSize.z
+	vec4 terrainHeight; // maxHeight, resolution, chunk size
+} uboMVP;
+
+layout(binding = 1) uniform sampler2D clipmap; // toroidal level textures stacked along y, see TerrainClipmap
+
+layout(location = 0) in vec2 inGridPosition; // vertex (a, b) of the level grid
+layout(location = 1) in vec4 inLevel; // first level sample i, j, spacing, level
+
+layout(location = 0) out vec2 outNormalMapCoord;
+
+out gl_PerVertex
+{
+    vec4 gl_Position;
+};
+
+const int gridSize = 128; // TERRAIN_CLIPMAP_GRID_SIZE
+const int textureSize = gridSize + 1;
+const float transitionWidth = float(gridSize) / 10.0; // outer cells of a level blended towards the next coarser one
+
+float levelHeight(ivec2 levelSample, int level)
+{
+	// Level sample (i, j) is texel (j mod size, level * size + i mod size), the samples can be negative
+	ivec2 texel = levelSample - textureSize * ivec2(floor(vec2(levelSample) / float(textureSize)));
+	return texelFetch(clipmap, ivec2(texel.y, level * textureSize + texel.x), 0).r * uboMVP.terrainHeight.x;
+}
+
+void main() 
+{
+	// The level origins are even: the odd vertices are the ones between two vertices of the next coarser level
+	ivec2 gridPosition = ivec2(inGridPosition);
+	ivec2 levelSample = ivec2(inLevel.xy) + gridPosition;
+	int spacing = int(inLevel.z);
+	int level = int(inLevel.w);
+
+	float height = levelHeight(levelSample, level);
+	float morphHeight = height;
+	if (gridPosition.x % 2 == 1 || gridPosition.y % 2 == 1)
+	{
+		if (gridPosition.y % 2 == 0)
+			morphHeight = (levelHeight(levelSample - ivec2(1, 0), level) + levelHeight(levelSample + ivec2(1, 0), level)) * 0.5;
+		else if (gridPosition.x % 2 == 0)
+			morphHeight = (levelHeight(levelSample - ivec2(0, 1), level) + levelHeight(levelSample + ivec2(0, 1), level)) * 0.5;
+		else
+			morphHeight = (levelHeight(levelSample + ivec2(1, -1), level) + levelHeight(levelSample + ivec2(-1, 1), level)) * 0.5;
+	}
+
+	// The grids are outside of the heightfield near its borders: their vertices are clamped on it
+	int resolution = int(uboMVP.terrainHeight.y);
+	vec2 gridSample = clamp(vec2(levelSample * spacing), vec2(0.0), vec2(resolution - 1));
+	vec3 position = vec3(uboMVP.terrainGrid.x + gridSample.x * uboMVP.terrainGrid.z, height, uboMVP.terrainGrid.y + gridSample.y * uboMVP.terrainGrid.w);
+
+	// The camera is less than 2 cells from the level center: the border of the level, on the coarser level, is fully morphed. Measured from the
+	// camera rather than the center, the morph doesn't jump when the level moves
+	vec2 cameraSample = (uboMVP.cameraPosition.xz - uboMVP.terrainGrid.xy) / uboMVP.terrainGrid.zw;
+	vec2 cellDistance = abs(vec2(levelSample * spacing) - cameraSample) / float(spacing);
+	float morph = clamp((max(cellDistance.x, cellDistance.y) - (float(gridSize / 2 - 2) - transitionWidth)) / transitionWidth, 0.0, 1.0);
+	position.y = mix(height, morphHeight, morph);
+	outNormalMapCoord = (gridSample.yx + 0.5) / float(resolution);
+
+	vec4 viewPos = uboMVP.view * uboMVP.model * vec4(position, 1.0);
+    gl_Position = uboMVP.projection * viewPos;
+}
@@ -1,3 +1,8 @@
-C:\VulkanSDK\1.2.148.1\Bin\glslangValidator.exe -V shader.vert
-C:\VulkanSDK\1.2.148.1\Bin\glslangValidator.exe -V shader.frag
-pause
\ No newline at end of file
+C:\VulkanSDK\1.2.148.1\Bin\glslangValidator.exe -V shader.vert || exit /b 1
+C:\VulkanSDK\1.2.148.1\Bin\glslangValidator.exe -V shader.frag || exit /b 1
+C:\VulkanSDK\1.2.148.1\Bin\glslangValidator.exe -V displacement.vert -o displacementVert.spv || exit /b 1
+C:\VulkanSDK\1.2.148.1\Bin\glslangValidator.exe -V tessellation.vert -o tessellationVert.spv || exit /b 1
+C:\VulkanSDK\1.2.148.1\Bin\glslangValidator.exe -V tessellation.tesc -o tessellationTesc.spv || exit /b 1
+C:\VulkanSDK\1.2.148.1\Bin\glslangValidator.exe -V tessellation.tese -o tessellationTese.spv || exit /b 1
+C:\VulkanSDK\1.2.148.1\Bin\glslangValidator.exe -V clipmap.vert -o clipmapVert.spv || exit /b 1
+if not "%1"=="nopause" pause
\ No newline at end of file
@@ -0,0 +1,65 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(binding = 0) uniform UniformBufferObjectMVP
+{
+    mat4 projection;
+    mat4 model;
+	mat4 view;
+	vec4 cameraPosition;
+	vec4 morphRanges[16]; // per LOD level: x = morph start distance, y = 1 / morph length
+	vec4 terrainGrid; // topLeftPos.x, topLeftPos.z, tileSize.x, tileSize.z
+	vec4 terrainHeight; // maxHeight, resolution, chunk size
+} uboMVP;
+
+layout(binding = 1) uniform sampler2D heightMap; // texel (x = j, y = i), heights in [0, 1]
+
+layout(location = 0) in vec2 inPatchPosition; // vertex (a, b) of the patch
+layout(location = 1) in vec4 inNode; // first sample i, j, stride, LOD level of the chunk
+
+layout(location = 0) out vec2 outNormalMapCoord;
+
+out gl_PerVertex
+{
+    vec4 gl_Position;
+};
+
+float sampleHeight(ivec2 ij)
+{
+	int resolution = int(uboMVP.terrainHeight.y);
+	return texelFetch(heightMap, clamp(ij, ivec2(0), ivec2(resolution - 1)).yx, 0).r * uboMVP.terrainHeight.x;
+}
+
+void main() 
+{
+	// Same vertices as TerrainQuadTree builds in mesh mode, the chunk is selected by the first instance of the indirect draw.
+	// The coarsest level never morphs (its morph start is at infinity)
+	ivec2 patchPosition = ivec2(inPatchPosition);
+	int stride = int(inNode.z);
+	int level = int(inNode.w);
+	ivec2 ij = ivec2(inNode.xy) + patchPosition * stride;
+
+	float height = sampleHeight(ij);
+	float morphHeight = height;
+	if (patchPosition.x % 2 == 1 || patchPosition.y % 2 == 1)
+	{
+		if (patchPosition.y % 2 == 0)
+			morphHeight = (sampleHeight(ij - ivec2(stride, 0)) + sampleHeight(ij + ivec2(stride, 0))) * 0.5;
+		else if (patchPosition.x % 2 == 0)
+			morphHeight = (sampleHeight(ij - ivec2(0, stride)) + sampleHeight(ij + ivec2(0, stride))) * 0.5;
+		else
+			morphHeight = (sampleHeight(ij + ivec2(stride, -stride)) + sampleHeight(ij + ivec2(-stride, stride))) * 0.5;
+	}
+
+	int resolution = int(uboMVP.terrainHeight.y);
+	vec2 gridPosition = vec2(min(ij, ivec2(resolution - 1)));
+	vec3 position = vec3(uboMVP.terrainGrid.x + gridPosition.x * uboMVP.terrainGrid.z, height, uboMVP.terrainGrid.y + gridPosition.y * uboMVP.terrainGrid.w);
+
+	vec2 morphRange = uboMVP.morphRanges[level].xy;
+	float morph = clamp((distance(position, uboMVP.cameraPosition.xyz) - morphRange.x) * morphRange.y, 0.0, 1.0);
+	position.y = mix(height, morphHeight, morph);
+	outNormalMapCoord = (gridPosition.yx + 0.5) / float(resolution);
+
+	vec4 viewPos = uboMVP.view * uboMVP.model * vec4(position, 1.0);
+    gl_Position = uboMVP.projection * viewPos;
+}
@@ -2,9 +2,53 @@
 #extension GL_ARB_separate_shader_objects : enable
 #extension GL_EXT_nonuniform_qualifier : enable
 
+layout(binding = 2) uniform sampler2D normalMap; // xy = octahedral normal, z = sine of the slope angle, see TerrainNormalMap
+layout(binding = 3) uniform sampler2D horizonMap0; // sine of the horizon elevation in the directions 0 to 3, see TerrainHorizonMap
+layout(binding = 4) uniform sampler2D horizonMap1; // directions 4 to 7
+layout(binding = 5) uniform sampler2D waterDepth; // in world units, see TerrainWater
+
+layout(location = 0) in vec2 inNormalMapCoord;
+
 layout(location = 0) out vec4 outColor;
 
+const vec3 sunDirection = normalize(vec3(0.4, 1.0, 0.3));
+const float PI = 3.14159265;
+const float sunShadowSoftness = 0.05; // in sine of the elevation, about the angular size of the sun
+
+vec3 decodeNormal(vec2 octahedral)
+{
+	// Upper half of the octahedron only, heightfield normals point up
+	octahedral = octahedral * 2.0 - 1.0;
+	return normalize(vec3(octahedral.x, 1.0 - abs(octahedral.x) - abs(octahedral.y), octahedral.y));
+}
+
 void main() 
 {
-	outColor = vec4(0.0, 1.0, 0.0, 1.0);
+	vec3 shading = texture(normalMap, inNormalMapCoord).xyz;
+	vec3 normal = decodeNormal(shading.xy);
+
+	// Grass on gentle slopes, rock on steep ones
+	vec3 albedo = mix(vec3(0.2, 0.6, 0.1), vec3(0.45, 0.4, 0.35), smoothstep(0.5, 0.8, shading.z));
+	// Deeper water hides more of the ground
+	float water = 1.0 - exp(-4.0 * texture(waterDepth, inNormalMapCoord).r);
+	albedo = mix(albedo, vec3(0.05, 0.2, 0.35), water);
+
+	// Direction k of the horizon map is k * 45 degrees from +x towards +z
+	float horizons[8];
+	vec4 horizons0 = texture(horizonMap0, inNormalMapCoord);
+	vec4 horizons1 = texture(horizonMap1, inNormalMapCoord);
+	horizons[0] = horizons0.x; horizons[1] = horizons0.y; horizons[2] = horizons0.z; horizons[3] = horizons0.w;
+	horizons[4] = horizons1.x; horizons[5] = horizons1.y; horizons[6] = horizons1.z; horizons[7] = horizons1.w;
+
+	// The sun is hidden where its elevation is under the horizon interpolated at its azimuth
+	float sunAzimuth = mod(atan(sunDirection.z, sunDirection.x) / (PI / 4.0) + 8.0, 8.0);
+	int direction = int(sunAzimuth) % 8;
+	float horizon = mix(horizons[direction], horizons[(direction + 1) % 8], fract(sunAzimuth));
+	float sunVisibility = smoothstep(horizon - sunShadowSoftness, horizon + sunShadowSoftness, sunDirection.y);
+
+	// Cosine weighted part of the sky above the horizon, averaged over the directions
+	float ambientOcclusion = 1.0 - (dot(horizons0, horizons0) + dot(horizons1, horizons1)) / 8.0;
+
+	float lighting = 0.25 * ambientOcclusion + 0.75 * max(dot(normal, sunDirection), 0.0) * sunVisibility;
+	outColor = vec4(albedo * lighting, 1.0);
 }
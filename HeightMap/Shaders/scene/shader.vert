@@ -6,23 +6,42 @@ layout(binding = 0) uniform UniformBufferObjectMVP
     mat4 projection;
     mat4 model;
 	mat4 view;
+	vec4 cameraPosition;
+	vec4 morphRanges[16]; // per LOD level: x = morph start distance, y = 1 / morph length
+	vec4 terrainGrid; // topLeftPos.x, topLeftPos.z, tileSize.x, tileSize.z
+	vec4 terrainHeight; // maxHeight, resolution, chunk size
 } uboMVP;
 
-layout(location = 0) in vec3 inPosition;
+layout(location = 0) in vec2 inHeights; // height and height of the next coarser LOD level at this position, quantized over the chunk height range
+layout(location = 1) in vec4 inNode; // first sample i, j, stride, LOD level of the chunk
+layout(location = 2) in vec2 inHeightRange; // lowest height of the chunk, height range
+
+layout(location = 0) out vec2 outNormalMapCoord;
 
 out gl_PerVertex
 {
     vec4 gl_Position;
 };
 
-const mat4 biasMat = mat4( 
-	0.5, 0.0, 0.0, 0.0,
-	0.0, 0.5, 0.0, 0.0,
-	0.0, 0.0, 1.0, 0.0,
-	0.5, 0.5, 0.0, 1.0 );
-
 void main() 
 {
-	vec4 viewPos = uboMVP.view * uboMVP.model * vec4(inPosition, 1.0);
+	// Terrain chunks are drawn indirectly with their chunk as first instance, starting at the vertices of the chunk:
+	// the vertex (a, b) of the patch is a * (chunk size + 1) + b
+	int vertexCountPerSide = int(uboMVP.terrainHeight.z) + 1;
+	int patchIndex = gl_VertexIndex % (vertexCountPerSide * vertexCountPerSide);
+	ivec2 patchPosition = ivec2(patchIndex / vertexCountPerSide, patchIndex % vertexCountPerSide);
+	ivec2 ij = ivec2(inNode.xy) + patchPosition * int(inNode.z);
+
+	int resolution = int(uboMVP.terrainHeight.y);
+	vec2 gridPosition = vec2(min(ij, ivec2(resolution - 1)));
+	vec2 heights = inHeightRange.x + inHeights * inHeightRange.y;
+	vec3 position = vec3(uboMVP.terrainGrid.x + gridPosition.x * uboMVP.terrainGrid.z, heights.x, uboMVP.terrainGrid.y + gridPosition.y * uboMVP.terrainGrid.w);
+
+	vec2 morphRange = uboMVP.morphRanges[int(inNode.w)].xy;
+	float morph = clamp((distance(position, uboMVP.cameraPosition.xyz) - morphRange.x) * morphRange.y, 0.0, 1.0);
+	position.y = mix(heights.x, heights.y, morph);
+	outNormalMapCoord = (gridPosition.yx + 0.5) / float(resolution);
+
+	vec4 viewPos = uboMVP.view * uboMVP.model * vec4(position, 1.0);
     gl_Position = uboMVP.projection * viewPos;
 } 
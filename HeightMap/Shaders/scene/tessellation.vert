@@ -0,0 +1,16 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(location = 0) in vec2 inPatchPosition; // corner (a, b) of the patch, 0 or the chunk size
+layout(location = 1) in vec4 inNode; // first sample i, j, stride, LOD level of the chunk
+layout(location = 2) in vec2 inHeightRange; // lowest height of the chunk, height range
+
+layout(location = 0) out vec2 outSamplePosition; // (i, j)
+layout(location = 1) out vec2 outHeightRange;
+
+void main() 
+{
+	// The corners only, the tessellation shaders place and displace the vertices
+	outSamplePosition = inNode.xy + inPatchPosition * inNode.z;
+	outHeightRange = inHeightRange;
+}
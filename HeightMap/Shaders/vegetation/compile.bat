@@ -0,0 +1,4 @@
+C:\VulkanSDK\1.2.148.1\Bin\glslangValidator.exe -V cull.comp -o cullComp.spv || exit /b 1
+C:\VulkanSDK\1.2.148.1\Bin\glslangValidator.exe -V prop.vert -o propVert.spv || exit /b 1
+C:\VulkanSDK\1.2.148.1\Bin\glslangValidator.exe -V prop.frag -o propFrag.spv || exit /b 1
+if not "%1"=="nopause" pause
\ No newline at end of file
@@ -0,0 +1,15 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(location = 0) in vec3 inNormal;
+layout(location = 1) in vec3 inColor;
+
+layout(location = 0) out vec4 outColor;
+
+const vec3 sunDirection = normalize(vec3(0.4, 1.0, 0.3)); // as Shaders/scene/shader.frag
+
+void main() 
+{
+	float lighting = 0.3 + 0.7 * max(dot(normalize(inNormal), sunDirection), 0.0);
+	outColor = vec4(inColor * lighting, 1.0);
+}
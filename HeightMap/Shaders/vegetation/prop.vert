@@ -0,0 +1,35 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(binding = 0) uniform UniformBufferVegetation
+{
+	mat4 viewProjection;
+} ubVegetation;
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inNormal;
+layout(location = 2) in vec4 inColor;
+layout(location = 3) in vec4 inPositionScale; // Wolf::InstanceTransform: translation and uniform scale
+layout(location = 4) in vec4 inRotation; // unit quaternion
+
+layout(location = 0) out vec3 outNormal;
+layout(location = 1) out vec3 outColor;
+
+out gl_PerVertex
+{
+    vec4 gl_Position;
+};
+
+vec3 rotate(vec4 q, vec3 v)
+{
+	return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+}
+
+void main() 
+{
+	vec3 worldPosition = inPositionScale.xyz + rotate(inRotation, inPosition * inPositionScale.w);
+	gl_Position = ubVegetation.viewProjection * vec4(worldPosition, 1.0);
+
+	outNormal = rotate(inRotation, inNormal);
+	outColor = inColor.rgb;
+}
@@ -0,0 +1,232 @@
+#include "ShallowWater.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define SHALLOW_WATER_X86
+#include <emmintrin.h>
+#endif
+
+#define SHALLOW_WATER_BORDER_HEIGHT 1.0e9f // terrain of the border cells, no water flows to them
+#define SHALLOW_WATER_MIN_DEPTH 1.0e-4f // shallower water is removed, evaporation alone would never dry a cell
+
+ShallowWater::ShallowWater(const HeightField& heightField, const TerrainMeshBuilder::GridInfo& gridInfo, const Parameters& parameters, ThreadPool* threadPool)
+	: m_heightField(heightField), m_gridInfo(gridInfo), m_parameters(parameters), m_threadPool(threadPool)
+{
+	// Square cells of tileSize.x: a pipe has the cross-section of a cell side squared and its length
+	m_resolution = m_heightField.getResolution();
+	m_stride = static_cast<size_t>(m_resolution) + 2;
+	m_cellArea = m_gridInfo.tileSize.x * m_gridInfo.tileSize.x;
+	m_flowFactor = SHALLOW_WATER_TIMESTEP * m_parameters.gravity * m_gridInfo.tileSize.x;
+
+	const size_t cellCount = m_stride * m_stride;
+	m_terrainHeights.assign(cellCount, SHALLOW_WATER_BORDER_HEIGHT);
+	m_depths.assign(cellCount, 0.0f);
+	m_leftFlows.assign(cellCount, 0.0f);
+	m_rightFlows.assign(cellCount, 0.0f);
+	m_upFlows.assign(cellCount, 0.0f);
+	m_downFlows.assign(cellCount, 0.0f);
+	m_wetRows.assign(m_resolution, 0);
+	updateRegion(0, 0, m_resolution, m_resolution);
+}
+
+void ShallowWater::step()
+{
+	// The flows only read the depths and the depths only read the flows: both sweeps can run in place, a band after the other
+	const uint32_t bandCount = (m_resolution + SHALLOW_WATER_BAND_SIZE - 1) / SHALLOW_WATER_BAND_SIZE;
+	auto updateFlowBand = [&](uint32_t band)
+	{
+		const uint32_t endRow = std::min((band + 1) * SHALLOW_WATER_BAND_SIZE, m_resolution);
+		for (uint32_t i = band * SHALLOW_WATER_BAND_SIZE; i < endRow; ++i)
+		{
+			const size_t cell = getCell(i, 0);
+			updateFlowRow(&m_terrainHeights[cell], &m_depths[cell], &m_leftFlows[cell], &m_rightFlows[cell], &m_upFlows[cell], &m_downFlows[cell]);
+		}
+	};
+	auto updateDepthBand = [&](uint32_t band)
+	{
+		const uint32_t endRow = std::min((band + 1) * SHALLOW_WATER_BAND_SIZE, m_resolution);
+		for (uint32_t i = band * SHALLOW_WATER_BAND_SIZE; i < endRow; ++i)
+		{
+			const size_t cell = getCell(i, 0);
+			updateDepthRow(&m_leftFlows[cell], &m_rightFlows[cell], &m_upFlows[cell], &m_downFlows[cell], &m_depths[cell]);
+			m_wetRows[i] = std::any_of(&m_depths[cell], &m_depths[cell] + m_resolution, [](float depth) { return depth > 0.0f; }) ? 1 : 0;
+		}
+	};
+
+	if (m_threadPool)
+	{
+		m_threadPool->parallelFor(bandCount, updateFlowBand);
+		m_threadPool->parallelFor(bandCount, updateDepthBand);
+	}
+	else
+	{
+		for (uint32_t band = 0; band < bandCount; ++band)
+			updateFlowBand(band);
+		for (uint32_t band = 0; band < bandCount; ++band)
+			updateDepthBand(band);
+	}
+}
+
+void ShallowWater::updateFlowRow(const float* terrain, const float* depths, float* leftFlows, float* rightFlows, float* upFlows, float* downFlows) const
+{
+	const float flowKeep = 1.0f - m_parameters.flowDamping;
+	const float volumeFactor = m_cellArea / SHALLOW_WATER_TIMESTEP;
+	const ptrdiff_t stride = static_cast<ptrdiff_t>(m_stride);
+
+	// Flows accelerated by the surface height differences, never negative. Then scaled so that a step takes at most the water of the cell
+	auto updateCell = [&](ptrdiff_t column)
+	{
+		const float surface = terrain[column] + depths[column];
+		const float leftFlow = std::max(leftFlows[column] * flowKeep + m_flowFactor * (surface - (terrain[column - 1] + depths[column - 1])), 0.0f);
+		const float rightFlow = std::max(rightFlows[column] * flowKeep + m_flowFactor * (surface - (terrain[column + 1] + depths[column + 1])), 0.0f);
+		const float upFlow = std::max(upFlows[column] * flowKeep + m_flowFactor * (surface - (terrain[column - stride] + depths[column - stride])), 0.0f);
+		const float downFlow = std::max(downFlows[column] * flowKeep + m_flowFactor * (surface - (terrain[column + stride] + depths[column + stride])), 0.0f);
+		const float totalFlow = leftFlow + rightFlow + upFlow + downFlow;
+		const float scale = totalFlow > 0.0f ? std::min(depths[column] * volumeFactor / totalFlow, 1.0f) : 0.0f;
+		leftFlows[column] = leftFlow * scale;
+		rightFlows[column] = rightFlow * scale;
+		upFlows[column] = upFlow * scale;
+		downFlows[column] = downFlow * scale;
+	};
+
+	uint32_t column = 0;
+
+#if defined(SHALLOW_WATER_X86)
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 keep = _mm_set1_ps(flowKeep);
+	const __m128 flowFactor = _mm_set1_ps(m_flowFactor);
+	const __m128 volume = _mm_set1_ps(volumeFactor);
+	auto loadSurface = [&](const float* terrainRow, const float* depthRow) { return _mm_add_ps(_mm_loadu_ps(terrainRow), _mm_loadu_ps(depthRow)); };
+	auto updateFlow = [&](const float* flows, __m128 surface, __m128 neighbourSurface)
+	{
+		return _mm_max_ps(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(flows), keep), _mm_mul_ps(flowFactor, _mm_sub_ps(surface, neighbourSurface))), zero);
+	};
+	for (; column + 4 <= m_resolution; column += 4)
+	{
+		// Same operations as updateCell, a division by a zero total flow gives a scale of 0 through the mask
+		const __m128 surface = loadSurface(terrain + column, depths + column);
+		const __m128 leftFlow = updateFlow(leftFlows + column, surface, loadSurface(terrain + column - 1, depths + column - 1));
+		const __m128 rightFlow = updateFlow(rightFlows + column, surface, loadSurface(terrain + column + 1, depths + column + 1));
+		const __m128 upFlow = updateFlow(upFlows + column, surface, loadSurface(terrain + column - stride, depths + column - stride));
+		const __m128 downFlow = updateFlow(downFlows + column, surface, loadSurface(terrain + column + stride, depths + column + stride));
+		const __m128 totalFlow = _mm_add_ps(_mm_add_ps(_mm_add_ps(leftFlow, rightFlow), upFlow), downFlow);
+		const __m128 flowing = _mm_cmpgt_ps(totalFlow, zero);
+		const __m128 scale = _mm_and_ps(_mm_min_ps(_mm_div_ps(_mm_mul_ps(_mm_loadu_ps(depths + column), volume), _mm_or_ps(totalFlow, _mm_andnot_ps(flowing, one))), one), flowing);
+		_mm_storeu_ps(leftFlows + column, _mm_mul_ps(leftFlow, scale));
+		_mm_storeu_ps(rightFlows + column, _mm_mul_ps(rightFlow, scale));
+		_mm_storeu_ps(upFlows + column, _mm_mul_ps(upFlow, scale));
+		_mm_storeu_ps(downFlows + column, _mm_mul_ps(downFlow, scale));
+	}
+#endif
+
+	for (; column < m_resolution; ++column)
+		updateCell(static_cast<ptrdiff_t>(column));
+}
+
+void ShallowWater::updateDepthRow(const float* leftFlows, const float* rightFlows, const float* upFlows, const float* downFlows, float* depths) const
+{
+	// Inflows are the flows of the neighbours towards the cell
+	const float depthFactor = SHALLOW_WATER_TIMESTEP / m_cellArea;
+	const float rain = m_parameters.rainRate * SHALLOW_WATER_TIMESTEP;
+	const float evaporationKeep = 1.0f - m_parameters.evaporationRate * SHALLOW_WATER_TIMESTEP;
+	const ptrdiff_t stride = static_cast<ptrdiff_t>(m_stride);
+
+	uint32_t column = 0;
+
+#if defined(SHALLOW_WATER_X86)
+	const __m128 factor = _mm_set1_ps(depthFactor);
+	const __m128 rainDepth = _mm_set1_ps(rain);
+	const __m128 keep = _mm_set1_ps(evaporationKeep);
+	const __m128 minDepth = _mm_set1_ps(SHALLOW_WATER_MIN_DEPTH);
+	for (; column + 4 <= m_resolution; column += 4)
+	{
+		const __m128 inflow = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_loadu_ps(rightFlows + column - 1), _mm_loadu_ps(leftFlows + column + 1)),
+			_mm_loadu_ps(downFlows + column - stride)), _mm_loadu_ps(upFlows + column + stride));
+		const __m128 outflow = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_loadu_ps(leftFlows + column), _mm_loadu_ps(rightFlows + column)),
+			_mm_loadu_ps(upFlows + column)), _mm_loadu_ps(downFlows + column));
+		__m128 depth = _mm_add_ps(_mm_loadu_ps(depths + column), _mm_mul_ps(_mm_sub_ps(inflow, outflow), factor));
+		depth = _mm_mul_ps(_mm_add_ps(depth, rainDepth), keep);
+		_mm_storeu_ps(depths + column, _mm_and_ps(depth, _mm_cmpge_ps(depth, minDepth)));
+	}
+#endif
+
+	for (; column < m_resolution; ++column)
+	{
+		// Signed indices, the first column reads the border cell before it
+		const ptrdiff_t cell = static_cast<ptrdiff_t>(column);
+		const float inflow = rightFlows[cell - 1] + leftFlows[cell + 1] + downFlows[cell - stride] + upFlows[cell + stride];
+		const float outflow = leftFlows[cell] + rightFlows[cell] + upFlows[cell] + downFlows[cell];
+		const float depth = (depths[cell] + (inflow - outflow) * depthFactor + rain) * evaporationKeep;
+		depths[cell] = depth >= SHALLOW_WATER_MIN_DEPTH ? depth : 0.0f;
+	}
+}
+
+void ShallowWater::addWater(float i, float j, float radius, float depth)
+{
+	const int64_t iStart = std::max<int64_t>(static_cast<int64_t>(std::floor(i - radius)), 0);
+	const int64_t jStart = std::max<int64_t>(static_cast<int64_t>(std::floor(j - radius)), 0);
+	const int64_t iEnd = std::min<int64_t>(static_cast<int64_t>(std::ceil(i + radius)), m_resolution - 1);
+	const int64_t jEnd = std::min<int64_t>(static_cast<int64_t>(std::ceil(j + radius)), m_resolution - 1);
+	for (int64_t sampleI = iStart; sampleI <= iEnd; ++sampleI)
+	{
+		for (int64_t sampleJ = jStart; sampleJ <= jEnd; ++sampleJ)
+		{
+			const float distance = std::sqrt((sampleI - i) * (sampleI - i) + (sampleJ - j) * (sampleJ - j));
+			if (distance < radius)
+			{
+				m_depths[getCell(static_cast<uint32_t>(sampleI), static_cast<uint32_t>(sampleJ))] += depth * (1.0f - distance / radius);
+				m_wetRows[sampleI] = 1;
+			}
+		}
+	}
+}
+
+void ShallowWater::updateRegion(uint32_t i, uint32_t j, uint32_t height, uint32_t width)
+{
+	for (uint32_t row = i; row < i + height; ++row)
+		for (uint32_t column = j; column < j + width; ++column)
+			m_terrainHeights[getCell(row, column)] = m_gridInfo.topLeftPos.y + m_heightField.get(row, column) * m_gridInfo.maxHeight;
+}
+
+void ShallowWater::computeTerrainHeights(const HeightField& heightField, const TerrainMeshBuilder::GridInfo& gridInfo, std::vector<float>& outTerrainHeights)
+{
+	const uint32_t resolution = heightField.getResolution();
+	const size_t stride = static_cast<size_t>(resolution) + 2;
+	outTerrainHeights.assign(stride * stride, SHALLOW_WATER_BORDER_HEIGHT);
+	for (uint32_t row = 0; row < resolution; ++row)
+		for (uint32_t column = 0; column < resolution; ++column)
+			outTerrainHeights[(row + 1) * stride + column + 1] = gridInfo.topLeftPos.y + heightField.get(row, column) * gridInfo.maxHeight;
+}
+
+double ShallowWater::computeVolume() const
+{
+	double volume = 0.0;
+	for (uint32_t i = 0; i < m_resolution; ++i)
+		for (uint32_t j = 0; j < m_resolution; ++j)
+			volume += m_depths[getCell(i, j)];
+	return volume * m_cellArea;
+}
+
+void ShallowWater::getWetRows(uint32_t& outFirstRow, uint32_t& outEndRow) const
+{
+	outFirstRow = m_resolution;
+	outEndRow = 0;
+	for (uint32_t i = 0; i < m_resolution; ++i)
+	{
+		if (m_wetRows[i])
+		{
+			outFirstRow = std::min(outFirstRow, i);
+			outEndRow = i + 1;
+		}
+	}
+}
+
+void ShallowWater::copyDepths(uint32_t firstRow, uint32_t endRow, float* outDepths) const
+{
+	for (uint32_t i = firstRow; i < endRow; ++i)
+		std::copy_n(&m_depths[getCell(i, 0)], m_resolution, outDepths + static_cast<size_t>(i - firstRow) * m_resolution);
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <vector>
+
+#include "HeightField.h"
+#include "TerrainMeshBuilder.h"
+#include "ThreadPool.h"
+
+#define SHALLOW_WATER_TIMESTEP (1.0f / 60.0f) // seconds simulated by a step
+#define SHALLOW_WATER_BAND_SIZE 16 // rows of cells computed by a job
+
+// Shallow water on the heightfield with the virtual pipes model (Mei et al. 2007): each cell holds a water depth and the flows through 4 pipes
+// to its neighbours, accelerated by the difference of water surface heights and scaled down so that a cell never gives more water than it has.
+// A step is two sweeps over bands of rows (flows, then depths), each cell only writes its own values: the result doesn't depend on the thread count.
+// The grids have a border of dry cells under an infinitely high terrain, closing the heightfield without any special case on its edges
+class ShallowWater
+{
+public:
+	struct Parameters
+	{
+		float gravity = 9.81f;
+		float flowDamping = 0.01f; // fraction of the flows lost per step, so that the waves settle
+		float rainRate = 0.0f; // world units of water added per second on every cell
+		float evaporationRate = 0.02f; // fraction of the depth evaporated per second
+	};
+
+	// A null thread pool simulates on the calling thread
+	ShallowWater(const HeightField& heightField, const TerrainMeshBuilder::GridInfo& gridInfo, const Parameters& parameters, ThreadPool* threadPool);
+
+	void step();
+	// Pours depth world units of water at (i, j) in samples, fading out over radius samples
+	void addWater(float i, float j, float radius, float depth);
+	// The samples [i, i + height[ x [j, j + width[ of the terrain were modified
+	void updateRegion(uint32_t i, uint32_t j, uint32_t height, uint32_t width);
+	// All the samples of the terrain were replaced: takes the cells given by computeTerrainHeights, e.g. on another thread, terrainHeights gets the previous ones
+	void swapTerrainHeights(std::vector<float>& terrainHeights) { m_terrainHeights.swap(terrainHeights); }
+	// Terrain of every cell of a simulation of the heightfield, border included
+	static void computeTerrainHeights(const HeightField& heightField, const TerrainMeshBuilder::GridInfo& gridInfo, std::vector<float>& outTerrainHeights);
+
+	uint32_t getResolution() const { return m_resolution; }
+	// Depths in world units
+	float getDepth(uint32_t i, uint32_t j) const { return m_depths[getCell(i, j)]; }
+	// Rows holding water, an empty range when everything is dry
+	void getWetRows(uint32_t& outFirstRow, uint32_t& outEndRow) const;
+	// Depths of the rows [firstRow, endRow[, row-major
+	void copyDepths(uint32_t firstRow, uint32_t endRow, float* outDepths) const;
+	// Volume of water in world units^3
+	double computeVolume() const;
+
+private:
+	size_t getCell(uint32_t i, uint32_t j) const { return static_cast<size_t>(i + 1) * m_stride + j + 1; }
+
+	// Columns [0, m_resolution[ of one row, the arrays point at the first cell of the row
+	void updateFlowRow(const float* terrain, const float* depths, float* leftFlows, float* rightFlows, float* upFlows, float* downFlows) const;
+	void updateDepthRow(const float* leftFlows, const float* rightFlows, const float* upFlows, const float* downFlows, float* depths) const;
+
+private:
+	const HeightField& m_heightField;
+	TerrainMeshBuilder::GridInfo m_gridInfo;
+	Parameters m_parameters;
+	ThreadPool* m_threadPool;
+
+	uint32_t m_resolution;
+	size_t m_stride; // resolution + 2 border cells
+	float m_cellArea;
+	float m_flowFactor; // timestep * gravity * pipe cross-section / pipe length
+
+	// (resolution + 2)^2 cells, row-major. Flows are volumes per second out of the cell
+	std::vector<float> m_terrainHeights; // world units
+	std::vector<float> m_depths;
+	std::vector<float> m_leftFlows;
+	std::vector<float> m_rightFlows;
+	std::vector<float> m_upFlows;
+	std::vector<float> m_downFlows;
+	std::vector<uint8_t> m_wetRows;
+};
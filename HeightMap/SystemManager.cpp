@@ -5,6 +5,7 @@ using namespace Wolf;
 void SystemManager::run()
 {
 	createWolfInstance();
+	m_threadPool = std::make_unique<ThreadPool>();
 
 	m_loadingScene = std::make_unique<LoadingScene>(m_wolfInstance.get());
 	m_sceneLoadingThread = std::thread(&SystemManager::loadSponzaScene, this);
@@ -57,7 +58,7 @@ void SystemManager::createWolfInstance()
 
 void SystemManager::loadSponzaScene()
 {
-	m_scene = std::make_unique<::Scene>(m_wolfInstance.get());
+	m_scene = std::make_unique<::Scene>(m_wolfInstance.get(), m_threadPool.get(), m_sceneCreateInfo);
 	m_gameState = GAME_STATE::RUNNING;
 	m_needJoinLoadingThread = true;
 }
@@ -2,6 +2,7 @@
 
 #include "LoadingScene.h"
 #include "Scene.h"
+#include "ThreadPool.h"
 
 enum class GAME_STATE
 {
@@ -12,16 +13,21 @@ enum class GAME_STATE
 class SystemManager
 {
 public:
+	SystemManager(const ::Scene::SceneCreateInfo& sceneCreateInfo) : m_sceneCreateInfo(sceneCreateInfo) {}
+
 	void run();
 
+	static void debugCallback(Wolf::Debug::Severity severity, std::string message);
+
 private:
 	void createWolfInstance();
 	void loadSponzaScene();
-	
-	static void debugCallback(Wolf::Debug::Severity severity, std::string message);
 
 private:
+	::Scene::SceneCreateInfo m_sceneCreateInfo;
+
 	std::unique_ptr<Wolf::WolfInstance> m_wolfInstance;
+	std::unique_ptr<ThreadPool> m_threadPool;
 
 	std::unique_ptr<LoadingScene> m_loadingScene;
 	std::unique_ptr<::Scene> m_scene;
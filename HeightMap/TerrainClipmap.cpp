@@ -0,0 +1,204 @@
+#include "TerrainClipmap.h"
+
+#include <algorithm>
+#include <cmath>
+
+TerrainClipmap::TerrainClipmap(Wolf::WolfInstance* wolfInstance, const HeightField& heightField, ThreadPool* threadPool)
+	: m_heightField(heightField), m_threadPool(threadPool)
+{
+	// The coarsest level covers the whole heightfield wherever the camera is on it
+	uint32_t levelCount = 1;
+	while ((static_cast<uint64_t>(TERRAIN_CLIPMAP_GRID_SIZE) << (levelCount - 1)) < 2ull * m_heightField.getResolution())
+		++levelCount;
+	m_levels.resize(levelCount, Level{ 0, 0, 0 });
+
+	m_image = wolfInstance->createImage({ TERRAIN_CLIPMAP_TEXTURE_SIZE, TERRAIN_CLIPMAP_TEXTURE_SIZE * levelCount, 1 },
+		VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT, VK_FORMAT_R16_UNORM, VK_SAMPLE_COUNT_1_BIT, VK_IMAGE_ASPECT_COLOR_BIT);
+}
+
+void TerrainClipmap::update(float cameraI, float cameraJ)
+{
+	// A level is centered on the camera rounded to the spacing of the next coarser level, so that its vertices are on the ones of this level
+	// and the level origins stay even. Inside the coarser level, the hole is then TERRAIN_CLIPMAP_GRID_SIZE / 4 or 1 more cells from the origin
+	const int32_t cameraSampleI = static_cast<int32_t>(std::floor(cameraI));
+	const int32_t cameraSampleJ = static_cast<int32_t>(std::floor(cameraJ));
+	auto floorDivide = [](int32_t value, int32_t divisor) { return value >= 0 ? value / divisor : -((-value + divisor - 1) / divisor); };
+
+	for (uint32_t levelIndex = 0; levelIndex < m_levels.size(); ++levelIndex)
+	{
+		Level& level = m_levels[levelIndex];
+		const int32_t coarserSpacing = 2 << levelIndex;
+		const int32_t originI = floorDivide(cameraSampleI, coarserSpacing) * 2 - TERRAIN_CLIPMAP_GRID_SIZE / 2;
+		const int32_t originJ = floorDivide(cameraSampleJ, coarserSpacing) * 2 - TERRAIN_CLIPMAP_GRID_SIZE / 2;
+		const int32_t deltaI = originI - level.originI;
+		const int32_t deltaJ = originJ - level.originJ;
+
+		if (!m_initialized || std::abs(deltaI) >= TERRAIN_CLIPMAP_TEXTURE_SIZE || std::abs(deltaJ) >= TERRAIN_CLIPMAP_TEXTURE_SIZE)
+			addRegion(levelIndex, originI, TERRAIN_CLIPMAP_TEXTURE_SIZE, originJ, TERRAIN_CLIPMAP_TEXTURE_SIZE);
+		else
+		{
+			// Rows then columns entering the level, the corner they share is uploaded twice
+			if (deltaI > 0)
+				addRegion(levelIndex, level.originI + TERRAIN_CLIPMAP_TEXTURE_SIZE, deltaI, originJ, TERRAIN_CLIPMAP_TEXTURE_SIZE);
+			else if (deltaI < 0)
+				addRegion(levelIndex, originI, -deltaI, originJ, TERRAIN_CLIPMAP_TEXTURE_SIZE);
+			if (deltaJ > 0)
+				addRegion(levelIndex, originI, TERRAIN_CLIPMAP_TEXTURE_SIZE, level.originJ + TERRAIN_CLIPMAP_TEXTURE_SIZE, deltaJ);
+			else if (deltaJ < 0)
+				addRegion(levelIndex, originI, TERRAIN_CLIPMAP_TEXTURE_SIZE, originJ, -deltaJ);
+		}
+
+		level.originI = originI;
+		level.originJ = originJ;
+	}
+	m_initialized = true;
+
+	m_levels[0].holeVariant = 0;
+	for (uint32_t levelIndex = 1; levelIndex < m_levels.size(); ++levelIndex)
+	{
+		const Level& finerLevel = m_levels[levelIndex - 1];
+		Level& level = m_levels[levelIndex];
+		const int32_t holeOffsetI = finerLevel.originI / 2 - level.originI - TERRAIN_CLIPMAP_GRID_SIZE / 4;
+		const int32_t holeOffsetJ = finerLevel.originJ / 2 - level.originJ - TERRAIN_CLIPMAP_GRID_SIZE / 4;
+		level.holeVariant = 1 + 2 * holeOffsetI + holeOffsetJ;
+	}
+
+	m_uploadedTexelCount = 0;
+	uploadRegions();
+}
+
+void TerrainClipmap::updateRegion(uint32_t i, uint32_t j, uint32_t height, uint32_t width)
+{
+	if (!m_initialized)
+		return;
+
+	// The level samples outside of the heightfield repeat its border
+	const uint32_t lastSample = m_heightField.getResolution() - 1;
+	for (uint32_t levelIndex = 0; levelIndex < m_levels.size(); ++levelIndex)
+	{
+		const Level& level = m_levels[levelIndex];
+		const int32_t spacing = 1 << levelIndex;
+		int32_t firstI = i == 0 ? level.originI : static_cast<int32_t>((i + spacing - 1) >> levelIndex);
+		int32_t firstJ = j == 0 ? level.originJ : static_cast<int32_t>((j + spacing - 1) >> levelIndex);
+		int32_t lastI = i + height - 1 == lastSample ? level.originI + TERRAIN_CLIPMAP_GRID_SIZE : static_cast<int32_t>((i + height - 1) >> levelIndex);
+		int32_t lastJ = j + width - 1 == lastSample ? level.originJ + TERRAIN_CLIPMAP_GRID_SIZE : static_cast<int32_t>((j + width - 1) >> levelIndex);
+		firstI = std::max(firstI, level.originI);
+		firstJ = std::max(firstJ, level.originJ);
+		lastI = std::min(lastI, level.originI + TERRAIN_CLIPMAP_GRID_SIZE);
+		lastJ = std::min(lastJ, level.originJ + TERRAIN_CLIPMAP_GRID_SIZE);
+		if (firstI <= lastI && firstJ <= lastJ)
+			addRegion(levelIndex, firstI, lastI - firstI + 1, firstJ, lastJ - firstJ + 1);
+	}
+
+	uploadRegions();
+}
+
+void TerrainClipmap::buildGeometry(std::vector<glm::vec2>& outVertices, std::vector<uint32_t>& outIndices)
+{
+	const uint32_t vertexCountPerSide = TERRAIN_CLIPMAP_GRID_SIZE + 1;
+	outVertices.clear();
+	for (uint32_t a = 0; a < vertexCountPerSide; ++a)
+		for (uint32_t b = 0; b < vertexCountPerSide; ++b)
+			outVertices.emplace_back(static_cast<float>(a), static_cast<float>(b));
+
+	outIndices.clear();
+	for (uint32_t variant = 0; variant < 5; ++variant)
+	{
+		const uint32_t holeI = variant > 0 ? TERRAIN_CLIPMAP_GRID_SIZE / 4 + (variant - 1) / 2 : TERRAIN_CLIPMAP_GRID_SIZE;
+		const uint32_t holeJ = variant > 0 ? TERRAIN_CLIPMAP_GRID_SIZE / 4 + (variant - 1) % 2 : TERRAIN_CLIPMAP_GRID_SIZE;
+		for (uint32_t a = 0; a < TERRAIN_CLIPMAP_GRID_SIZE; ++a)
+		{
+			for (uint32_t b = 0; b < TERRAIN_CLIPMAP_GRID_SIZE; ++b)
+			{
+				if (a >= holeI && a < holeI + TERRAIN_CLIPMAP_GRID_SIZE / 2 && b >= holeJ && b < holeJ + TERRAIN_CLIPMAP_GRID_SIZE / 2)
+					continue;
+
+				const uint32_t vertex = a * vertexCountPerSide + b;
+				outIndices.insert(outIndices.end(), { vertex, vertex + vertexCountPerSide, vertex + 1, vertex + vertexCountPerSide, vertex + vertexCountPerSide + 1, vertex + 1 });
+			}
+		}
+	}
+}
+
+TerrainClipmap::IndexRange TerrainClipmap::getIndexRange(uint32_t variant)
+{
+	const uint32_t gridIndexCount = 6 * TERRAIN_CLIPMAP_GRID_SIZE * TERRAIN_CLIPMAP_GRID_SIZE;
+	const uint32_t ringIndexCount = gridIndexCount - gridIndexCount / 4;
+	if (variant == 0)
+		return { 0, gridIndexCount };
+	return { gridIndexCount + (variant - 1) * ringIndexCount, ringIndexCount };
+}
+
+void TerrainClipmap::addRegion(uint32_t level, int32_t firstI, int32_t countI, int32_t firstJ, int32_t countJ)
+{
+	// Consecutive level samples are consecutive texels until the end of the texture
+	auto split = [](int32_t first, int32_t count, int32_t* outFirsts, int32_t* outCounts)
+	{
+		outFirsts[0] = first;
+		outCounts[0] = std::min(count, TERRAIN_CLIPMAP_TEXTURE_SIZE - wrap(first));
+		outFirsts[1] = first + outCounts[0];
+		outCounts[1] = count - outCounts[0];
+		return outCounts[1] > 0 ? 2u : 1u;
+	};
+
+	int32_t firstsI[2], countsI[2], firstsJ[2], countsJ[2];
+	const uint32_t partCountI = split(firstI, countI, firstsI, countsI);
+	const uint32_t partCountJ = split(firstJ, countJ, firstsJ, countsJ);
+	for (uint32_t partI = 0; partI < partCountI; ++partI)
+	{
+		for (uint32_t partJ = 0; partJ < partCountJ; ++partJ)
+		{
+			Region region;
+			region.level = level;
+			region.firstI = firstsI[partI];
+			region.firstJ = firstsJ[partJ];
+			region.texels.offset = { wrap(firstsJ[partJ]), static_cast<int32_t>(level * TERRAIN_CLIPMAP_TEXTURE_SIZE) + wrap(firstsI[partI]) };
+			region.texels.extent = { static_cast<uint32_t>(countsJ[partJ]), static_cast<uint32_t>(countsI[partI]) };
+			m_regions.push_back(region);
+		}
+	}
+}
+
+void TerrainClipmap::uploadRegions()
+{
+	if (m_regions.empty())
+		return;
+
+	std::vector<size_t> firstTexels(m_regions.size());
+	std::vector<VkRect2D> rects(m_regions.size());
+	size_t texelCount = 0;
+	for (size_t regionIndex = 0; regionIndex < m_regions.size(); ++regionIndex)
+	{
+		firstTexels[regionIndex] = texelCount;
+		rects[regionIndex] = m_regions[regionIndex].texels;
+		texelCount += static_cast<size_t>(rects[regionIndex].extent.width) * rects[regionIndex].extent.height;
+	}
+	m_texels.resize(texelCount);
+	m_uploadedTexelCount = static_cast<uint32_t>(texelCount);
+
+	const int32_t lastSample = static_cast<int32_t>(m_heightField.getResolution()) - 1;
+	auto convertRegion = [&](uint32_t regionIndex)
+	{
+		const Region& region = m_regions[regionIndex];
+		uint16_t* texels = &m_texels[firstTexels[regionIndex]];
+		for (uint32_t row = 0; row < region.texels.extent.height; ++row)
+		{
+			const int32_t i = std::min(std::max((region.firstI + static_cast<int32_t>(row)) * (1 << region.level), 0), lastSample);
+			for (uint32_t column = 0; column < region.texels.extent.width; ++column)
+			{
+				const int32_t j = std::min(std::max((region.firstJ + static_cast<int32_t>(column)) * (1 << region.level), 0), lastSample);
+				const float height = std::min(std::max(m_heightField.get(static_cast<uint32_t>(i), static_cast<uint32_t>(j)), 0.0f), 1.0f);
+				*texels++ = static_cast<uint16_t>(std::lround(height * 65535.0f));
+			}
+		}
+	};
+
+	if (m_threadPool)
+		m_threadPool->parallelFor(static_cast<uint32_t>(m_regions.size()), convertRegion);
+	else
+		for (uint32_t regionIndex = 0; regionIndex < m_regions.size(); ++regionIndex)
+			convertRegion(regionIndex);
+
+	m_image->copyFromPixels(m_texels.data(), sizeof(uint16_t), rects, VK_PIPELINE_STAGE_VERTEX_SHADER_BIT);
+	m_regions.clear();
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <vector>
+
+#include <WolfEngine.h>
+
+#include "HeightField.h"
+#include "ThreadPool.h"
+
+#define TERRAIN_CLIPMAP_GRID_SIZE 128 // cells per side of a level, a multiple of 4. Must match Shaders/scene/clipmap.vert
+#define TERRAIN_CLIPMAP_TEXTURE_SIZE (TERRAIN_CLIPMAP_GRID_SIZE + 1) // texels per side of the toroidal texture of a level
+
+// Geometry clipmap: nested grids of TERRAIN_CLIPMAP_GRID_SIZE cells centered on the camera, level l having a spacing of 2^l samples. A level is
+// drawn as a ring around the next finer one, the finest one as a full grid.
+// The heights of a level are in a toroidal texture, texel (x = j mod size, y = i mod size) of the level being the level sample (i, j) (heightfield
+// sample (i * 2^l, j * 2^l)): when the camera moves, only the rows and columns entering a level are uploaded. The textures of the levels are stacked
+// along y in one R16_UNORM image. The upload and the geometry per frame only depend on the level count, not on the heightfield resolution
+class TerrainClipmap
+{
+public:
+	struct Level
+	{
+		int32_t originI; // first level sample of the grid, even
+		int32_t originJ;
+		uint32_t holeVariant; // ring geometry: position of the next finer level inside this one, see getIndexRange
+	};
+
+	struct IndexRange
+	{
+		uint32_t firstIndex;
+		uint32_t indexCount;
+	};
+
+	TerrainClipmap(Wolf::WolfInstance* wolfInstance, const HeightField& heightField, ThreadPool* threadPool);
+
+	// Moves the levels with the camera, (i, j) in samples, and uploads the texels entering them
+	void update(float cameraI, float cameraJ);
+	// The samples [i, i + height[ x [j, j + width[ were modified
+	void updateRegion(uint32_t i, uint32_t j, uint32_t height, uint32_t width);
+
+	uint32_t getLevelCount() const { return static_cast<uint32_t>(m_levels.size()); }
+	const Level& getLevel(uint32_t level) const { return m_levels[level]; }
+	// Texels uploaded by the last update() or updateRegion()
+	uint32_t getUploadedTexelCount() const { return m_uploadedTexelCount; }
+	Wolf::Image* getImage() const { return m_image; }
+
+	// Grid vertices (a, b) in [0, TERRAIN_CLIPMAP_GRID_SIZE], vertex a * (TERRAIN_CLIPMAP_GRID_SIZE + 1) + b. The indices hold the full grid
+	// (variant 0) then the 4 rings (variant 1 + 2 * holeOffsetI + holeOffsetJ, the hole starting 1 cell further along i and/or j)
+	static void buildGeometry(std::vector<glm::vec2>& outVertices, std::vector<uint32_t>& outIndices);
+	static IndexRange getIndexRange(uint32_t variant);
+
+private:
+	// Level samples [firstI, firstI + countI[ x [firstJ, firstJ + countJ[, up to 4 regions when they wrap around the texture
+	void addRegion(uint32_t level, int32_t firstI, int32_t countI, int32_t firstJ, int32_t countJ);
+	void uploadRegions();
+	static int32_t wrap(int32_t levelSample) { return ((levelSample % TERRAIN_CLIPMAP_TEXTURE_SIZE) + TERRAIN_CLIPMAP_TEXTURE_SIZE) % TERRAIN_CLIPMAP_TEXTURE_SIZE; }
+
+private:
+	const HeightField& m_heightField;
+	ThreadPool* m_threadPool;
+	Wolf::Image* m_image;
+
+	std::vector<Level> m_levels;
+	bool m_initialized = false;
+	uint32_t m_uploadedTexelCount = 0;
+
+	// Pending uploads of an update
+	struct Region
+	{
+		uint32_t level;
+		int32_t firstI; // level samples
+		int32_t firstJ;
+		VkRect2D texels;
+	};
+	std::vector<Region> m_regions;
+	std::vector<uint16_t> m_texels;
+};
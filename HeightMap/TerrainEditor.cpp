@@ -0,0 +1,111 @@
+#include "TerrainEditor.h"
+
+#include <algorithm>
+#include <cmath>
+
+void TerrainEditor::apply(const Brush& brush, float centerI, float centerJ)
+{
+	const int64_t lastSample = m_heightField.getResolution() - 1;
+	const int64_t iMin = std::max<int64_t>(static_cast<int64_t>(std::floor(centerI - brush.radius)), 0);
+	const int64_t iMax = std::min<int64_t>(static_cast<int64_t>(std::ceil(centerI + brush.radius)), lastSample);
+	const int64_t jMin = std::max<int64_t>(static_cast<int64_t>(std::floor(centerJ - brush.radius)), 0);
+	const int64_t jMax = std::min<int64_t>(static_cast<int64_t>(std::ceil(centerJ + brush.radius)), lastSample);
+	if (iMin > iMax || jMin > jMax || brush.radius <= 0.0f)
+		return;
+
+	// Smooth reads the neighbours of the region as well, before they are modified
+	const int64_t sourceI = std::max<int64_t>(iMin - 1, 0);
+	const int64_t sourceJ = std::max<int64_t>(jMin - 1, 0);
+	const int64_t sourceWidth = std::min<int64_t>(jMax + 1, lastSample) - sourceJ + 1;
+	if (brush.mode == BrushMode::SMOOTH)
+	{
+		const int64_t sourceHeight = std::min<int64_t>(iMax + 1, lastSample) - sourceI + 1;
+		m_sourceHeights.resize(static_cast<size_t>(sourceHeight * sourceWidth));
+		for (int64_t row = 0; row < sourceHeight; ++row)
+			m_heightField.copyRow(static_cast<uint32_t>(sourceI + row), static_cast<uint32_t>(sourceJ), static_cast<uint32_t>(sourceWidth),
+				&m_sourceHeights[static_cast<size_t>(row * sourceWidth)]);
+	}
+	auto sourceHeight = [&](int64_t i, int64_t j)
+	{
+		i = std::min<int64_t>(std::max<int64_t>(i, 0), lastSample);
+		j = std::min<int64_t>(std::max<int64_t>(j, 0), lastSample);
+		return m_sourceHeights[static_cast<size_t>((i - sourceI) * sourceWidth + (j - sourceJ))];
+	};
+
+	const float squaredRadius = brush.radius * brush.radius;
+	for (int64_t i = iMin; i <= iMax; ++i)
+	{
+		for (int64_t j = jMin; j <= jMax; ++j)
+		{
+			const float di = static_cast<float>(i) - centerI;
+			const float dj = static_cast<float>(j) - centerJ;
+			const float squaredDistance = di * di + dj * dj;
+			if (squaredDistance >= squaredRadius)
+				continue;
+
+			const float falloff = (1.0f - squaredDistance / squaredRadius) * (1.0f - squaredDistance / squaredRadius);
+			const float weight = brush.strength * falloff;
+			float height = m_heightField.get(static_cast<uint32_t>(i), static_cast<uint32_t>(j));
+			switch (brush.mode)
+			{
+			case BrushMode::RAISE:
+				height += weight;
+				break;
+			case BrushMode::LOWER:
+				height -= weight;
+				break;
+			case BrushMode::SMOOTH:
+			{
+				float average = 0.0f;
+				for (int64_t a = -1; a <= 1; ++a)
+					for (int64_t b = -1; b <= 1; ++b)
+						average += sourceHeight(i + a, j + b);
+				height += (average / 9.0f - height) * std::min(weight, 1.0f);
+				break;
+			}
+			case BrushMode::FLATTEN:
+				height += (brush.flattenHeight - height) * std::min(weight, 1.0f);
+				break;
+			}
+			m_heightField.set(static_cast<uint32_t>(i), static_cast<uint32_t>(j), std::min(std::max(height, 0.0f), 1.0f));
+		}
+	}
+
+	addDirtyRegion({ static_cast<uint32_t>(iMin), static_cast<uint32_t>(jMin), static_cast<uint32_t>(iMax - iMin + 1), static_cast<uint32_t>(jMax - jMin + 1) });
+}
+
+void TerrainEditor::takeDirtyRegions(std::vector<Region>& outRegions)
+{
+	outRegions.clear();
+	outRegions.swap(m_dirtyRegions);
+}
+
+void TerrainEditor::addDirtyRegion(Region region)
+{
+	// A region absorbs every region it overlaps or touches, the grown region is then checked again against the remaining ones
+	bool merged = true;
+	while (merged)
+	{
+		merged = false;
+		for (size_t regionIndex = 0; regionIndex < m_dirtyRegions.size(); ++regionIndex)
+		{
+			const Region& other = m_dirtyRegions[regionIndex];
+			if (other.i > region.i + region.height || region.i > other.i + other.height || other.j > region.j + region.width || region.j > other.j + other.width)
+				continue;
+
+			const uint32_t iEnd = std::max(region.i + region.height, other.i + other.height);
+			const uint32_t jEnd = std::max(region.j + region.width, other.j + other.width);
+			region.i = std::min(region.i, other.i);
+			region.j = std::min(region.j, other.j);
+			region.height = iEnd - region.i;
+			region.width = jEnd - region.j;
+
+			m_dirtyRegions[regionIndex] = m_dirtyRegions.back();
+			m_dirtyRegions.pop_back();
+			merged = true;
+			break;
+		}
+	}
+
+	m_dirtyRegions.push_back(region);
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <vector>
+
+#include "HeightField.h"
+
+// Brush edits of the heightfield. The modified samples are tracked as dirty rectangles, merged when they overlap or touch, so that the GPU data
+// derived from the heights (vertices, normal map, height texture) are only updated over the edited area
+class TerrainEditor
+{
+public:
+	enum class BrushMode
+	{
+		RAISE,
+		LOWER,
+		SMOOTH, // towards the average of the 3x3 neighbourhood
+		FLATTEN // towards flattenHeight
+	};
+
+	struct Brush
+	{
+		BrushMode mode = BrushMode::RAISE;
+		float radius = 16.0f; // in samples
+		float strength = 0.005f; // raise and lower: height change at the center, smooth and flatten: blend factor at the center
+		float flattenHeight = 0.5f;
+	};
+
+	// Samples [i, i + height[ x [j, j + width[
+	struct Region
+	{
+		uint32_t i;
+		uint32_t j;
+		uint32_t height;
+		uint32_t width;
+	};
+
+	explicit TerrainEditor(HeightField& heightField) : m_heightField(heightField) {}
+
+	// The influence decreases as (1 - d^2 / r^2)^2 from the center (in samples, i along x and j along z), heights stay in [0, 1]
+	void apply(const Brush& brush, float centerI, float centerJ);
+
+	bool hasDirtyRegions() const { return !m_dirtyRegions.empty(); }
+	// Regions modified since the previous call, they don't overlap
+	void takeDirtyRegions(std::vector<Region>& outRegions);
+
+private:
+	void addDirtyRegion(Region region);
+
+private:
+	HeightField& m_heightField;
+	std::vector<Region> m_dirtyRegions;
+	std::vector<float> m_sourceHeights; // smooth reads the heights before the edit
+};
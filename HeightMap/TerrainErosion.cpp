@@ -0,0 +1,293 @@
+#include "TerrainErosion.h"
+
+#include <algorithm>
+#include <cmath>
+
+TerrainErosion::TerrainErosion(const Parameters& parameters) : m_parameters(parameters)
+{
+	// Weights decrease linearly with the distance to the droplet cell
+	const int32_t radius = static_cast<int32_t>(m_parameters.erosionRadius);
+	float totalWeight = 0.0f;
+	for (int32_t i = -radius; i <= radius; ++i)
+	{
+		for (int32_t j = -radius; j <= radius; ++j)
+		{
+			const float weight = radius > 0 ? static_cast<float>(radius) - std::sqrt(static_cast<float>(i * i + j * j)) : 1.0f;
+			if (weight <= 0.0f)
+				continue;
+
+			m_brushOffsetsI.push_back(i);
+			m_brushOffsetsJ.push_back(j);
+			m_brushWeights.push_back(weight);
+			totalWeight += weight;
+		}
+	}
+	for (float& weight : m_brushWeights)
+		weight /= totalWeight;
+}
+
+void TerrainErosion::erode(HeightField& heightField, const TerrainMeshBuilder::GridInfo& gridInfo, ThreadPool* threadPool) const
+{
+	const uint32_t resolution = heightField.getResolution();
+	std::vector<float> heights(static_cast<size_t>(resolution) * resolution);
+	heightField.copyToRowMajor(heights.data());
+
+	if (m_parameters.dropletCount > 0)
+		erodeHydraulic(heights.data(), resolution, threadPool);
+	if (m_parameters.thermalIterationCount > 0)
+		erodeThermal(heights, resolution, m_parameters.talusSlope * gridInfo.tileSize.x / gridInfo.maxHeight, threadPool);
+
+	// The deposits can slightly exceed the height range
+	for (float& height : heights)
+		height = std::min(std::max(height, 0.0f), 1.0f);
+	heightField.copyFromRowMajor(heights.data());
+}
+
+void TerrainErosion::erodeHydraulic(float* heights, uint32_t resolution, ThreadPool* threadPool) const
+{
+	const int32_t tileSize = static_cast<int32_t>(std::min<uint32_t>(TERRAIN_EROSION_TILE_SIZE, resolution));
+	const int32_t margin = tileSize / 4;
+	const int32_t lastSample = static_cast<int32_t>(resolution) - 1;
+	const uint64_t dropletCountPerRound = m_parameters.dropletCount / TERRAIN_EROSION_ROUND_COUNT;
+
+	std::vector<uint32_t> phaseTiles;
+	for (uint32_t round = 0; round < TERRAIN_EROSION_ROUND_COUNT; ++round)
+	{
+		const int32_t offset = static_cast<int32_t>(round) * tileSize / TERRAIN_EROSION_ROUND_COUNT;
+		const uint32_t tileCountPerSide = (resolution + offset + tileSize - 1) / tileSize;
+
+		// Tiles of a phase are separated by a tile, wider than both their margins
+		for (uint32_t phase = 0; phase < 4; ++phase)
+		{
+			phaseTiles.clear();
+			for (uint32_t tileI = phase & 1; tileI < tileCountPerSide; tileI += 2)
+				for (uint32_t tileJ = phase >> 1; tileJ < tileCountPerSide; tileJ += 2)
+					phaseTiles.push_back(tileI * tileCountPerSide + tileJ);
+
+			auto erodeTile = [&](uint32_t phaseTileIndex)
+			{
+				const uint32_t tileIndex = phaseTiles[phaseTileIndex];
+				Area tile;
+				tile.iMin = std::max(static_cast<int32_t>(tileIndex / tileCountPerSide) * tileSize - offset, 0);
+				tile.jMin = std::max(static_cast<int32_t>(tileIndex % tileCountPerSide) * tileSize - offset, 0);
+				tile.iMax = std::min(static_cast<int32_t>(tileIndex / tileCountPerSide + 1) * tileSize - offset - 1, lastSample);
+				tile.jMax = std::min(static_cast<int32_t>(tileIndex % tileCountPerSide + 1) * tileSize - offset - 1, lastSample);
+				const Area area = { std::max(tile.iMin - margin, 0), std::max(tile.jMin - margin, 0), std::min(tile.iMax + margin, lastSample),
+					std::min(tile.jMax + margin, lastSample) };
+
+				// Same density of droplets everywhere
+				const uint32_t tileHeight = tile.iMax - tile.iMin + 1;
+				const uint32_t tileWidth = tile.jMax - tile.jMin + 1;
+				const uint64_t dropletCount = dropletCountPerRound * tileHeight * tileWidth / (static_cast<uint64_t>(resolution) * resolution);
+
+				uint32_t randomState = hash(m_parameters.seed ^ hash(round * 0x9E3779B9u + hash(tileIndex)));
+				for (uint64_t droplet = 0; droplet < dropletCount; ++droplet)
+				{
+					const float i = static_cast<float>(tile.iMin) + randomFloat(randomState) * static_cast<float>(tileHeight - 1);
+					const float j = static_cast<float>(tile.jMin) + randomFloat(randomState) * static_cast<float>(tileWidth - 1);
+					runDroplet(heights, resolution, area, i, j);
+				}
+			};
+
+			if (threadPool)
+				threadPool->parallelFor(static_cast<uint32_t>(phaseTiles.size()), erodeTile);
+			else
+				for (uint32_t phaseTileIndex = 0; phaseTileIndex < phaseTiles.size(); ++phaseTileIndex)
+					erodeTile(phaseTileIndex);
+		}
+	}
+}
+
+void TerrainErosion::runDroplet(float* heights, uint32_t resolution, const Area& area, float i, float j) const
+{
+	const int32_t reach = std::max<int32_t>(static_cast<int32_t>(m_parameters.erosionRadius), 1); // cells around the droplet that it can modify
+	float directionI = 0.0f;
+	float directionJ = 0.0f;
+	float speed = 1.0f;
+	float water = 1.0f;
+	float sediment = 0.0f;
+
+	// Where the droplet stops, the sediment it carries is dropped if the cell is in its area
+	auto dropSediment = [&](float stopI, float stopJ)
+	{
+		const int32_t cellI = static_cast<int32_t>(stopI);
+		const int32_t cellJ = static_cast<int32_t>(stopJ);
+		if (cellI < area.iMin || cellI >= area.iMax || cellJ < area.jMin || cellJ >= area.jMax)
+			return;
+
+		const float u = stopI - static_cast<float>(cellI);
+		const float v = stopJ - static_cast<float>(cellJ);
+		float* cell = heights + static_cast<size_t>(cellI) * resolution + cellJ;
+		cell[0] += sediment * (1.0f - u) * (1.0f - v);
+		cell[1] += sediment * (1.0f - u) * v;
+		cell[resolution] += sediment * u * (1.0f - v);
+		cell[resolution + 1] += sediment * u * v;
+	};
+
+	for (uint32_t step = 0; step < m_parameters.maxDropletLifetime; ++step)
+	{
+		// The droplet stops where it would modify the heights outside of its area
+		const int32_t cellI = static_cast<int32_t>(i);
+		const int32_t cellJ = static_cast<int32_t>(j);
+		if (cellI - reach < area.iMin || cellI + reach > area.iMax || cellJ - reach < area.jMin || cellJ + reach > area.jMax)
+			break;
+
+		// Bilinear height and gradient in the cell
+		const float u = i - static_cast<float>(cellI);
+		const float v = j - static_cast<float>(cellJ);
+		float* cell = heights + static_cast<size_t>(cellI) * resolution + cellJ;
+		const float topLeft = cell[0];
+		const float topRight = cell[1];
+		const float bottomLeft = cell[resolution];
+		const float bottomRight = cell[resolution + 1];
+		const float gradientI = (bottomLeft - topLeft) * (1.0f - v) + (bottomRight - topRight) * v;
+		const float gradientJ = (topRight - topLeft) * (1.0f - u) + (bottomRight - bottomLeft) * u;
+		const float height = topLeft * (1.0f - u) * (1.0f - v) + bottomLeft * u * (1.0f - v) + topRight * (1.0f - u) * v + bottomRight * u * v;
+
+		directionI = directionI * m_parameters.inertia - gradientI * (1.0f - m_parameters.inertia);
+		directionJ = directionJ * m_parameters.inertia - gradientJ * (1.0f - m_parameters.inertia);
+		const float directionLength = std::sqrt(directionI * directionI + directionJ * directionJ);
+		if (directionLength == 0.0f) // flat, no way to go
+			break;
+		directionI /= directionLength;
+		directionJ /= directionLength;
+
+		const float nextI = i + directionI;
+		const float nextJ = j + directionJ;
+		const int32_t nextCellI = static_cast<int32_t>(nextI);
+		const int32_t nextCellJ = static_cast<int32_t>(nextJ);
+		if (nextI < 0.0f || nextJ < 0.0f || nextCellI < area.iMin || nextCellI >= area.iMax || nextCellJ < area.jMin || nextCellJ >= area.jMax)
+			break;
+		i = nextI;
+		j = nextJ;
+
+		const float nextU = i - static_cast<float>(nextCellI);
+		const float nextV = j - static_cast<float>(nextCellJ);
+		const float* nextCell = heights + static_cast<size_t>(nextCellI) * resolution + nextCellJ;
+		const float nextHeight = nextCell[0] * (1.0f - nextU) * (1.0f - nextV) + nextCell[resolution] * nextU * (1.0f - nextV) +
+			nextCell[1] * (1.0f - nextU) * nextV + nextCell[resolution + 1] * nextU * nextV;
+		const float heightDifference = nextHeight - height;
+
+		const float capacity = std::max(-heightDifference * speed * water * m_parameters.sedimentCapacity, m_parameters.minSedimentCapacity);
+		if (sediment > capacity || heightDifference > 0.0f)
+		{
+			// Uphill, the droplet fills the pit it leaves, at most up to the next height. Otherwise it drops the sediment over its capacity
+			const float deposit = heightDifference > 0.0f ? std::min(heightDifference, sediment) : (sediment - capacity) * m_parameters.depositSpeed;
+			sediment -= deposit;
+			cell[0] += deposit * (1.0f - u) * (1.0f - v);
+			cell[1] += deposit * (1.0f - u) * v;
+			cell[resolution] += deposit * u * (1.0f - v);
+			cell[resolution + 1] += deposit * u * v;
+		}
+		else
+		{
+			// Never more than the height difference, which would dig a pit
+			const float erosion = std::min((capacity - sediment) * m_parameters.erodeSpeed, -heightDifference);
+			for (size_t brushIndex = 0; brushIndex < m_brushWeights.size(); ++brushIndex)
+			{
+				float& brushHeight = cell[static_cast<ptrdiff_t>(m_brushOffsetsI[brushIndex]) * resolution + m_brushOffsetsJ[brushIndex]];
+				const float brushErosion = std::min(brushHeight, erosion * m_brushWeights[brushIndex]);
+				brushHeight -= brushErosion;
+				sediment += brushErosion;
+			}
+		}
+
+		speed = std::sqrt(std::max(speed * speed - heightDifference * m_parameters.gravity, 0.0f));
+		water *= 1.0f - m_parameters.evaporateSpeed;
+	}
+
+	dropSediment(i, j);
+}
+
+void TerrainErosion::erodeThermal(std::vector<float>& heights, uint32_t resolution, float talus, ThreadPool* threadPool) const
+{
+	// Each cell sends rate * (steepest difference - talus) / 2 to its 4 neighbours, in proportion to their difference over the talus.
+	// The first pass computes that proportion per cell, the second gathers what each cell sends and receives
+	std::vector<float> nextHeights(heights.size());
+	std::vector<float> flowFactors(heights.size());
+	const int32_t neighbourOffsets[4][2] = { { -1, 0 }, { 1, 0 }, { 0, -1 }, { 0, 1 } };
+	const uint32_t bandCount = (resolution + TERRAIN_EROSION_BAND_SIZE - 1) / TERRAIN_EROSION_BAND_SIZE;
+
+	auto forEachNeighbour = [&](uint32_t i, uint32_t j, auto function)
+	{
+		for (const int32_t* offset : neighbourOffsets)
+		{
+			const uint32_t neighbourI = i + offset[0];
+			const uint32_t neighbourJ = j + offset[1];
+			if (neighbourI < resolution && neighbourJ < resolution) // wraps below 0
+				function(static_cast<size_t>(neighbourI) * resolution + neighbourJ);
+		}
+	};
+	auto forEachBand = [&](const std::function<void(uint32_t)>& job)
+	{
+		if (threadPool)
+			threadPool->parallelFor(bandCount, job);
+		else
+			for (uint32_t band = 0; band < bandCount; ++band)
+				job(band);
+	};
+
+	for (uint32_t iteration = 0; iteration < m_parameters.thermalIterationCount; ++iteration)
+	{
+		forEachBand([&](uint32_t band)
+		{
+			const uint32_t iEnd = std::min((band + 1) * TERRAIN_EROSION_BAND_SIZE, resolution);
+			for (uint32_t i = band * TERRAIN_EROSION_BAND_SIZE; i < iEnd; ++i)
+			{
+				for (uint32_t j = 0; j < resolution; ++j)
+				{
+					const size_t index = static_cast<size_t>(i) * resolution + j;
+					float totalExcess = 0.0f;
+					float maxDifference = 0.0f;
+					forEachNeighbour(i, j, [&](size_t neighbourIndex)
+					{
+						const float difference = heights[index] - heights[neighbourIndex];
+						totalExcess += std::max(difference - talus, 0.0f);
+						maxDifference = std::max(maxDifference, difference);
+					});
+					flowFactors[index] = totalExcess > 0.0f ? m_parameters.thermalRate * (maxDifference - talus) * 0.5f / totalExcess : 0.0f;
+				}
+			}
+		});
+
+		forEachBand([&](uint32_t band)
+		{
+			const uint32_t iEnd = std::min((band + 1) * TERRAIN_EROSION_BAND_SIZE, resolution);
+			for (uint32_t i = band * TERRAIN_EROSION_BAND_SIZE; i < iEnd; ++i)
+			{
+				for (uint32_t j = 0; j < resolution; ++j)
+				{
+					const size_t index = static_cast<size_t>(i) * resolution + j;
+					float height = heights[index];
+					forEachNeighbour(i, j, [&](size_t neighbourIndex)
+					{
+						const float difference = heights[index] - heights[neighbourIndex];
+						if (difference > talus)
+							height -= (difference - talus) * flowFactors[index];
+						else if (-difference > talus)
+							height += (-difference - talus) * flowFactors[neighbourIndex];
+					});
+					nextHeights[index] = height;
+				}
+			}
+		});
+
+		heights.swap(nextHeights);
+	}
+}
+
+uint32_t TerrainErosion::hash(uint32_t x)
+{
+	x ^= x >> 16;
+	x *= 0x7FEB352Du;
+	x ^= x >> 15;
+	x *= 0x846CA68Bu;
+	x ^= x >> 16;
+	return x;
+}
+
+float TerrainErosion::randomFloat(uint32_t& state)
+{
+	state += 0x9E3779B9u;
+	return static_cast<float>(hash(state) >> 8) * (1.0f / 16777216.0f);
+}
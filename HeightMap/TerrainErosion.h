@@ -0,0 +1,70 @@
+#pragma once
+
+#include <vector>
+
+#include "HeightField.h"
+#include "TerrainMeshBuilder.h"
+#include "ThreadPool.h"
+
+#define TERRAIN_EROSION_TILE_SIZE 128 // droplet tiles, a droplet can leave its tile by a quarter of a tile
+#define TERRAIN_EROSION_ROUND_COUNT 4 // the tile grid is shifted between rounds so that the tile borders don't show
+#define TERRAIN_EROSION_BAND_SIZE 32 // rows of a thermal erosion job
+
+// Post-process of the generated heights: particle based hydraulic erosion (droplets carving the slopes and depositing in the valleys),
+// then grid based thermal erosion (material sliding down the slopes steeper than the angle of repose).
+// The droplets of a tile only touch the heights of their tile and its margin, and the tiles run concurrently are two tiles apart (4 phases
+// per round), while thermal erosion reads the previous iteration only: the result doesn't depend on the thread count or scheduling
+class TerrainErosion
+{
+public:
+	struct Parameters
+	{
+		uint32_t seed = 0;
+
+		// Hydraulic erosion, disabled without droplets
+		uint32_t dropletCount = 1u << 21;
+		uint32_t maxDropletLifetime = 30; // steps of one cell
+		float inertia = 0.05f; // part of the previous direction kept at each step
+		float sedimentCapacity = 4.0f;
+		float minSedimentCapacity = 0.01f;
+		float depositSpeed = 0.3f;
+		float erodeSpeed = 0.3f;
+		float evaporateSpeed = 0.01f;
+		float gravity = 4.0f;
+		uint32_t erosionRadius = 3; // in cells, the material is taken around the droplet
+
+		// Thermal erosion, disabled without iterations
+		uint32_t thermalIterationCount = 32;
+		float talusSlope = 0.7f; // steepest stable slope in world units, the tangent of the angle of repose
+		float thermalRate = 0.5f; // part of the material above the angle of repose moved by an iteration
+	};
+
+	TerrainErosion(const Parameters& parameters);
+
+	// gridInfo converts the slopes to world units, a null thread pool erodes on the calling thread
+	void erode(HeightField& heightField, const TerrainMeshBuilder::GridInfo& gridInfo, ThreadPool* threadPool) const;
+
+private:
+	struct Area
+	{
+		int32_t iMin;
+		int32_t jMin;
+		int32_t iMax; // inclusive
+		int32_t jMax;
+	};
+
+	void erodeHydraulic(float* heights, uint32_t resolution, ThreadPool* threadPool) const;
+	void runDroplet(float* heights, uint32_t resolution, const Area& area, float i, float j) const;
+	void erodeThermal(std::vector<float>& heights, uint32_t resolution, float talus, ThreadPool* threadPool) const;
+
+	static uint32_t hash(uint32_t x);
+	static float randomFloat(uint32_t& state);
+
+private:
+	Parameters m_parameters;
+
+	// Cells around a droplet where its material is taken, weights sum to 1
+	std::vector<int32_t> m_brushOffsetsI;
+	std::vector<int32_t> m_brushOffsetsJ;
+	std::vector<float> m_brushWeights;
+};
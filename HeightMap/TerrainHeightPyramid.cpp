@@ -0,0 +1,284 @@
+#include "TerrainHeightPyramid.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#define TERRAIN_HEIGHT_PYRAMID_RAYS_PER_JOB 256
+
+TerrainHeightPyramid::TerrainHeightPyramid(const HeightField& heightField, const TerrainMeshBuilder::GridInfo& gridInfo, ThreadPool* threadPool)
+	: m_heightField(heightField), m_gridInfo(gridInfo), m_threadPool(threadPool), m_resolution(heightField.getResolution())
+{
+	for (uint32_t cellCount = m_resolution; cellCount > 0; cellCount >>= 1)
+		m_levels.emplace_back(static_cast<size_t>(cellCount) * cellCount);
+
+	updateRegion(0, 0, m_resolution, m_resolution);
+}
+
+void TerrainHeightPyramid::updateRegion(uint32_t i, uint32_t j, uint32_t height, uint32_t width)
+{
+	// Cell (i, j) reads the samples up to (i + 1, j + 1)
+	uint32_t firstCellI = i > 0 ? i - 1 : 0;
+	uint32_t firstCellJ = j > 0 ? j - 1 : 0;
+	uint32_t endCellI = std::min(i + height, m_resolution);
+	uint32_t endCellJ = std::min(j + width, m_resolution);
+	updateLevel0(firstCellI, endCellI, firstCellJ, endCellJ);
+
+	for (uint32_t level = 1; level < m_levels.size(); ++level)
+	{
+		firstCellI >>= 1;
+		firstCellJ >>= 1;
+		endCellI = ((endCellI - 1) >> 1) + 1;
+		endCellJ = ((endCellJ - 1) >> 1) + 1;
+		updateLevel(level, firstCellI, endCellI, firstCellJ, endCellJ);
+	}
+}
+
+float TerrainHeightPyramid::getHeight(float x, float z) const
+{
+	const float lastSample = static_cast<float>(m_resolution - 1);
+	const float i = std::min(std::max((x - m_gridInfo.topLeftPos.x) / m_gridInfo.tileSize.x, 0.0f), lastSample);
+	const float j = std::min(std::max((z - m_gridInfo.topLeftPos.z) / m_gridInfo.tileSize.z, 0.0f), lastSample);
+	const uint32_t cellI = std::min(static_cast<uint32_t>(i), m_resolution - 2);
+	const uint32_t cellJ = std::min(static_cast<uint32_t>(j), m_resolution - 2);
+	const float u = i - static_cast<float>(cellI);
+	const float v = j - static_cast<float>(cellJ);
+
+	const float top = getSample(cellI, cellJ) + v * (getSample(cellI, cellJ + 1) - getSample(cellI, cellJ));
+	const float bottom = getSample(cellI + 1, cellJ) + v * (getSample(cellI + 1, cellJ + 1) - getSample(cellI + 1, cellJ));
+	return m_gridInfo.topLeftPos.y + (top + u * (bottom - top)) * m_gridInfo.maxHeight;
+}
+
+TerrainHeightPyramid::RaycastHit TerrainHeightPyramid::raycast(const Ray& ray) const
+{
+	SampleRay sampleRay;
+	if (!toSampleRay(ray, sampleRay))
+		return RaycastHit();
+
+	// Up one level after each cell left, down one level where the ray can hit the heights of the cell. The nudge puts t in the next cell after
+	// each exit, so t moves forward until tEnd: only an exit clamped to the last cell of the terrain border doesn't, and the ray leaves there
+	const uint32_t topLevel = static_cast<uint32_t>(m_levels.size()) - 1;
+	uint32_t level = topLevel;
+	float t = sampleRay.tStart;
+	while (true)
+	{
+		uint32_t cellI, cellJ;
+		float exitT;
+		findCell(sampleRay, t, level, cellI, cellJ, exitT);
+		const float minRayHeight = std::min(sampleRay.origin.y + sampleRay.direction.y * t, sampleRay.origin.y + sampleRay.direction.y * exitT);
+		const float maxCellHeight = m_levels[level][static_cast<size_t>(cellI) * (m_resolution >> level) + cellJ].y;
+
+		if (minRayHeight <= maxCellHeight && level > 0)
+		{
+			--level;
+			continue;
+		}
+
+		float hitT;
+		if (minRayHeight <= maxCellHeight && intersectPatch(sampleRay, cellI, cellJ, t, exitT, hitT))
+			return toHit(ray, hitT);
+		if (exitT >= sampleRay.tEnd || exitT <= t)
+			break;
+		t = exitT;
+		level = std::min(level + 1, topLevel);
+	}
+
+	return RaycastHit();
+}
+
+void TerrainHeightPyramid::raycast(const Ray* rays, uint32_t count, RaycastHit* outHits, ThreadPool* threadPool) const
+{
+	const uint32_t jobCount = (count + TERRAIN_HEIGHT_PYRAMID_RAYS_PER_JOB - 1) / TERRAIN_HEIGHT_PYRAMID_RAYS_PER_JOB;
+	auto castJob = [&](uint32_t job)
+	{
+		const uint32_t firstRayIndex = job * TERRAIN_HEIGHT_PYRAMID_RAYS_PER_JOB;
+		const uint32_t endRayIndex = std::min(firstRayIndex + TERRAIN_HEIGHT_PYRAMID_RAYS_PER_JOB, count);
+		for (uint32_t rayIndex = firstRayIndex; rayIndex < endRayIndex; ++rayIndex)
+			outHits[rayIndex] = raycast(rays[rayIndex]);
+	};
+
+	if (threadPool)
+		threadPool->parallelFor(jobCount, castJob);
+	else
+		for (uint32_t job = 0; job < jobCount; ++job)
+			castJob(job);
+}
+
+bool TerrainHeightPyramid::isVisible(const glm::vec3& from, const glm::vec3& to) const
+{
+	const float distance = glm::length(to - from);
+	if (distance == 0.0f)
+		return true;
+
+	// to can be on the surface
+	return !raycast({ from, to - from, distance * 0.999f }).hit;
+}
+
+bool TerrainHeightPyramid::toSampleRay(const Ray& ray, SampleRay& outSampleRay) const
+{
+	const float directionLength = glm::length(ray.direction);
+	if (directionLength == 0.0f)
+		return false;
+
+	const glm::vec3 direction = ray.direction / directionLength;
+	outSampleRay.origin = (ray.origin - m_gridInfo.topLeftPos) / glm::vec3(m_gridInfo.tileSize.x, m_gridInfo.maxHeight, m_gridInfo.tileSize.z);
+	outSampleRay.direction = direction / glm::vec3(m_gridInfo.tileSize.x, m_gridInfo.maxHeight, m_gridInfo.tileSize.z);
+	outSampleRay.inverseDirection = 1.0f / outSampleRay.direction;
+	outSampleRay.nudge = glm::vec3(outSampleRay.direction.x > 0.0f ? TERRAIN_HEIGHT_PYRAMID_NUDGE : -TERRAIN_HEIGHT_PYRAMID_NUDGE, 0.0f,
+		outSampleRay.direction.z > 0.0f ? TERRAIN_HEIGHT_PYRAMID_NUDGE : -TERRAIN_HEIGHT_PYRAMID_NUDGE);
+	if (outSampleRay.direction.x == 0.0f)
+		outSampleRay.nudge.x = 0.0f;
+	if (outSampleRay.direction.z == 0.0f)
+		outSampleRay.nudge.z = 0.0f;
+
+	// Clipped to the bounds of the terrain, which is solid down to -infinity: a ray passing under the lowest height enters it through its side
+	const glm::vec2 rootBounds = m_levels.back()[0];
+	const glm::vec3 boundsMin(0.0f, -std::numeric_limits<float>::infinity(), 0.0f);
+	const glm::vec3 boundsMax(static_cast<float>(m_resolution - 1), rootBounds.y, static_cast<float>(m_resolution - 1));
+	outSampleRay.tStart = 0.0f;
+	outSampleRay.tEnd = ray.maxDistance;
+	for (glm::length_t axis = 0; axis < 3; ++axis)
+	{
+		if (outSampleRay.direction[axis] == 0.0f)
+		{
+			if (outSampleRay.origin[axis] < boundsMin[axis] || outSampleRay.origin[axis] > boundsMax[axis])
+				return false;
+			continue;
+		}
+
+		float tMin = (boundsMin[axis] - outSampleRay.origin[axis]) * outSampleRay.inverseDirection[axis];
+		float tMax = (boundsMax[axis] - outSampleRay.origin[axis]) * outSampleRay.inverseDirection[axis];
+		if (tMin > tMax)
+			std::swap(tMin, tMax);
+		outSampleRay.tStart = std::max(outSampleRay.tStart, tMin);
+		outSampleRay.tEnd = std::min(outSampleRay.tEnd, tMax);
+	}
+
+	return outSampleRay.tStart <= outSampleRay.tEnd;
+}
+
+TerrainHeightPyramid::RaycastHit TerrainHeightPyramid::toHit(const Ray& ray, float t) const
+{
+	RaycastHit hit;
+	hit.hit = true;
+	hit.distance = t;
+	hit.position = ray.origin + glm::normalize(ray.direction) * t;
+	return hit;
+}
+
+void TerrainHeightPyramid::findCell(const SampleRay& ray, float t, uint32_t level, uint32_t& outCellI, uint32_t& outCellJ, float& outExitT) const
+{
+	const float size = static_cast<float>(1u << level);
+	const float inverseSize = 1.0f / size;
+	const uint32_t lastCell = (m_resolution >> level) - 1;
+	const float i = (ray.origin.x + ray.direction.x * t) + ray.nudge.x;
+	const float j = (ray.origin.z + ray.direction.z * t) + ray.nudge.z;
+	outCellI = std::min(static_cast<uint32_t>(std::max(i * inverseSize, 0.0f)), lastCell);
+	outCellJ = std::min(static_cast<uint32_t>(std::max(j * inverseSize, 0.0f)), lastCell);
+
+	const float infinity = std::numeric_limits<float>::infinity();
+	const float exitI = ray.direction.x != 0.0f ?
+		(static_cast<float>(outCellI + (ray.direction.x > 0.0f ? 1 : 0)) * size - ray.origin.x) * ray.inverseDirection.x : infinity;
+	const float exitJ = ray.direction.z != 0.0f ?
+		(static_cast<float>(outCellJ + (ray.direction.z > 0.0f ? 1 : 0)) * size - ray.origin.z) * ray.inverseDirection.z : infinity;
+	outExitT = std::min(std::min(exitI, exitJ), ray.tEnd);
+}
+
+bool TerrainHeightPyramid::intersectPatch(const SampleRay& ray, uint32_t cellI, uint32_t cellJ, float t, float exitT, float& outT) const
+{
+	// Along the ray from t, the bilinear height h00 + a * u + b * v + c * u * v is a quadratic of the distance s: the difference with the ray height
+	// is quadraticA * s^2 + quadraticB * s + quadraticC
+	const float h00 = getSample(cellI, cellJ);
+	const float h10 = getSample(cellI + 1, cellJ);
+	const float h01 = getSample(cellI, cellJ + 1);
+	const float h11 = getSample(cellI + 1, cellJ + 1);
+	const float a = h10 - h00;
+	const float b = h01 - h00;
+	const float c = h00 - h10 - h01 + h11;
+
+	const float u = ray.origin.x + ray.direction.x * t - static_cast<float>(cellI);
+	const float v = ray.origin.z + ray.direction.z * t - static_cast<float>(cellJ);
+	const float quadraticC = (ray.origin.y + ray.direction.y * t) - (h00 + a * u + b * v + c * u * v);
+	if (quadraticC <= 0.0f)
+	{
+		outT = t;
+		return true;
+	}
+	const float quadraticB = ray.direction.y - (a * ray.direction.x + b * ray.direction.z + c * (u * ray.direction.z + v * ray.direction.x));
+	const float quadraticA = -c * ray.direction.x * ray.direction.z;
+
+	// The ray is above at s = 0, the hit is the first root
+	float s = std::numeric_limits<float>::infinity();
+	if (quadraticA == 0.0f)
+	{
+		if (quadraticB < 0.0f)
+			s = -quadraticC / quadraticB;
+	}
+	else
+	{
+		const float discriminant = quadraticB * quadraticB - 4.0f * quadraticA * quadraticC;
+		if (discriminant < 0.0f)
+			return false;
+
+		// Without the cancellation of -b + sqrt(discriminant)
+		const float q = -0.5f * (quadraticB + std::copysign(std::sqrt(discriminant), quadraticB));
+		const float root0 = q / quadraticA;
+		const float root1 = q != 0.0f ? quadraticC / q : root0;
+		if (root0 >= 0.0f)
+			s = root0;
+		if (root1 >= 0.0f)
+			s = std::min(s, root1);
+	}
+
+	if (s > exitT - t)
+		return false;
+	outT = t + s;
+	return true;
+}
+
+void TerrainHeightPyramid::updateLevel0(uint32_t firstCellI, uint32_t endCellI, uint32_t firstCellJ, uint32_t endCellJ)
+{
+	std::vector<glm::vec2>& cells = m_levels[0];
+	auto updateRow = [&](uint32_t row)
+	{
+		const uint32_t cellI = firstCellI + row;
+		for (uint32_t cellJ = firstCellJ; cellJ < endCellJ; ++cellJ)
+		{
+			const float h00 = getSample(cellI, cellJ);
+			const float h10 = getSample(cellI + 1, cellJ);
+			const float h01 = getSample(cellI, cellJ + 1);
+			const float h11 = getSample(cellI + 1, cellJ + 1);
+			cells[static_cast<size_t>(cellI) * m_resolution + cellJ] = glm::vec2(std::min(std::min(h00, h10), std::min(h01, h11)),
+				std::max(std::max(h00, h10), std::max(h01, h11)));
+		}
+	};
+
+	if (m_threadPool)
+		m_threadPool->parallelFor(endCellI - firstCellI, updateRow);
+	else
+		for (uint32_t row = 0; row < endCellI - firstCellI; ++row)
+			updateRow(row);
+}
+
+void TerrainHeightPyramid::updateLevel(uint32_t level, uint32_t firstCellI, uint32_t endCellI, uint32_t firstCellJ, uint32_t endCellJ)
+{
+	const std::vector<glm::vec2>& children = m_levels[level - 1];
+	std::vector<glm::vec2>& cells = m_levels[level];
+	const uint32_t childCountPerSide = m_resolution >> (level - 1);
+	for (uint32_t cellI = firstCellI; cellI < endCellI; ++cellI)
+	{
+		for (uint32_t cellJ = firstCellJ; cellJ < endCellJ; ++cellJ)
+		{
+			const glm::vec2* topChildren = &children[static_cast<size_t>(2 * cellI) * childCountPerSide + 2 * cellJ];
+			const glm::vec2* bottomChildren = topChildren + childCountPerSide;
+			cells[static_cast<size_t>(cellI) * (childCountPerSide >> 1) + cellJ] = glm::vec2(
+				std::min(std::min(topChildren[0].x, topChildren[1].x), std::min(bottomChildren[0].x, bottomChildren[1].x)),
+				std::max(std::max(topChildren[0].y, topChildren[1].y), std::max(bottomChildren[0].y, bottomChildren[1].y)));
+		}
+	}
+}
+
+float TerrainHeightPyramid::getSample(uint32_t i, uint32_t j) const
+{
+	return m_heightField.get(std::min(i, m_resolution - 1), std::min(j, m_resolution - 1));
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <vector>
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/glm.hpp>
+
+#include "HeightField.h"
+#include "TerrainMeshBuilder.h"
+#include "ThreadPool.h"
+
+#define TERRAIN_HEIGHT_PYRAMID_NUDGE (1.0f / 256.0f) // in samples, moves a point on a cell border into the next cell along the ray
+
+// Min/max pyramid of the heightfield for height queries and ray casts. Cell (i, j) of level 0 is the bilinear patch between the samples (i, j)
+// and (i + 1, j + 1), a cell of level l contains 2^l * 2^l cells of level 0. A ray descends the pyramid only where it can hit a cell's height range,
+// skipping the largest empty cells, so that a query visits O(log N) cells instead of marching every sample.
+// The heightfield resolution must be a power of 2, positions are in world space (sample (i, j) at topLeftPos + (i * tileSize.x, height * maxHeight, j * tileSize.z))
+class TerrainHeightPyramid
+{
+public:
+	struct Ray
+	{
+		glm::vec3 origin;
+		glm::vec3 direction; // doesn't need to be normalized
+		float maxDistance;
+	};
+
+	struct RaycastHit
+	{
+		bool hit = false;
+		float distance = 0.0f; // along the normalized direction
+		glm::vec3 position = glm::vec3(0.0f);
+	};
+
+	TerrainHeightPyramid(const HeightField& heightField, const TerrainMeshBuilder::GridInfo& gridInfo, ThreadPool* threadPool);
+
+	// The samples [i, i + height[ x [j, j + width[ were modified
+	void updateRegion(uint32_t i, uint32_t j, uint32_t height, uint32_t width);
+	// The heightfields of both pyramids exchanged their samples (same resolution): exchanges the levels built from them
+	void swapHeightData(TerrainHeightPyramid& other) { m_levels.swap(other.m_levels); }
+
+	// Bilinear height at (x, z), clamped to the terrain
+	float getHeight(float x, float z) const;
+	// First intersection with the bilinear patches, a ray starting under the terrain hits where it enters the terrain bounds
+	RaycastHit raycast(const Ray& ray) const;
+	// raycast() of each ray, in jobs of the thread pool. A null thread pool casts on the calling thread
+	void raycast(const Ray* rays, uint32_t count, RaycastHit* outHits, ThreadPool* threadPool) const;
+	// Nothing between from and to
+	bool isVisible(const glm::vec3& from, const glm::vec3& to) const;
+
+private:
+	// Ray in sample space: i, normalized height, j. t is the world distance
+	struct SampleRay
+	{
+		glm::vec3 origin;
+		glm::vec3 direction;
+		glm::vec3 inverseDirection;
+		glm::vec3 nudge; // TERRAIN_HEIGHT_PYRAMID_NUDGE towards the direction
+		float tStart;
+		float tEnd;
+	};
+	bool toSampleRay(const Ray& ray, SampleRay& outSampleRay) const;
+	RaycastHit toHit(const Ray& ray, float t) const;
+
+	// Cell of a level containing the point at t, t at which the ray leaves it
+	void findCell(const SampleRay& ray, float t, uint32_t level, uint32_t& outCellI, uint32_t& outCellJ, float& outExitT) const;
+	// First t in [t, exitT] where the ray is under the patch of the level 0 cell
+	bool intersectPatch(const SampleRay& ray, uint32_t cellI, uint32_t cellJ, float t, float exitT, float& outT) const;
+
+	void updateLevel0(uint32_t firstCellI, uint32_t endCellI, uint32_t firstCellJ, uint32_t endCellJ);
+	void updateLevel(uint32_t level, uint32_t firstCellI, uint32_t endCellI, uint32_t firstCellJ, uint32_t endCellJ);
+	float getSample(uint32_t i, uint32_t j) const;
+
+private:
+	const HeightField& m_heightField;
+	TerrainMeshBuilder::GridInfo m_gridInfo;
+	ThreadPool* m_threadPool;
+	uint32_t m_resolution;
+
+	// (min, max) normalized heights, m_levels[level][cellI * (resolution >> level) + cellJ]
+	std::vector<std::vector<glm::vec2>> m_levels;
+};
@@ -0,0 +1,64 @@
+#include "TerrainHeightTexture.h"
+
+TerrainHeightTexture::TerrainHeightTexture(Wolf::WolfInstance* wolfInstance, const HeightField& heightField, ThreadPool* threadPool)
+	: m_heightField(heightField), m_threadPool(threadPool)
+{
+	const uint32_t resolution = m_heightField.getResolution();
+	m_image = wolfInstance->createImage({ resolution, resolution, 1 }, VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT, VK_FORMAT_R16_UNORM,
+		VK_SAMPLE_COUNT_1_BIT, VK_IMAGE_ASPECT_COLOR_BIT);
+
+	updateRegion(0, 0, resolution, resolution);
+}
+
+TerrainHeightTexture::TerrainHeightTexture(Wolf::Image* image, const HeightField& heightField, ThreadPool* threadPool)
+	: m_heightField(heightField), m_threadPool(threadPool), m_image(image)
+{
+}
+
+void TerrainHeightTexture::updateRegion(uint32_t i, uint32_t j, uint32_t height, uint32_t width)
+{
+	const VkOffset2D offset = { static_cast<int32_t>(j), static_cast<int32_t>(i) };
+	if (m_image->getFormat() == VK_FORMAT_R32_SFLOAT)
+	{
+		std::vector<float> texels;
+		convertRegion(m_heightField, i, j, height, width, texels, m_threadPool);
+		m_image->copyFromPixels(texels.data(), sizeof(float), offset, { width, height }, VK_PIPELINE_STAGE_VERTEX_SHADER_BIT);
+	}
+	else
+	{
+		std::vector<uint16_t> texels;
+		computeRegion(m_heightField, i, j, height, width, texels, m_threadPool);
+		uploadRegion(i, j, height, width, texels);
+	}
+}
+
+void TerrainHeightTexture::uploadRegion(uint32_t i, uint32_t j, uint32_t height, uint32_t width, const std::vector<uint16_t>& texels)
+{
+	m_image->copyFromPixels(texels.data(), sizeof(uint16_t), { static_cast<int32_t>(j), static_cast<int32_t>(i) }, { width, height }, VK_PIPELINE_STAGE_VERTEX_SHADER_BIT);
+}
+
+void TerrainHeightTexture::computeRegion(const HeightField& heightField, uint32_t i, uint32_t j, uint32_t height, uint32_t width, std::vector<uint16_t>& outTexels,
+	ThreadPool* threadPool)
+{
+	convertRegion(heightField, i, j, height, width, outTexels, threadPool);
+}
+
+template<typename T>
+void TerrainHeightTexture::convertRegion(const HeightField& heightField, uint32_t i, uint32_t j, uint32_t height, uint32_t width, std::vector<T>& outTexels,
+	ThreadPool* threadPool)
+{
+	outTexels.resize(static_cast<size_t>(width) * height);
+
+	auto convertRow = [&](uint32_t row)
+	{
+		T* texels = &outTexels[static_cast<size_t>(row) * width];
+		for (uint32_t column = 0; column < width; ++column)
+			texels[column] = convertHeight(heightField.get(i + row, j + column), T());
+	};
+
+	if (threadPool)
+		threadPool->parallelFor(height, convertRow);
+	else
+		for (uint32_t row = 0; row < height; ++row)
+			convertRow(row);
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+
+#include <WolfEngine.h>
+
+#include "HeightField.h"
+#include "ThreadPool.h"
+
+// The heightfield as a R16_UNORM image (heights are in [0, 1]) for the vertex shader displacement, texel (x = j, y = i) is the sample (i, j)
+// An edit of the heightfield only uploads the modified region again. An image already holding the heights (R16_UNORM or R32_SFLOAT, e.g. generated
+// on the GPU) can be used instead
+class TerrainHeightTexture
+{
+public:
+	TerrainHeightTexture(Wolf::WolfInstance* wolfInstance, const HeightField& heightField, ThreadPool* threadPool);
+	TerrainHeightTexture(Wolf::Image* image, const HeightField& heightField, ThreadPool* threadPool);
+
+	// Uploads the samples [i, i + height[ x [j, j + width[ from the heightfield
+	void updateRegion(uint32_t i, uint32_t j, uint32_t height, uint32_t width);
+	// R16_UNORM image only: uploads the texels of the samples [i, i + height[ x [j, j + width[ given by computeRegion, e.g. on another thread
+	void uploadRegion(uint32_t i, uint32_t j, uint32_t height, uint32_t width, const std::vector<uint16_t>& texels);
+
+	Wolf::Image* getImage() const { return m_image; }
+
+	// R16_UNORM texels of the samples [i, i + height[ x [j, j + width[, row-major. A null thread pool converts on the calling thread
+	static void computeRegion(const HeightField& heightField, uint32_t i, uint32_t j, uint32_t height, uint32_t width, std::vector<uint16_t>& outTexels,
+		ThreadPool* threadPool);
+
+private:
+	template<typename T>
+	static void convertRegion(const HeightField& heightField, uint32_t i, uint32_t j, uint32_t height, uint32_t width, std::vector<T>& outTexels,
+		ThreadPool* threadPool);
+	static uint16_t convertHeight(float height, uint16_t) { return static_cast<uint16_t>(std::lround(std::min(std::max(height, 0.0f), 1.0f) * 65535.0f)); }
+	static float convertHeight(float height, float) { return height; }
+
+private:
+	const HeightField& m_heightField;
+	ThreadPool* m_threadPool;
+	Wolf::Image* m_image;
+};
@@ -0,0 +1,260 @@
+#include "TerrainHorizonMap.h"
+
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define TERRAIN_HORIZON_MAP_X86
+#include <emmintrin.h>
+#endif
+
+TerrainHorizonMap::TerrainHorizonMap(Wolf::WolfInstance* wolfInstance, const HeightField& heightField, const TerrainMeshBuilder::GridInfo& gridInfo,
+	ThreadPool* threadPool) : m_heightField(heightField), m_gridInfo(gridInfo), m_threadPool(threadPool)
+{
+	const uint32_t resolution = m_heightField.getResolution();
+	for (Wolf::Image*& image : m_images)
+		image = wolfInstance->createImage({ resolution, resolution, 1 }, VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT, VK_FORMAT_R8G8B8A8_UNORM,
+			VK_SAMPLE_COUNT_1_BIT, VK_IMAGE_ASPECT_COLOR_BIT);
+
+	for (std::vector<uint32_t>& texels : m_texels)
+		texels.resize(static_cast<size_t>(resolution) * resolution);
+	updateRegion(0, 0, resolution, resolution);
+}
+
+void TerrainHorizonMap::updateRegion(uint32_t i, uint32_t j, uint32_t height, uint32_t width)
+{
+	static const int32_t directions[TERRAIN_HORIZON_MAP_DIRECTION_COUNT][2] = { { 1, 0 }, { 1, 1 }, { 0, 1 }, { -1, 1 }, { -1, 0 }, { -1, -1 }, { 0, -1 }, { 1, -1 } };
+	const uint32_t resolution = m_heightField.getResolution();
+	if (height == resolution && width == resolution)
+	{
+		// Every line is swept again, without comparing
+		for (uint32_t imageIndex = 0; imageIndex < TERRAIN_HORIZON_MAP_IMAGE_COUNT; ++imageIndex)
+		{
+			computeTexels(m_heightField, m_gridInfo, 4 * imageIndex, m_texels[imageIndex].data(), m_threadPool);
+			m_images[imageIndex]->copyFromPixels(m_texels[imageIndex].data(), sizeof(uint32_t), { 0, 0 }, { resolution, resolution }, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+		}
+		return;
+	}
+
+	std::vector<glm::ivec2> lineStarts;
+	std::vector<glm::ivec2> changedSamples;
+	std::mutex changedSamplesMutex;
+	std::vector<glm::uvec2> rowSpans(resolution);
+	std::vector<VkRect2D> regions;
+	std::vector<uint32_t> regionTexels;
+	for (uint32_t imageIndex = 0; imageIndex < TERRAIN_HORIZON_MAP_IMAGE_COUNT; ++imageIndex)
+	{
+		uint32_t* texels = m_texels[imageIndex].data();
+		changedSamples.clear();
+		for (uint32_t plane = 0; plane < 4; ++plane)
+		{
+			const int32_t directionI = directions[4 * imageIndex + plane][0];
+			const int32_t directionJ = directions[4 * imageIndex + plane][1];
+			const float stepLength = glm::length(glm::vec2(directionI * m_gridInfo.tileSize.x, directionJ * m_gridInfo.tileSize.z));
+			const uint32_t channelMask = 0xFFu << (8 * plane);
+			getLineStarts(resolution, directionI, directionJ, i, j, height, width, lineStarts);
+
+			// The lines of a direction don't share a sample: each job writes its own texels
+			auto sweep = [&](uint32_t line)
+			{
+				std::vector<glm::vec2> hull;
+				hull.reserve(resolution);
+				std::vector<glm::ivec2> lineChangedSamples;
+				sweepLine(m_heightField, lineStarts[line].x, lineStarts[line].y, directionI, directionJ, stepLength, m_gridInfo.maxHeight, hull,
+					[&](int32_t sampleI, int32_t sampleJ, float tangent)
+					{
+						uint32_t& texel = texels[static_cast<size_t>(sampleI) * resolution + sampleJ];
+						const uint32_t channel = packChannel(tangent) << (8 * plane);
+						if ((texel & channelMask) == channel)
+							return;
+						texel = (texel & ~channelMask) | channel;
+						lineChangedSamples.emplace_back(sampleI, sampleJ);
+					});
+				if (lineChangedSamples.empty())
+					return;
+				std::lock_guard<std::mutex> lock(changedSamplesMutex);
+				changedSamples.insert(changedSamples.end(), lineChangedSamples.begin(), lineChangedSamples.end());
+			};
+
+			if (m_threadPool)
+				m_threadPool->parallelFor(static_cast<uint32_t>(lineStarts.size()), sweep);
+			else
+				for (uint32_t line = 0; line < lineStarts.size(); ++line)
+					sweep(line);
+		}
+		if (changedSamples.empty())
+			continue;
+
+		// One region per row from its first to its last changed texel: the horizons change along the lines, often far from the edit but on few texels
+		std::fill(rowSpans.begin(), rowSpans.end(), glm::uvec2(resolution, 0));
+		for (const glm::ivec2& sample : changedSamples)
+		{
+			glm::uvec2& rowSpan = rowSpans[sample.x];
+			rowSpan.x = std::min(rowSpan.x, static_cast<uint32_t>(sample.y));
+			rowSpan.y = std::max(rowSpan.y, static_cast<uint32_t>(sample.y) + 1);
+		}
+		regions.clear();
+		regionTexels.clear();
+		for (uint32_t row = 0; row < resolution; ++row)
+		{
+			if (rowSpans[row].x >= rowSpans[row].y)
+				continue;
+			regions.push_back({ { static_cast<int32_t>(rowSpans[row].x), static_cast<int32_t>(row) }, { rowSpans[row].y - rowSpans[row].x, 1 } });
+			const uint32_t* rowTexels = texels + static_cast<size_t>(row) * resolution;
+			regionTexels.insert(regionTexels.end(), rowTexels + rowSpans[row].x, rowTexels + rowSpans[row].y);
+		}
+		m_images[imageIndex]->copyFromPixels(regionTexels.data(), sizeof(uint32_t), regions, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+	}
+}
+
+void TerrainHorizonMap::swapTexels(std::array<std::vector<uint32_t>, TERRAIN_HORIZON_MAP_IMAGE_COUNT>& texels)
+{
+	const uint32_t resolution = m_heightField.getResolution();
+	for (uint32_t imageIndex = 0; imageIndex < TERRAIN_HORIZON_MAP_IMAGE_COUNT; ++imageIndex)
+	{
+		m_texels[imageIndex].swap(texels[imageIndex]);
+		m_images[imageIndex]->copyFromPixels(m_texels[imageIndex].data(), sizeof(uint32_t), { 0, 0 }, { resolution, resolution }, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+	}
+}
+
+void TerrainHorizonMap::computeTexels(const HeightField& heightField, const TerrainMeshBuilder::GridInfo& gridInfo, uint32_t firstDirection, uint32_t* outTexels,
+	ThreadPool* threadPool)
+{
+	static const int32_t directions[TERRAIN_HORIZON_MAP_DIRECTION_COUNT][2] = { { 1, 0 }, { 1, 1 }, { 0, 1 }, { -1, 1 }, { -1, 0 }, { -1, -1 }, { 0, -1 }, { 1, -1 } };
+	const uint32_t resolution = heightField.getResolution();
+	const size_t sampleCount = static_cast<size_t>(resolution) * resolution;
+
+	auto run = [threadPool](uint32_t count, const std::function<void(uint32_t)>& job)
+	{
+		if (threadPool)
+			threadPool->parallelFor(count, job);
+		else
+			for (uint32_t index = 0; index < count; ++index)
+				job(index);
+	};
+
+	std::vector<float> tangents(4 * sampleCount);
+	std::vector<glm::ivec2> lineStarts;
+	for (uint32_t plane = 0; plane < 4; ++plane)
+	{
+		const int32_t directionI = directions[firstDirection + plane][0];
+		const int32_t directionJ = directions[firstDirection + plane][1];
+		const float stepLength = glm::length(glm::vec2(directionI * gridInfo.tileSize.x, directionJ * gridInfo.tileSize.z));
+		getLineStarts(resolution, directionI, directionJ, 0, 0, resolution, resolution, lineStarts);
+
+		float* planeTangents = &tangents[plane * sampleCount];
+		run(static_cast<uint32_t>(lineStarts.size()), [&](uint32_t line)
+		{
+			std::vector<glm::vec2> hull;
+			hull.reserve(resolution);
+			sweepLine(heightField, lineStarts[line].x, lineStarts[line].y, directionI, directionJ, stepLength, gridInfo.maxHeight, hull,
+				[planeTangents, resolution](int32_t sampleI, int32_t sampleJ, float tangent) { planeTangents[static_cast<size_t>(sampleI) * resolution + sampleJ] = tangent; });
+		});
+	}
+
+	const float* planes[4] = { &tangents[0], &tangents[sampleCount], &tangents[2 * sampleCount], &tangents[3 * sampleCount] };
+	run((resolution + TERRAIN_HORIZON_MAP_BAND_SIZE - 1) / TERRAIN_HORIZON_MAP_BAND_SIZE, [&](uint32_t band)
+	{
+		const size_t firstSample = static_cast<size_t>(band) * TERRAIN_HORIZON_MAP_BAND_SIZE * resolution;
+		const size_t count = std::min(firstSample + static_cast<size_t>(TERRAIN_HORIZON_MAP_BAND_SIZE) * resolution, sampleCount) - firstSample;
+		const float* bandPlanes[4] = { planes[0] + firstSample, planes[1] + firstSample, planes[2] + firstSample, planes[3] + firstSample };
+		packTexels(bandPlanes, count, outTexels + firstSample);
+	});
+}
+
+void TerrainHorizonMap::getLineStarts(uint32_t resolution, int32_t directionI, int32_t directionJ, uint32_t i, uint32_t j, uint32_t height, uint32_t width,
+	std::vector<glm::ivec2>& outLineStarts)
+{
+	// A line entering the region goes through a sample of its border, which is followed in the direction up to the line start
+	const int32_t last = static_cast<int32_t>(resolution) - 1;
+	auto addLineOf = [&](int32_t sampleI, int32_t sampleJ)
+	{
+		const int32_t stepsI = directionI > 0 ? last - sampleI : directionI < 0 ? sampleI : last;
+		const int32_t stepsJ = directionJ > 0 ? last - sampleJ : directionJ < 0 ? sampleJ : last;
+		const int32_t steps = std::min(stepsI, stepsJ);
+		outLineStarts.emplace_back(sampleI + steps * directionI, sampleJ + steps * directionJ);
+	};
+
+	outLineStarts.clear();
+	const int32_t iStart = static_cast<int32_t>(i);
+	const int32_t jStart = static_cast<int32_t>(j);
+	const int32_t iEnd = static_cast<int32_t>(i + height) - 1;
+	const int32_t jEnd = static_cast<int32_t>(j + width) - 1;
+	for (int32_t sampleJ = jStart; sampleJ <= jEnd; ++sampleJ)
+	{
+		addLineOf(iStart, sampleJ);
+		addLineOf(iEnd, sampleJ);
+	}
+	for (int32_t sampleI = iStart; sampleI <= iEnd; ++sampleI)
+	{
+		addLineOf(sampleI, jStart);
+		addLineOf(sampleI, jEnd);
+	}
+
+	std::sort(outLineStarts.begin(), outLineStarts.end(), [](const glm::ivec2& a, const glm::ivec2& b) { return a.x != b.x ? a.x < b.x : a.y < b.y; });
+	outLineStarts.erase(std::unique(outLineStarts.begin(), outLineStarts.end()), outLineStarts.end());
+}
+
+template <typename Output>
+void TerrainHorizonMap::sweepLine(const HeightField& heightField, int32_t i, int32_t j, int32_t directionI, int32_t directionJ, float stepLength, float maxHeight,
+	std::vector<glm::vec2>& hull, Output output)
+{
+	// Hull points are (distance from the line start, height), the samples already swept are in the direction
+	const int32_t resolution = static_cast<int32_t>(heightField.getResolution());
+	hull.clear();
+	float distance = 0.0f;
+	for (; i >= 0 && i < resolution && j >= 0 && j < resolution; i -= directionI, j -= directionJ, distance += stepLength)
+	{
+		const float height = heightField.get(i, j) * maxHeight;
+		auto tangent = [&](const glm::vec2& point) { return (point.y - height) / (distance - point.x); };
+
+		// A hull point under the segment from the previous one to this sample is hidden for this sample and all the next ones
+		while (hull.size() >= 2 && tangent(hull[hull.size() - 2]) >= tangent(hull.back()))
+			hull.pop_back();
+
+		output(i, j, hull.empty() ? 0.0f : std::max(tangent(hull.back()), 0.0f));
+		hull.emplace_back(distance, height);
+	}
+}
+
+void TerrainHorizonMap::packTexels(const float* const* tangents, size_t count, uint32_t* outTexels)
+{
+	size_t index = 0;
+
+#if defined(TERRAIN_HORIZON_MAP_X86)
+	const __m128 one = _mm_set1_ps(1.0f);
+	for (; index + 4 <= count; index += 4)
+	{
+		// sin(atan(t)) = sqrt(t^2 / (1 + t^2)), [0, 1] to [0, 255] rounded
+		__m128i texels = _mm_setzero_si128();
+		for (uint32_t plane = 0; plane < 4; ++plane)
+		{
+			const __m128 tangent = _mm_loadu_ps(tangents[plane] + index);
+			const __m128 squaredTangent = _mm_mul_ps(tangent, tangent);
+			const __m128 sine = _mm_sqrt_ps(_mm_div_ps(squaredTangent, _mm_add_ps(one, squaredTangent)));
+			const __m128i channel = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(sine, _mm_set1_ps(255.0f)), _mm_set1_ps(0.5f)));
+			texels = _mm_or_si128(texels, _mm_sll_epi32(channel, _mm_cvtsi32_si128(8 * plane)));
+		}
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(outTexels + index), texels);
+	}
+#endif
+
+	for (; index < count; ++index)
+		outTexels[index] = packTexel(tangents, index);
+}
+
+uint32_t TerrainHorizonMap::packTexel(const float* const* tangents, size_t index)
+{
+	uint32_t texel = 0;
+	for (uint32_t plane = 0; plane < 4; ++plane)
+		texel |= packChannel(tangents[plane][index]) << (8 * plane);
+	return texel;
+}
+
+uint32_t TerrainHorizonMap::packChannel(float tangent)
+{
+	const float squaredTangent = tangent * tangent;
+	const float sine = std::sqrt(squaredTangent / (1.0f + squaredTangent));
+	return static_cast<uint32_t>(sine * 255.0f + 0.5f);
+}
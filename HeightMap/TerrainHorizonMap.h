@@ -0,0 +1,59 @@
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include <WolfEngine.h>
+
+#include "HeightField.h"
+#include "TerrainMeshBuilder.h"
+#include "ThreadPool.h"
+
+#define TERRAIN_HORIZON_MAP_DIRECTION_COUNT 8 // must match Shaders/scene/shader.frag
+#define TERRAIN_HORIZON_MAP_IMAGE_COUNT (TERRAIN_HORIZON_MAP_DIRECTION_COUNT / 4)
+#define TERRAIN_HORIZON_MAP_BAND_SIZE 32 // rows packed by a job
+
+// Horizon of every sample in 8 directions, direction k being k * 45 degrees from +i (x) towards +j (z), for the sun shadow and the ambient occlusion
+// of the terrain shader. Stored as the sine of the horizon elevation angle in R8G8B8A8_UNORM images, directions 4 * n to 4 * n + 3 in image n,
+// texel (x = j, y = i) is the sample (i, j).
+// A direction is swept along the rows, columns or diagonals of the heightfield keeping the upper convex hull of the samples already swept, the
+// horizon of a sample is its neighbour on the hull: the horizons are exact whatever their distance, in amortized constant time per sample
+class TerrainHorizonMap
+{
+public:
+	TerrainHorizonMap(Wolf::WolfInstance* wolfInstance, const HeightField& heightField, const TerrainMeshBuilder::GridInfo& gridInfo, ThreadPool* threadPool);
+
+	// The samples [i, i + height[ x [j, j + width[ were modified: a height can be the horizon of any sample behind it on its lines, the lines crossing
+	// the region are swept again and the span of the texels whose value changed is uploaded in each row
+	void updateRegion(uint32_t i, uint32_t j, uint32_t height, uint32_t width);
+	// All the samples were replaced: uploads the texels of each image given by computeTexels, e.g. on another thread, and keeps them. texels gets the
+	// previous ones
+	void swapTexels(std::array<std::vector<uint32_t>, TERRAIN_HORIZON_MAP_IMAGE_COUNT>& texels);
+
+	Wolf::Image* getImage(uint32_t index) const { return m_images[index]; }
+
+	// Packed texels of the directions firstDirection to firstDirection + 3, outTexels[i * resolution + j]. A null thread pool computes on the calling thread
+	static void computeTexels(const HeightField& heightField, const TerrainMeshBuilder::GridInfo& gridInfo, uint32_t firstDirection, uint32_t* outTexels,
+		ThreadPool* threadPool);
+
+private:
+	// First samples of the lines of a direction crossing the samples [i, i + height[ x [j, j + width[, a line starts at the sample whose next one in the
+	// direction is out of the heightfield
+	static void getLineStarts(uint32_t resolution, int32_t directionI, int32_t directionJ, uint32_t i, uint32_t j, uint32_t height, uint32_t width,
+		std::vector<glm::ivec2>& outLineStarts);
+	// Tangent of the horizon elevation (0 when below the horizontal) of the samples of the line starting at (i, j) and going backwards along the direction,
+	// given to output(i, j, tangent)
+	template <typename Output>
+	static void sweepLine(const HeightField& heightField, int32_t i, int32_t j, int32_t directionI, int32_t directionJ, float stepLength, float maxHeight,
+		std::vector<glm::vec2>& hull, Output output);
+	static void packTexels(const float* const* tangents, size_t count, uint32_t* outTexels);
+	static uint32_t packTexel(const float* const* tangents, size_t index);
+	static uint32_t packChannel(float tangent);
+
+private:
+	const HeightField& m_heightField;
+	TerrainMeshBuilder::GridInfo m_gridInfo;
+	ThreadPool* m_threadPool;
+	std::array<Wolf::Image*, TERRAIN_HORIZON_MAP_IMAGE_COUNT> m_images;
+	std::array<std::vector<uint32_t>, TERRAIN_HORIZON_MAP_IMAGE_COUNT> m_texels; // as uploaded, compared with the ones of an update
+};
@@ -0,0 +1,29 @@
+#include "TerrainMeshBuilder.h"
+
+void TerrainMeshBuilder::buildGridIndices(uint32_t resolution, std::vector<uint32_t>& outIndices)
+{
+	const uint32_t cellCountPerSide = resolution - 1;
+	outIndices.resize(static_cast<size_t>(cellCountPerSide) * cellCountPerSide * 6);
+	for (uint32_t i = 0; i < cellCountPerSide; ++i)
+		writeRowIndices(i, resolution, &outIndices[static_cast<size_t>(i) * cellCountPerSide * 6]);
+}
+
+void TerrainMeshBuilder::writeRowIndices(uint32_t row, uint32_t resolution, uint32_t* indices)
+{
+	for (uint32_t j = 0; j < resolution - 1; ++j)
+	{
+		const uint32_t topLeft = row * resolution + j;
+		const uint32_t topRight = topLeft + resolution; // (i + 1, j)
+		const uint32_t bottomLeft = topLeft + 1; // (i, j + 1)
+		const uint32_t bottomRight = topRight + 1; // (i + 1, j + 1)
+
+		// Same triangles and winding as the previous 4 vertices per cell layout
+		*indices++ = topLeft;
+		*indices++ = topRight;
+		*indices++ = bottomLeft;
+
+		*indices++ = topRight;
+		*indices++ = bottomRight;
+		*indices++ = bottomLeft;
+	}
+}
\ No newline at end of file
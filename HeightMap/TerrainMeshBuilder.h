@@ -0,0 +1,27 @@
+#pragma once
+
+#include <vector>
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/glm.hpp>
+
+// Placement of the height samples in the world, and the indices of a grid with one vertex per sample shared by the (up to) 6 triangles around it
+class TerrainMeshBuilder
+{
+public:
+	struct GridInfo
+	{
+		// The sample (i, j) is placed at topLeftPos + (i * tileSize.x, height * maxHeight, j * tileSize.z)
+		glm::vec3 topLeftPos = glm::vec3(0.0f);
+		glm::vec3 tileSize = glm::vec3(1.0f, 0.0f, 1.0f);
+		float maxHeight = 1.0f;
+	};
+
+	// Indices of a resolution * resolution grid, vertex i * resolution + j, for patches whose vertices are built elsewhere
+	static void buildGridIndices(uint32_t resolution, std::vector<uint32_t>& outIndices);
+
+private:
+	static void writeRowIndices(uint32_t row, uint32_t resolution, uint32_t* indices);
+};
@@ -0,0 +1,136 @@
+#include "TerrainNormalMap.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define TERRAIN_NORMAL_MAP_X86
+#include <emmintrin.h>
+#endif
+
+TerrainNormalMap::TerrainNormalMap(Wolf::WolfInstance* wolfInstance, const HeightField& heightField, const TerrainMeshBuilder::GridInfo& gridInfo,
+	ThreadPool* threadPool) : m_heightField(heightField), m_gridInfo(gridInfo), m_threadPool(threadPool)
+{
+	const uint32_t resolution = m_heightField.getResolution();
+	m_image = wolfInstance->createImage({ resolution, resolution, 1 }, VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT, VK_FORMAT_R8G8B8A8_UNORM,
+		VK_SAMPLE_COUNT_1_BIT, VK_IMAGE_ASPECT_COLOR_BIT);
+
+	updateRegion(0, 0, resolution, resolution);
+}
+
+void TerrainNormalMap::updateRegion(uint32_t i, uint32_t j, uint32_t height, uint32_t width)
+{
+	// A sample is a neighbour of the texels around it
+	const uint32_t resolution = m_heightField.getResolution();
+	const uint32_t iStart = i > 0 ? i - 1 : 0;
+	const uint32_t jStart = j > 0 ? j - 1 : 0;
+	const uint32_t iEnd = std::min(i + height + 1, resolution);
+	const uint32_t jEnd = std::min(j + width + 1, resolution);
+
+	std::vector<uint32_t> texels(static_cast<size_t>(iEnd - iStart) * (jEnd - jStart));
+	computeRegion(m_heightField, m_gridInfo, iStart, jStart, iEnd - iStart, jEnd - jStart, texels.data(), jEnd - jStart, m_threadPool);
+	uploadRegion(iStart, jStart, iEnd - iStart, jEnd - jStart, texels.data());
+}
+
+void TerrainNormalMap::uploadRegion(uint32_t i, uint32_t j, uint32_t height, uint32_t width, const uint32_t* texels)
+{
+	m_image->copyFromPixels(texels, sizeof(uint32_t), { static_cast<int32_t>(j), static_cast<int32_t>(i) }, { width, height }, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+}
+
+void TerrainNormalMap::computeRegion(const HeightField& heightField, const TerrainMeshBuilder::GridInfo& gridInfo, uint32_t i, uint32_t j, uint32_t height,
+	uint32_t width, uint32_t* outTexels, size_t rowPitch, ThreadPool* threadPool)
+{
+	const uint32_t resolution = heightField.getResolution();
+	// Central differences of the heights, i goes along x and j along z
+	const float xScale = gridInfo.maxHeight / (2.0f * gridInfo.tileSize.x);
+	const float zScale = gridInfo.maxHeight / (2.0f * gridInfo.tileSize.z);
+
+	// Columns [j - 1, j + width] of a row, clamped to the border
+	auto loadRow = [&](int64_t rowIndex, float* row)
+	{
+		const uint32_t clampedRow = static_cast<uint32_t>(std::min<int64_t>(std::max<int64_t>(rowIndex, 0), resolution - 1));
+		const uint32_t firstColumn = j > 0 ? j - 1 : 0;
+		const uint32_t endColumn = std::min(j + width + 1, resolution);
+		heightField.copyRow(clampedRow, firstColumn, endColumn - firstColumn, row + (firstColumn + 1 - j));
+		if (j == 0)
+			row[0] = row[1];
+		if (j + width == resolution)
+			row[width + 1] = row[width];
+	};
+
+	const uint32_t bandCount = (height + TERRAIN_NORMAL_MAP_BAND_SIZE - 1) / TERRAIN_NORMAL_MAP_BAND_SIZE;
+	auto computeBand = [&](uint32_t band)
+	{
+		const uint32_t firstRow = band * TERRAIN_NORMAL_MAP_BAND_SIZE;
+		const uint32_t endRow = std::min(firstRow + TERRAIN_NORMAL_MAP_BAND_SIZE, height);
+
+		// Rolling window of 3 rows
+		const size_t rowSize = static_cast<size_t>(width) + 2;
+		std::vector<float> rows(3 * rowSize);
+		float* up = &rows[0];
+		float* center = &rows[rowSize];
+		float* down = &rows[2 * rowSize];
+		loadRow(static_cast<int64_t>(i) + firstRow - 1, up);
+		loadRow(static_cast<int64_t>(i) + firstRow, center);
+		for (uint32_t row = firstRow; row < endRow; ++row)
+		{
+			loadRow(static_cast<int64_t>(i) + row + 1, down);
+			packRow(up, center, down, width, xScale, zScale, outTexels + row * rowPitch);
+
+			float* previousUp = up;
+			up = center;
+			center = down;
+			down = previousUp;
+		}
+	};
+
+	if (threadPool)
+		threadPool->parallelFor(bandCount, computeBand);
+	else
+		for (uint32_t band = 0; band < bandCount; ++band)
+			computeBand(band);
+}
+
+void TerrainNormalMap::packRow(const float* up, const float* center, const float* down, uint32_t width, float xScale, float zScale, uint32_t* outTexels)
+{
+	uint32_t column = 0;
+
+#if defined(TERRAIN_NORMAL_MAP_X86)
+	const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+	const __m128 one = _mm_set1_ps(1.0f);
+	for (; column + 4 <= width; column += 4)
+	{
+		const __m128 xSlope = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(down + column + 1), _mm_loadu_ps(up + column + 1)), _mm_set1_ps(xScale));
+		const __m128 zSlope = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(center + column + 2), _mm_loadu_ps(center + column)), _mm_set1_ps(zScale));
+
+		// Normal (-xSlope, 1, -zSlope): its octahedral coordinates do not need it normalized
+		const __m128 inverseL1Norm = _mm_div_ps(one, _mm_add_ps(_mm_add_ps(_mm_and_ps(xSlope, absMask), one), _mm_and_ps(zSlope, absMask)));
+		const __m128 octahedralX = _mm_mul_ps(_mm_sub_ps(_mm_setzero_ps(), xSlope), inverseL1Norm);
+		const __m128 octahedralZ = _mm_mul_ps(_mm_sub_ps(_mm_setzero_ps(), zSlope), inverseL1Norm);
+		const __m128 squaredGradient = _mm_add_ps(_mm_mul_ps(xSlope, xSlope), _mm_mul_ps(zSlope, zSlope));
+		const __m128 slopeSine = _mm_sqrt_ps(_mm_div_ps(squaredGradient, _mm_add_ps(one, squaredGradient)));
+
+		// [-1, 1] to [0, 255] and [0, 1] to [0, 255], rounded
+		const __m128i red = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(octahedralX, _mm_set1_ps(127.5f)), _mm_set1_ps(128.0f)));
+		const __m128i green = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(octahedralZ, _mm_set1_ps(127.5f)), _mm_set1_ps(128.0f)));
+		const __m128i blue = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(slopeSine, _mm_set1_ps(255.0f)), _mm_set1_ps(0.5f)));
+		const __m128i texels = _mm_or_si128(_mm_or_si128(red, _mm_slli_epi32(green, 8)), _mm_or_si128(_mm_slli_epi32(blue, 16), _mm_set1_epi32(0xff000000)));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(outTexels + column), texels);
+	}
+#endif
+
+	for (; column < width; ++column)
+		outTexels[column] = packTexel((down[column + 1] - up[column + 1]) * xScale, (center[column + 2] - center[column]) * zScale);
+}
+
+uint32_t TerrainNormalMap::packTexel(float xSlope, float zSlope)
+{
+	const float inverseL1Norm = 1.0f / (std::abs(xSlope) + 1.0f + std::abs(zSlope));
+	const float squaredGradient = xSlope * xSlope + zSlope * zSlope;
+	const float slopeSine = std::sqrt(squaredGradient / (1.0f + squaredGradient));
+
+	const uint32_t red = static_cast<uint32_t>(-xSlope * inverseL1Norm * 127.5f + 128.0f);
+	const uint32_t green = static_cast<uint32_t>(-zSlope * inverseL1Norm * 127.5f + 128.0f);
+	const uint32_t blue = static_cast<uint32_t>(slopeSine * 255.0f + 0.5f);
+	return red | (green << 8) | (blue << 16) | 0xff000000u;
+}
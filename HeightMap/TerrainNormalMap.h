@@ -0,0 +1,41 @@
+#pragma once
+
+#include <WolfEngine.h>
+
+#include "HeightField.h"
+#include "TerrainMeshBuilder.h"
+#include "ThreadPool.h"
+
+#define TERRAIN_NORMAL_MAP_BAND_SIZE 32 // rows computed by a job, each row of heights is read once per band
+
+// Shading data of the terrain as a R8G8B8A8_UNORM image, texel (x = j, y = i) is the sample (i, j): xy is the octahedral encoding of the normal,
+// z the sine of the slope angle. Both come from the same central differences, computed in a single sweep over the heights.
+// A heightfield normal always points up, so the encoding is (n.x, n.z) / (|n.x| + n.y + |n.z|) without the fold of the lower half
+class TerrainNormalMap
+{
+public:
+	TerrainNormalMap(Wolf::WolfInstance* wolfInstance, const HeightField& heightField, const TerrainMeshBuilder::GridInfo& gridInfo, ThreadPool* threadPool);
+
+	// The samples [i, i + height[ x [j, j + width[ were modified: uploads their texels and the ones around them again
+	void updateRegion(uint32_t i, uint32_t j, uint32_t height, uint32_t width);
+
+	// Uploads the texels of the samples [i, i + height[ x [j, j + width[ given by computeRegion, e.g. on another thread
+	void uploadRegion(uint32_t i, uint32_t j, uint32_t height, uint32_t width, const uint32_t* texels);
+
+	Wolf::Image* getImage() const { return m_image; }
+
+	// Packed texels of the samples [i, i + height[ x [j, j + width[, outTexels[row * rowPitch + column]. A null thread pool computes on the calling thread
+	static void computeRegion(const HeightField& heightField, const TerrainMeshBuilder::GridInfo& gridInfo, uint32_t i, uint32_t j, uint32_t height, uint32_t width,
+		uint32_t* outTexels, size_t rowPitch, ThreadPool* threadPool);
+
+private:
+	// Neighbours of column c of the row are up[c + 1], down[c + 1], center[c] and center[c + 2]
+	static void packRow(const float* up, const float* center, const float* down, uint32_t width, float xScale, float zScale, uint32_t* outTexels);
+	static uint32_t packTexel(float xSlope, float zSlope);
+
+private:
+	const HeightField& m_heightField;
+	TerrainMeshBuilder::GridInfo m_gridInfo;
+	ThreadPool* m_threadPool;
+	Wolf::Image* m_image;
+};
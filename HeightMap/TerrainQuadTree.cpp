@@ -0,0 +1,339 @@
+#include "TerrainQuadTree.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+TerrainQuadTree::TerrainQuadTree(const HeightField& heightField, uint32_t chunkSize, const TerrainMeshBuilder::GridInfo& gridInfo, ThreadPool* threadPool, bool buildVertices,
+	const HeightSummary* heightSummary)
+	: m_heightField(heightField), m_resolution(heightField.getResolution()), m_chunkSize(chunkSize), m_gridInfo(gridInfo)
+{
+	m_leafCountPerSide = m_resolution / m_chunkSize;
+	while ((1u << m_levelCount) <= m_leafCountPerSide)
+		++m_levelCount;
+
+	buildNodes();
+
+	// The error of a node only depends on the heights, so the whole tree is built in parallel and the per level maximum is taken afterwards
+	std::vector<float> nodeErrors(m_nodes.size());
+	if (buildVertices)
+		m_vertices.resize(m_nodes.size() * getVertexCountPerNode());
+	auto buildNodeByIndex = [&](uint32_t nodeIndex)
+	{
+		buildNode(nodeIndex, buildVertices, heightSummary, nodeErrors[nodeIndex]);
+	};
+
+	if (threadPool)
+		threadPool->parallelFor(static_cast<uint32_t>(m_nodes.size()), buildNodeByIndex);
+	else
+		for (uint32_t nodeIndex = 0; nodeIndex < m_nodes.size(); ++nodeIndex)
+			buildNodeByIndex(nodeIndex);
+
+	m_levelErrors.assign(m_levelCount, 0.0f);
+	if (heightSummary)
+		for (uint32_t level = 0; level < m_levelCount; ++level)
+			m_levelErrors[level] = heightSummary->levelErrors[level] * m_gridInfo.maxHeight;
+	else
+		for (size_t nodeIndex = 0; nodeIndex < m_nodes.size(); ++nodeIndex)
+			m_levelErrors[m_nodes[nodeIndex].level] = std::max(m_levelErrors[m_nodes[nodeIndex].level], nodeErrors[nodeIndex]);
+
+	TerrainMeshBuilder::buildGridIndices(m_chunkSize + 1, m_patchIndices);
+	m_ranges.resize(m_levelCount);
+}
+
+void TerrainQuadTree::swapHeightData(TerrainQuadTree& other)
+{
+	m_nodes.swap(other.m_nodes);
+	m_levelErrors.swap(other.m_levelErrors);
+	m_vertices.swap(other.m_vertices);
+}
+
+TerrainQuadTree::HeightSummary TerrainQuadTree::getHeightSummary() const
+{
+	HeightSummary heightSummary;
+	heightSummary.nodeHeights.resize(m_nodes.size());
+	for (size_t nodeIndex = 0; nodeIndex < m_nodes.size(); ++nodeIndex)
+		heightSummary.nodeHeights[nodeIndex] = glm::vec2(m_nodes[nodeIndex].boundsMin.y, m_nodes[nodeIndex].boundsMax.y) / m_gridInfo.maxHeight;
+	heightSummary.levelErrors.resize(m_levelCount);
+	for (uint32_t level = 0; level < m_levelCount; ++level)
+		heightSummary.levelErrors[level] = m_levelErrors[level] / m_gridInfo.maxHeight;
+
+	return heightSummary;
+}
+
+void TerrainQuadTree::updateRanges(float distanceScale, float maxPixelError)
+{
+	const float cellSize = std::max(m_gridInfo.tileSize.x, m_gridInfo.tileSize.z);
+
+	float previousEnd = 0.0f;
+	for (uint32_t level = 0; level < m_levelCount; ++level)
+	{
+		LODRange& range = m_ranges[level];
+		if (level == m_levelCount - 1)
+		{
+			range.morphStart = range.end = std::numeric_limits<float>::max();
+			break;
+		}
+
+		// Level + 1 replaces this level where its error is projected under maxPixelError
+		range.end = m_levelErrors[level + 1] * distanceScale / maxPixelError;
+		// A node of this level is only split while its bounds are within the previous range, its vertices can then be up to a node diagonal
+		// further: the morph of this level must not start before, so that its border still matches the fully morphed finer neighbours
+		const float nodeSize = static_cast<float>(m_chunkSize << level) * cellSize;
+		const float nodeDiagonal = glm::length(glm::vec3(nodeSize, m_gridInfo.maxHeight, nodeSize));
+		range.end = std::max(range.end, previousEnd + nodeDiagonal / TERRAIN_MORPH_START);
+		range.morphStart = previousEnd + (range.end - previousEnd) * TERRAIN_MORPH_START;
+
+		previousEnd = range.end;
+	}
+}
+
+void TerrainQuadTree::select(const glm::vec3& cameraPosition, const glm::mat4& viewProjection, std::vector<SelectedNode>& outSelectedNodes) const
+{
+	// Planes from the rows of the matrix (Gribb/Hartmann) for a [0, 1] depth range, inside when dot(plane.xyz, p) + plane.w >= 0
+	std::array<glm::vec4, 6> frustumPlanes;
+	const glm::mat4 transposed = glm::transpose(viewProjection);
+	frustumPlanes[0] = transposed[3] + transposed[0];
+	frustumPlanes[1] = transposed[3] - transposed[0];
+	frustumPlanes[2] = transposed[3] + transposed[1];
+	frustumPlanes[3] = transposed[3] - transposed[1];
+	frustumPlanes[4] = transposed[2];
+	frustumPlanes[5] = transposed[3] - transposed[2];
+
+	outSelectedNodes.clear();
+	selectNode(0, cameraPosition, frustumPlanes, outSelectedNodes);
+}
+
+void TerrainQuadTree::updateRegion(uint32_t i, uint32_t j, uint32_t height, uint32_t width, std::vector<uint32_t>& outUpdatedNodes)
+{
+	outUpdatedNodes.clear();
+
+	// Children always come after their parent: in reverse order, the bounds of the children of a node are up to date when it is reached
+	for (uint32_t nodeIndex = static_cast<uint32_t>(m_nodes.size()); nodeIndex-- > 0;)
+	{
+		Node& node = m_nodes[nodeIndex];
+		const uint32_t nodeSize = m_chunkSize << node.level;
+		if (node.i > i + height - 1 || node.i + nodeSize < i || node.j > j + width - 1 || node.j + nodeSize < j)
+			continue;
+
+		// The level errors are kept: the LOD ranges stay the ones of the initial heights
+		float minHeight = std::numeric_limits<float>::max();
+		float maxHeight = std::numeric_limits<float>::lowest();
+		if (node.level == 0)
+		{
+			const uint32_t iEnd = std::min(node.i + m_chunkSize, m_resolution - 1);
+			const uint32_t jEnd = std::min(node.j + m_chunkSize, m_resolution - 1);
+			for (uint32_t sampleI = node.i; sampleI <= iEnd; ++sampleI)
+			{
+				for (uint32_t sampleJ = node.j; sampleJ <= jEnd; ++sampleJ)
+				{
+					const float sample = sampleHeight(sampleI, sampleJ);
+					minHeight = std::min(minHeight, sample);
+					maxHeight = std::max(maxHeight, sample);
+				}
+			}
+		}
+		else
+		{
+			// The samples of a node are the union of the ones of its children
+			for (uint32_t child = 0; child < 4; ++child)
+			{
+				minHeight = std::min(minHeight, m_nodes[node.firstChild + child].boundsMin.y);
+				maxHeight = std::max(maxHeight, m_nodes[node.firstChild + child].boundsMax.y);
+			}
+		}
+		node.boundsMin.y = minHeight;
+		node.boundsMax.y = maxHeight;
+
+		if (!m_vertices.empty())
+			buildNodeVertices(nodeIndex);
+		outUpdatedNodes.push_back(nodeIndex);
+	}
+
+	std::reverse(outUpdatedNodes.begin(), outUpdatedNodes.end());
+}
+
+TerrainQuadTree::NodeGrid TerrainQuadTree::getNodeGrid(uint32_t nodeIndex) const
+{
+	const Node& node = m_nodes[nodeIndex];
+	return { node.i, node.j, 1u << node.level, node.level };
+}
+
+glm::vec2 TerrainQuadTree::getNodeHeightRange(uint32_t nodeIndex) const
+{
+	const Node& node = m_nodes[nodeIndex];
+	return glm::vec2(node.boundsMin.y, node.boundsMax.y - node.boundsMin.y);
+}
+
+glm::vec2 TerrainQuadTree::getMorphRange(uint32_t level) const
+{
+	const LODRange& range = m_ranges[level];
+	if (range.end == range.morphStart) // coarsest level, never morphs
+		return glm::vec2(range.morphStart, 1.0f);
+
+	return glm::vec2(range.morphStart, 1.0f / (range.end - range.morphStart));
+}
+
+void TerrainQuadTree::buildNodes()
+{
+	Node root;
+	root.i = 0;
+	root.j = 0;
+	root.level = m_levelCount - 1;
+	m_nodes.push_back(root);
+
+	// Breadth first, so the 4 children of a node are consecutive
+	for (uint32_t nodeIndex = 0; nodeIndex < m_nodes.size(); ++nodeIndex)
+	{
+		if (m_nodes[nodeIndex].level == 0)
+			continue;
+
+		const Node parent = m_nodes[nodeIndex];
+		const uint32_t halfSize = m_chunkSize << (parent.level - 1);
+		m_nodes[nodeIndex].firstChild = static_cast<uint32_t>(m_nodes.size());
+		for (uint32_t child = 0; child < 4; ++child)
+		{
+			Node node;
+			node.i = parent.i + (child & 1) * halfSize;
+			node.j = parent.j + (child >> 1) * halfSize;
+			node.level = parent.level - 1;
+			m_nodes.push_back(node);
+		}
+	}
+}
+
+void TerrainQuadTree::buildNode(uint32_t nodeIndex, bool buildVertices, const HeightSummary* heightSummary, float& outLevelError)
+{
+	Node& node = m_nodes[nodeIndex];
+	const uint32_t stride = 1u << node.level;
+
+	// Bounds contain every finer level so that a culled node culls its whole subtree
+	const uint32_t iEnd = std::min(node.i + m_chunkSize * stride, m_resolution - 1);
+	const uint32_t jEnd = std::min(node.j + m_chunkSize * stride, m_resolution - 1);
+	float minHeight = std::numeric_limits<float>::max();
+	float maxHeight = std::numeric_limits<float>::lowest();
+	float levelError = 0.0f;
+	if (heightSummary)
+	{
+		// The scale is monotonic: the same bounds as the samples scaled one by one
+		minHeight = heightSummary->nodeHeights[nodeIndex].x * m_gridInfo.maxHeight;
+		maxHeight = heightSummary->nodeHeights[nodeIndex].y * m_gridInfo.maxHeight;
+	}
+	else
+	{
+		for (uint32_t i = node.i; i <= iEnd; ++i)
+		{
+			for (uint32_t j = node.j; j <= jEnd; ++j)
+			{
+				const float height = sampleHeight(i, j);
+				minHeight = std::min(minHeight, height);
+				maxHeight = std::max(maxHeight, height);
+				if (stride > 1)
+					levelError = std::max(levelError, std::abs(height - interpolateLevelHeight(i, j, stride)));
+			}
+		}
+	}
+
+	node.boundsMin = glm::vec3(m_gridInfo.topLeftPos.x + node.i * m_gridInfo.tileSize.x, minHeight, m_gridInfo.topLeftPos.z + node.j * m_gridInfo.tileSize.z);
+	node.boundsMax = glm::vec3(m_gridInfo.topLeftPos.x + iEnd * m_gridInfo.tileSize.x, maxHeight, m_gridInfo.topLeftPos.z + jEnd * m_gridInfo.tileSize.z);
+	outLevelError = levelError;
+
+	if (buildVertices)
+		buildNodeVertices(nodeIndex);
+}
+
+void TerrainQuadTree::buildNodeVertices(uint32_t nodeIndex)
+{
+	const Node& node = m_nodes[nodeIndex];
+	const uint32_t stride = 1u << node.level;
+	const uint32_t vertexCountPerSide = m_chunkSize + 1;
+	const bool isRoot = node.level == m_levelCount - 1;
+
+	// Every vertex height, morph heights included, is within the bounds
+	const float minHeight = node.boundsMin.y;
+	const float heightRange = node.boundsMax.y - node.boundsMin.y;
+	auto quantizeHeight = [&](float height)
+	{
+		return heightRange > 0.0f ? static_cast<uint16_t>(std::lround((height - minHeight) / heightRange * 65535.0f)) : static_cast<uint16_t>(0);
+	};
+
+	Vertex* vertices = &m_vertices[static_cast<size_t>(nodeIndex) * getVertexCountPerNode()];
+	for (uint32_t a = 0; a < vertexCountPerSide; ++a)
+	{
+		for (uint32_t b = 0; b < vertexCountPerSide; ++b)
+		{
+			const int64_t i = node.i + a * stride;
+			const int64_t j = node.j + b * stride;
+			const int64_t s = stride;
+
+			const float height = sampleHeight(i, j);
+			float morphHeight;
+			// Height of the parent level surface at this vertex: the vertices with an odd coordinate lie on an edge or on the diagonal
+			// (i + 1, j - 1) -> (i - 1, j + 1) of a parent cell, the triangulation of TerrainMeshBuilder
+			if (isRoot || (a % 2 == 0 && b % 2 == 0))
+				morphHeight = height;
+			else if (b % 2 == 0)
+				morphHeight = (sampleHeight(i - s, j) + sampleHeight(i + s, j)) * 0.5f;
+			else if (a % 2 == 0)
+				morphHeight = (sampleHeight(i, j - s) + sampleHeight(i, j + s)) * 0.5f;
+			else
+				morphHeight = (sampleHeight(i + s, j - s) + sampleHeight(i - s, j + s)) * 0.5f;
+
+			Vertex& vertex = vertices[a * vertexCountPerSide + b];
+			vertex.height = quantizeHeight(height);
+			vertex.morphHeight = quantizeHeight(morphHeight);
+		}
+	}
+}
+
+float TerrainQuadTree::sampleHeight(int64_t i, int64_t j) const
+{
+	i = std::min<int64_t>(std::max<int64_t>(i, 0), m_resolution - 1);
+	j = std::min<int64_t>(std::max<int64_t>(j, 0), m_resolution - 1);
+
+	return m_heightField.get(static_cast<uint32_t>(i), static_cast<uint32_t>(j)) * m_gridInfo.maxHeight;
+}
+
+float TerrainQuadTree::interpolateLevelHeight(uint32_t i, uint32_t j, uint32_t stride) const
+{
+	const uint32_t cellI = i / stride * stride;
+	const uint32_t cellJ = j / stride * stride;
+	const float u = static_cast<float>(i - cellI) / static_cast<float>(stride);
+	const float v = static_cast<float>(j - cellJ) / static_cast<float>(stride);
+
+	const float topRight = sampleHeight(cellI + stride, cellJ);
+	const float bottomLeft = sampleHeight(cellI, cellJ + stride);
+	if (u + v <= 1.0f)
+	{
+		const float topLeft = sampleHeight(cellI, cellJ);
+		return topLeft + u * (topRight - topLeft) + v * (bottomLeft - topLeft);
+	}
+
+	const float bottomRight = sampleHeight(cellI + stride, cellJ + stride);
+	return bottomRight + (1.0f - u) * (bottomLeft - bottomRight) + (1.0f - v) * (topRight - bottomRight);
+}
+
+void TerrainQuadTree::selectNode(uint32_t nodeIndex, const glm::vec3& cameraPosition, const std::array<glm::vec4, 6>& frustumPlanes,
+	std::vector<SelectedNode>& outSelectedNodes) const
+{
+	const Node& node = m_nodes[nodeIndex];
+
+	for (const glm::vec4& plane : frustumPlanes)
+	{
+		const glm::vec3 farthestCorner(plane.x >= 0.0f ? node.boundsMax.x : node.boundsMin.x, plane.y >= 0.0f ? node.boundsMax.y : node.boundsMin.y,
+			plane.z >= 0.0f ? node.boundsMax.z : node.boundsMin.z);
+		if (glm::dot(glm::vec3(plane), farthestCorner) + plane.w < 0.0f)
+			return;
+	}
+
+	// Children are only needed where the finer level is in range, a child selected outside of its range is fully morphed and looks like this node
+	const float distance = glm::distance(cameraPosition, glm::clamp(cameraPosition, node.boundsMin, node.boundsMax));
+	if (node.level == 0 || distance > m_ranges[node.level - 1].end)
+	{
+		outSelectedNodes.push_back({ nodeIndex, node.level });
+		return;
+	}
+
+	for (uint32_t child = 0; child < 4; ++child)
+		selectNode(node.firstChild + child, cameraPosition, frustumPlanes, outSelectedNodes);
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <array>
+#include <vector>
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/glm.hpp>
+
+#include "HeightField.h"
+#include "TerrainMeshBuilder.h"
+#include "ThreadPool.h"
+
+#define TERRAIN_MAX_LOD_COUNT 16 // must match the morphRanges array of Shaders/scene/shader.vert
+#define TERRAIN_MORPH_START 0.7f // part of a LOD range rendered without morphing
+
+// CDLOD terrain: a quadtree of chunks where every node is a chunkSize * chunkSize cells patch, its level (0 = leaves) being the sample stride (2^level)
+// Each vertex also stores the height of the next coarser level at its position, the vertex shader morphs towards it at the end of the LOD range
+// so that neighbouring chunks of different levels meet without cracks
+class TerrainQuadTree
+{
+public:
+	// x and z follow from the vertex index inside its node and the node grid, heights are quantized over the height range of the node
+	struct Vertex
+	{
+		uint16_t height;
+		uint16_t morphHeight;
+	};
+
+	struct SelectedNode
+	{
+		uint32_t nodeIndex;
+		uint32_t level;
+	};
+
+	struct NodeGrid
+	{
+		uint32_t i; // first sample
+		uint32_t j;
+		uint32_t stride;
+		uint32_t level;
+	};
+
+	// What the tree reads every sample for, with a maxHeight of 1 so that it only depends on the heights and the chunk size (e.g. baked with them)
+	struct HeightSummary
+	{
+		std::vector<glm::vec2> nodeHeights; // x: lowest, y: highest height of each node
+		std::vector<float> levelErrors;
+	};
+
+	// The resolution of the heightfield divided by chunkSize must be a power of 2, the heightfield must outlive the tree
+	// Without buildVertices, only the patch indices are built: the heights are then read by the vertex shader
+	// With the summary of these heights, the bounds and the level errors are taken from it instead of reading every sample
+	TerrainQuadTree(const HeightField& heightField, uint32_t chunkSize, const TerrainMeshBuilder::GridInfo& gridInfo, ThreadPool* threadPool, bool buildVertices = true,
+		const HeightSummary* heightSummary = nullptr);
+
+	// distanceScale converts a world space error at distance 1 to pixels: viewportHeight / (2 * tan(fovY / 2))
+	void updateRanges(float distanceScale, float maxPixelError);
+	// The samples [i, i + height[ x [j, j + width[ were modified: updates the bounds and the vertices of the nodes containing them, returned in increasing order
+	void updateRegion(uint32_t i, uint32_t j, uint32_t height, uint32_t width, std::vector<uint32_t>& outUpdatedNodes);
+	// The heightfields of both trees exchanged their samples (same resolution and parameters): exchanges the bounds, the level errors and the vertices
+	// built from them. updateRanges must then be called
+	void swapHeightData(TerrainQuadTree& other);
+	// Nodes to draw this frame, culled against the frustum of viewProjection (model space = world space)
+	void select(const glm::vec3& cameraPosition, const glm::mat4& viewProjection, std::vector<SelectedNode>& outSelectedNodes) const;
+
+	// Vertices of all nodes, node n starts at n * getVertexCountPerNode() and its vertex (a, b) is a * (chunkSize + 1) + b, they all share getPatchIndices()
+	const std::vector<Vertex>& getVertices() const { return m_vertices; }
+	const std::vector<uint32_t>& getPatchIndices() const { return m_patchIndices; }
+	uint32_t getVertexCountPerNode() const { return (m_chunkSize + 1) * (m_chunkSize + 1); }
+	uint32_t getChunkSize() const { return m_chunkSize; }
+	uint32_t getNodeCount() const { return static_cast<uint32_t>(m_nodes.size()); }
+	HeightSummary getHeightSummary() const;
+	NodeGrid getNodeGrid(uint32_t nodeIndex) const;
+	// x: lowest height of the node, y: height range, a quantized height q is x + y * q / 65535
+	glm::vec2 getNodeHeightRange(uint32_t nodeIndex) const;
+	uint32_t getLevelCount() const { return m_levelCount; }
+	uint32_t getMaxSelectedNodeCount() const { return m_leafCountPerSide * m_leafCountPerSide; }
+	// x: distance where the morph starts, y: 1 / morph length, as expected by the vertex shader
+	glm::vec2 getMorphRange(uint32_t level) const;
+
+private:
+	void buildNodes();
+	void buildNode(uint32_t nodeIndex, bool buildVertices, const HeightSummary* heightSummary, float& outLevelError);
+	void buildNodeVertices(uint32_t nodeIndex);
+	float sampleHeight(int64_t i, int64_t j) const;
+	float interpolateLevelHeight(uint32_t i, uint32_t j, uint32_t stride) const;
+	void selectNode(uint32_t nodeIndex, const glm::vec3& cameraPosition, const std::array<glm::vec4, 6>& frustumPlanes, std::vector<SelectedNode>& outSelectedNodes) const;
+
+private:
+	const HeightField& m_heightField;
+	uint32_t m_resolution;
+	uint32_t m_chunkSize;
+	TerrainMeshBuilder::GridInfo m_gridInfo;
+
+	uint32_t m_leafCountPerSide;
+	uint32_t m_levelCount = 0;
+
+	struct Node
+	{
+		uint32_t i; // first sample
+		uint32_t j;
+		uint32_t level;
+		uint32_t firstChild = 0; // children are consecutive, 0 for leaves
+		glm::vec3 boundsMin;
+		glm::vec3 boundsMax;
+	};
+	std::vector<Node> m_nodes;
+	std::vector<float> m_levelErrors; // max world space height error of a level compared to the full resolution
+
+	struct LODRange
+	{
+		float morphStart;
+		float end;
+	};
+	std::vector<LODRange> m_ranges;
+
+	std::vector<Vertex> m_vertices;
+	std::vector<uint32_t> m_patchIndices;
+};
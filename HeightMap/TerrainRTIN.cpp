@@ -0,0 +1,188 @@
+#include "TerrainRTIN.h"
+
+#include <algorithm>
+#include <cmath>
+
+TerrainRTIN::TerrainRTIN(const HeightField& heightField, uint32_t chunkSize, float maxHeight, ThreadPool* threadPool)
+	: m_heightField(heightField), m_resolution(heightField.getResolution()), m_chunkSize(chunkSize), m_chunkCountPerSide(m_resolution / chunkSize),
+	m_maxHeight(maxHeight)
+{
+	buildTriangleCoords();
+	computeErrors(threadPool);
+}
+
+void TerrainRTIN::buildIndices(float maxError, ThreadPool* threadPool)
+{
+	const uint32_t chunkCount = m_chunkCountPerSide * m_chunkCountPerSide;
+	std::vector<std::vector<uint32_t>> chunkIndices(chunkCount);
+	auto buildChunk = [&](uint32_t chunkIndex)
+	{
+		const uint32_t chunkI = chunkIndex / m_chunkCountPerSide;
+		const uint32_t chunkJ = chunkIndex % m_chunkCountPerSide;
+		buildChunkIndices(chunkI, chunkJ, maxError, 0, 0, m_chunkSize, m_chunkSize, m_chunkSize, 0, chunkIndices[chunkIndex]);
+		buildChunkIndices(chunkI, chunkJ, maxError, m_chunkSize, m_chunkSize, 0, 0, 0, m_chunkSize, chunkIndices[chunkIndex]);
+	};
+
+	if (threadPool)
+		threadPool->parallelFor(chunkCount, buildChunk);
+	else
+		for (uint32_t chunkIndex = 0; chunkIndex < chunkCount; ++chunkIndex)
+			buildChunk(chunkIndex);
+
+	m_indices.clear();
+	m_chunkRanges.resize(chunkCount);
+	for (uint32_t chunkIndex = 0; chunkIndex < chunkCount; ++chunkIndex)
+	{
+		m_chunkRanges[chunkIndex] = { static_cast<uint32_t>(m_indices.size()), static_cast<uint32_t>(chunkIndices[chunkIndex].size()) };
+		m_indices.insert(m_indices.end(), chunkIndices[chunkIndex].begin(), chunkIndices[chunkIndex].end());
+	}
+}
+
+void TerrainRTIN::buildTriangleCoords()
+{
+	// The 2 root triangles share the diagonal (0, 0) -> (chunkSize, chunkSize), the children of a triangle are the halves on each side of its middle
+	const uint32_t triangleCount = m_chunkSize * m_chunkSize * 2 - 2;
+	m_triangleCoords.resize(static_cast<size_t>(triangleCount) * 4);
+	for (uint32_t triangle = 0; triangle < triangleCount; ++triangle)
+	{
+		uint32_t id = triangle + 2;
+		uint32_t ax = 0, ay = 0, bx = 0, by = 0, cx = 0, cy = 0;
+		if (id & 1)
+			bx = by = cx = m_chunkSize;
+		else
+			ax = ay = cy = m_chunkSize;
+
+		while ((id >>= 1) > 1)
+		{
+			const uint32_t mx = (ax + bx) >> 1;
+			const uint32_t my = (ay + by) >> 1;
+			if (id & 1)
+			{
+				bx = ax;
+				by = ay;
+				ax = cx;
+				ay = cy;
+			}
+			else
+			{
+				ax = bx;
+				ay = by;
+				bx = cx;
+				by = cy;
+			}
+			cx = mx;
+			cy = my;
+		}
+
+		uint16_t* coords = &m_triangleCoords[static_cast<size_t>(triangle) * 4];
+		coords[0] = static_cast<uint16_t>(ax);
+		coords[1] = static_cast<uint16_t>(ay);
+		coords[2] = static_cast<uint16_t>(bx);
+		coords[3] = static_cast<uint16_t>(by);
+	}
+}
+
+void TerrainRTIN::computeErrors(ThreadPool* threadPool)
+{
+	m_errors.assign(static_cast<size_t>(m_resolution + 1) * (m_resolution + 1), 0.0f);
+
+	// Finest triangles first, a triangle takes the errors of its children. Hypotenuses on a chunk border are shared with the neighbour chunk,
+	// so a level is done for the chunks of one diagonal orientation, then for the others
+	std::vector<uint32_t> chunksByOrientation[2];
+	for (uint32_t chunkI = 0; chunkI < m_chunkCountPerSide; ++chunkI)
+		for (uint32_t chunkJ = 0; chunkJ < m_chunkCountPerSide; ++chunkJ)
+			chunksByOrientation[isMirrored(chunkI, chunkJ) ? 1 : 0].push_back(chunkI * m_chunkCountPerSide + chunkJ);
+
+	const uint32_t triangleCount = m_chunkSize * m_chunkSize * 2 - 2;
+	uint32_t levelEnd = triangleCount + 2;
+	while (levelEnd > 2)
+	{
+		// Triangles t of a level have t + 2 in [2^level, 2^(level + 1)[
+		uint32_t levelStart = 1;
+		while (levelStart * 2 < levelEnd)
+			levelStart *= 2;
+
+		for (const std::vector<uint32_t>& chunks : chunksByOrientation)
+		{
+			auto computeChunk = [&](uint32_t k)
+			{
+				computeChunkErrors(chunks[k] / m_chunkCountPerSide, chunks[k] % m_chunkCountPerSide, levelStart - 2, levelEnd - 2);
+			};
+
+			if (threadPool)
+				threadPool->parallelFor(static_cast<uint32_t>(chunks.size()), computeChunk);
+			else
+				for (uint32_t k = 0; k < chunks.size(); ++k)
+					computeChunk(k);
+		}
+
+		levelEnd = levelStart;
+	}
+}
+
+void TerrainRTIN::computeChunkErrors(uint32_t chunkI, uint32_t chunkJ, uint32_t firstTriangle, uint32_t endTriangle)
+{
+	const uint32_t parentTriangleCount = m_chunkSize * m_chunkSize - 2;
+	for (uint32_t triangle = firstTriangle; triangle < endTriangle; ++triangle)
+	{
+		const uint16_t* coords = &m_triangleCoords[static_cast<size_t>(triangle) * 4];
+		const uint32_t ax = coords[0], ay = coords[1], bx = coords[2], by = coords[3];
+		const uint32_t mx = (ax + bx) >> 1;
+		const uint32_t my = (ay + by) >> 1;
+
+		const float interpolatedHeight = (getHeight(chunkI, chunkJ, ax, ay) + getHeight(chunkI, chunkJ, bx, by)) * 0.5f;
+		const size_t middleIndex = getErrorIndex(chunkI, chunkJ, mx, my);
+		float error = std::max(m_errors[middleIndex], std::abs(interpolatedHeight - getHeight(chunkI, chunkJ, mx, my)));
+
+		if (triangle < parentTriangleCount)
+		{
+			// Middles of the hypotenuses of the children (the legs of this triangle)
+			const uint32_t cx = mx + my - ay;
+			const uint32_t cy = my + ax - mx;
+			error = std::max(error, m_errors[getErrorIndex(chunkI, chunkJ, (ax + cx) >> 1, (ay + cy) >> 1)]);
+			error = std::max(error, m_errors[getErrorIndex(chunkI, chunkJ, (bx + cx) >> 1, (by + cy) >> 1)]);
+		}
+
+		m_errors[middleIndex] = error;
+	}
+}
+
+void TerrainRTIN::buildChunkIndices(uint32_t chunkI, uint32_t chunkJ, float maxError, uint32_t ax, uint32_t ay, uint32_t bx, uint32_t by, uint32_t cx,
+	uint32_t cy, std::vector<uint32_t>& outIndices) const
+{
+	const uint32_t mx = (ax + bx) >> 1;
+	const uint32_t my = (ay + by) >> 1;
+	const uint32_t legLength = (ax > cx ? ax - cx : cx - ax) + (ay > cy ? ay - cy : cy - ay);
+	if (legLength > 1 && m_errors[getErrorIndex(chunkI, chunkJ, mx, my)] > maxError)
+	{
+		buildChunkIndices(chunkI, chunkJ, maxError, cx, cy, ax, ay, mx, my, outIndices);
+		buildChunkIndices(chunkI, chunkJ, maxError, bx, by, cx, cy, mx, my, outIndices);
+		return;
+	}
+
+	// Vertex (a, b) of the chunk, counter clockwise in (i, j) as the triangles of TerrainMeshBuilder
+	const uint32_t vertexCountPerSide = m_chunkSize + 1;
+	const bool mirrored = isMirrored(chunkI, chunkJ);
+	const int32_t a[3] = { static_cast<int32_t>(mirrored ? m_chunkSize - ax : ax), static_cast<int32_t>(mirrored ? m_chunkSize - bx : bx),
+		static_cast<int32_t>(mirrored ? m_chunkSize - cx : cx) };
+	const int32_t b[3] = { static_cast<int32_t>(ay), static_cast<int32_t>(by), static_cast<int32_t>(cy) };
+	const bool clockwise = (a[1] - a[0]) * (b[2] - b[0]) - (b[1] - b[0]) * (a[2] - a[0]) < 0;
+
+	outIndices.push_back(a[0] * vertexCountPerSide + b[0]);
+	outIndices.push_back(clockwise ? a[2] * vertexCountPerSide + b[2] : a[1] * vertexCountPerSide + b[1]);
+	outIndices.push_back(clockwise ? a[1] * vertexCountPerSide + b[1] : a[2] * vertexCountPerSide + b[2]);
+}
+
+size_t TerrainRTIN::getErrorIndex(uint32_t chunkI, uint32_t chunkJ, uint32_t x, uint32_t y) const
+{
+	const uint32_t i = chunkI * m_chunkSize + (isMirrored(chunkI, chunkJ) ? m_chunkSize - x : x);
+	const uint32_t j = chunkJ * m_chunkSize + y;
+	return static_cast<size_t>(i) * (m_resolution + 1) + j;
+}
+
+float TerrainRTIN::getHeight(uint32_t chunkI, uint32_t chunkJ, uint32_t x, uint32_t y) const
+{
+	const uint32_t i = chunkI * m_chunkSize + (isMirrored(chunkI, chunkJ) ? m_chunkSize - x : x);
+	const uint32_t j = chunkJ * m_chunkSize + y;
+	return m_heightField.get(std::min(i, m_resolution - 1), std::min(j, m_resolution - 1)) * m_maxHeight;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <vector>
+
+#include "HeightField.h"
+#include "ThreadPool.h"
+
+// Right-triangulated irregular network (Martini): the terrain is split into right triangles by halving their hypotenuse, a triangle is only split
+// while the height at the middle of its hypotenuse differs from the interpolation by more than the tolerated error (its own or any of its descendants)
+// The terrain is meshed chunk by chunk, chunks being the level 0 nodes of TerrainQuadTree (their vertex (a, b) is a * (chunkSize + 1) + b), with the
+// errors of the single network covering the whole terrain: triangles sharing a chunk border are split together, so there are no cracks
+class TerrainRTIN
+{
+public:
+	// chunkSize must be a power of 2 and divide the resolution. Heights are in world units (heightfield * maxHeight), as the errors
+	TerrainRTIN(const HeightField& heightField, uint32_t chunkSize, float maxHeight, ThreadPool* threadPool);
+
+	// Triangles of every chunk, within maxError of the heightfield
+	void buildIndices(float maxError, ThreadPool* threadPool);
+
+	struct ChunkRange
+	{
+		uint32_t firstIndex;
+		uint32_t indexCount;
+	};
+	// Indices of chunk (chunkI, chunkJ), the chunk of the samples (chunkI * chunkSize, chunkJ * chunkSize), are
+	// getIndices()[getChunkRange(chunkI, chunkJ).firstIndex ...]
+	const std::vector<uint32_t>& getIndices() const { return m_indices; }
+	const ChunkRange& getChunkRange(uint32_t chunkI, uint32_t chunkJ) const { return m_chunkRanges[chunkI * m_chunkCountPerSide + chunkJ]; }
+	uint32_t getChunkCountPerSide() const { return m_chunkCountPerSide; }
+
+private:
+	void buildTriangleCoords();
+	void computeErrors(ThreadPool* threadPool);
+	void computeChunkErrors(uint32_t chunkI, uint32_t chunkJ, uint32_t firstTriangle, uint32_t endTriangle);
+	void buildChunkIndices(uint32_t chunkI, uint32_t chunkJ, float maxError, uint32_t ax, uint32_t ay, uint32_t bx, uint32_t by, uint32_t cx, uint32_t cy,
+		std::vector<uint32_t>& outIndices) const;
+
+	// Chunk coordinates (x, y) to the sample (i, j): one chunk out of two has its diagonal mirrored, the one of its square in the whole network
+	size_t getErrorIndex(uint32_t chunkI, uint32_t chunkJ, uint32_t x, uint32_t y) const;
+	float getHeight(uint32_t chunkI, uint32_t chunkJ, uint32_t x, uint32_t y) const;
+	bool isMirrored(uint32_t chunkI, uint32_t chunkJ) const { return ((chunkI + chunkJ) & 1) != 0; }
+
+private:
+	const HeightField& m_heightField;
+	uint32_t m_resolution;
+	uint32_t m_chunkSize;
+	uint32_t m_chunkCountPerSide;
+	float m_maxHeight;
+
+	// Triangles of a chunk in breadth first order (triangle t is the node t + 2 of the binary tree), hypotenuse ends a and b: ax, ay, bx, by
+	std::vector<uint16_t> m_triangleCoords;
+	// Per sample of the (resolution + 1)^2 grid, the last row and column repeat the border samples
+	std::vector<float> m_errors;
+
+	std::vector<uint32_t> m_indices;
+	std::vector<ChunkRange> m_chunkRanges;
+};
@@ -0,0 +1,173 @@
+#include "TerrainScatter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <glm/gtc/quaternion.hpp>
+
+TerrainScatter::TerrainScatter(const HeightField& heightField, const TerrainMeshBuilder::GridInfo& gridInfo) : m_heightField(heightField), m_gridInfo(gridInfo)
+{
+}
+
+void TerrainScatter::scatter(const Layer& layer, std::vector<Wolf::InstanceTransform>& outInstances, ThreadPool* threadPool) const
+{
+	// Positions (x, z) relative to topLeftPos, the terrain covers [0, sizeX] x [0, sizeZ]
+	const float lastSample = static_cast<float>(m_heightField.getResolution() - 1);
+	const float sizeX = lastSample * m_gridInfo.tileSize.x;
+	const float sizeZ = lastSample * m_gridInfo.tileSize.z;
+	const float cellSize = layer.minDistance / std::sqrt(2.0f);
+	const uint32_t cellCountX = std::max(static_cast<uint32_t>(std::ceil(sizeX / cellSize)), 1u);
+	const uint32_t cellCountZ = std::max(static_cast<uint32_t>(std::ceil(sizeZ / cellSize)), 1u);
+	const uint32_t tileCountX = (cellCountX + TERRAIN_SCATTER_TILE_CELLS - 1) / TERRAIN_SCATTER_TILE_CELLS;
+	const uint32_t tileCountZ = (cellCountZ + TERRAIN_SCATTER_TILE_CELLS - 1) / TERRAIN_SCATTER_TILE_CELLS;
+	const float minDistanceSquared = layer.minDistance * layer.minDistance;
+
+	// Position of the instance of each occupied cell, cell cellX * cellCountZ + cellZ
+	std::vector<glm::vec2> cellPositions(static_cast<size_t>(cellCountX) * cellCountZ);
+	std::vector<uint8_t> occupiedCells(cellPositions.size(), 0);
+	std::vector<std::vector<Wolf::InstanceTransform>> tileInstances(static_cast<size_t>(tileCountX) * tileCountZ);
+
+	std::vector<uint32_t> phaseTiles;
+	for (uint32_t phase = 0; phase < 4; ++phase)
+	{
+		phaseTiles.clear();
+		for (uint32_t tileX = phase & 1; tileX < tileCountX; tileX += 2)
+			for (uint32_t tileZ = phase >> 1; tileZ < tileCountZ; tileZ += 2)
+				phaseTiles.push_back(tileX * tileCountZ + tileZ);
+
+		auto fillTile = [&](uint32_t phaseTileIndex)
+		{
+			const uint32_t tileIndex = phaseTiles[phaseTileIndex];
+			const uint32_t firstCellX = tileIndex / tileCountZ * TERRAIN_SCATTER_TILE_CELLS;
+			const uint32_t firstCellZ = tileIndex % tileCountZ * TERRAIN_SCATTER_TILE_CELLS;
+			const uint32_t tileCellCountX = std::min(firstCellX + TERRAIN_SCATTER_TILE_CELLS, cellCountX) - firstCellX;
+			const uint32_t tileCellCountZ = std::min(firstCellZ + TERRAIN_SCATTER_TILE_CELLS, cellCountZ) - firstCellZ;
+			const uint32_t attemptCount = TERRAIN_SCATTER_ATTEMPTS_PER_CELL * tileCellCountX * tileCellCountZ;
+
+			uint32_t randomState = hash(layer.seed ^ hash(tileIndex));
+			for (uint32_t attempt = 0; attempt < attemptCount; ++attempt)
+			{
+				// Every candidate draws the same random numbers, kept or not
+				const float x = (static_cast<float>(firstCellX) + randomFloat(randomState) * static_cast<float>(tileCellCountX)) * cellSize;
+				const float z = (static_cast<float>(firstCellZ) + randomFloat(randomState) * static_cast<float>(tileCellCountZ)) * cellSize;
+				const float keep = randomFloat(randomState);
+				const float yaw = randomFloat(randomState) * 6.28318531f;
+				const float scale = layer.scaleRange.x + randomFloat(randomState) * (layer.scaleRange.y - layer.scaleRange.x);
+				if (x >= sizeX || z >= sizeZ)
+					continue;
+
+				const uint32_t cellX = std::min(static_cast<uint32_t>(x / cellSize), firstCellX + tileCellCountX - 1);
+				const uint32_t cellZ = std::min(static_cast<uint32_t>(z / cellSize), firstCellZ + tileCellCountZ - 1);
+				if (occupiedCells[static_cast<size_t>(cellX) * cellCountZ + cellZ])
+					continue;
+
+				// Two cells away at most, the cell diagonal being minDistance
+				bool tooClose = false;
+				for (uint32_t neighbourX = cellX > 2 ? cellX - 2 : 0; neighbourX <= std::min(cellX + 2, cellCountX - 1) && !tooClose; ++neighbourX)
+				{
+					for (uint32_t neighbourZ = cellZ > 2 ? cellZ - 2 : 0; neighbourZ <= std::min(cellZ + 2, cellCountZ - 1); ++neighbourZ)
+					{
+						const size_t neighbourCell = static_cast<size_t>(neighbourX) * cellCountZ + neighbourZ;
+						if (occupiedCells[neighbourCell])
+						{
+							const glm::vec2 offset = cellPositions[neighbourCell] - glm::vec2(x, z);
+							if (glm::dot(offset, offset) < minDistanceSquared)
+							{
+								tooClose = true;
+								break;
+							}
+						}
+					}
+				}
+				if (tooClose)
+					continue;
+
+				float height, slope;
+				glm::vec3 normal;
+				sampleTerrain(x, z, height, slope, normal);
+				if (keep >= computeDensity(height, layer.heightRange, layer.heightFade) * computeDensity(slope, layer.slopeRange, layer.slopeFade))
+					continue;
+
+				const size_t cell = static_cast<size_t>(cellX) * cellCountZ + cellZ;
+				occupiedCells[cell] = 1;
+				cellPositions[cell] = glm::vec2(x, z);
+
+				// Yaw around the up axis, then the up axis tilted towards the normal
+				const glm::vec3 up = glm::normalize(glm::mix(glm::vec3(0.0f, 1.0f, 0.0f), normal, layer.normalAlignment));
+				const glm::quat tilt = glm::normalize(glm::quat(1.0f + up.y, up.z, 0.0f, -up.x));
+				const glm::quat rotation = tilt * glm::quat(std::cos(yaw * 0.5f), 0.0f, std::sin(yaw * 0.5f), 0.0f);
+
+				Wolf::InstanceTransform instance;
+				instance.positionScale = glm::vec4(m_gridInfo.topLeftPos.x + x, m_gridInfo.topLeftPos.y + height * m_gridInfo.maxHeight, m_gridInfo.topLeftPos.z + z, scale);
+				instance.rotation = glm::vec4(rotation.x, rotation.y, rotation.z, rotation.w);
+				tileInstances[tileIndex].push_back(instance);
+			}
+		};
+
+		if (threadPool)
+			threadPool->parallelFor(static_cast<uint32_t>(phaseTiles.size()), fillTile);
+		else
+			for (uint32_t phaseTileIndex = 0; phaseTileIndex < phaseTiles.size(); ++phaseTileIndex)
+				fillTile(phaseTileIndex);
+	}
+
+	for (const std::vector<Wolf::InstanceTransform>& instances : tileInstances)
+		outInstances.insert(outInstances.end(), instances.begin(), instances.end());
+}
+
+void TerrainScatter::sampleTerrain(float x, float z, float& outHeight, float& outSlope, glm::vec3& outNormal) const
+{
+	const uint32_t resolution = m_heightField.getResolution();
+	const float lastSample = static_cast<float>(resolution - 1);
+	const float i = std::min(std::max(x / m_gridInfo.tileSize.x, 0.0f), lastSample);
+	const float j = std::min(std::max(z / m_gridInfo.tileSize.z, 0.0f), lastSample);
+	const uint32_t cellI = std::min(static_cast<uint32_t>(i), resolution - 2);
+	const uint32_t cellJ = std::min(static_cast<uint32_t>(j), resolution - 2);
+	const float u = i - static_cast<float>(cellI);
+	const float v = j - static_cast<float>(cellJ);
+
+	const float h00 = m_heightField.get(cellI, cellJ);
+	const float h01 = m_heightField.get(cellI, cellJ + 1);
+	const float h10 = m_heightField.get(cellI + 1, cellJ);
+	const float h11 = m_heightField.get(cellI + 1, cellJ + 1);
+	const float top = h00 + v * (h01 - h00);
+	const float bottom = h10 + v * (h11 - h10);
+	outHeight = top + u * (bottom - top);
+
+	// Derivatives of the bilinear patch, in world units
+	const float slopeX = ((1.0f - v) * (h10 - h00) + v * (h11 - h01)) * m_gridInfo.maxHeight / m_gridInfo.tileSize.x;
+	const float slopeZ = ((1.0f - u) * (h01 - h00) + u * (h11 - h10)) * m_gridInfo.maxHeight / m_gridInfo.tileSize.z;
+	const float gradientSquared = slopeX * slopeX + slopeZ * slopeZ;
+	outSlope = std::sqrt(gradientSquared / (1.0f + gradientSquared));
+	outNormal = glm::normalize(glm::vec3(-slopeX, 1.0f, -slopeZ));
+}
+
+float TerrainScatter::computeDensity(float value, const glm::vec2& range, float fade)
+{
+	if (value < range.x || value > range.y)
+		return 0.0f;
+	if (fade <= 0.0f)
+		return 1.0f;
+
+	// No fade at the ends of the [0, 1] domain: a range starting at 0 keeps its full density on flat ground
+	const float lowerDistance = range.x > 0.0f ? value - range.x : std::numeric_limits<float>::max();
+	const float upperDistance = range.y < 1.0f ? range.y - value : std::numeric_limits<float>::max();
+	return std::min(std::min(lowerDistance, upperDistance) / fade, 1.0f);
+}
+
+uint32_t TerrainScatter::hash(uint32_t x)
+{
+	x ^= x >> 16;
+	x *= 0x7FEB352Du;
+	x ^= x >> 15;
+	x *= 0x846CA68Bu;
+	x ^= x >> 16;
+	return x;
+}
+
+float TerrainScatter::randomFloat(uint32_t& state)
+{
+	state += 0x9E3779B9u;
+	return static_cast<float>(hash(state) >> 8) * (1.0f / 16777216.0f);
+}
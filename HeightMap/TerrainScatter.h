@@ -0,0 +1,50 @@
+#pragma once
+
+#include <vector>
+
+#include <InstanceTemplate.h>
+
+#include "HeightField.h"
+#include "TerrainMeshBuilder.h"
+#include "ThreadPool.h"
+
+#define TERRAIN_SCATTER_TILE_CELLS 16 // grid cells per side of a tile, the tiles of a phase are filled concurrently
+#define TERRAIN_SCATTER_ATTEMPTS_PER_CELL 4 // random candidates per grid cell
+
+// Poisson-disk scattering of props on the terrain: the instances of a layer are at least minDistance apart, and a candidate position is kept with
+// the probability given by the height and slope masks of the layer.
+// Candidates are thrown tile by tile into a grid of cells of minDistance / sqrt(2) (at most one instance per cell), checking the 5 x 5 cells
+// around them. The tiles run concurrently are one tile apart (4 phases), each tile has its own random sequence: the instances don't depend on the
+// thread count or scheduling
+class TerrainScatter
+{
+public:
+	struct Layer
+	{
+		uint32_t seed = 0;
+		float minDistance = 1.0f; // world units between two instances
+		glm::vec2 heightRange = glm::vec2(0.0f, 1.0f); // normalized heights where the layer grows
+		glm::vec2 slopeRange = glm::vec2(0.0f, 1.0f); // sines of the slope angle, as in TerrainNormalMap
+		float heightFade = 0.05f; // the density fades out over this width inside the edges of the ranges
+		float slopeFade = 0.05f;
+		glm::vec2 scaleRange = glm::vec2(1.0f); // uniform scale of the instances
+		float normalAlignment = 0.0f; // 0 keeps the instances upright, 1 aligns their up axis with the terrain normal
+	};
+
+	TerrainScatter(const HeightField& heightField, const TerrainMeshBuilder::GridInfo& gridInfo);
+
+	// Instances of the layer in world space, appended to outInstances. A null thread pool scatters on the calling thread
+	void scatter(const Layer& layer, std::vector<Wolf::InstanceTransform>& outInstances, ThreadPool* threadPool) const;
+
+private:
+	// Normalized height, sine of the slope angle and normal of the bilinear patches at (x, z) relative to topLeftPos
+	void sampleTerrain(float x, float z, float& outHeight, float& outSlope, glm::vec3& outNormal) const;
+	static float computeDensity(float value, const glm::vec2& range, float fade);
+
+	static uint32_t hash(uint32_t x);
+	static float randomFloat(uint32_t& state);
+
+private:
+	const HeightField& m_heightField;
+	TerrainMeshBuilder::GridInfo m_gridInfo;
+};
@@ -0,0 +1,198 @@
+#include "TerrainTileCache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#include <WolfEngine.h>
+
+#include "HeightMapGenerator.h"
+
+#define TERRAIN_TILE_CACHE_MAGIC "HMTILES"
+#define TERRAIN_TILE_CACHE_VERSION 3
+#define TERRAIN_TILE_CACHE_ALIGNMENT 4096
+
+std::string TerrainTileCache::getFilename(uint64_t parametersKey, uint32_t resolution)
+{
+	char filename[64];
+	snprintf(filename, sizeof(filename), "terrain_%u_%016llx.tiles", resolution, static_cast<unsigned long long>(parametersKey));
+
+	return filename;
+}
+
+bool TerrainTileCache::write(const std::string& filename, uint64_t parametersKey, const HeightField& heightField, uint32_t chunkSize, ThreadPool* threadPool)
+{
+	const Header header = buildHeader(parametersKey, heightField.getResolution(), heightField.getBlockSize(), chunkSize);
+	const uint32_t tileCount = header.tileCountPerSide * header.tileCountPerSide;
+	const uint32_t texelCountPerTile = header.tileSize * header.tileSize;
+
+	std::vector<uint16_t> tiles(static_cast<size_t>(tileCount) * texelCountPerTile);
+	auto quantizeTile = [&](uint32_t tileIndex)
+	{
+		const float* block = heightField.getBlock(tileIndex / header.tileCountPerSide, tileIndex % header.tileCountPerSide);
+		uint16_t* tile = &tiles[static_cast<size_t>(tileIndex) * texelCountPerTile];
+		for (uint32_t k = 0; k < texelCountPerTile; ++k)
+			tile[k] = static_cast<uint16_t>(std::lround(std::min(std::max(block[k], 0.0f), 1.0f) * 65535.0f));
+	};
+
+	if (threadPool)
+		threadPool->parallelFor(tileCount, quantizeTile);
+	else
+		for (uint32_t tileIndex = 0; tileIndex < tileCount; ++tileIndex)
+			quantizeTile(tileIndex);
+
+	// The summary must be the one of the heights loaded back, not of the generated ones: vertices quantized over bounds that don't contain them wrap
+	TerrainQuadTree::HeightSummary heightSummary;
+	{
+		HeightField cachedHeightField(header.resolution, header.tileSize);
+		dequantizeTiles(tiles.data(), cachedHeightField, threadPool);
+		const TerrainQuadTree quadTree(cachedHeightField, chunkSize, TerrainMeshBuilder::GridInfo(), threadPool, false);
+		if (quadTree.getNodeCount() != header.nodeCount || quadTree.getLevelCount() != header.levelCount)
+			return false;
+		heightSummary = quadTree.getHeightSummary();
+	}
+
+	// Written under a temporary name so that a crash never leaves a truncated cache behind
+	const std::string temporaryFilename = filename + ".tmp";
+	bool success;
+	{
+		std::ofstream file(temporaryFilename, std::ios::binary | std::ios::trunc);
+		if (!file)
+			return false;
+
+		uint64_t position = 0;
+		auto writeAt = [&file, &position](uint64_t offset, const void* data, size_t size)
+		{
+			static const char zeros[TERRAIN_TILE_CACHE_ALIGNMENT] = {};
+			file.write(zeros, static_cast<std::streamsize>(offset - position));
+			file.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+			position = offset + size;
+			return static_cast<bool>(file);
+		};
+		success = writeAt(0, &header, sizeof(header));
+		success = success && writeAt(header.nodeHeightsOffset, heightSummary.nodeHeights.data(), heightSummary.nodeHeights.size() * sizeof(glm::vec2));
+		success = success && writeAt(header.levelErrorsOffset, heightSummary.levelErrors.data(), heightSummary.levelErrors.size() * sizeof(float));
+		success = success && writeAt(header.tilesOffset, tiles.data(), tiles.size() * sizeof(uint16_t));
+		file.close();
+		success = success && !file.fail();
+	}
+
+	std::remove(filename.c_str());
+	if (!success || std::rename(temporaryFilename.c_str(), filename.c_str()) != 0)
+	{
+		std::remove(temporaryFilename.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+void TerrainTileCache::bake(const std::vector<uint32_t>& resolutions, uint32_t tileSize, uint32_t chunkSize, ThreadPool* threadPool)
+{
+	for (uint32_t resolution : resolutions)
+	{
+		HeightField heightField(resolution, tileSize);
+		HeightMapGenerator heightMapGenerator(resolution);
+		heightMapGenerator.generate(heightField, threadPool);
+
+		const std::string filename = getFilename(heightMapGenerator.getParametersKey(), resolution);
+		if (write(filename, heightMapGenerator.getParametersKey(), heightField, chunkSize, threadPool))
+			Wolf::Debug::sendInfo("Baked " + filename);
+		else
+			Wolf::Debug::sendError("Can't write " + filename);
+	}
+}
+
+bool TerrainTileCache::open(const std::string& filename, uint64_t parametersKey, uint32_t resolution, uint32_t tileSize, uint32_t chunkSize)
+{
+	m_header = nullptr;
+	if (!m_file.open(filename) || m_file.getSize() < sizeof(Header))
+		return false;
+
+	const Header* header = reinterpret_cast<const Header*>(m_file.getData());
+	const Header expectedHeader = buildHeader(parametersKey, resolution, tileSize, chunkSize);
+	const uint64_t tileCount = static_cast<uint64_t>(header->tileCountPerSide) * header->tileCountPerSide;
+	if (std::memcmp(header, &expectedHeader, sizeof(Header)) != 0 ||
+		m_file.getSize() < header->tilesOffset + tileCount * tileSize * tileSize * sizeof(uint16_t))
+	{
+		m_file.close();
+		return false;
+	}
+
+	m_header = header;
+	return true;
+}
+
+void TerrainTileCache::loadHeightField(HeightField& heightField, ThreadPool* threadPool) const
+{
+	dequantizeTiles(getTile(0, 0), heightField, threadPool);
+}
+
+TerrainQuadTree::HeightSummary TerrainTileCache::getHeightSummary() const
+{
+	TerrainQuadTree::HeightSummary heightSummary;
+	const glm::vec2* nodeHeights = reinterpret_cast<const glm::vec2*>(m_file.getData() + m_header->nodeHeightsOffset);
+	heightSummary.nodeHeights.assign(nodeHeights, nodeHeights + m_header->nodeCount);
+	const float* levelErrors = reinterpret_cast<const float*>(m_file.getData() + m_header->levelErrorsOffset);
+	heightSummary.levelErrors.assign(levelErrors, levelErrors + m_header->levelCount);
+
+	return heightSummary;
+}
+
+const uint16_t* TerrainTileCache::getTile(uint32_t tileI, uint32_t tileJ) const
+{
+	const uint8_t* tiles = m_file.getData() + m_header->tilesOffset;
+	return reinterpret_cast<const uint16_t*>(tiles) + (static_cast<size_t>(tileI) * m_header->tileCountPerSide + tileJ) * m_header->tileSize * m_header->tileSize;
+}
+
+TerrainTileCache::Header TerrainTileCache::buildHeader(uint64_t parametersKey, uint32_t resolution, uint32_t tileSize, uint32_t chunkSize)
+{
+	auto align = [](uint64_t offset)
+	{
+		return (offset + TERRAIN_TILE_CACHE_ALIGNMENT - 1) / TERRAIN_TILE_CACHE_ALIGNMENT * TERRAIN_TILE_CACHE_ALIGNMENT;
+	};
+
+	Header header;
+	std::memset(&header, 0, sizeof(header));
+	std::memcpy(header.magic, TERRAIN_TILE_CACHE_MAGIC, sizeof(header.magic));
+	header.version = TERRAIN_TILE_CACHE_VERSION;
+	header.resolution = resolution;
+	header.tileSize = tileSize;
+	header.tileCountPerSide = resolution / tileSize;
+	header.chunkSize = chunkSize;
+	// As TerrainQuadTree: one node per leaf, then a quarter as many for each coarser level up to the root
+	for (uint32_t nodeCountPerSide = resolution / chunkSize; nodeCountPerSide > 0; nodeCountPerSide /= 2)
+	{
+		++header.levelCount;
+		header.nodeCount += nodeCountPerSide * nodeCountPerSide;
+	}
+	header.parametersKey = parametersKey;
+	header.nodeHeightsOffset = sizeof(Header);
+	header.levelErrorsOffset = header.nodeHeightsOffset + header.nodeCount * sizeof(glm::vec2);
+	header.tilesOffset = align(header.levelErrorsOffset + header.levelCount * sizeof(float));
+
+	return header;
+}
+
+void TerrainTileCache::dequantizeTiles(const uint16_t* tiles, HeightField& heightField, ThreadPool* threadPool)
+{
+	// Tiles and heightfield blocks have the same layout
+	const uint32_t tileCountPerSide = heightField.getResolution() / heightField.getBlockSize();
+	const uint32_t texelCountPerTile = heightField.getBlockSize() * heightField.getBlockSize();
+	auto dequantizeTile = [&](uint32_t tileIndex)
+	{
+		const uint16_t* tile = tiles + static_cast<size_t>(tileIndex) * texelCountPerTile;
+		float* block = heightField.getBlock(tileIndex / tileCountPerSide, tileIndex % tileCountPerSide);
+		for (uint32_t k = 0; k < texelCountPerTile; ++k)
+			block[k] = tile[k] / 65535.0f;
+	};
+
+	const uint32_t tileCount = tileCountPerSide * tileCountPerSide;
+	if (threadPool)
+		threadPool->parallelFor(tileCount, dequantizeTile);
+	else
+		for (uint32_t tileIndex = 0; tileIndex < tileCount; ++tileIndex)
+			dequantizeTile(tileIndex);
+}
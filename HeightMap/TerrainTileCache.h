@@ -0,0 +1,56 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "HeightField.h"
+#include "MappedFile.h"
+#include "TerrainQuadTree.h"
+#include "ThreadPool.h"
+
+// Baked terrain on disk so that a warm start maps a file instead of generating: heights quantized to 16 bits (as uploaded to the R16 texture)
+// tile by tile, and the quadtree height summary of these quantized heights so that the tree doesn't read every sample again. The tiles start
+// on a page so they can be used straight from the mapping
+class TerrainTileCache
+{
+public:
+	// File of the given generator parameters in the working directory
+	static std::string getFilename(uint64_t parametersKey, uint32_t resolution);
+	static bool write(const std::string& filename, uint64_t parametersKey, const HeightField& heightField, uint32_t chunkSize, ThreadPool* threadPool);
+	// Batch: generates and writes the cache of each resolution
+	static void bake(const std::vector<uint32_t>& resolutions, uint32_t tileSize, uint32_t chunkSize, ThreadPool* threadPool);
+
+	// Returns false if the file doesn't exist or was baked with other parameters
+	bool open(const std::string& filename, uint64_t parametersKey, uint32_t resolution, uint32_t tileSize, uint32_t chunkSize);
+
+	void loadHeightField(HeightField& heightField, ThreadPool* threadPool) const;
+	// Of the heights loaded by loadHeightField, for a quadtree of the chunk size given to open
+	TerrainQuadTree::HeightSummary getHeightSummary() const;
+
+	uint32_t getTileCountPerSide() const { return m_header->tileCountPerSide; }
+	const uint16_t* getTile(uint32_t tileI, uint32_t tileJ) const;
+
+private:
+	struct Header
+	{
+		char magic[8];
+		uint32_t version;
+		uint32_t resolution;
+		uint32_t tileSize;
+		uint32_t tileCountPerSide;
+		uint32_t chunkSize;
+		uint32_t levelCount;
+		uint32_t nodeCount;
+		uint64_t parametersKey;
+		uint64_t nodeHeightsOffset;
+		uint64_t levelErrorsOffset;
+		uint64_t tilesOffset;
+	};
+	static Header buildHeader(uint64_t parametersKey, uint32_t resolution, uint32_t tileSize, uint32_t chunkSize);
+	// Tiles stored one after the other in the order of the blocks
+	static void dequantizeTiles(const uint16_t* tiles, HeightField& heightField, ThreadPool* threadPool);
+
+private:
+	MappedFile m_file;
+	const Header* m_header = nullptr;
+};
@@ -0,0 +1,360 @@
+#include "TerrainVegetation.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+using namespace Wolf;
+
+TerrainVegetation::TerrainVegetation(Wolf::WolfInstance* wolfInstance, Wolf::Scene* scene, int renderPassID, const HeightField& heightField,
+	const TerrainMeshBuilder::GridInfo& gridInfo, ThreadPool* threadPool)
+{
+	// Grass on low gentle slopes, trees a bit higher, rocks on the steep slopes. The seeds keep the layers independent
+	Prop props[3];
+	props[0].layer.seed = 1;
+	props[0].layer.minDistance = 0.7f;
+	props[0].layer.heightRange = glm::vec2(0.0f, 0.55f);
+	props[0].layer.slopeRange = glm::vec2(0.0f, 0.45f);
+	props[0].layer.scaleRange = glm::vec2(0.6f, 1.2f);
+	props[0].layer.normalAlignment = 1.0f;
+	props[0].lodDistances = glm::vec2(25.0f, 60.0f);
+
+	props[1].layer.seed = 2;
+	props[1].layer.minDistance = 4.0f;
+	props[1].layer.heightRange = glm::vec2(0.05f, 0.5f);
+	props[1].layer.slopeRange = glm::vec2(0.0f, 0.35f);
+	props[1].layer.scaleRange = glm::vec2(0.8f, 1.5f);
+	props[1].lodDistances = glm::vec2(60.0f, 300.0f);
+
+	props[2].layer.seed = 3;
+	props[2].layer.minDistance = 3.0f;
+	props[2].layer.slopeRange = glm::vec2(0.45f, 1.0f);
+	props[2].layer.scaleRange = glm::vec2(0.4f, 1.6f);
+	props[2].layer.normalAlignment = 1.0f;
+	props[2].lodDistances = glm::vec2(40.0f, 150.0f);
+
+	void (*const buildMeshes[])(uint32_t, std::vector<PropVertex>&, std::vector<uint32_t>&) = { buildGrassTuft, buildConifer, buildRock };
+	const uint32_t propCount = static_cast<uint32_t>(sizeof(props) / sizeof(props[0]));
+	static_assert(sizeof(props) / sizeof(props[0]) <= TERRAIN_VEGETATION_MAX_PROP_COUNT, "Too many props for the culling uniform buffer");
+
+	const auto startTime = std::chrono::steady_clock::now();
+	TerrainScatter terrainScatter(heightField, gridInfo);
+	std::vector<InstanceTransform> instances;
+	std::vector<uint32_t> firstInstances;
+	for (uint32_t propIndex = 0; propIndex < propCount; ++propIndex)
+	{
+		firstInstances.push_back(static_cast<uint32_t>(instances.size()));
+		terrainScatter.scatter(props[propIndex].layer, instances, threadPool);
+	}
+	firstInstances.push_back(static_cast<uint32_t>(instances.size()));
+	m_instanceCount = static_cast<uint32_t>(instances.size());
+	Debug::sendInfo("Vegetation: " + std::to_string(firstInstances[1] - firstInstances[0]) + " grass tufts, " + std::to_string(firstInstances[2] - firstInstances[1]) +
+		" trees, " + std::to_string(firstInstances[3] - firstInstances[2]) + " rocks scattered in " +
+		std::to_string(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count()) + " ms");
+	if (m_instanceCount == 0)
+		return;
+
+	// All the LOD meshes in one vertex buffer, the draws index it from vertex 0
+	std::vector<PropVertex> vertices;
+	std::vector<uint32_t> indices;
+	std::vector<size_t> lodEnds;
+	for (uint32_t propIndex = 0; propIndex < propCount; ++propIndex)
+	{
+		const size_t firstVertex = vertices.size();
+		for (uint32_t lod = 0; lod < TERRAIN_VEGETATION_LOD_COUNT; ++lod)
+		{
+			buildMeshes[propIndex](lod, vertices, indices);
+			lodEnds.push_back(indices.size());
+		}
+
+		// Around the bounding box of all the LODs of the prop
+		glm::vec3 minPosition = vertices[firstVertex].position;
+		glm::vec3 maxPosition = vertices[firstVertex].position;
+		for (size_t vertex = firstVertex; vertex < vertices.size(); ++vertex)
+		{
+			minPosition = glm::min(minPosition, vertices[vertex].position);
+			maxPosition = glm::max(maxPosition, vertices[vertex].position);
+		}
+		const glm::vec3 center = (minPosition + maxPosition) * 0.5f;
+		float radius = 0.0f;
+		for (size_t vertex = firstVertex; vertex < vertices.size(); ++vertex)
+			radius = std::max(radius, glm::length(vertices[vertex].position - center));
+
+		GPUProp& gpuProp = m_ubData.props[propIndex];
+		gpuProp.boundingSphere = glm::vec4(center, radius);
+		gpuProp.lodDistances = glm::vec4(props[propIndex].lodDistances, 0.0f, 0.0f);
+		gpuProp.ranges = glm::uvec4(firstInstances[propIndex], firstInstances[propIndex + 1] - firstInstances[propIndex], propIndex * TERRAIN_VEGETATION_LOD_COUNT, 0u);
+	}
+	// The triangles stay in their LOD range
+	Debug::sendInfo("Vegetation mesh: " + MeshOptimizer::toString(MeshOptimizer::optimize(vertices, indices, static_cast<int32_t>(offsetof(PropVertex, position)),
+		std::vector<size_t>(lodEnds.begin(), lodEnds.end() - 1))));
+
+	Model::ModelCreateInfo modelCreateInfo{};
+	modelCreateInfo.inputVertexTemplate = InputVertexTemplate::NO;
+	m_model = wolfInstance->createModel<PropVertex>(modelCreateInfo);
+	m_model->addMeshFromVertices(vertices.data(), static_cast<uint32_t>(vertices.size()), sizeof(PropVertex), indices);
+
+	// Draw propIndex * TERRAIN_VEGETATION_LOD_COUNT + lod, its instances are appended by the culling
+	std::vector<VkDrawIndexedIndirectCommand> drawCommands(propCount * TERRAIN_VEGETATION_LOD_COUNT, VkDrawIndexedIndirectCommand{});
+	for (uint32_t propIndex = 0; propIndex < propCount; ++propIndex)
+	{
+		const uint32_t instanceCount = firstInstances[propIndex + 1] - firstInstances[propIndex];
+		for (uint32_t lod = 0; lod < TERRAIN_VEGETATION_LOD_COUNT; ++lod)
+		{
+			const uint32_t drawIndex = propIndex * TERRAIN_VEGETATION_LOD_COUNT + lod;
+			VkDrawIndexedIndirectCommand& drawCommand = drawCommands[drawIndex];
+			drawCommand.firstIndex = drawIndex == 0 ? 0 : static_cast<uint32_t>(lodEnds[drawIndex - 1]);
+			drawCommand.indexCount = static_cast<uint32_t>(lodEnds[drawIndex]) - drawCommand.firstIndex;
+			drawCommand.firstInstance = firstInstances[propIndex] * TERRAIN_VEGETATION_LOD_COUNT + lod * instanceCount;
+		}
+	}
+	m_drawCommandsSize = drawCommands.size() * sizeof(VkDrawIndexedIndirectCommand);
+	m_drawCommands = wolfInstance->createBuffer(m_drawCommandsSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+	m_drawCommandsTemplate = wolfInstance->createUniformBufferObject(drawCommands.data(), m_drawCommandsSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
+
+	// The placements are uploaded once, then only read by the culling
+	const VkDeviceSize placementsSize = instances.size() * sizeof(InstanceTransform);
+	m_placements = wolfInstance->createInstanceBuffer<InstanceTransform>();
+	m_placements->loadFromVector(std::move(instances), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+	const VkDeviceSize visibleInstancesSize = placementsSize * TERRAIN_VEGETATION_LOD_COUNT;
+	m_visibleInstanceBuffer = wolfInstance->createBuffer(visibleInstancesSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+	m_visibleInstances = wolfInstance->createInstanceBuffer<InstanceTransform>();
+	m_visibleInstances->createFromBuffer(m_visibleInstanceBuffer, m_instanceCount * TERRAIN_VEGETATION_LOD_COUNT);
+
+	// One instance per invocation, in rows when there are too many instances for the groups of one dimension
+	const uint32_t rowLength = std::min((m_instanceCount + TERRAIN_VEGETATION_CULL_GROUP_SIZE - 1) / TERRAIN_VEGETATION_CULL_GROUP_SIZE * TERRAIN_VEGETATION_CULL_GROUP_SIZE,
+		TERRAIN_VEGETATION_MAX_ROW_LENGTH);
+	m_ubData.viewProjection = glm::mat4(1.0f);
+	m_ubData.cameraPosition = glm::vec4(0.0f);
+	m_ubData.counts = glm::uvec4(m_instanceCount, propCount, rowLength, 0u);
+	m_ub = wolfInstance->createUniformBufferObject(&m_ubData, sizeof(m_ubData));
+
+	// On the graphics queue like the draws, so the buffers never change of queue family. The render pass waits for the culling before reading the draws
+	Wolf::Scene::CommandBufferCreateInfo commandBufferCreateInfo;
+	commandBufferCreateInfo.commandType = Wolf::Scene::CommandType::GRAPHICS;
+	commandBufferCreateInfo.finalPipelineStage = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT;
+	m_commandBufferID = scene->addCommandBuffer(commandBufferCreateInfo);
+
+	DescriptorSetGenerator cullingDescriptorSetGenerator;
+	cullingDescriptorSetGenerator.addUniformBuffer(m_ub, VK_SHADER_STAGE_COMPUTE_BIT, 0);
+	cullingDescriptorSetGenerator.addBuffer(m_placements->getInstanceBuffer().instanceBuffer, placementsSize, VK_SHADER_STAGE_COMPUTE_BIT, 1);
+	cullingDescriptorSetGenerator.addBuffer(m_drawCommands->getBuffer(), m_drawCommandsSize, VK_SHADER_STAGE_COMPUTE_BIT, 2);
+	cullingDescriptorSetGenerator.addBuffer(m_visibleInstanceBuffer->getBuffer(), visibleInstancesSize, VK_SHADER_STAGE_COMPUTE_BIT, 3);
+
+	Wolf::Scene::ComputePassCreateInfo computePassCreateInfo;
+	computePassCreateInfo.commandBufferID = m_commandBufferID;
+	computePassCreateInfo.name = "Vegetation culling";
+	computePassCreateInfo.computeShaderPath = "Shaders/vegetation/cullComp.spv";
+	computePassCreateInfo.extent = { rowLength, (m_instanceCount + rowLength - 1) / rowLength };
+	computePassCreateInfo.dispatchGroups = { TERRAIN_VEGETATION_CULL_GROUP_SIZE, 1, 1 };
+	computePassCreateInfo.descriptorSetCreateInfo = cullingDescriptorSetGenerator.getDescritorSetCreateInfo();
+	computePassCreateInfo.beforeRecord = recordResetDrawCommands;
+	computePassCreateInfo.dataForBeforeRecordCallback = this;
+	scene->addComputePass(computePassCreateInfo);
+
+	RendererCreateInfo rendererCreateInfo;
+
+	ShaderCreateInfo vertexShaderCreateInfo{};
+	vertexShaderCreateInfo.filename = "Shaders/vegetation/propVert.spv";
+	vertexShaderCreateInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
+	rendererCreateInfo.pipelineCreateInfo.shaderCreateInfos.push_back(vertexShaderCreateInfo);
+
+	ShaderCreateInfo fragmentShaderCreateInfo{};
+	fragmentShaderCreateInfo.filename = "Shaders/vegetation/propFrag.spv";
+	fragmentShaderCreateInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+	rendererCreateInfo.pipelineCreateInfo.shaderCreateInfos.push_back(fragmentShaderCreateInfo);
+
+	// The instance attributes follow the vertex ones
+	rendererCreateInfo.inputVerticesTemplate = InputVertexTemplate::NO;
+	rendererCreateInfo.instanceTemplate = InstanceTemplate::TRANSFORM;
+	rendererCreateInfo.pipelineCreateInfo.vertexInputBindingDescriptions = { PropVertex::getBindingDescription(0) };
+	rendererCreateInfo.pipelineCreateInfo.vertexInputAttributeDescriptions = PropVertex::getAttributeDescriptions(0);
+	rendererCreateInfo.renderPassID = renderPassID;
+	rendererCreateInfo.pipelineCreateInfo.polygonMode = VK_POLYGON_MODE_FILL;
+	rendererCreateInfo.pipelineCreateInfo.alphaBlending = { false };
+
+	DescriptorSetGenerator descriptorSetGenerator;
+	descriptorSetGenerator.addUniformBuffer(m_ub, VK_SHADER_STAGE_VERTEX_BIT, 0);
+	rendererCreateInfo.descriptorLayouts = descriptorSetGenerator.getDescriptorLayouts();
+
+	Renderer::AddMeshInfo addMeshInfo{};
+	addMeshInfo.vertexBuffer = m_model->getVertexBuffers()[0];
+	addMeshInfo.instanceBuffer = m_visibleInstances->getInstanceBuffer();
+	addMeshInfo.renderPassID = renderPassID;
+	addMeshInfo.rendererID = scene->addRenderer(rendererCreateInfo);
+	addMeshInfo.indirectBuffer.indirectBuffer = m_drawCommands->getBuffer();
+	addMeshInfo.indirectBuffer.drawCount = static_cast<uint32_t>(drawCommands.size());
+	addMeshInfo.descriptorSetCreateInfo = descriptorSetGenerator.getDescritorSetCreateInfo();
+	scene->addMesh(addMeshInfo);
+}
+
+void TerrainVegetation::update(const glm::mat4& viewProjection, const glm::vec3& cameraPosition)
+{
+	if (m_instanceCount == 0)
+		return;
+
+	// Planes from the rows of the matrix (Gribb/Hartmann) for a [0, 1] depth range, normalized for the bounding sphere distances
+	const glm::mat4 transposed = glm::transpose(viewProjection);
+	m_ubData.frustumPlanes[0] = transposed[3] + transposed[0];
+	m_ubData.frustumPlanes[1] = transposed[3] - transposed[0];
+	m_ubData.frustumPlanes[2] = transposed[3] + transposed[1];
+	m_ubData.frustumPlanes[3] = transposed[3] - transposed[1];
+	m_ubData.frustumPlanes[4] = transposed[2];
+	m_ubData.frustumPlanes[5] = transposed[3] - transposed[2];
+	for (glm::vec4& frustumPlane : m_ubData.frustumPlanes)
+		frustumPlane /= glm::length(glm::vec3(frustumPlane));
+
+	m_ubData.viewProjection = viewProjection;
+	m_ubData.cameraPosition = glm::vec4(cameraPosition, 1.0f);
+	m_ub->updateData(&m_ubData);
+}
+
+void TerrainVegetation::recordResetDrawCommands(void* vegetation, VkCommandBuffer commandBuffer)
+{
+	const TerrainVegetation* terrainVegetation = static_cast<const TerrainVegetation*>(vegetation);
+
+	// The draws of the previous frame have read the commands and the visible instances before they are written again
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+		VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 0, nullptr);
+
+	VkBufferCopy copyRegion = {};
+	copyRegion.size = terrainVegetation->m_drawCommandsSize;
+	vkCmdCopyBuffer(commandBuffer, terrainVegetation->m_drawCommandsTemplate->getUniformBuffer(), terrainVegetation->m_drawCommands->getBuffer(), 1, &copyRegion);
+
+	VkMemoryBarrier memoryBarrier = {};
+	memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	memoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	memoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+}
+
+void TerrainVegetation::buildGrassTuft(uint32_t lod, std::vector<PropVertex>& outVertices, std::vector<uint32_t>& outIndices)
+{
+	// Curved blades around the center, single sided strips seen from both sides: their normals lean up so both faces are lit alike
+	const uint32_t bladeCount = lod == 0 ? 7 : 3;
+	const uint32_t segmentCount = lod == 0 ? 3 : 1;
+	for (uint32_t blade = 0; blade < bladeCount; ++blade)
+	{
+		const float angle = static_cast<float>(blade) * 2.39996323f; // golden angle
+		const float height = 0.45f + 0.25f * std::fmod(static_cast<float>(blade) * 0.618034f, 1.0f);
+		const glm::vec3 leanDirection(std::cos(angle), 0.0f, std::sin(angle));
+		const glm::vec3 widthDirection(-leanDirection.z, 0.0f, leanDirection.x);
+		const glm::vec3 base = leanDirection * (0.08f * std::sqrt((static_cast<float>(blade) + 0.5f) / static_cast<float>(bladeCount)));
+		const glm::vec3 normal = glm::normalize(leanDirection + glm::vec3(0.0f, 1.5f, 0.0f));
+
+		// segmentCount rows of 2 vertices, then the tip
+		const uint32_t firstVertex = static_cast<uint32_t>(outVertices.size());
+		for (uint32_t row = 0; row <= segmentCount; ++row)
+		{
+			const float t = static_cast<float>(row) / static_cast<float>(segmentCount);
+			const glm::vec3 center = base + leanDirection * (0.35f * height * t * t) + glm::vec3(0.0f, height * t, 0.0f);
+			const uint32_t color = packColor(glm::mix(glm::vec3(0.15f, 0.35f, 0.05f), glm::vec3(0.45f, 0.7f, 0.2f), t));
+			if (row == segmentCount)
+			{
+				outVertices.push_back({ center, normal, color });
+				break;
+			}
+
+			const float halfWidth = 0.035f * (1.0f - t);
+			outVertices.push_back({ center - widthDirection * halfWidth, normal, color });
+			outVertices.push_back({ center + widthDirection * halfWidth, normal, color });
+		}
+		for (uint32_t row = 0; row + 1 < segmentCount; ++row)
+		{
+			const uint32_t corner = firstVertex + 2 * row;
+			outIndices.insert(outIndices.end(), { corner, corner + 1, corner + 2, corner + 1, corner + 3, corner + 2 });
+		}
+		const uint32_t lastRow = firstVertex + 2 * (segmentCount - 1);
+		outIndices.insert(outIndices.end(), { lastRow, lastRow + 1, lastRow + 2 });
+	}
+}
+
+void TerrainVegetation::buildConifer(uint32_t lod, std::vector<PropVertex>& outVertices, std::vector<uint32_t>& outIndices)
+{
+	// The trunk starts under the ground for the slopes
+	const uint32_t trunkColor = packColor(glm::vec3(0.35f, 0.22f, 0.12f));
+	const uint32_t foliageColor = packColor(glm::vec3(0.1f, 0.3f, 0.12f));
+	addCone(glm::vec3(0.0f, -0.2f, 0.0f), 0.18f, 0.12f, 1.4f, lod == 0 ? 8 : 4, false, trunkColor, outVertices, outIndices);
+	if (lod == 0)
+	{
+		addCone(glm::vec3(0.0f, 0.8f, 0.0f), 1.3f, 0.0f, 2.0f, 10, true, foliageColor, outVertices, outIndices);
+		addCone(glm::vec3(0.0f, 1.9f, 0.0f), 1.0f, 0.0f, 1.7f, 10, true, foliageColor, outVertices, outIndices);
+		addCone(glm::vec3(0.0f, 2.9f, 0.0f), 0.7f, 0.0f, 1.6f, 10, true, foliageColor, outVertices, outIndices);
+	}
+	else
+		addCone(glm::vec3(0.0f, 0.8f, 0.0f), 1.2f, 0.0f, 3.7f, 6, true, foliageColor, outVertices, outIndices);
+}
+
+void TerrainVegetation::buildRock(uint32_t lod, std::vector<PropVertex>& outVertices, std::vector<uint32_t>& outIndices)
+{
+	// Bumpy flattened ellipsoid, half buried: poles, then rings of segmentCount vertices. The bumps are a function of the direction, the same for both LODs
+	const uint32_t ringCount = lod == 0 ? 6 : 3;
+	const uint32_t segmentCount = lod == 0 ? 10 : 5;
+	const glm::vec3 radii(0.8f, 0.55f, 0.7f);
+	const glm::vec3 center(0.0f, 0.15f, 0.0f);
+
+	auto addVertex = [&](float theta, float phi)
+	{
+		const glm::vec3 direction(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+		const float bump = 1.0f + 0.15f * std::sin(3.0f * phi + 1.3f) * std::sin(2.0f * theta + 0.4f);
+		const glm::vec3 position = center + direction * radii * bump;
+		const uint32_t color = packColor(glm::vec3(0.42f, 0.4f, 0.38f) * (0.8f + 0.2f * direction.y));
+		outVertices.push_back({ position, glm::normalize(direction / radii), color });
+	};
+
+	const float pi = 3.14159265f;
+	const uint32_t topPole = static_cast<uint32_t>(outVertices.size());
+	addVertex(0.0f, 0.0f);
+	for (uint32_t ring = 1; ring < ringCount; ++ring)
+		for (uint32_t segment = 0; segment < segmentCount; ++segment)
+			addVertex(pi * static_cast<float>(ring) / static_cast<float>(ringCount), 2.0f * pi * static_cast<float>(segment) / static_cast<float>(segmentCount));
+	const uint32_t bottomPole = static_cast<uint32_t>(outVertices.size());
+	addVertex(pi, 0.0f);
+
+	auto ringVertex = [&](uint32_t ring, uint32_t segment) { return topPole + 1 + (ring - 1) * segmentCount + segment % segmentCount; };
+	for (uint32_t segment = 0; segment < segmentCount; ++segment)
+	{
+		outIndices.insert(outIndices.end(), { topPole, ringVertex(1, segment + 1), ringVertex(1, segment) });
+		for (uint32_t ring = 1; ring + 1 < ringCount; ++ring)
+			outIndices.insert(outIndices.end(), { ringVertex(ring, segment), ringVertex(ring, segment + 1), ringVertex(ring + 1, segment),
+				ringVertex(ring, segment + 1), ringVertex(ring + 1, segment + 1), ringVertex(ring + 1, segment) });
+		outIndices.insert(outIndices.end(), { ringVertex(ringCount - 1, segment), ringVertex(ringCount - 1, segment + 1), bottomPole });
+	}
+}
+
+void TerrainVegetation::addCone(const glm::vec3& base, float baseRadius, float topRadius, float height, uint32_t sideCount, bool baseCap, uint32_t color,
+	std::vector<PropVertex>& outVertices, std::vector<uint32_t>& outIndices)
+{
+	// Side: a base and a top vertex per direction, with the normal of the side
+	const uint32_t firstVertex = static_cast<uint32_t>(outVertices.size());
+	for (uint32_t side = 0; side < sideCount; ++side)
+	{
+		const float angle = 6.28318531f * static_cast<float>(side) / static_cast<float>(sideCount);
+		const glm::vec3 direction(std::cos(angle), 0.0f, std::sin(angle));
+		const glm::vec3 normal = glm::normalize(direction + glm::vec3(0.0f, (baseRadius - topRadius) / height, 0.0f));
+		outVertices.push_back({ base + direction * baseRadius, normal, color });
+		outVertices.push_back({ base + direction * topRadius + glm::vec3(0.0f, height, 0.0f), normal, color });
+	}
+	for (uint32_t side = 0; side < sideCount; ++side)
+	{
+		const uint32_t current = firstVertex + 2 * side;
+		const uint32_t next = firstVertex + 2 * ((side + 1) % sideCount);
+		outIndices.insert(outIndices.end(), { current, current + 1, next, next, current + 1, next + 1 });
+	}
+	if (!baseCap)
+		return;
+
+	// Base: a fan with its own vertices, facing down
+	const uint32_t capCenter = static_cast<uint32_t>(outVertices.size());
+	outVertices.push_back({ base, glm::vec3(0.0f, -1.0f, 0.0f), color });
+	for (uint32_t side = 0; side < sideCount; ++side)
+		outVertices.push_back({ outVertices[firstVertex + 2 * side].position, glm::vec3(0.0f, -1.0f, 0.0f), color });
+	for (uint32_t side = 0; side < sideCount; ++side)
+		outIndices.insert(outIndices.end(), { capCenter, capCenter + 1 + side, capCenter + 1 + (side + 1) % sideCount });
+}
+
+uint32_t TerrainVegetation::packColor(const glm::vec3& color)
+{
+	const glm::uvec3 channels = glm::uvec3(glm::clamp(color, 0.0f, 1.0f) * 255.0f + 0.5f);
+	return channels.r | (channels.g << 8) | (channels.b << 16) | (255u << 24);
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <vector>
+
+#include <WolfEngine.h>
+
+#include "HeightField.h"
+#include "TerrainMeshBuilder.h"
+#include "TerrainScatter.h"
+#include "ThreadPool.h"
+
+#define TERRAIN_VEGETATION_LOD_COUNT 2 // meshes per prop. Must match Shaders/vegetation/cull.comp
+#define TERRAIN_VEGETATION_MAX_PROP_COUNT 4 // Must match Shaders/vegetation/cull.comp
+#define TERRAIN_VEGETATION_CULL_GROUP_SIZE 64 // Must match the local size of Shaders/vegetation/cull.comp
+#define TERRAIN_VEGETATION_MAX_ROW_LENGTH 65536u // instances per row of the culling dispatch, which keeps its group count under the guaranteed limit
+
+// Grass, trees and rocks scattered once by TerrainScatter, then culled on the GPU: every frame a compute pass tests each instance against the
+// frustum, picks its LOD from its distance and appends it to the instances of one indirect draw per (prop, LOD). The CPU only writes the camera.
+// The instances of prop p and LOD l are written from the first instance of their draw, sum of the previous counts * LOD count + l * count, so an
+// instance can always be appended to the LOD it selects
+class TerrainVegetation
+{
+public:
+	TerrainVegetation(Wolf::WolfInstance* wolfInstance, Wolf::Scene* scene, int renderPassID, const HeightField& heightField, const TerrainMeshBuilder::GridInfo& gridInfo,
+		ThreadPool* threadPool);
+
+	void update(const glm::mat4& viewProjection, const glm::vec3& cameraPosition);
+
+	// Culling, to submit before the command buffer drawing the render pass. Nothing is added to the scene when no instance was scattered
+	int getCommandBufferID() const { return m_commandBufferID; }
+	uint32_t getInstanceCount() const { return m_instanceCount; }
+
+private:
+	struct PropVertex
+	{
+		glm::vec3 position;
+		glm::vec3 normal;
+		uint32_t color; // R8G8B8A8_UNORM
+
+		static VkVertexInputBindingDescription getBindingDescription(uint32_t binding)
+		{
+			VkVertexInputBindingDescription bindingDescription = {};
+			bindingDescription.binding = binding;
+			bindingDescription.stride = sizeof(PropVertex);
+			bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+			return bindingDescription;
+		}
+
+		static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions(uint32_t binding)
+		{
+			std::vector<VkVertexInputAttributeDescription> attributeDescriptions(3);
+
+			attributeDescriptions[0].binding = binding;
+			attributeDescriptions[0].location = 0;
+			attributeDescriptions[0].format = VK_FORMAT_R32G32B32_SFLOAT;
+			attributeDescriptions[0].offset = offsetof(PropVertex, position);
+
+			attributeDescriptions[1].binding = binding;
+			attributeDescriptions[1].location = 1;
+			attributeDescriptions[1].format = VK_FORMAT_R32G32B32_SFLOAT;
+			attributeDescriptions[1].offset = offsetof(PropVertex, normal);
+
+			attributeDescriptions[2].binding = binding;
+			attributeDescriptions[2].location = 2;
+			attributeDescriptions[2].format = VK_FORMAT_R8G8B8A8_UNORM;
+			attributeDescriptions[2].offset = offsetof(PropVertex, color);
+
+			return attributeDescriptions;
+		}
+
+		bool operator==(const PropVertex& other) const
+		{
+			return position == other.position && normal == other.normal && color == other.color;
+		}
+	};
+
+	struct Prop
+	{
+		TerrainScatter::Layer layer;
+		glm::vec2 lodDistances; // LOD 1 beyond x, culled beyond y, in world units for a scale of 1
+	};
+
+	// Procedural meshes of the props, y up from the ground at 0, appended to outVertices and outIndices
+	static void buildGrassTuft(uint32_t lod, std::vector<PropVertex>& outVertices, std::vector<uint32_t>& outIndices);
+	static void buildConifer(uint32_t lod, std::vector<PropVertex>& outVertices, std::vector<uint32_t>& outIndices);
+	static void buildRock(uint32_t lod, std::vector<PropVertex>& outVertices, std::vector<uint32_t>& outIndices);
+	// Side of a truncated cone along y, closed at the base when baseCap is set
+	static void addCone(const glm::vec3& base, float baseRadius, float topRadius, float height, uint32_t sideCount, bool baseCap, uint32_t color,
+		std::vector<PropVertex>& outVertices, std::vector<uint32_t>& outIndices);
+	static uint32_t packColor(const glm::vec3& color);
+
+	static void recordResetDrawCommands(void* vegetation, VkCommandBuffer commandBuffer);
+
+private:
+	int m_commandBufferID = -1;
+	uint32_t m_instanceCount = 0;
+
+	struct GPUProp
+	{
+		glm::vec4 boundingSphere; // center and radius in mesh space
+		glm::vec4 lodDistances;
+		glm::uvec4 ranges; // first instance, instance count, first draw command
+	};
+	struct UniformBufferData
+	{
+		glm::mat4 viewProjection;
+		glm::vec4 frustumPlanes[6]; // inside when dot(plane.xyz, position) + plane.w >= 0
+		glm::vec4 cameraPosition;
+		glm::uvec4 counts; // instance count, prop count, row length of the dispatch
+		GPUProp props[TERRAIN_VEGETATION_MAX_PROP_COUNT];
+	};
+	UniformBufferData m_ubData;
+	Wolf::UniformBuffer* m_ub;
+
+	Wolf::Model* m_model;
+	Wolf::Instance<Wolf::InstanceTransform>* m_placements; // all instances, sorted by prop
+	Wolf::Buffer* m_visibleInstanceBuffer;
+	Wolf::Instance<Wolf::InstanceTransform>* m_visibleInstances;
+	// Reset from the template at the start of the culling: instance counts of 0, the LOD index ranges and the first instances never change
+	Wolf::Buffer* m_drawCommands;
+	Wolf::UniformBuffer* m_drawCommandsTemplate;
+	VkDeviceSize m_drawCommandsSize;
+};
@@ -0,0 +1,164 @@
+#include "TerrainViewshed.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+TerrainViewshed::TerrainViewshed(const HeightField& heightField, const TerrainMeshBuilder::GridInfo& gridInfo) : m_heightField(heightField), m_gridInfo(gridInfo)
+{
+}
+
+uint32_t TerrainViewshed::compute(const Observer& observer, std::vector<uint8_t>& outMask, ThreadPool* threadPool) const
+{
+	const int64_t resolution = m_heightField.getResolution();
+	outMask.assign(static_cast<size_t>(resolution * resolution), 0);
+
+	const int64_t observerI = std::min(std::max(static_cast<int64_t>(std::lround((observer.x - m_gridInfo.topLeftPos.x) / m_gridInfo.tileSize.x)),
+		static_cast<int64_t>(0)), resolution - 1);
+	const int64_t observerJ = std::min(std::max(static_cast<int64_t>(std::lround((observer.z - m_gridInfo.topLeftPos.z) / m_gridInfo.tileSize.z)),
+		static_cast<int64_t>(0)), resolution - 1);
+	const float eyeHeight = m_heightField.get(static_cast<uint32_t>(observerI), static_cast<uint32_t>(observerJ)) * m_gridInfo.maxHeight + observer.observerHeight;
+	outMask[static_cast<size_t>(observerI * resolution + observerJ)] = 1;
+
+	// The square reaches the farthest sample of the heightfield, or of the maximum distance
+	int64_t radius = std::max(std::max(observerI, resolution - 1 - observerI), std::max(observerJ, resolution - 1 - observerJ));
+	const double maxDistanceSamples = static_cast<double>(observer.maxDistance) / std::min(m_gridInfo.tileSize.x, m_gridInfo.tileSize.z);
+	if (maxDistanceSamples < static_cast<double>(radius))
+		radius = static_cast<int64_t>(maxDistanceSamples);
+	if (radius == 0)
+		return 1;
+
+	// Sector boundaries at equal shares of the total cost of the rays (their steps inside the heightfield, plus one for the ray itself)
+	const int64_t rayCount = 8 * radius;
+	const int64_t sectorCount = std::min(static_cast<int64_t>(TERRAIN_VIEWSHED_SECTOR_COUNT), rayCount);
+	std::vector<int64_t> rayCostSums(static_cast<size_t>(rayCount) + 1, 0);
+	for (int64_t p = 0; p < rayCount; ++p)
+		rayCostSums[p + 1] = rayCostSums[p] + getRayStepCount(p, radius, observerI, observerJ) + 1;
+	std::vector<int64_t> sectorFirstRays(static_cast<size_t>(sectorCount) + 1, rayCount);
+	for (int64_t sector = 0; sector < sectorCount; ++sector)
+		sectorFirstRays[sector] = std::lower_bound(rayCostSums.begin(), rayCostSums.end() - 1, sector * rayCostSums[rayCount] / sectorCount) - rayCostSums.begin();
+
+	std::vector<uint32_t> visibleCounts(static_cast<size_t>(sectorCount), 0);
+	auto computeSector = [&](uint32_t sector)
+	{
+		for (int64_t p = sectorFirstRays[sector]; p < sectorFirstRays[sector + 1]; ++p)
+			visibleCounts[sector] += castRay(p, radius, observerI, observerJ, eyeHeight, observer, outMask.data());
+	};
+	if (threadPool)
+		threadPool->parallelFor(static_cast<uint32_t>(sectorCount), computeSector);
+	else
+	{
+		for (uint32_t sector = 0; sector < sectorCount; ++sector)
+			computeSector(sector);
+	}
+
+	uint32_t visibleCount = 1;
+	for (uint32_t count : visibleCounts)
+		visibleCount += count;
+	return visibleCount;
+}
+
+void TerrainViewshed::getPerimeterOffset(int64_t p, int64_t radius, int64_t& outI, int64_t& outJ)
+{
+	const int64_t side = p / (2 * radius);
+	const int64_t q = p % (2 * radius);
+	switch (side)
+	{
+	case 0: outI = radius; outJ = q - radius; break;
+	case 1: outI = radius - q; outJ = radius; break;
+	case 2: outI = -radius; outJ = radius - q; break;
+	default: outI = q - radius; outJ = -radius; break;
+	}
+}
+
+int64_t TerrainViewshed::getRayStepCount(int64_t p, int64_t radius, int64_t observerI, int64_t observerJ) const
+{
+	const int64_t resolution = m_heightField.getResolution();
+	int64_t targetI, targetJ;
+	getPerimeterOffset(p, radius, targetI, targetJ);
+	const int64_t side = p / (2 * radius);
+	const bool majorI = side == 0 || side == 2;
+	const int64_t targetMajor = majorI ? targetI : targetJ;
+	const int64_t targetMinor = majorI ? targetJ : targetI;
+	const int64_t observerMajor = majorI ? observerI : observerJ;
+	const int64_t observerMinor = majorI ? observerJ : observerI;
+
+	int64_t stepCount = std::min(radius, targetMajor > 0 ? resolution - 1 - observerMajor : observerMajor);
+	if (targetMinor != 0)
+	{
+		// The minor sample round(s * targetMinor / R) stays inside while s * |targetMinor| / R < minorRoom + 1 / 2
+		const int64_t minorRoom = targetMinor > 0 ? resolution - 1 - observerMinor : observerMinor;
+		stepCount = std::min(stepCount, ((2 * minorRoom + 1) * radius - 1) / (2 * std::abs(targetMinor)));
+	}
+	return stepCount;
+}
+
+uint32_t TerrainViewshed::castRay(int64_t p, int64_t radius, int64_t observerI, int64_t observerJ, float eyeHeight, const Observer& observer, uint8_t* mask) const
+{
+	const int64_t resolution = m_heightField.getResolution();
+	int64_t targetI, targetJ;
+	getPerimeterOffset(p, radius, targetI, targetJ);
+	const int64_t side = p / (2 * radius);
+	const bool majorI = side == 0 || side == 2;
+	const int64_t majorSign = majorI ? (targetI > 0 ? 1 : -1) : (targetJ > 0 ? 1 : -1);
+	const int64_t targetMinor = majorI ? targetJ : targetI;
+	const double majorTileSize = majorI ? m_gridInfo.tileSize.x : m_gridInfo.tileSize.z;
+	const double minorTileSize = majorI ? m_gridInfo.tileSize.z : m_gridInfo.tileSize.x;
+	const double maxDistanceSquared = static_cast<double>(observer.maxDistance) * observer.maxDistance;
+
+	// The point of the ray at step s is s times this far from the observer
+	const double minorStep = static_cast<double>(targetMinor) / static_cast<double>(radius);
+	const double rayStepLength = std::sqrt(majorTileSize * majorTileSize + minorStep * minorTileSize * minorStep * minorTileSize);
+
+	auto getHeight = [&](int64_t major, int64_t minor)
+	{
+		const int64_t i = majorI ? observerI + majorSign * major : observerI + minor;
+		const int64_t j = majorI ? observerJ + minor : observerJ + majorSign * major;
+		return static_cast<double>(m_heightField.get(static_cast<uint32_t>(i), static_cast<uint32_t>(j))) * m_gridInfo.maxHeight;
+	};
+
+	uint32_t visibleCount = 0;
+	double maxSlope = -std::numeric_limits<double>::infinity();
+	for (int64_t s = 1; s <= radius; ++s)
+	{
+		const double minor = minorStep * static_cast<double>(s);
+		const int64_t minorSample = static_cast<int64_t>(std::floor(minor + 0.5));
+		const int64_t i = majorI ? observerI + majorSign * s : observerI + minorSample;
+		const int64_t j = majorI ? observerJ + minorSample : observerJ + majorSign * s;
+		if (i < 0 || i >= resolution || j < 0 || j >= resolution)
+			break;
+
+		// This ray tests the sample if it's the one aimed at the projection of the sample on the perimeter: round(minorSample * R / s) is its
+		// minor target, and the sample is on the side of the ray (the corners belong to the side they start)
+		const bool onSide = (side == 0 || side == 3) ? minorSample < s : minorSample > -s;
+		const int64_t scaledMinor = 2 * minorSample * radius;
+		if (onSide && scaledMinor >= 2 * targetMinor * s - s && scaledMinor < 2 * targetMinor * s + s)
+		{
+			const double majorDistance = static_cast<double>(s) * majorTileSize;
+			const double minorDistance = static_cast<double>(minorSample) * minorTileSize;
+			const double distanceSquared = majorDistance * majorDistance + minorDistance * minorDistance;
+			if (distanceSquared <= maxDistanceSquared &&
+				(getHeight(s, minorSample) + observer.targetHeight - eyeHeight) / std::sqrt(distanceSquared) >= maxSlope)
+			{
+				mask[i * resolution + j] = 1;
+				++visibleCount;
+			}
+		}
+
+		// The horizon only rises after the test, a sample doesn't hide itself
+		const int64_t minorFloor = static_cast<int64_t>(std::floor(minor));
+		const double weight = minor - static_cast<double>(minorFloor);
+		const int64_t minorFloorSample = (majorI ? observerJ : observerI) + minorFloor;
+		double height;
+		if (minorFloorSample < 0)
+			height = getHeight(s, minorFloor + 1);
+		else
+		{
+			height = getHeight(s, minorFloor);
+			if (weight > 0.0 && minorFloorSample + 1 < resolution)
+				height += (getHeight(s, minorFloor + 1) - height) * weight;
+		}
+		maxSlope = std::max(maxSlope, (height - eyeHeight) / (static_cast<double>(s) * rayStepLength));
+	}
+	return visibleCount;
+}
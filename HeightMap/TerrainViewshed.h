@@ -0,0 +1,48 @@
+#pragma once
+
+#include <limits>
+#include <vector>
+
+#include "HeightField.h"
+#include "TerrainMeshBuilder.h"
+#include "ThreadPool.h"
+
+#define TERRAIN_VIEWSHED_SECTOR_COUNT 64 // angular sectors computed concurrently
+
+// Visibility mask of the terrain seen from an observer, by a radial sweep (R2): one ray from the observer to each sample of the square of radius R
+// around it, marched one sample of its major axis at a time while tracking the highest slope seen so far (the horizon, from the heights
+// interpolated on the ray). A sample is tested by a single ray, the one aimed at its projection on the square, which always goes through it:
+// the sectors of consecutive rays run concurrently without sharing a sample, and the mask doesn't depend on the thread count. The sectors have
+// about the same number of steps: near a border of the heightfield, most rays leave it early and a sector gets more of them.
+// Point to point line of sight is TerrainHeightPyramid::isVisible
+class TerrainViewshed
+{
+public:
+	struct Observer
+	{
+		float x = 0.0f; // world position, on the nearest sample
+		float z = 0.0f;
+		float observerHeight = 2.0f; // eye above the terrain, in world units
+		float targetHeight = 0.0f; // the point tested above each sample, in world units
+		float maxDistance = std::numeric_limits<float>::max(); // horizontal, in world units
+	};
+
+	TerrainViewshed(const HeightField& heightField, const TerrainMeshBuilder::GridInfo& gridInfo);
+
+	// outMask[i * resolution + j] is 1 where the sample (i, j) is visible, 0 elsewhere. Returns the visible sample count.
+	// A null thread pool computes on the calling thread
+	uint32_t compute(const Observer& observer, std::vector<uint8_t>& outMask, ThreadPool* threadPool) const;
+
+private:
+	// Sample of the square of radius R at perimeter index p in [0, 8R[. The sides run along +j at i = R, then -i at j = R, -j at i = -R and +i at
+	// j = -R, each with the corner it starts from. Sides 0 and 2 march along i, sides 1 and 3 along j
+	static void getPerimeterOffset(int64_t p, int64_t radius, int64_t& outI, int64_t& outJ);
+	// Steps of the ray to the perimeter index p before it leaves the heightfield, as castRay marches them (up to rounding at the minor border)
+	int64_t getRayStepCount(int64_t p, int64_t radius, int64_t observerI, int64_t observerJ) const;
+	// Marches the ray to the perimeter index p, marks the visible samples it tests and returns their count
+	uint32_t castRay(int64_t p, int64_t radius, int64_t observerI, int64_t observerJ, float eyeHeight, const Observer& observer, uint8_t* mask) const;
+
+private:
+	const HeightField& m_heightField;
+	TerrainMeshBuilder::GridInfo m_gridInfo;
+};
@@ -0,0 +1,45 @@
+#include "TerrainWater.h"
+
+#include <algorithm>
+
+TerrainWater::TerrainWater(Wolf::WolfInstance* wolfInstance, const HeightField& heightField, const TerrainMeshBuilder::GridInfo& gridInfo,
+	const ShallowWater::Parameters& parameters, ThreadPool* threadPool) : m_simulation(heightField, gridInfo, parameters, threadPool)
+{
+	const uint32_t resolution = m_simulation.getResolution();
+	m_image = wolfInstance->createImage({ resolution, resolution, 1 }, VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT, VK_FORMAT_R32_SFLOAT,
+		VK_SAMPLE_COUNT_1_BIT, VK_IMAGE_ASPECT_COLOR_BIT);
+	uploadDepths(0, resolution);
+}
+
+void TerrainWater::update(float elapsedSeconds)
+{
+	m_accumulatedSeconds += elapsedSeconds;
+	uint32_t stepCount = 0;
+	for (; m_accumulatedSeconds >= SHALLOW_WATER_TIMESTEP && stepCount < TERRAIN_WATER_MAX_STEPS_PER_UPDATE; ++stepCount)
+	{
+		m_simulation.step();
+		m_accumulatedSeconds -= SHALLOW_WATER_TIMESTEP;
+	}
+	m_accumulatedSeconds = std::min(m_accumulatedSeconds, SHALLOW_WATER_TIMESTEP);
+	if (stepCount == 0)
+		return;
+
+	// The rows wet now, and the ones wet at the last upload that may have dried since
+	uint32_t firstRow, endRow;
+	m_simulation.getWetRows(firstRow, endRow);
+	const uint32_t uploadFirstRow = std::min(firstRow, m_uploadedFirstRow);
+	const uint32_t uploadEndRow = std::max(endRow, m_uploadedEndRow);
+	m_uploadedFirstRow = firstRow;
+	m_uploadedEndRow = endRow;
+	if (uploadFirstRow < uploadEndRow)
+		uploadDepths(uploadFirstRow, uploadEndRow);
+}
+
+void TerrainWater::uploadDepths(uint32_t firstRow, uint32_t endRow)
+{
+	const uint32_t resolution = m_simulation.getResolution();
+	std::vector<float> texels(static_cast<size_t>(endRow - firstRow) * resolution);
+	m_simulation.copyDepths(firstRow, endRow, texels.data());
+	m_image->copyFromPixels(texels.data(), sizeof(float), { 0, static_cast<int32_t>(firstRow) }, { resolution, endRow - firstRow },
+		VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+}
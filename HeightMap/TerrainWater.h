@@ -0,0 +1,31 @@
+#pragma once
+
+#include <WolfEngine.h>
+
+#include "ShallowWater.h"
+
+#define TERRAIN_WATER_MAX_STEPS_PER_UPDATE 4 // a slow frame drops simulated time instead of taking longer and longer
+
+// ShallowWater stepped at its fixed timestep whatever the frame rate. The depths, in world units, are uploaded to a R32_SFLOAT image sampled by
+// the terrain shading, texel (x = j, y = i) is the sample (i, j). Only the rows holding water, or that held some at the last upload, are uploaded
+class TerrainWater
+{
+public:
+	TerrainWater(Wolf::WolfInstance* wolfInstance, const HeightField& heightField, const TerrainMeshBuilder::GridInfo& gridInfo,
+		const ShallowWater::Parameters& parameters, ThreadPool* threadPool);
+
+	void update(float elapsedSeconds);
+
+	ShallowWater& getSimulation() { return m_simulation; }
+	Wolf::Image* getImage() const { return m_image; }
+
+private:
+	void uploadDepths(uint32_t firstRow, uint32_t endRow);
+
+private:
+	ShallowWater m_simulation;
+	Wolf::Image* m_image;
+	float m_accumulatedSeconds = 0.0f;
+	uint32_t m_uploadedFirstRow = 0;
+	uint32_t m_uploadedEndRow = 0;
+};
@@ -0,0 +1,131 @@
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(uint32_t threadCount)
+{
+	if (threadCount == 0)
+		threadCount = 1;
+
+	for (uint32_t i = 0; i < threadCount; ++i)
+		m_queues.push_back(std::make_unique<WorkQueue>());
+
+	for (uint32_t i = 0; i < threadCount; ++i)
+		m_workers.emplace_back(&ThreadPool::workerLoop, this, i);
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_wakeMutex);
+		m_stop = true;
+	}
+	m_wakeCondition.notify_all();
+
+	for (std::thread& worker : m_workers)
+		worker.join();
+}
+
+void ThreadPool::submit(std::function<void()> job)
+{
+	const uint32_t queueIndex = m_nextQueue++ % static_cast<uint32_t>(m_queues.size());
+
+	// Count the job before it becomes visible so a thief can never decrement below zero
+	{
+		std::lock_guard<std::mutex> lock(m_wakeMutex);
+		++m_pendingJobCount;
+	}
+	{
+		std::lock_guard<std::mutex> lock(m_queues[queueIndex]->mutex);
+		m_queues[queueIndex]->jobs.push_back(std::move(job));
+	}
+	m_wakeCondition.notify_one();
+}
+
+void ThreadPool::parallelFor(uint32_t count, const std::function<void(uint32_t)>& job)
+{
+	if (count == 0)
+		return;
+
+	std::atomic<uint32_t> remainingJobCount{ count };
+
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		submit([&, i]()
+		{
+			job(i);
+
+			// The locals of parallelFor may be gone once the count reaches 0, only the members are used after it
+			if (--remainingJobCount == 0)
+			{
+				{
+					std::lock_guard<std::mutex> lock(m_wakeMutex);
+				}
+				m_wakeCondition.notify_all();
+			}
+		});
+	}
+
+	// Help the workers instead of sleeping until every job of this call is done: the jobs submitted meanwhile by nested parallelFor calls
+	// of the other threads are run too, so a thread waiting here never leaves queued work behind
+	const uint32_t startQueue = m_nextQueue % static_cast<uint32_t>(m_queues.size());
+	std::function<void()> stolenJob;
+	while (remainingJobCount > 0)
+	{
+		if (popJob(startQueue, stolenJob))
+		{
+			stolenJob();
+			continue;
+		}
+
+		// Nothing to steal: sleep until a job is submitted or the last job of this call completes
+		std::unique_lock<std::mutex> lock(m_wakeMutex);
+		m_wakeCondition.wait(lock, [this, &remainingJobCount] { return remainingJobCount == 0 || m_pendingJobCount > 0; });
+	}
+}
+
+void ThreadPool::workerLoop(uint32_t queueIndex)
+{
+	std::function<void()> job;
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_wakeMutex);
+			m_wakeCondition.wait(lock, [this] { return m_stop || m_pendingJobCount > 0; });
+			if (m_stop && m_pendingJobCount == 0)
+				return;
+		}
+
+		if (popJob(queueIndex, job))
+			job();
+		else
+			std::this_thread::yield();
+	}
+}
+
+bool ThreadPool::popJob(uint32_t queueIndex, std::function<void()>& job)
+{
+	const uint32_t queueCount = static_cast<uint32_t>(m_queues.size());
+
+	// Own queue first (LIFO keeps the data hot), then steal the oldest job of the others
+	for (uint32_t offset = 0; offset < queueCount; ++offset)
+	{
+		WorkQueue& queue = *m_queues[(queueIndex + offset) % queueCount];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (queue.jobs.empty())
+			continue;
+
+		if (offset == 0)
+		{
+			job = std::move(queue.jobs.back());
+			queue.jobs.pop_back();
+		}
+		else
+		{
+			job = std::move(queue.jobs.front());
+			queue.jobs.pop_front();
+		}
+		--m_pendingJobCount;
+		return true;
+	}
+
+	return false;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work-stealing thread pool: each worker owns a queue, pops its own jobs from the back and steals from the front of the others when empty
+class ThreadPool
+{
+public:
+	ThreadPool(uint32_t threadCount = std::thread::hardware_concurrency());
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	void submit(std::function<void()> job);
+
+	// Run job(0) ... job(count - 1) on the pool and wait for all of them, the calling thread runs queued jobs while it waits (safe to nest)
+	void parallelFor(uint32_t count, const std::function<void(uint32_t)>& job);
+
+	uint32_t getThreadCount() const { return static_cast<uint32_t>(m_workers.size()); }
+
+private:
+	void workerLoop(uint32_t queueIndex);
+	bool popJob(uint32_t queueIndex, std::function<void()>& job);
+
+private:
+	struct WorkQueue
+	{
+		std::mutex mutex;
+		std::deque<std::function<void()>> jobs;
+	};
+	std::vector<std::unique_ptr<WorkQueue>> m_queues;
+	std::vector<std::thread> m_workers;
+
+	std::mutex m_wakeMutex;
+	std::condition_variable m_wakeCondition;
+	std::atomic<uint32_t> m_pendingJobCount{ 0 };
+	std::atomic<uint32_t> m_nextQueue{ 0 };
+	bool m_stop = false;
+};
@@ -0,0 +1,182 @@
+#include "ValueNoiseKernel.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define VALUE_NOISE_KERNEL_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// MSVC accepts any intrinsic in any function, GCC and Clang need the target to be enabled per function
+#if defined(VALUE_NOISE_KERNEL_X86) && !defined(_MSC_VER)
+#define VALUE_NOISE_KERNEL_TARGET_AVX __attribute__((target("avx")))
+#else
+#define VALUE_NOISE_KERNEL_TARGET_AVX
+#endif
+
+ValueNoiseKernel::InstructionSet ValueNoiseKernel::getBestInstructionSet()
+{
+	static const InstructionSet bestInstructionSet = []()
+	{
+#if defined(VALUE_NOISE_KERNEL_X86)
+#if defined(_MSC_VER)
+		int cpuInfo[4];
+		__cpuid(cpuInfo, 1);
+		const bool osUsesXSave = (cpuInfo[2] & (1 << 27)) != 0;
+		const bool cpuHasAVX = (cpuInfo[2] & (1 << 28)) != 0;
+		if (osUsesXSave && cpuHasAVX && (_xgetbv(0) & 0x6) == 0x6)
+			return InstructionSet::AVX;
+		if (cpuInfo[3] & (1 << 25))
+			return InstructionSet::SSE;
+#else
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx"))
+			return InstructionSet::AVX;
+		if (__builtin_cpu_supports("sse"))
+			return InstructionSet::SSE;
+#endif
+#endif
+		return InstructionSet::SCALAR;
+	}();
+
+	return bestInstructionSet;
+}
+
+const char* ValueNoiseKernel::getInstructionSetName(InstructionSet instructionSet)
+{
+	switch (instructionSet)
+	{
+	case InstructionSet::SSE:
+		return "SSE";
+	case InstructionSet::AVX:
+		return "AVX";
+	default:
+		return "Scalar";
+	}
+}
+
+void ValueNoiseKernel::accumulateRow(float* heights, const float* fragmentValues, uint32_t fragmentSizeLog2, const float* interpolationWeights, uint32_t count, float octaveWeight,
+	InstructionSet instructionSet)
+{
+	switch (instructionSet)
+	{
+	case InstructionSet::AVX:
+		accumulateRowAVX(heights, fragmentValues, fragmentSizeLog2, interpolationWeights, count, octaveWeight);
+		break;
+	case InstructionSet::SSE:
+		accumulateRowSSE(heights, fragmentValues, fragmentSizeLog2, interpolationWeights, count, octaveWeight);
+		break;
+	default:
+		accumulateRowScalar(heights, fragmentValues, fragmentSizeLog2, interpolationWeights, 0, count, octaveWeight);
+		break;
+	}
+}
+
+void ValueNoiseKernel::accumulateRowScalar(float* heights, const float* fragmentValues, uint32_t fragmentSizeLog2, const float* interpolationWeights, uint32_t first, uint32_t count,
+	float octaveWeight)
+{
+	for (uint32_t k = first; k < count; ++k)
+	{
+		const float startValue = fragmentValues[k >> fragmentSizeLog2];
+		const float endValue = fragmentValues[(k >> fragmentSizeLog2) + 1];
+		const float bilinearValue = startValue + interpolationWeights[k] * (endValue - startValue);
+		heights[k] += bilinearValue * octaveWeight;
+	}
+}
+
+void ValueNoiseKernel::accumulateRowSSE(float* heights, const float* fragmentValues, uint32_t fragmentSizeLog2, const float* interpolationWeights, uint32_t count, float octaveWeight)
+{
+#if defined(VALUE_NOISE_KERNEL_X86)
+	if (fragmentSizeLog2 == 0) // one fragment per texel, nothing to share between lanes
+	{
+		accumulateRowScalar(heights, fragmentValues, fragmentSizeLog2, interpolationWeights, 0, count, octaveWeight);
+		return;
+	}
+
+	const __m128 octaveWeights = _mm_set1_ps(octaveWeight);
+
+	uint32_t k = 0;
+	for (; k + 4 <= count; k += 4)
+	{
+		// Spread the fragment values over the lanes, a block of 4 texels covers 1 or 2 fragments
+		__m128 start;
+		__m128 end;
+		if (fragmentSizeLog2 >= 2)
+		{
+			start = _mm_set1_ps(fragmentValues[k >> fragmentSizeLog2]);
+			end = _mm_set1_ps(fragmentValues[(k >> fragmentSizeLog2) + 1]);
+		}
+		else
+		{
+			const uint32_t fragmentIndex = k >> 1;
+			start = _mm_setr_ps(fragmentValues[fragmentIndex], fragmentValues[fragmentIndex], fragmentValues[fragmentIndex + 1], fragmentValues[fragmentIndex + 1]);
+			end = _mm_setr_ps(fragmentValues[fragmentIndex + 1], fragmentValues[fragmentIndex + 1], fragmentValues[fragmentIndex + 2], fragmentValues[fragmentIndex + 2]);
+		}
+		const __m128 interpolationWeight = _mm_loadu_ps(interpolationWeights + k);
+
+		const __m128 bilinearValue = _mm_add_ps(start, _mm_mul_ps(interpolationWeight, _mm_sub_ps(end, start)));
+		_mm_storeu_ps(heights + k, _mm_add_ps(_mm_loadu_ps(heights + k), _mm_mul_ps(bilinearValue, octaveWeights)));
+	}
+
+	accumulateRowScalar(heights, fragmentValues, fragmentSizeLog2, interpolationWeights, k, count, octaveWeight);
+#else
+	accumulateRowScalar(heights, fragmentValues, fragmentSizeLog2, interpolationWeights, 0, count, octaveWeight);
+#endif
+}
+
+VALUE_NOISE_KERNEL_TARGET_AVX
+void ValueNoiseKernel::accumulateRowAVX(float* heights, const float* fragmentValues, uint32_t fragmentSizeLog2, const float* interpolationWeights, uint32_t count, float octaveWeight)
+{
+#if defined(VALUE_NOISE_KERNEL_X86)
+	if (fragmentSizeLog2 == 0) // one fragment per texel, nothing to share between lanes
+	{
+		accumulateRowScalar(heights, fragmentValues, fragmentSizeLog2, interpolationWeights, 0, count, octaveWeight);
+		return;
+	}
+
+	const __m256 octaveWeights = _mm256_set1_ps(octaveWeight);
+
+	// No FMA here: fused operations would round differently from the scalar path
+	uint32_t k = 0;
+	for (; k + 8 <= count; k += 8)
+	{
+		// Spread the fragment values over the lanes, a block of 8 texels covers 1, 2 or 4 fragments
+		__m256 start;
+		__m256 end;
+		if (fragmentSizeLog2 >= 3)
+		{
+			start = _mm256_set1_ps(fragmentValues[k >> fragmentSizeLog2]);
+			end = _mm256_set1_ps(fragmentValues[(k >> fragmentSizeLog2) + 1]);
+		}
+		else if (fragmentSizeLog2 == 2)
+		{
+			const __m128 values = _mm_loadu_ps(fragmentValues + (k >> 2)); // f, f + 1, f + 2, f + 3
+			start = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_shuffle_ps(values, values, _MM_SHUFFLE(0, 0, 0, 0))), _mm_shuffle_ps(values, values, _MM_SHUFFLE(1, 1, 1, 1)), 1);
+			end = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_shuffle_ps(values, values, _MM_SHUFFLE(1, 1, 1, 1))), _mm_shuffle_ps(values, values, _MM_SHUFFLE(2, 2, 2, 2)), 1);
+		}
+		else
+		{
+			const __m128 values = _mm_loadu_ps(fragmentValues + (k >> 1)); // f, f + 1, f + 2, f + 3
+			const __m128 nextValues = _mm_loadu_ps(fragmentValues + (k >> 1) + 1); // f + 1, ..., f + 4
+			start = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_unpacklo_ps(values, values)), _mm_unpackhi_ps(values, values), 1);
+			end = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_unpacklo_ps(nextValues, nextValues)), _mm_unpackhi_ps(nextValues, nextValues), 1);
+		}
+		const __m256 interpolationWeight = _mm256_loadu_ps(interpolationWeights + k);
+
+		const __m256 bilinearValue = _mm256_add_ps(start, _mm256_mul_ps(interpolationWeight, _mm256_sub_ps(end, start)));
+		_mm256_storeu_ps(heights + k, _mm256_add_ps(_mm256_loadu_ps(heights + k), _mm256_mul_ps(bilinearValue, octaveWeights)));
+	}
+
+	// Remainder stays in this function so it is VEX encoded too, calling the legacy SSE path here is much slower
+	for (; k < count; ++k)
+	{
+		const float startValue = fragmentValues[k >> fragmentSizeLog2];
+		const float endValue = fragmentValues[(k >> fragmentSizeLog2) + 1];
+		const float bilinearValue = startValue + interpolationWeights[k] * (endValue - startValue);
+		heights[k] += bilinearValue * octaveWeight;
+	}
+#else
+	accumulateRowScalar(heights, fragmentValues, fragmentSizeLog2, interpolationWeights, 0, count, octaveWeight);
+#endif
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+
+// Vectorized inner loop of the value noise: blends a whole row of interpolants at once
+class ValueNoiseKernel
+{
+public:
+	enum class InstructionSet { SCALAR, SSE, AVX };
+
+	static InstructionSet getBestInstructionSet();
+	static const char* getInstructionSetName(InstructionSet instructionSet);
+
+	// With f = k >> fragmentSizeLog2: heights[k] += mix(fragmentValues[f], fragmentValues[f + 1], interpolationWeights[k]) * octaveWeight
+	// The operation order is the one of glm::mix so all instruction sets give identical results
+	static void accumulateRow(float* heights, const float* fragmentValues, uint32_t fragmentSizeLog2, const float* interpolationWeights, uint32_t count, float octaveWeight,
+		InstructionSet instructionSet);
+
+private:
+	static void accumulateRowScalar(float* heights, const float* fragmentValues, uint32_t fragmentSizeLog2, const float* interpolationWeights, uint32_t first, uint32_t count,
+		float octaveWeight);
+	static void accumulateRowSSE(float* heights, const float* fragmentValues, uint32_t fragmentSizeLog2, const float* interpolationWeights, uint32_t count, float octaveWeight);
+	static void accumulateRowAVX(float* heights, const float* fragmentValues, uint32_t fragmentSizeLog2, const float* interpolationWeights, uint32_t count, float octaveWeight);
+};
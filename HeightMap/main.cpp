@@ -1,7 +1,96 @@
 #include "SystemManager.h"
 
-int main()
+#include <cstdlib>
+#include <cstring>
+
+int main(int argc, char** argv)
 {
-	SystemManager s;
+	// The Wolf instance sets it again once created, the messages about the arguments come before
+	Wolf::Debug::setCallback(SystemManager::debugCallback);
+
+	// HeightMap.exe bake resolution... writes the terrain caches and exits
+	if (argc > 1 && std::strcmp(argv[1], "bake") == 0)
+	{
+		std::vector<uint32_t> resolutions;
+		for (int i = 2; i < argc; ++i)
+		{
+			const uint32_t resolution = static_cast<uint32_t>(std::strtoul(argv[i], nullptr, 10));
+			if (::Scene::isHeightMapResolutionValid(resolution))
+				resolutions.push_back(resolution);
+			else
+				Wolf::Debug::sendError("Invalid heightmap resolution " + std::string(argv[i]));
+		}
+
+		ThreadPool threadPool;
+		TerrainTileCache::bake(resolutions, HEIGHMAP_TILE_SIZE, HEIGHMAP_CHUNK_SIZE, &threadPool);
+		return 0;
+	}
+
+	// HeightMap.exe [resolution] [mesh|displacement|adaptive|tessellation|clipmap] [cpu|gpu|gpu-verify|value|gradient|simplex|elevation file (.pgm, .raw)] [seed] [erosion] [props] [water] [progressive]
+	// value, gradient and simplex generate on the CPU with the seeded fractal noise, erosion erodes the generated heights, props scatters grass, trees and rocks.
+	// water simulates shallow water, poured with the right mouse button. progressive shows the coarse octaves of the CPU value noise first.
+	// erosion, props, water and progressive are always the last arguments
+	::Scene::SceneCreateInfo sceneCreateInfo;
+	if (argc > 1 && std::strcmp(argv[argc - 1], "progressive") == 0)
+	{
+		sceneCreateInfo.progressiveGeneration = true;
+		--argc;
+	}
+	if (argc > 1 && std::strcmp(argv[argc - 1], "water") == 0)
+	{
+		sceneCreateInfo.simulateWater = true;
+		--argc;
+	}
+	if (argc > 1 && std::strcmp(argv[argc - 1], "props") == 0)
+	{
+		sceneCreateInfo.scatterProps = true;
+		--argc;
+	}
+	if (argc > 1 && std::strcmp(argv[argc - 1], "erosion") == 0)
+	{
+		sceneCreateInfo.useErosion = true;
+		--argc;
+	}
+	if (argc > 1)
+		sceneCreateInfo.heightMapResolution = static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 10));
+	if (!::Scene::isHeightMapResolutionValid(sceneCreateInfo.heightMapResolution))
+	{
+		Wolf::Debug::sendError("Invalid heightmap resolution " + std::to_string(sceneCreateInfo.heightMapResolution) + ", using " + std::to_string(HEIGHMAP_DEFAULT_RES));
+		sceneCreateInfo.heightMapResolution = HEIGHMAP_DEFAULT_RES;
+	}
+	if (argc > 2 && std::strcmp(argv[2], "displacement") == 0)
+		sceneCreateInfo.terrainRenderMode = TerrainRenderMode::DISPLACEMENT;
+	else if (argc > 2 && std::strcmp(argv[2], "adaptive") == 0)
+		sceneCreateInfo.terrainRenderMode = TerrainRenderMode::ADAPTIVE;
+	else if (argc > 2 && std::strcmp(argv[2], "tessellation") == 0)
+		sceneCreateInfo.terrainRenderMode = TerrainRenderMode::TESSELLATION;
+	else if (argc > 2 && std::strcmp(argv[2], "clipmap") == 0)
+		sceneCreateInfo.terrainRenderMode = TerrainRenderMode::CLIPMAP;
+	if (argc > 3 && std::strcmp(argv[3], "gpu") == 0)
+		sceneCreateInfo.heightMapGeneration = HeightMapGeneration::GPU;
+	else if (argc > 3 && std::strcmp(argv[3], "gpu-verify") == 0)
+		sceneCreateInfo.heightMapGeneration = HeightMapGeneration::GPU_VERIFY;
+	else if (argc > 3 && std::strcmp(argv[3], "value") == 0)
+	{
+		sceneCreateInfo.useFractalNoise = true;
+		sceneCreateInfo.noiseParameters.type = FractalNoise::Type::VALUE;
+	}
+	else if (argc > 3 && std::strcmp(argv[3], "gradient") == 0)
+	{
+		sceneCreateInfo.useFractalNoise = true;
+		sceneCreateInfo.noiseParameters.type = FractalNoise::Type::GRADIENT;
+	}
+	else if (argc > 3 && std::strcmp(argv[3], "simplex") == 0)
+	{
+		sceneCreateInfo.useFractalNoise = true;
+		sceneCreateInfo.noiseParameters.type = FractalNoise::Type::SIMPLEX;
+	}
+	else if (argc > 3 && std::strcmp(argv[3], "cpu") != 0)
+		sceneCreateInfo.demFilename = argv[3];
+	if (sceneCreateInfo.useFractalNoise && argc > 4)
+		sceneCreateInfo.noiseParameters.seed = static_cast<uint32_t>(std::strtoul(argv[4], nullptr, 10));
+	sceneCreateInfo.erosionParameters.seed = sceneCreateInfo.noiseParameters.seed;
+
+	SystemManager s(sceneCreateInfo);
 	s.run();
 }
\ No newline at end of file
@@ -36,7 +36,7 @@ void Wolf::CommandBuffer::endCommandBuffer()
 }
 
 void Wolf::CommandBuffer::submit(VkDevice device, Queue queue, std::vector<Wolf::Semaphore*> waitSemaphores,
-	std::vector<VkSemaphore> signalSemaphores)
+	std::vector<VkSemaphore> signalSemaphores, VkFence fence)
 {
 	VkSubmitInfo submitInfo = {};
 	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
@@ -60,7 +60,7 @@ void Wolf::CommandBuffer::submit(VkDevice device, Queue queue, std::vector<Wolf:
 	submitInfo.pWaitDstStageMask = stages.data();
 
 	queue.mutex->lock();
-	if (vkQueueSubmit(queue.queue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+	if (vkQueueSubmit(queue.queue, 1, &submitInfo, fence) != VK_SUCCESS)
 	{
 		queue.mutex->unlock();
 		throw std::runtime_error("Error : submit to graphics queue");
@@ -15,7 +15,7 @@ namespace Wolf
 
 		void beginCommandBuffer();
 		void endCommandBuffer();
-		void submit(VkDevice device, Queue queue, std::vector<Wolf::Semaphore*> waitSemaphores, std::vector<VkSemaphore> signalSemaphores);
+		void submit(VkDevice device, Queue queue, std::vector<Wolf::Semaphore*> waitSemaphores, std::vector<VkSemaphore> signalSemaphores, VkFence fence = VK_NULL_HANDLE);
 
 		// Getter
 	public:
@@ -24,6 +24,11 @@ Wolf::ComputePass::ComputePass(VkDevice device, VkPhysicalDevice physicalDevice,
 	m_pipeline = std::make_unique<Pipeline>(device, std::move(computeShader), &m_descriptorSetLayout);
 }
 
+Wolf::ComputePass::~ComputePass()
+{
+	vkDestroyDescriptorSetLayout(m_device, m_descriptorSetLayout, nullptr);
+}
+
 void Wolf::ComputePass::create(VkDescriptorPool descriptorPool)
 {
 	m_descriptorSet = createDescriptorSet(m_device, m_descriptorSetLayout, descriptorPool, m_descriptorSetCreateInfo);
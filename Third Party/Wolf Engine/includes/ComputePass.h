@@ -18,6 +18,7 @@ namespace Wolf
 	public:
 		ComputePass(VkDevice device, VkPhysicalDevice physicalDevice, VkCommandPool commandPool, std::string computeShader,
 			DescriptorSetCreateInfo descriptorSetCreateInfo);
+		~ComputePass();
 
 		void create(VkDescriptorPool descriptorPool);
 		void record(VkCommandBuffer commandBuffer, VkExtent2D extent, VkExtent3D dispatchGroups);
@@ -29,7 +29,9 @@ void Wolf::DescriptorPool::allocate(VkDevice device)
 
 void Wolf::DescriptorPool::cleanup(VkDevice device)
 {
-	vkDestroyDescriptorPool(device, m_descriptorPool, nullptr);
+	if (m_descriptorPool != VK_NULL_HANDLE)
+		vkDestroyDescriptorPool(device, m_descriptorPool, nullptr);
+	m_descriptorPool = VK_NULL_HANDLE;
 }
 
 void Wolf::DescriptorPool::addDescriptorPoolSize(VkDescriptorType descriptorType, uint32_t descriptorCount,
@@ -35,7 +35,7 @@ namespace Wolf
 		unsigned int m_storageBufferCount = 0;
 		unsigned int m_accelerationStructureCount = 0;
 		
-		VkDescriptorPool m_descriptorPool;
+		VkDescriptorPool m_descriptorPool = VK_NULL_HANDLE; // not allocated without descriptors
 	};
 
 
@@ -4,6 +4,7 @@ Wolf::Image::Image(VkDevice device, VkPhysicalDevice physicalDevice, VkCommandPo
 	VkFormat format, VkSampleCountFlagBits sampleCount, VkImageAspectFlags aspect)
 {
 	m_device = device;
+	m_physicalDevice = physicalDevice;
 	m_commandPool = commandPool;
 	m_graphicsQueue = graphicsQueue;
 	
@@ -180,6 +181,106 @@ void Wolf::Image::setImageLayout(VkImageLayout newLayout, VkPipelineStageFlags s
 	m_imageLayout = newLayout;
 }
 
+void Wolf::Image::copyFromPixels(const void* pixels, uint32_t bytesPerPixel, VkOffset2D offset, VkExtent2D extent, VkPipelineStageFlags readingStage)
+{
+	copyFromPixels(pixels, bytesPerPixel, std::vector<VkRect2D>{ { offset, extent } }, readingStage);
+}
+
+void Wolf::Image::copyFromPixels(const void* pixels, uint32_t bytesPerPixel, const std::vector<VkRect2D>& regions, VkPipelineStageFlags readingStage)
+{
+	if (regions.empty())
+		return;
+
+	std::vector<VkBufferImageCopy> copies(regions.size());
+	VkDeviceSize regionSize = 0;
+	for (size_t i = 0; i < regions.size(); ++i)
+	{
+		copies[i].bufferOffset = regionSize;
+		copies[i].bufferRowLength = 0;
+		copies[i].bufferImageHeight = 0;
+
+		copies[i].imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		copies[i].imageSubresource.mipLevel = 0;
+		copies[i].imageSubresource.baseArrayLayer = 0;
+		copies[i].imageSubresource.layerCount = 1;
+
+		copies[i].imageOffset = { regions[i].offset.x, regions[i].offset.y, 0 };
+		copies[i].imageExtent = { regions[i].extent.width, regions[i].extent.height, 1 };
+
+		regionSize += static_cast<VkDeviceSize>(regions[i].extent.width) * regions[i].extent.height * bytesPerPixel;
+	}
+
+	VkBuffer stagingBuffer;
+	VkDeviceMemory stagingBufferMemory;
+	createBuffer(m_device, m_physicalDevice, regionSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory);
+
+	void* data;
+	vkMapMemory(m_device, stagingBufferMemory, 0, regionSize, 0, &data);
+	memcpy(data, pixels, static_cast<size_t>(regionSize));
+	vkUnmapMemory(m_device, stagingBufferMemory);
+
+	VkCommandBuffer commandBuffer = beginSingleTimeCommands(m_device, m_commandPool);
+
+	// Previous reads are in submission order on the same queue, the barrier waits for them
+	transitionImageLayoutUsingCommandBuffer(commandBuffer, m_image, m_imageFormat, m_imageLayout, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, m_mipLevels,
+		m_imageLayout == VK_IMAGE_LAYOUT_UNDEFINED ? VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT : readingStage, VK_PIPELINE_STAGE_TRANSFER_BIT, 0);
+
+	vkCmdCopyBufferToImage(commandBuffer, stagingBuffer, m_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(copies.size()), copies.data());
+
+	transitionImageLayoutUsingCommandBuffer(commandBuffer, m_image, m_imageFormat, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, m_mipLevels,
+		VK_PIPELINE_STAGE_TRANSFER_BIT, readingStage, 0);
+	m_imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+	endSingleTimeCommands(m_device, m_graphicsQueue, commandBuffer, m_commandPool);
+
+	vkDestroyBuffer(m_device, stagingBuffer, nullptr);
+	vkFreeMemory(m_device, stagingBufferMemory, nullptr);
+}
+
+void Wolf::Image::copyToPixels(void* pixels, uint32_t bytesPerPixel, VkOffset2D offset, VkExtent2D extent, VkPipelineStageFlags usingStage)
+{
+	const VkDeviceSize regionSize = static_cast<VkDeviceSize>(extent.width) * extent.height * bytesPerPixel;
+
+	VkBuffer stagingBuffer;
+	VkDeviceMemory stagingBufferMemory;
+	createBuffer(m_device, m_physicalDevice, regionSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory);
+
+	VkCommandBuffer commandBuffer = beginSingleTimeCommands(m_device, m_commandPool);
+
+	transitionImageLayoutUsingCommandBuffer(commandBuffer, m_image, m_imageFormat, m_imageLayout, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, m_mipLevels,
+		usingStage, VK_PIPELINE_STAGE_TRANSFER_BIT, 0);
+
+	VkBufferImageCopy region = {};
+	region.bufferOffset = 0;
+	region.bufferRowLength = 0;
+	region.bufferImageHeight = 0;
+
+	region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	region.imageSubresource.mipLevel = 0;
+	region.imageSubresource.baseArrayLayer = 0;
+	region.imageSubresource.layerCount = 1;
+
+	region.imageOffset = { offset.x, offset.y, 0 };
+	region.imageExtent = { extent.width, extent.height, 1 };
+
+	vkCmdCopyImageToBuffer(commandBuffer, m_image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, stagingBuffer, 1, &region);
+
+	transitionImageLayoutUsingCommandBuffer(commandBuffer, m_image, m_imageFormat, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, m_imageLayout, m_mipLevels,
+		VK_PIPELINE_STAGE_TRANSFER_BIT, usingStage, 0);
+
+	endSingleTimeCommands(m_device, m_graphicsQueue, commandBuffer, m_commandPool);
+
+	void* data;
+	vkMapMemory(m_device, stagingBufferMemory, 0, regionSize, 0, &data);
+	memcpy(pixels, data, static_cast<size_t>(regionSize));
+	vkUnmapMemory(m_device, stagingBufferMemory);
+
+	vkDestroyBuffer(m_device, stagingBuffer, nullptr);
+	vkFreeMemory(m_device, stagingBufferMemory, nullptr);
+}
+
 void Wolf::Image::createImage(VkDevice device, VkPhysicalDevice physicalDevice, uint32_t width, uint32_t height, uint32_t depth, uint32_t mipLevels, VkSampleCountFlagBits numSamples,
 	VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, uint32_t arrayLayers, VkImageCreateFlags flags, VkImageLayout initialLayout,
 	VkImage& image, VkDeviceMemory& imageMemory)
@@ -444,7 +545,7 @@ void Wolf::Image::transitionImageLayoutUsingCommandBuffer(VkCommandBuffer comman
 		break;
 
 	case VK_IMAGE_LAYOUT_GENERAL:
-		barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT; // storage images
 		break;
 
 	default:
@@ -479,7 +580,7 @@ void Wolf::Image::transitionImageLayoutUsingCommandBuffer(VkCommandBuffer comman
 		break;
 
 	case VK_IMAGE_LAYOUT_GENERAL:
-		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
 		break;
 
 	case VK_IMAGE_LAYOUT_PRESENT_SRC_KHR:
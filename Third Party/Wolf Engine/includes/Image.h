@@ -31,6 +31,13 @@ namespace Wolf
 
 		void setImageLayout(VkImageLayout newLayout, VkPipelineStageFlags sourceStage, VkPipelineStageFlags destinationStage);
 		void setImageLayoutWithoutOperation(VkImageLayout newImageLayout) { m_imageLayout = newImageLayout; }
+		// Upload to a region of the first mip level (image created with transfer destination usage), pixels are tightly packed rows of extent.width texels
+		// The image is left in shader read only layout for readingStage
+		void copyFromPixels(const void* pixels, uint32_t bytesPerPixel, VkOffset2D offset, VkExtent2D extent, VkPipelineStageFlags readingStage);
+		// Same with several regions in one submission, the texels of each region follow the ones of the previous region
+		void copyFromPixels(const void* pixels, uint32_t bytesPerPixel, const std::vector<VkRect2D>& regions, VkPipelineStageFlags readingStage);
+		// Read back a region of the first mip level (image created with transfer source usage) into tightly packed rows, the image keeps its layout
+		void copyToPixels(void* pixels, uint32_t bytesPerPixel, VkOffset2D offset, VkExtent2D extent, VkPipelineStageFlags usingStage);
 
 		VkImage getImage() { return m_image; }
 		VkDeviceMemory getImageMemory() { return m_imageMemory; }
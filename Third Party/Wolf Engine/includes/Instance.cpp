@@ -2,6 +2,9 @@
 
 Wolf::InstanceParent::~InstanceParent()
 {
+	if (!m_ownsInstanceBuffer)
+		return;
+
 	vkDestroyBuffer(m_device, m_instanceBuffer, nullptr);
 	vkFreeMemory(m_device, m_instanceBufferMemory, nullptr);
 }
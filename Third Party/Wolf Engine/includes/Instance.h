@@ -11,6 +11,12 @@ namespace Wolf
 		uint32_t nInstances = 0;
 	};
 
+	struct IndirectBuffer
+	{
+		VkBuffer indirectBuffer = VK_NULL_HANDLE; // array of VkDrawIndexedIndirectCommand
+		uint32_t drawCount = 0;
+	};
+
 	class InstanceParent : public VulkanElement
 	{
 	public:
@@ -22,6 +28,7 @@ namespace Wolf
 	protected:
 		VkBuffer m_instanceBuffer = nullptr;
 		VkDeviceMemory m_instanceBufferMemory = nullptr;
+		bool m_ownsInstanceBuffer = true; // false for a buffer given to createFromBuffer
 	};
 	
 	template <typename T>
@@ -32,16 +39,21 @@ namespace Wolf
 			Queue graphicsQueue);
 		~Instance() = default;
 
-		void loadFromVector(std::vector<T> data);
-		void createFromBuffer(Buffer* buffer);
+		// additionalUsage allows e.g. reading the instances as a storage buffer
+		void loadFromVector(std::vector<T> data, VkBufferUsageFlags additionalUsage = 0);
+		// Instance ranges (first instance, instance count) copied from data, which has the layout of the whole buffer
+		void updateInstances(const std::vector<std::pair<uint32_t, uint32_t>>& instanceRanges, const T* data);
+		// Instances written on the GPU, instanceCount is the capacity of the buffer
+		void createFromBuffer(Buffer* buffer, uint32_t instanceCount);
 
 		void cleanup(VkDevice device);
 
 	public: // Getters
-		InstanceBuffer getInstanceBuffer() const { return { m_instanceBuffer, static_cast<uint32_t>(m_instances.size()) }; }
+		InstanceBuffer getInstanceBuffer() const { return { m_instanceBuffer, m_instances.empty() ? m_bufferInstanceCount : static_cast<uint32_t>(m_instances.size()) }; }
 
 	private:
 		std::vector<T> m_instances;
+		uint32_t m_bufferInstanceCount = 0;
 	};
 
 	template <typename T>
@@ -55,7 +67,7 @@ namespace Wolf
 	}
 
 	template <typename T>
-	void Instance<T>::loadFromVector(std::vector<T> data)
+	void Instance<T>::loadFromVector(std::vector<T> data, VkBufferUsageFlags additionalUsage)
 	{
 		m_instances = std::move(data);
 		const VkDeviceSize bufferSize = sizeof(m_instances[0]) * m_instances.size();
@@ -69,7 +81,7 @@ namespace Wolf
 		memcpy(pData, m_instances.data(), bufferSize);
 		vkUnmapMemory(m_device, stagingBufferMemory);
 
-		createBuffer(m_device, m_physicalDevice, bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_instanceBuffer, m_instanceBufferMemory);
+		createBuffer(m_device, m_physicalDevice, bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | additionalUsage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_instanceBuffer, m_instanceBufferMemory);
 
 		copyBuffer(m_device, m_commandPool, m_graphicsQueue, stagingBuffer, m_instanceBuffer, bufferSize);
 
@@ -77,10 +89,26 @@ namespace Wolf
 		vkFreeMemory(m_device, stagingBufferMemory, nullptr);
 	}
 
+	template <typename T>
+	void Instance<T>::updateInstances(const std::vector<std::pair<uint32_t, uint32_t>>& instanceRanges, const T* data)
+	{
+		std::vector<std::pair<VkDeviceSize, VkDeviceSize>> ranges;
+		for (const std::pair<uint32_t, uint32_t>& instanceRange : instanceRanges)
+		{
+			std::copy(data + instanceRange.first, data + instanceRange.first + instanceRange.second, m_instances.begin() + instanceRange.first);
+			ranges.emplace_back(sizeof(T) * instanceRange.first, sizeof(T) * instanceRange.second);
+		}
+
+		copyToBufferRanges(m_device, m_physicalDevice, m_commandPool, m_graphicsQueue, data, ranges, m_instanceBuffer, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT,
+			VK_PIPELINE_STAGE_VERTEX_INPUT_BIT);
+	}
+
 	template<typename T>
-	void Instance<T>::createFromBuffer(Buffer* buffer)
+	void Instance<T>::createFromBuffer(Buffer* buffer, uint32_t instanceCount)
 	{
 		m_instanceBuffer = buffer->getBuffer();
+		m_bufferInstanceCount = instanceCount;
+		m_ownsInstanceBuffer = false;
 	}
 
 	template <typename T>
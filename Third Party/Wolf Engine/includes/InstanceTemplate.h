@@ -5,7 +5,7 @@
 
 namespace Wolf
 {
-	enum class InstanceTemplate { NO, SINGLE_ID };
+	enum class InstanceTemplate { NO, SINGLE_ID, TRANSFORM };
 	
 	struct InstanceSingleID
 	{
@@ -33,4 +33,38 @@ namespace Wolf
 			return attributeDescriptions;
 		}
 	};
+
+	// Uniform scale, rotation then translation of the instance
+	struct InstanceTransform
+	{
+		glm::vec4 positionScale; // xyz = translation, w = uniform scale
+		glm::vec4 rotation; // unit quaternion (x, y, z, w)
+
+		static VkVertexInputBindingDescription getBindingDescription(uint32_t binding)
+		{
+			VkVertexInputBindingDescription bindingDescription = {};
+			bindingDescription.binding = binding;
+			bindingDescription.stride = sizeof(InstanceTransform);
+			bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+
+			return bindingDescription;
+		}
+
+		static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions(uint32_t binding, uint32_t startLocation)
+		{
+			std::vector<VkVertexInputAttributeDescription> attributeDescriptions(2);
+
+			attributeDescriptions[0].binding = binding;
+			attributeDescriptions[0].location = startLocation;
+			attributeDescriptions[0].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+			attributeDescriptions[0].offset = offsetof(InstanceTransform, positionScale);
+
+			attributeDescriptions[1].binding = binding;
+			attributeDescriptions[1].location = startLocation + 1;
+			attributeDescriptions[1].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+			attributeDescriptions[1].offset = offsetof(InstanceTransform, rotation);
+
+			return attributeDescriptions;
+		}
+	};
 }
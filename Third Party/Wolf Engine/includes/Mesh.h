@@ -40,6 +40,21 @@ namespace Wolf
 			vkFreeMemory(device, m_indexBufferMemory, nullptr);
 		}
 
+		// Vertex ranges (first vertex, vertex count) copied from vertices, which has the layout of the whole buffer
+		void updateVertices(VkDevice device, VkPhysicalDevice physicalDevice, VkCommandPool commandPool, Queue graphicsQueue,
+			const std::vector<std::pair<uint32_t, uint32_t>>& vertexRanges, const T* vertices)
+		{
+			std::vector<std::pair<VkDeviceSize, VkDeviceSize>> ranges;
+			for (const std::pair<uint32_t, uint32_t>& vertexRange : vertexRanges)
+			{
+				std::copy(vertices + vertexRange.first, vertices + vertexRange.first + vertexRange.second, m_vertices.begin() + vertexRange.first);
+				ranges.emplace_back(sizeof(T) * vertexRange.first, sizeof(T) * vertexRange.second);
+			}
+
+			copyToBufferRanges(device, physicalDevice, commandPool, graphicsQueue, vertices, ranges, m_vertexBuffer, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT,
+				VK_PIPELINE_STAGE_VERTEX_INPUT_BIT);
+		}
+
 		VertexBuffer getVertexBuffer() { return { m_vertexBuffer, static_cast<unsigned int>(m_vertices.size()), m_indexBuffer, static_cast<unsigned int>(m_indices.size()) }; }
 
 	private:
@@ -0,0 +1,344 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+
+Wolf::MeshOptimizer::VertexCacheStatistics Wolf::MeshOptimizer::analyzeVertexCache(const uint32_t* indices, size_t indexCount, uint32_t vertexCount, uint32_t cacheSize)
+{
+	// A vertex is in the FIFO cache while less than cacheSize vertices were transformed after it
+	std::vector<uint32_t> timestamps(vertexCount, 0);
+	std::vector<bool> referenced(vertexCount, false);
+	uint32_t time = cacheSize + 1;
+	uint32_t referencedVertexCount = 0;
+
+	VertexCacheStatistics statistics;
+	for (size_t i = 0; i < indexCount; ++i)
+	{
+		const uint32_t vertex = indices[i];
+		if (time - timestamps[vertex] > cacheSize)
+		{
+			timestamps[vertex] = time++;
+			statistics.transformedVertexCount++;
+		}
+		if (!referenced[vertex])
+		{
+			referenced[vertex] = true;
+			referencedVertexCount++;
+		}
+	}
+
+	if (indexCount >= 3)
+		statistics.acmr = static_cast<float>(statistics.transformedVertexCount) / static_cast<float>(indexCount / 3);
+	if (referencedVertexCount > 0)
+		statistics.atvr = static_cast<float>(statistics.transformedVertexCount) / static_cast<float>(referencedVertexCount);
+	return statistics;
+}
+
+float Wolf::MeshOptimizer::computeVertexScore(int32_t cachePosition, uint32_t remainingTriangleCount)
+{
+	if (remainingTriangleCount == 0)
+		return -1.0f;
+
+	float score = 0.0f;
+	if (cachePosition >= 0)
+	{
+		// The vertices of the last triangle get a fixed score, not to favour emitting the same edge again
+		if (cachePosition < 3)
+			score = 0.75f;
+		else
+			score = std::pow(1.0f - static_cast<float>(cachePosition - 3) / static_cast<float>(MESH_OPTIMIZER_CACHE_SIZE - 3), 1.5f);
+	}
+
+	// Finishing the vertices with few triangles left avoids coming back to them once they left the cache
+	return score + 2.0f / std::sqrt(static_cast<float>(remainingTriangleCount));
+}
+
+void Wolf::MeshOptimizer::optimizeVertexCache(uint32_t* indices, size_t indexCount, uint32_t vertexCount)
+{
+	const size_t triangleCount = indexCount / 3;
+	if (triangleCount == 0)
+		return;
+
+	// Triangles not emitted yet of each vertex: adjacency[firstAdjacency[v] ... firstAdjacency[v] + remainingTriangleCounts[v][
+	std::vector<uint32_t> remainingTriangleCounts(vertexCount, 0);
+	for (size_t i = 0; i < triangleCount * 3; ++i)
+		remainingTriangleCounts[indices[i]]++;
+	std::vector<uint32_t> firstAdjacency(vertexCount, 0);
+	for (uint32_t vertex = 1; vertex < vertexCount; ++vertex)
+		firstAdjacency[vertex] = firstAdjacency[vertex - 1] + remainingTriangleCounts[vertex - 1];
+	std::vector<uint32_t> adjacency(triangleCount * 3);
+	{
+		std::vector<uint32_t> adjacencyCounts(vertexCount, 0);
+		for (size_t i = 0; i < triangleCount * 3; ++i)
+			adjacency[firstAdjacency[indices[i]] + adjacencyCounts[indices[i]]++] = static_cast<uint32_t>(i / 3);
+	}
+
+	std::vector<int32_t> cachePositions(vertexCount, -1);
+	std::vector<float> vertexScores(vertexCount);
+	for (uint32_t vertex = 0; vertex < vertexCount; ++vertex)
+		vertexScores[vertex] = computeVertexScore(-1, remainingTriangleCounts[vertex]);
+
+	std::vector<float> triangleScores(triangleCount);
+	std::vector<bool> emitted(triangleCount, false);
+	size_t bestTriangle = 0;
+	for (size_t triangle = 0; triangle < triangleCount; ++triangle)
+	{
+		triangleScores[triangle] = vertexScores[indices[triangle * 3]] + vertexScores[indices[triangle * 3 + 1]] + vertexScores[indices[triangle * 3 + 2]];
+		if (triangleScores[triangle] > triangleScores[bestTriangle])
+			bestTriangle = triangle;
+	}
+
+	std::vector<uint32_t> optimizedIndices(triangleCount * 3);
+	std::vector<uint32_t> cache;
+	std::vector<uint32_t> newCache;
+	cache.reserve(MESH_OPTIMIZER_CACHE_SIZE + 3);
+	newCache.reserve(MESH_OPTIMIZER_CACHE_SIZE + 3);
+	size_t nextUnemittedTriangle = 0;
+	for (size_t outputTriangle = 0; outputTriangle < triangleCount; ++outputTriangle)
+	{
+		// No triangle left around the cache: the next one in the input order
+		if (bestTriangle == triangleCount)
+		{
+			while (emitted[nextUnemittedTriangle])
+				nextUnemittedTriangle++;
+			bestTriangle = nextUnemittedTriangle;
+		}
+
+		const uint32_t* triangleVertices = &indices[bestTriangle * 3];
+		std::copy(triangleVertices, triangleVertices + 3, &optimizedIndices[outputTriangle * 3]);
+		emitted[bestTriangle] = true;
+
+		for (uint32_t corner = 0; corner < 3; ++corner)
+		{
+			const uint32_t vertex = triangleVertices[corner];
+			uint32_t* vertexTriangles = &adjacency[firstAdjacency[vertex]];
+			uint32_t& remainingTriangleCount = remainingTriangleCounts[vertex];
+			for (uint32_t k = 0; k < remainingTriangleCount; ++k)
+			{
+				if (vertexTriangles[k] == bestTriangle)
+				{
+					std::swap(vertexTriangles[k], vertexTriangles[remainingTriangleCount - 1]);
+					remainingTriangleCount--;
+					break;
+				}
+			}
+		}
+
+		// LRU cache: the vertices of the triangle move to the front, the ones pushed past the end leave it
+		newCache.clear();
+		for (uint32_t corner = 0; corner < 3; ++corner)
+			if (std::find(newCache.begin(), newCache.end(), triangleVertices[corner]) == newCache.end())
+				newCache.push_back(triangleVertices[corner]);
+		for (uint32_t vertex : cache)
+			if (vertex != triangleVertices[0] && vertex != triangleVertices[1] && vertex != triangleVertices[2])
+				newCache.push_back(vertex);
+
+		for (size_t position = 0; position < newCache.size(); ++position)
+		{
+			const uint32_t vertex = newCache[position];
+			cachePositions[vertex] = position < MESH_OPTIMIZER_CACHE_SIZE ? static_cast<int32_t>(position) : -1;
+			vertexScores[vertex] = computeVertexScore(cachePositions[vertex], remainingTriangleCounts[vertex]);
+		}
+
+		// The triangles around the vertices whose score changed, the best one being emitted next
+		bestTriangle = triangleCount;
+		float bestScore = -1.0f;
+		for (uint32_t vertex : newCache)
+		{
+			const uint32_t* vertexTriangles = &adjacency[firstAdjacency[vertex]];
+			for (uint32_t k = 0; k < remainingTriangleCounts[vertex]; ++k)
+			{
+				const uint32_t triangle = vertexTriangles[k];
+				triangleScores[triangle] = vertexScores[indices[triangle * 3]] + vertexScores[indices[triangle * 3 + 1]] + vertexScores[indices[triangle * 3 + 2]];
+				if (triangleScores[triangle] > bestScore)
+				{
+					bestScore = triangleScores[triangle];
+					bestTriangle = triangle;
+				}
+			}
+		}
+
+		if (newCache.size() > MESH_OPTIMIZER_CACHE_SIZE)
+			newCache.resize(MESH_OPTIMIZER_CACHE_SIZE);
+		cache.swap(newCache);
+	}
+
+	std::copy(optimizedIndices.begin(), optimizedIndices.end(), indices);
+}
+
+void Wolf::MeshOptimizer::optimizeOverdraw(uint32_t* indices, size_t indexCount, const float* positions, size_t positionStride, uint32_t vertexCount, float threshold)
+{
+	const size_t triangleCount = indexCount / 3;
+	if (triangleCount == 0)
+		return;
+
+	std::vector<uint32_t> timestamps(vertexCount, 0);
+	uint32_t time = MESH_OPTIMIZER_CACHE_SIZE + 1;
+	auto countMisses = [&](size_t triangle)
+	{
+		uint32_t misses = 0;
+		for (uint32_t corner = 0; corner < 3; ++corner)
+		{
+			const uint32_t vertex = indices[triangle * 3 + corner];
+			if (time - timestamps[vertex] > MESH_OPTIMIZER_CACHE_SIZE)
+			{
+				timestamps[vertex] = time++;
+				misses++;
+			}
+		}
+		return misses;
+	};
+	auto flushCache = [&]() { time += MESH_OPTIMIZER_CACHE_SIZE + 1; };
+
+	// Hard boundaries: a triangle whose 3 vertices miss restarts the cache, reordering there costs nothing
+	std::vector<size_t> hardBoundaries(1, 0);
+	for (size_t triangle = 0; triangle < triangleCount; ++triangle)
+		if (countMisses(triangle) == 3 && triangle > 0)
+			hardBoundaries.push_back(triangle);
+	hardBoundaries.push_back(triangleCount);
+
+	// Soft boundaries: inside a hard cluster, a new cluster starts once the ACMR since the last boundary is within threshold of the cluster one
+	std::vector<size_t> clusterStarts;
+	for (size_t hardCluster = 0; hardCluster + 1 < hardBoundaries.size(); ++hardCluster)
+	{
+		const size_t start = hardBoundaries[hardCluster];
+		const size_t end = hardBoundaries[hardCluster + 1];
+
+		flushCache();
+		uint32_t clusterMisses = 0;
+		for (size_t triangle = start; triangle < end; ++triangle)
+			clusterMisses += countMisses(triangle);
+		const float clusterThreshold = threshold * static_cast<float>(clusterMisses) / static_cast<float>(end - start);
+
+		clusterStarts.push_back(start);
+		flushCache();
+		uint32_t runningMisses = 0;
+		uint32_t runningTriangleCount = 0;
+		for (size_t triangle = start; triangle + 1 < end; ++triangle)
+		{
+			runningMisses += countMisses(triangle);
+			runningTriangleCount++;
+			if (static_cast<float>(runningMisses) / static_cast<float>(runningTriangleCount) <= clusterThreshold)
+			{
+				clusterStarts.push_back(triangle + 1);
+				flushCache();
+				runningMisses = 0;
+				runningTriangleCount = 0;
+			}
+		}
+	}
+	clusterStarts.push_back(triangleCount);
+
+	// Area weighted centroid and normal of the clusters and of the mesh
+	auto getPosition = [&](uint32_t vertex)
+	{
+		const float* position = reinterpret_cast<const float*>(reinterpret_cast<const char*>(positions) + vertex * positionStride);
+		return std::array<float, 3>{ position[0], position[1], position[2] };
+	};
+	const size_t clusterCount = clusterStarts.size() - 1;
+	std::vector<std::array<float, 3>> clusterCentroids(clusterCount, { 0.0f, 0.0f, 0.0f });
+	std::vector<std::array<float, 3>> clusterNormals(clusterCount, { 0.0f, 0.0f, 0.0f });
+	std::array<float, 3> meshCentroid = { 0.0f, 0.0f, 0.0f };
+	float meshArea = 0.0f;
+	for (size_t cluster = 0; cluster < clusterCount; ++cluster)
+	{
+		float clusterArea = 0.0f;
+		for (size_t triangle = clusterStarts[cluster]; triangle < clusterStarts[cluster + 1]; ++triangle)
+		{
+			const std::array<float, 3> p0 = getPosition(indices[triangle * 3]);
+			const std::array<float, 3> p1 = getPosition(indices[triangle * 3 + 1]);
+			const std::array<float, 3> p2 = getPosition(indices[triangle * 3 + 2]);
+			const float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+			const float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+			const float normal[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+			const float area = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+
+			for (uint32_t axis = 0; axis < 3; ++axis)
+			{
+				const float center = (p0[axis] + p1[axis] + p2[axis]) / 3.0f;
+				clusterCentroids[cluster][axis] += center * area;
+				clusterNormals[cluster][axis] += normal[axis];
+				meshCentroid[axis] += center * area;
+			}
+			clusterArea += area;
+		}
+
+		const float inverseArea = clusterArea > 0.0f ? 1.0f / clusterArea : 0.0f;
+		for (uint32_t axis = 0; axis < 3; ++axis)
+			clusterCentroids[cluster][axis] *= inverseArea;
+		meshArea += clusterArea;
+	}
+	const float inverseMeshArea = meshArea > 0.0f ? 1.0f / meshArea : 0.0f;
+	for (uint32_t axis = 0; axis < 3; ++axis)
+		meshCentroid[axis] *= inverseMeshArea;
+
+	std::vector<float> clusterKeys(clusterCount);
+	for (size_t cluster = 0; cluster < clusterCount; ++cluster)
+	{
+		const std::array<float, 3>& normal = clusterNormals[cluster];
+		const float normalLength = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+		float key = 0.0f;
+		for (uint32_t axis = 0; axis < 3; ++axis)
+			key += (clusterCentroids[cluster][axis] - meshCentroid[axis]) * normal[axis];
+		clusterKeys[cluster] = normalLength > 0.0f ? key / normalLength : 0.0f;
+	}
+
+	std::vector<size_t> clusterOrder(clusterCount);
+	for (size_t cluster = 0; cluster < clusterCount; ++cluster)
+		clusterOrder[cluster] = cluster;
+	std::stable_sort(clusterOrder.begin(), clusterOrder.end(), [&](size_t left, size_t right) { return clusterKeys[left] > clusterKeys[right]; });
+
+	std::vector<uint32_t> orderedIndices;
+	orderedIndices.reserve(triangleCount * 3);
+	for (size_t cluster : clusterOrder)
+		orderedIndices.insert(orderedIndices.end(), indices + clusterStarts[cluster] * 3, indices + clusterStarts[cluster + 1] * 3);
+	std::copy(orderedIndices.begin(), orderedIndices.end(), indices);
+}
+
+uint32_t Wolf::MeshOptimizer::optimizeVertexFetch(uint32_t* indices, size_t indexCount, uint32_t vertexCount, std::vector<uint32_t>& outRemap)
+{
+	outRemap.assign(vertexCount, ~0u);
+	uint32_t newVertexCount = 0;
+	for (size_t i = 0; i < indexCount; ++i)
+	{
+		uint32_t& newVertex = outRemap[indices[i]];
+		if (newVertex == ~0u)
+			newVertex = newVertexCount++;
+		indices[i] = newVertex;
+	}
+	return newVertexCount;
+}
+
+Wolf::MeshOptimizer::Statistics Wolf::MeshOptimizer::optimizeIndices(std::vector<uint32_t>& indices, uint32_t vertexCount, const std::vector<size_t>& rangeEnds,
+	const float* positions, size_t positionStride)
+{
+	Statistics statistics;
+	statistics.before = analyzeVertexCache(indices.data(), indices.size(), vertexCount);
+
+	size_t rangeStart = 0;
+	for (size_t range = 0; range <= rangeEnds.size(); ++range)
+	{
+		const size_t rangeEnd = range < rangeEnds.size() ? rangeEnds[range] : indices.size();
+		if (rangeEnd > rangeStart)
+		{
+			optimizeVertexCache(&indices[rangeStart], rangeEnd - rangeStart, vertexCount);
+			if (positions)
+				optimizeOverdraw(&indices[rangeStart], rangeEnd - rangeStart, positions, positionStride, vertexCount);
+		}
+		rangeStart = rangeEnd;
+	}
+
+	statistics.after = analyzeVertexCache(indices.data(), indices.size(), vertexCount);
+	return statistics;
+}
+
+std::string Wolf::MeshOptimizer::toString(const Statistics& statistics)
+{
+	std::ostringstream stream;
+	stream << std::fixed << std::setprecision(3) << "ACMR " << statistics.before.acmr << " -> " << statistics.after.acmr <<
+		", ATVR " << statistics.before.atvr << " -> " << statistics.after.atvr;
+	return stream.str();
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+#define MESH_OPTIMIZER_CACHE_SIZE 32 // entries of the simulated post-transform vertex cache
+#define MESH_OPTIMIZER_OVERDRAW_THRESHOLD 1.05f // tolerated ACMR increase of the overdraw cluster order
+
+namespace Wolf
+{
+	// Index and vertex order optimizations to run before Mesh<T>::loadFromVertices. They only change the order of the triangles (keeping their winding)
+	// and of the vertices, never the rendered mesh
+	class MeshOptimizer
+	{
+	public:
+		struct VertexCacheStatistics
+		{
+			uint32_t transformedVertexCount = 0; // cache misses of a FIFO cache of MESH_OPTIMIZER_CACHE_SIZE vertices
+			float acmr = 0.0f; // average cache miss ratio: transformed vertices per triangle, 3 at worst, about 0.5 at best on a regular grid
+			float atvr = 0.0f; // average transform to vertex ratio: transformed vertices per referenced vertex, 1 at best
+		};
+
+		struct Statistics
+		{
+			VertexCacheStatistics before;
+			VertexCacheStatistics after;
+		};
+
+		static VertexCacheStatistics analyzeVertexCache(const uint32_t* indices, size_t indexCount, uint32_t vertexCount, uint32_t cacheSize = MESH_OPTIMIZER_CACHE_SIZE);
+
+		// Forsyth's linear-speed vertex cache optimisation: greedily emits the triangle whose vertices score best, the score favouring the vertices recently
+		// used in a simulated LRU cache and the ones with few remaining triangles
+		static void optimizeVertexCache(uint32_t* indices, size_t indexCount, uint32_t vertexCount);
+		// Splits the cache optimized order into clusters, where the cache restarts then wherever the ACMR from the cluster start is within threshold
+		// of the one of the whole cluster, and draws the clusters facing away from the mesh center first (Sander et al.), as they tend to hide the others.
+		// positionStride is in bytes, a position being 3 floats
+		static void optimizeOverdraw(uint32_t* indices, size_t indexCount, const float* positions, size_t positionStride, uint32_t vertexCount,
+			float threshold = MESH_OPTIMIZER_OVERDRAW_THRESHOLD);
+		// Vertices in the order of their first use, outRemap[old vertex] being the new one (~0u for an unreferenced vertex). Returns the new vertex count
+		static uint32_t optimizeVertexFetch(uint32_t* indices, size_t indexCount, uint32_t vertexCount, std::vector<uint32_t>& outRemap);
+		template <typename T>
+		static void remapVertices(std::vector<T>& vertices, const std::vector<uint32_t>& remap, uint32_t newVertexCount);
+
+		// Vertex cache then overdraw order of each index range, [0, rangeEnds[0][, [rangeEnds[0], rangeEnds[1][, ... and [rangeEnds.back(), indexCount[,
+		// whose triangles stay in their range. The overdraw order is skipped without positions
+		static Statistics optimizeIndices(std::vector<uint32_t>& indices, uint32_t vertexCount, const std::vector<size_t>& rangeEnds = {},
+			const float* positions = nullptr, size_t positionStride = 0);
+		// optimizeIndices then optimizeVertexFetch. positionOffset is the byte offset of a 3 floats position in T, the overdraw order is skipped if negative
+		template <typename T>
+		static Statistics optimize(std::vector<T>& vertices, std::vector<uint32_t>& indices, int32_t positionOffset, const std::vector<size_t>& rangeEnds = {});
+
+		static std::string toString(const Statistics& statistics);
+
+	private:
+		static float computeVertexScore(int32_t cachePosition, uint32_t remainingTriangleCount);
+	};
+
+	template <typename T>
+	void MeshOptimizer::remapVertices(std::vector<T>& vertices, const std::vector<uint32_t>& remap, uint32_t newVertexCount)
+	{
+		std::vector<T> remappedVertices(newVertexCount);
+		for (size_t vertex = 0; vertex < vertices.size(); ++vertex)
+			if (remap[vertex] != ~0u)
+				remappedVertices[remap[vertex]] = vertices[vertex];
+		vertices.swap(remappedVertices);
+	}
+
+	template <typename T>
+	MeshOptimizer::Statistics MeshOptimizer::optimize(std::vector<T>& vertices, std::vector<uint32_t>& indices, int32_t positionOffset, const std::vector<size_t>& rangeEnds)
+	{
+		const float* positions = positionOffset >= 0 && !vertices.empty() ?
+			reinterpret_cast<const float*>(reinterpret_cast<const char*>(vertices.data()) + positionOffset) : nullptr;
+		Statistics statistics = optimizeIndices(indices, static_cast<uint32_t>(vertices.size()), rangeEnds, positions, sizeof(T));
+
+		std::vector<uint32_t> remap;
+		const uint32_t newVertexCount = optimizeVertexFetch(indices.data(), indices.size(), static_cast<uint32_t>(vertices.size()), remap);
+		remapVertices(vertices, remap, newVertexCount);
+
+		return statistics;
+	}
+}
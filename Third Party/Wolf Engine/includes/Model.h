@@ -19,6 +19,8 @@ namespace Wolf
 		virtual ~Model() = default;
 
 		virtual int addMeshFromVertices(void* vertices, uint32_t vertexCount, size_t vertexSize, std::vector<uint32_t> indices) { return -1; }
+		// vertexRanges are (first vertex, vertex count), vertices has the layout of the whole mesh
+		virtual void updateMeshVertices(int meshID, const std::vector<std::pair<uint32_t, uint32_t>>& vertexRanges, const void* vertices) {}
 
 		struct ModelLoadingInfo
 		{
@@ -31,6 +33,9 @@ namespace Wolf
 
 			// Material Options
 			bool loadMaterials = true;
+
+			// Vertex cache, overdraw and vertex fetch order of the mesh, see MeshOptimizer
+			bool optimizeMesh = false;
 		};
 		virtual void loadObj(ModelLoadingInfo modelLoadingInfo) {}
 
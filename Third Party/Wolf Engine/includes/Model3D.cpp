@@ -6,6 +6,7 @@
 #include <array>
 
 #include "Debug.h"
+#include "MeshOptimizer.h"
 
 Wolf::Model3D::~Model3D()
 {
@@ -156,6 +157,14 @@ void Wolf::Model3D::loadObj(ModelLoadingInfo modelLoadingInfo)
 	if(!m_images.empty())
 		m_sampler = std::make_unique<Sampler>(m_device, VK_SAMPLER_ADDRESS_MODE_REPEAT, static_cast<float>(m_images[0]->getMipLevels()), VK_FILTER_LINEAR);
 
+	if (modelLoadingInfo.optimizeMesh)
+	{
+		// The triangles of the materials drawn last stay after the others
+		const MeshOptimizer::Statistics statistics = MeshOptimizer::optimize(vertices, indices, static_cast<int32_t>(offsetof(Vertex3D, pos)),
+			{ indices.size() - lastIndices.size() });
+		Debug::sendInfo("Model optimized: " + MeshOptimizer::toString(statistics));
+	}
+
 	Mesh<Vertex3D> mesh;
 	mesh.loadFromVertices(m_device, m_physicalDevice, m_commandPool, m_graphicsQueue, vertices, indices);
 	m_meshes.push_back(mesh);
@@ -15,6 +15,7 @@ namespace Wolf
 		~ModelCustom();
 
 		int addMeshFromVertices(void* vertices, uint32_t vertexCount, size_t vertexSize, std::vector<uint32_t> indices) override;
+		void updateMeshVertices(int meshID, const std::vector<std::pair<uint32_t, uint32_t>>& vertexRanges, const void* vertices) override;
 
 		std::vector<Wolf::VertexBuffer> getVertexBuffers();
 
@@ -46,6 +47,12 @@ namespace Wolf
 		return static_cast<int>(m_meshes.size() - 1);
 	}
 
+	template <typename T>
+	void ModelCustom<T>::updateMeshVertices(int meshID, const std::vector<std::pair<uint32_t, uint32_t>>& vertexRanges, const void* vertices)
+	{
+		m_meshes[meshID].updateVertices(m_device, m_physicalDevice, m_commandPool, m_graphicsQueue, vertexRanges, static_cast<const T*>(vertices));
+	}
+
 	template <typename T>
 	std::vector<Wolf::VertexBuffer> ModelCustom<T>::getVertexBuffers()
 	{
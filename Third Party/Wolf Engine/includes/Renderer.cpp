@@ -60,12 +60,12 @@ void Wolf::Renderer::setViewport(std::array<float, 2> viewportScale, std::array<
 	m_renderingPipelineCreate.viewportOffset = viewportOffset;
 }
 
-std::vector<std::tuple<Wolf::VertexBuffer, Wolf::InstanceBuffer, VkDescriptorSet>> Wolf::Renderer::getMeshes()
+std::vector<std::tuple<Wolf::VertexBuffer, Wolf::InstanceBuffer, VkDescriptorSet, Wolf::IndirectBuffer>> Wolf::Renderer::getMeshes()
 {
-	std::vector<std::tuple<Wolf::VertexBuffer, Wolf::InstanceBuffer, VkDescriptorSet>> r(m_meshes.size());
+	std::vector<std::tuple<Wolf::VertexBuffer, Wolf::InstanceBuffer, VkDescriptorSet, Wolf::IndirectBuffer>> r(m_meshes.size());
 	for(size_t i(0); i < m_meshes.size(); ++i)
 	{
-		r[i] = std::make_tuple(m_meshes[i].vertexBuffer, m_meshes[i].instanceBuffer, m_meshes[i].descriptorSet);
+		r[i] = std::make_tuple(m_meshes[i].vertexBuffer, m_meshes[i].instanceBuffer, m_meshes[i].descriptorSet, m_meshes[i].indirectBuffer);
 	}
 
 	return r;
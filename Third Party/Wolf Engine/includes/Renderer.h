@@ -46,6 +46,7 @@ namespace Wolf
 			// IA
 			VertexBuffer vertexBuffer;
 			InstanceBuffer instanceBuffer;
+			IndirectBuffer indirectBuffer; // when set, draw parameters are read from this buffer at execution instead of recorded
 
 			VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
 
@@ -65,7 +66,7 @@ namespace Wolf
 		void setViewport(std::array<float, 2> viewportScale, std::array<float, 2> viewportOffset);	
 
 		VkPipeline getPipeline() { return m_pipeline->getPipeline(); }
-		std::vector<std::tuple<VertexBuffer, InstanceBuffer, VkDescriptorSet>> getMeshes();
+		std::vector<std::tuple<VertexBuffer, InstanceBuffer, VkDescriptorSet, IndirectBuffer>> getMeshes();
 		std::vector<AddMeshInfo> getMeshInfos() { return m_meshes; }
 		VkPipelineLayout getPipelineLayout() { return m_pipeline->getPipelineLayout(); }
 		RendererCreateInfo getRendererCreateInfoStructure();
@@ -1,5 +1,6 @@
 #include "Scene.h"
 
+#include <limits>
 #include <utility>
 #include "InputVertexTemplate.h"
 #include "Debug.h"
@@ -31,6 +32,23 @@ Wolf::Scene::Scene(SceneCreateInfo createInfo, VkDevice device, VkPhysicalDevice
 	m_windowSwapChainImages = std::move(windowSwapChainImages);
 }
 
+Wolf::Scene::~Scene()
+{
+	if (m_swapChainCompleteFence != VK_NULL_HANDLE)
+	{
+		waitForLastFrame();
+		vkDestroyFence(m_device, m_swapChainCompleteFence, nullptr);
+	}
+
+	// The passes and command buffers free the rest, the descriptor sets go with the pool
+	m_descriptorPool.cleanup(m_device);
+	for (SceneCommandBuffer& sceneCommandBuffer : m_sceneCommandBuffers)
+		if (sceneCommandBuffer.semaphore)
+			sceneCommandBuffer.semaphore->cleanup(m_device);
+	if (m_swapChainCompleteSemaphore)
+		m_swapChainCompleteSemaphore->cleanup(m_device);
+}
+
 int Wolf::Scene::addRenderPass(Wolf::Scene::RenderPassCreateInfo createInfo, int forceID)
 {
 	if(createInfo.outputIsSwapChain)
@@ -289,6 +307,7 @@ int Wolf::Scene::addRenderer(RendererCreateInfo createInfo)
 	switch (createInfo.instanceTemplate)
 	{
 	case InstanceTemplate::SINGLE_ID:
+	{
 		std::vector<VkVertexInputAttributeDescription> inputAttributeDescriptions = InstanceSingleID::getAttributeDescriptions(1, 2);
 		std::vector<VkVertexInputBindingDescription> inputBindingDescriptions = { InstanceSingleID::getBindingDescription(1) };
 
@@ -298,6 +317,20 @@ int Wolf::Scene::addRenderer(RendererCreateInfo createInfo)
 			createInfo.pipelineCreateInfo.vertexInputBindingDescriptions.push_back(inputBindingDescription);
 		break;
 	}
+	case InstanceTemplate::TRANSFORM:
+	{
+		// Locations following the vertex attributes
+		const uint32_t startLocation = static_cast<uint32_t>(createInfo.pipelineCreateInfo.vertexInputAttributeDescriptions.size());
+		std::vector<VkVertexInputAttributeDescription> inputAttributeDescriptions = InstanceTransform::getAttributeDescriptions(1, startLocation);
+
+		for (VkVertexInputAttributeDescription& inputAttributeDescription : inputAttributeDescriptions)
+			createInfo.pipelineCreateInfo.vertexInputAttributeDescriptions.push_back(inputAttributeDescription);
+		createInfo.pipelineCreateInfo.vertexInputBindingDescriptions.push_back(InstanceTransform::getBindingDescription(1));
+		break;
+	}
+	case InstanceTemplate::NO:
+		break;
+	}
 
 	if (createInfo.pipelineCreateInfo.extent.width == 0)
 		createInfo.pipelineCreateInfo.extent = { m_swapChainImages[0]->getExtent().width, m_swapChainImages[0]->getExtent().height };
@@ -441,8 +474,8 @@ void Wolf::Scene::record()
 						viewport.maxDepth = 1.0f;
 						vkCmdSetViewport(m_swapChainCommandBuffers[i]->getCommandBuffer(), 0, 1, &viewport);*/
 
-						std::vector<std::tuple<VertexBuffer, InstanceBuffer, VkDescriptorSet>> meshesToRender = renderer->getMeshes();
-						for (std::tuple<VertexBuffer, InstanceBuffer, VkDescriptorSet>& mesh : meshesToRender)
+						std::vector<std::tuple<VertexBuffer, InstanceBuffer, VkDescriptorSet, IndirectBuffer>> meshesToRender = renderer->getMeshes();
+						for (std::tuple<VertexBuffer, InstanceBuffer, VkDescriptorSet, IndirectBuffer>& mesh : meshesToRender)
 						{
 							bool isInstancied = std::get<1>(mesh).nInstances > 0 && std::get<1>(mesh).instanceBuffer;
 
@@ -456,7 +489,10 @@ void Wolf::Scene::record()
 								vkCmdBindDescriptorSets(m_swapChainCommandBuffers[i]->getCommandBuffer(), VK_PIPELINE_BIND_POINT_GRAPHICS,
 									renderer->getPipelineLayout(), 0, 1, &std::get<2>(mesh), 0, nullptr);
 
-							if (!isInstancied)
+							if (std::get<3>(mesh).indirectBuffer)
+								vkCmdDrawIndexedIndirect(m_swapChainCommandBuffers[i]->getCommandBuffer(), std::get<3>(mesh).indirectBuffer, 0, std::get<3>(mesh).drawCount,
+									sizeof(VkDrawIndexedIndirectCommand));
+							else if (!isInstancied)
 								vkCmdDrawIndexed(m_swapChainCommandBuffers[i]->getCommandBuffer(), std::get<0>(mesh).nbIndices, 1, 0, 0, 0);
 							else
 								vkCmdDrawIndexed(m_swapChainCommandBuffers[i]->getCommandBuffer(), std::get<0>(mesh).nbIndices, std::get<1>(meshesToRender[j]).nInstances, 0, 0, 0);
@@ -599,6 +635,15 @@ void Wolf::Scene::record()
 
 	m_swapChainCompleteSemaphore = std::make_unique<Semaphore>();
 	m_swapChainCompleteSemaphore->initialize(m_device);
+	if (m_swapChainCompleteFence == VK_NULL_HANDLE)
+	{
+		// Signaled: there is no frame to wait for before the first one
+		VkFenceCreateInfo fenceInfo = {};
+		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+		if (vkCreateFence(m_device, &fenceInfo, nullptr, &m_swapChainCompleteFence) != VK_SUCCESS)
+			throw std::runtime_error("Error : create fence");
+	}
 	
 	// Other command buffers
 	for(size_t i(0); i < m_sceneCommandBuffers.size(); ++i)
@@ -665,8 +710,8 @@ inline void Wolf::Scene::recordRenderPass(SceneRenderPass& sceneRenderPass)
 		vkCmdBindPipeline(m_sceneCommandBuffers[sceneRenderPass.commandBufferID].commandBuffer->getCommandBuffer(), VK_PIPELINE_BIND_POINT_GRAPHICS, renderer->getPipeline());
 		const VkDeviceSize offsets[1] = { 0 };
 
-		std::vector<std::tuple<VertexBuffer, InstanceBuffer, VkDescriptorSet>> meshesToRender = renderer->getMeshes();
-		for (std::tuple<VertexBuffer, InstanceBuffer, VkDescriptorSet>& mesh : meshesToRender)
+		std::vector<std::tuple<VertexBuffer, InstanceBuffer, VkDescriptorSet, IndirectBuffer>> meshesToRender = renderer->getMeshes();
+		for (std::tuple<VertexBuffer, InstanceBuffer, VkDescriptorSet, IndirectBuffer>& mesh : meshesToRender)
 		{
 			bool isInstancied = std::get<1>(mesh).nInstances > 0 && std::get<1>(mesh).instanceBuffer;
 
@@ -680,7 +725,10 @@ inline void Wolf::Scene::recordRenderPass(SceneRenderPass& sceneRenderPass)
 				vkCmdBindDescriptorSets(m_sceneCommandBuffers[sceneRenderPass.commandBufferID].commandBuffer->getCommandBuffer(), VK_PIPELINE_BIND_POINT_GRAPHICS,
 					renderer->getPipelineLayout(), 0, 1, &std::get<2>(mesh), 0, nullptr);
 
-			if (!isInstancied)
+			if (std::get<3>(mesh).indirectBuffer)
+				vkCmdDrawIndexedIndirect(m_sceneCommandBuffers[sceneRenderPass.commandBufferID].commandBuffer->getCommandBuffer(), std::get<3>(mesh).indirectBuffer, 0,
+					std::get<3>(mesh).drawCount, sizeof(VkDrawIndexedIndirectCommand));
+			else if (!isInstancied)
 				vkCmdDrawIndexed(m_sceneCommandBuffers[sceneRenderPass.commandBufferID].commandBuffer->getCommandBuffer(), std::get<0>(mesh).nbIndices, 1, 0, 0, 0);
 			else
 				vkCmdDrawIndexed(m_sceneCommandBuffers[sceneRenderPass.commandBufferID].commandBuffer->getCommandBuffer(), std::get<0>(mesh).nbIndices, std::get<1>(mesh).nInstances, 0, 0, 0);
@@ -738,10 +786,32 @@ void Wolf::Scene::frame(Queue graphicsQueue, Queue computeQueue, uint32_t swapCh
 		}
 	}
 
+	// The swap chain command buffer waits for the others: its fence covers the whole frame
+	waitForLastFrame();
+	vkResetFences(m_device, 1, &m_swapChainCompleteFence);
 	if(m_swapChainCommandType == CommandType::GRAPHICS || m_swapChainCommandType == CommandType::TRANSFER)
-		m_swapChainCommandBuffers[swapChainImageIndex]->submit(m_device, graphicsQueue, waitSemaphoreSwapChain, signalSemaphoreSwapChain);
+		m_swapChainCommandBuffers[swapChainImageIndex]->submit(m_device, graphicsQueue, waitSemaphoreSwapChain, signalSemaphoreSwapChain, m_swapChainCompleteFence);
 	else
-		m_swapChainCommandBuffers[swapChainImageIndex]->submit(m_device, computeQueue, waitSemaphoreSwapChain, signalSemaphoreSwapChain);
+		m_swapChainCommandBuffers[swapChainImageIndex]->submit(m_device, computeQueue, waitSemaphoreSwapChain, signalSemaphoreSwapChain, m_swapChainCompleteFence);
+}
+
+void Wolf::Scene::waitForLastFrame()
+{
+	if (m_swapChainCompleteFence != VK_NULL_HANDLE) // not recorded yet
+		vkWaitForFences(m_device, 1, &m_swapChainCompleteFence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+}
+
+void Wolf::Scene::submitCommandBuffers(Queue graphicsQueue, Queue computeQueue, const std::vector<int>& commandBufferIDs)
+{
+	for (int commandBufferID : commandBufferIDs)
+	{
+		if (m_sceneCommandBuffers[commandBufferID].type == CommandType::GRAPHICS || m_sceneCommandBuffers[commandBufferID].type == CommandType::RAY_TRACING)
+			m_sceneCommandBuffers[commandBufferID].commandBuffer->submit(m_device, graphicsQueue, {}, {});
+		else if (m_sceneCommandBuffers[commandBufferID].type == CommandType::COMPUTE)
+			m_sceneCommandBuffers[commandBufferID].commandBuffer->submit(m_device, computeQueue, {}, {});
+		else
+			Debug::sendError("Invalid queue type at sumbit");
+	}
 }
 
 void Wolf::Scene::resize(std::vector<Image*> swapChainImages)
@@ -31,6 +31,7 @@ namespace Wolf
 		
 		Scene(SceneCreateInfo createInfo, VkDevice device, VkPhysicalDevice physicalDevice, std::vector<Image*> swapChainImages, VkCommandPool graphicsCommandPool, VkCommandPool computeCommandPool);
 		Scene(SceneCreateInfo createInfo, VkDevice device, VkPhysicalDevice physicalDevice, std::vector<Image*> ovrSwapChainImages, std::vector<Image*> windowSwapChainImages, VkCommandPool graphicsCommandPool, VkCommandPool computeCommandPool);
+		~Scene();
 
 		struct RenderPassOutput
 		{
@@ -128,6 +129,10 @@ namespace Wolf
 		
 		void frame(Queue graphicsQueue, Queue computeQueue, uint32_t swapChainImageIndex, Semaphore* imageAvailableSemaphore, std::vector<int> commandBufferIDs,
 		           const std::vector<std::pair<int, int>>&);
+		// Before the host writes to a buffer the recorded commands read (e.g. with UniformBuffer::updateData): the last submitted frame is done
+		void waitForLastFrame();
+		// Out of the frame loop, e.g. one-shot work before rendering starts: no semaphore is waited or signaled
+		void submitCommandBuffers(Queue graphicsQueue, Queue computeQueue, const std::vector<int>& commandBufferIDs);
 
 		void resize(std::vector<Image*> swapChainImages);
 
@@ -146,6 +151,7 @@ namespace Wolf
 		std::vector<Image*> m_swapChainImages;
 		std::vector<std::unique_ptr<CommandBuffer>> m_swapChainCommandBuffers;
 		std::unique_ptr<Semaphore> m_swapChainCompleteSemaphore;
+		VkFence m_swapChainCompleteFence = VK_NULL_HANDLE; // signaled by the swap chain command buffer of the last frame
 		CommandType m_swapChainCommandType = CommandType::GRAPHICS;
 
 		// VR
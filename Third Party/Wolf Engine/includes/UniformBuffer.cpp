@@ -1,12 +1,12 @@
 #include "UniformBuffer.h"
 #include "Debug.h"
 
-Wolf::UniformBuffer::UniformBuffer(VkDevice device, VkPhysicalDevice physicalDevice, void* data, VkDeviceSize size)
+Wolf::UniformBuffer::UniformBuffer(VkDevice device, VkPhysicalDevice physicalDevice, void* data, VkDeviceSize size, VkBufferUsageFlags additionalUsage)
 {
 	m_device = device;
 	m_physicalDevice = physicalDevice;
 
-	createBuffer(m_device, m_physicalDevice, size, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+	createBuffer(m_device, m_physicalDevice, size, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | additionalUsage,
 		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, m_uniformBuffer, m_uniformBufferMemory);
 
 	m_size = size;
@@ -7,7 +7,7 @@ namespace Wolf
 	class UniformBuffer : public VulkanElement
 	{
 	public:
-		UniformBuffer(VkDevice device, VkPhysicalDevice physicalDevice, void* data, VkDeviceSize size);
+		UniformBuffer(VkDevice device, VkPhysicalDevice physicalDevice, void* data, VkDeviceSize size, VkBufferUsageFlags additionalUsage = 0);
 		~UniformBuffer();
 
 		void updateData(void* data);
@@ -246,6 +246,61 @@ void copyBuffer(VkDevice device, VkCommandPool commandPool, Queue graphicsQueue,
 	endSingleTimeCommands(device, graphicsQueue, commandBuffer, commandPool);
 }
 
+void copyToBufferRanges(VkDevice device, VkPhysicalDevice physicalDevice, VkCommandPool commandPool, Queue graphicsQueue, const void* data,
+	const std::vector<std::pair<VkDeviceSize, VkDeviceSize>>& ranges, VkBuffer dstBuffer, VkAccessFlags readingAccess, VkPipelineStageFlags readingStage)
+{
+	// The ranges are packed in the staging buffer
+	VkDeviceSize stagingSize = 0;
+	for (const std::pair<VkDeviceSize, VkDeviceSize>& range : ranges)
+		stagingSize += range.second;
+	if (stagingSize == 0)
+		return;
+
+	VkBuffer stagingBuffer;
+	VkDeviceMemory stagingBufferMemory;
+	createBuffer(device, physicalDevice, stagingSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		stagingBuffer, stagingBufferMemory);
+
+	void* stagingData;
+	vkMapMemory(device, stagingBufferMemory, 0, stagingSize, 0, &stagingData);
+	std::vector<VkBufferCopy> copyRegions(ranges.size());
+	VkDeviceSize stagingOffset = 0;
+	for (size_t i = 0; i < ranges.size(); ++i)
+	{
+		memcpy(static_cast<char*>(stagingData) + stagingOffset, static_cast<const char*>(data) + ranges[i].first, static_cast<size_t>(ranges[i].second));
+		copyRegions[i].srcOffset = stagingOffset;
+		copyRegions[i].dstOffset = ranges[i].first;
+		copyRegions[i].size = ranges[i].second;
+		stagingOffset += ranges[i].second;
+	}
+	vkUnmapMemory(device, stagingBufferMemory);
+
+	VkCommandBuffer commandBuffer = beginSingleTimeCommands(device, commandPool);
+
+	// Previous reads are in submission order on the same queue, the barrier waits for them
+	VkBufferMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	barrier.srcAccessMask = readingAccess;
+	barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.buffer = dstBuffer;
+	barrier.offset = 0;
+	barrier.size = VK_WHOLE_SIZE;
+	vkCmdPipelineBarrier(commandBuffer, readingStage, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+
+	vkCmdCopyBuffer(commandBuffer, stagingBuffer, dstBuffer, static_cast<uint32_t>(copyRegions.size()), copyRegions.data());
+
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = readingAccess;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, readingStage, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+
+	endSingleTimeCommands(device, graphicsQueue, commandBuffer, commandPool);
+
+	vkDestroyBuffer(device, stagingBuffer, nullptr);
+	vkFreeMemory(device, stagingBufferMemory, nullptr);
+}
+
 VkCommandBuffer beginSingleTimeCommands(VkDevice device, VkCommandPool commandPool)
 {
 	VkCommandBufferAllocateInfo allocInfo = {};
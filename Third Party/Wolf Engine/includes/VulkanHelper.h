@@ -48,6 +48,9 @@ VkFormat findDepthFormat(VkPhysicalDevice physicalDevice);
 VkFormat findSupportedFormat(const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features, VkPhysicalDevice physicalDevice);
 void createBuffer(VkDevice device, VkPhysicalDevice physicalDevice, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& bufferMemory);
 void copyBuffer(VkDevice device, VkCommandPool commandPool, Queue graphicsQueue, VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
+// Copies the ranges (offset, size) of data to the same ranges of dstBuffer, after the previous readingStage accesses of the queue and before the next ones
+void copyToBufferRanges(VkDevice device, VkPhysicalDevice physicalDevice, VkCommandPool commandPool, Queue graphicsQueue, const void* data,
+	const std::vector<std::pair<VkDeviceSize, VkDeviceSize>>& ranges, VkBuffer dstBuffer, VkAccessFlags readingAccess, VkPipelineStageFlags readingStage);
 VkCommandBuffer beginSingleTimeCommands(VkDevice device, VkCommandPool commandPool);
 void endSingleTimeCommands(VkDevice device, Queue graphicsQueue, VkCommandBuffer commandBuffer, VkCommandPool commandPool);
 VkCommandPool createCommandPool(VkDevice device, VkPhysicalDevice physicalDevice, VkSurfaceKHR surface, uint32_t queueFamilyIndex);
@@ -1,5 +1,6 @@
 #include "WolfEngine.h"
 
+#include <algorithm>
 #include <utility>
 
 Wolf::WolfInstance::WolfInstance(WolfInstanceCreateInfo createInfo)
@@ -36,13 +37,24 @@ Wolf::Scene* Wolf::WolfInstance::createScene(Scene::SceneCreateInfo createInfo)
 	return m_scenes[m_scenes.size() - 1].get();
 }
 
-Wolf::UniformBuffer* Wolf::WolfInstance::createUniformBufferObject(void* data, VkDeviceSize size)
+void Wolf::WolfInstance::destroyScene(Scene* scene)
 {
-	m_uniformBufferObjects.push_back(std::make_unique<UniformBuffer>(m_vulkan->getDevice(), m_vulkan->getPhysicalDevice(), data, size));
+	m_scenes.erase(std::find_if(m_scenes.begin(), m_scenes.end(), [scene](const std::unique_ptr<Scene>& ownedScene) { return ownedScene.get() == scene; }));
+}
+
+Wolf::UniformBuffer* Wolf::WolfInstance::createUniformBufferObject(void* data, VkDeviceSize size, VkBufferUsageFlags additionalUsage)
+{
+	m_uniformBufferObjects.push_back(std::make_unique<UniformBuffer>(m_vulkan->getDevice(), m_vulkan->getPhysicalDevice(), data, size, additionalUsage));
 
 	return m_uniformBufferObjects[m_uniformBufferObjects.size() - 1].get();
 }
 
+void Wolf::WolfInstance::destroyUniformBufferObject(UniformBuffer* uniformBuffer)
+{
+	m_uniformBufferObjects.erase(std::find_if(m_uniformBufferObjects.begin(), m_uniformBufferObjects.end(),
+		[uniformBuffer](const std::unique_ptr<UniformBuffer>& ownedUniformBuffer) { return ownedUniformBuffer.get() == uniformBuffer; }));
+}
+
 Wolf::Buffer* Wolf::WolfInstance::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage)
 {
 	m_buffers.push_back(std::make_unique<Buffer>(m_vulkan->getDevice(), m_vulkan->getPhysicalDevice(), m_graphicsCommandPool.getCommandPool(), size, usage));
@@ -140,6 +152,18 @@ void Wolf::WolfInstance::frame(Scene* scene, std::vector<int> commandBufferIDs,
 	}
 }
 
+void Wolf::WolfInstance::submitAndWait(Scene* scene, const std::vector<int>& commandBufferIDs)
+{
+	scene->submitCommandBuffers(m_vulkan->getGraphicsQueue(), m_vulkan->getComputeQueue(), commandBufferIDs);
+
+	for (Queue queue : { m_vulkan->getGraphicsQueue(), m_vulkan->getComputeQueue() })
+	{
+		queue.mutex->lock();
+		vkQueueWaitIdle(queue.queue);
+		queue.mutex->unlock();
+	}
+}
+
 bool Wolf::WolfInstance::windowShouldClose()
 {
 	return glfwWindowShouldClose(m_window->getWindow());
@@ -18,6 +18,7 @@
 #include "Model2DTextured.h"
 #include "Model3D.h"
 #include "ModelCustom.h"
+#include "MeshOptimizer.h"
 
 namespace Wolf
 {	
@@ -42,11 +43,14 @@ namespace Wolf
 		~WolfInstance() = default;
 
 		Scene* createScene(Scene::SceneCreateInfo createInfo);
+		// The GPU must be done with the scene, e.g. after submitAndWait
+		void destroyScene(Scene* scene);
 		template<typename T = float>
 		Model* createModel(Model::ModelCreateInfo createInfo);
 		template<typename T>
 		Instance<T>* createInstanceBuffer();
-		UniformBuffer* createUniformBufferObject(void* data, VkDeviceSize size);
+		UniformBuffer* createUniformBufferObject(void* data, VkDeviceSize size, VkBufferUsageFlags additionalUsage = 0); // additionalUsage allows e.g. host written indirect draws
+		void destroyUniformBufferObject(UniformBuffer* uniformBuffer);
 		Buffer* createBuffer(VkDeviceSize size, VkBufferUsageFlags usage);
 		[[deprecated("Use createImage instead")]]
 		Texture* createTexture();
@@ -65,6 +69,8 @@ namespace Wolf
 
 		void updateOVR();
 		void frame(Scene* scene, std::vector<int> commandBufferIDs, std::vector<std::pair<int, int>> commandBufferSynchronisation);
+		// Submits scene command buffers outside of a frame and waits for them to complete
+		void submitAndWait(Scene* scene, const std::vector<int>& commandBufferIDs);
 		bool windowShouldClose();
 
 		void waitIdle();